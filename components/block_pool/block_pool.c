@@ -0,0 +1,180 @@
+#include "block_pool.h"
+#include <stdlib.h>
+
+#define CLASS_SIZE(size, count)     (size),
+#define CLASS_COUNT(size, count)    (count),
+#define CLASS_BYTES(size, count)    + (size) * (count)
+#define CLASS_BLOCKS(size, count)   + (count)
+#define CLASS_ONE(size, count)      + 1
+
+static const uint32_t class_size[BLOCK_POOL_CLASSES] = { BLOCK_POOL_CLASS_TABLE(CLASS_SIZE) };
+static const uint32_t class_count[BLOCK_POOL_CLASSES] = { BLOCK_POOL_CLASS_TABLE(CLASS_COUNT) };
+
+#define ARENA_SIZE   (0 BLOCK_POOL_CLASS_TABLE(CLASS_BYTES))
+#define TOTAL_BLOCKS (0 BLOCK_POOL_CLASS_TABLE(CLASS_BLOCKS))
+
+_Static_assert((0 BLOCK_POOL_CLASS_TABLE(CLASS_ONE)) == BLOCK_POOL_CLASSES,
+               "BLOCK_POOL_CLASSES must match BLOCK_POOL_CLASS_TABLE");
+
+static uint8_t arena[ARENA_SIZE] __attribute__((aligned(8)));
+
+// Free stack of one class. `head` packs a 16-bit change counter over the
+// index + 1 of the top block (0 = empty); the counter makes a pop that read
+// a stale `next` fail its compare-and-swap (ABA). Blocks never handed out
+// yet are taken from `fresh`, so no initialisation pass is needed.
+typedef struct {
+    uint32_t head;
+    uint32_t fresh;
+    uint32_t in_use;
+    uint32_t high_water;
+    uint32_t allocs;
+    uint32_t exhausted;
+} pool_class_t;
+
+static pool_class_t classes[BLOCK_POOL_CLASSES];
+static uint16_t next_free[TOTAL_BLOCKS];       // Per block: index + 1 of the block below it
+static uint32_t heap_allocs;
+static uint32_t heap_in_use;
+
+// Byte offset in the arena and first next_free slot of a class
+static void class_base(int c, uint32_t *offset, uint32_t *first)
+{
+    *offset = 0;
+    *first = 0;
+    for (int i = 0; i < c; i++) {
+        *offset += class_size[i] * class_count[i];
+        *first += class_count[i];
+    }
+}
+
+static int pop_block(int c, uint32_t first)
+{
+    pool_class_t *pc = &classes[c];
+    uint32_t old = __atomic_load_n(&pc->head, __ATOMIC_ACQUIRE);
+    while ((old & 0xFFFF) != 0) {
+        uint32_t idx = (old & 0xFFFF) - 1;
+        uint32_t next = __atomic_load_n(&next_free[first + idx], __ATOMIC_RELAXED);
+        uint32_t desired = (((old >> 16) + 1) << 16) | next;
+        if (__atomic_compare_exchange_n(&pc->head, &old, desired, true,
+                                        __ATOMIC_ACQUIRE, __ATOMIC_ACQUIRE)) {
+            return (int)idx;
+        }
+    }
+
+    uint32_t fresh = __atomic_load_n(&pc->fresh, __ATOMIC_RELAXED);
+    while (fresh < class_count[c]) {
+        if (__atomic_compare_exchange_n(&pc->fresh, &fresh, fresh + 1, true,
+                                        __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+            return (int)fresh;
+        }
+    }
+    return -1;
+}
+
+static void push_block(int c, uint32_t first, uint32_t idx)
+{
+    pool_class_t *pc = &classes[c];
+    uint32_t old = __atomic_load_n(&pc->head, __ATOMIC_RELAXED);
+    uint32_t desired;
+    do {
+        __atomic_store_n(&next_free[first + idx], (uint16_t)(old & 0xFFFF), __ATOMIC_RELAXED);
+        desired = (((old >> 16) + 1) << 16) | (idx + 1);
+    } while (!__atomic_compare_exchange_n(&pc->head, &old, desired, true,
+                                          __ATOMIC_RELEASE, __ATOMIC_RELAXED));
+}
+
+void *block_pool_alloc(size_t size)
+{
+    if (size == 0) {
+        return NULL;
+    }
+
+    bool fits = false;
+    for (int c = 0; c < BLOCK_POOL_CLASSES; c++) {
+        if (size > class_size[c]) {
+            continue;
+        }
+        pool_class_t *pc = &classes[c];
+        if (!fits) {
+            // Counted once, in the smallest class the request fits
+            fits = true;
+            __atomic_fetch_add(&pc->allocs, 1, __ATOMIC_RELAXED);
+        }
+        uint32_t offset, first;
+        class_base(c, &offset, &first);
+        int idx = pop_block(c, first);
+        if (idx < 0) {
+            // Next larger class
+            __atomic_fetch_add(&pc->exhausted, 1, __ATOMIC_RELAXED);
+            continue;
+        }
+
+        uint32_t used = __atomic_add_fetch(&pc->in_use, 1, __ATOMIC_RELAXED);
+        uint32_t high = __atomic_load_n(&pc->high_water, __ATOMIC_RELAXED);
+        while (used > high &&
+               !__atomic_compare_exchange_n(&pc->high_water, &high, used, true,
+                                            __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+        }
+        return &arena[offset + (uint32_t)idx * class_size[c]];
+    }
+
+    void *p = malloc(size);
+    if (p != NULL) {
+        __atomic_fetch_add(&heap_allocs, 1, __ATOMIC_RELAXED);
+        __atomic_fetch_add(&heap_in_use, 1, __ATOMIC_RELAXED);
+    }
+    return p;
+}
+
+bool block_pool_owns(const void *ptr)
+{
+    const uint8_t *p = (const uint8_t *)ptr;
+    return p >= arena && p < arena + ARENA_SIZE;
+}
+
+void block_pool_free(void *ptr)
+{
+    if (ptr == NULL) {
+        return;
+    }
+    if (!block_pool_owns(ptr)) {
+        __atomic_fetch_sub(&heap_in_use, 1, __ATOMIC_RELAXED);
+        free(ptr);
+        return;
+    }
+
+    uint32_t at = (uint32_t)((uint8_t *)ptr - arena);
+    uint32_t offset = 0, first = 0;
+    for (int c = 0; c < BLOCK_POOL_CLASSES; c++) {
+        uint32_t span = class_size[c] * class_count[c];
+        if (at < offset + span) {
+            uint32_t rel = at - offset;
+            if (rel % class_size[c] != 0) {
+                return;     // Not a block start: ignore rather than corrupt the stack
+            }
+            push_block(c, first, rel / class_size[c]);
+            __atomic_fetch_sub(&classes[c].in_use, 1, __ATOMIC_RELAXED);
+            return;
+        }
+        offset += span;
+        first += class_count[c];
+    }
+}
+
+void block_pool_get_stats(block_pool_stats_t *stats)
+{
+    if (stats == NULL) {
+        return;
+    }
+    for (int c = 0; c < BLOCK_POOL_CLASSES; c++) {
+        block_pool_class_stats_t *s = &stats->classes[c];
+        s->block_size = class_size[c];
+        s->blocks = class_count[c];
+        s->in_use = __atomic_load_n(&classes[c].in_use, __ATOMIC_RELAXED);
+        s->high_water = __atomic_load_n(&classes[c].high_water, __ATOMIC_RELAXED);
+        s->allocs = __atomic_load_n(&classes[c].allocs, __ATOMIC_RELAXED);
+        s->exhausted = __atomic_load_n(&classes[c].exhausted, __ATOMIC_RELAXED);
+    }
+    stats->heap_allocs = __atomic_load_n(&heap_allocs, __ATOMIC_RELAXED);
+    stats->heap_in_use = __atomic_load_n(&heap_in_use, __ATOMIC_RELAXED);
+}
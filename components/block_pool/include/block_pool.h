@@ -0,0 +1,72 @@
+#ifndef BLOCK_POOL_H
+#define BLOCK_POOL_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Fixed-block allocator for small, short-lived payloads (background jobs,
+ * NVS operations).
+ *
+ * A static arena is split into a few size classes; each class keeps its
+ * free blocks on a lock-free stack, so allocation and free are O(1), never
+ * fragment the heap and may be called from any task or core. A request
+ * that fits no class, or finds its class and the larger ones empty, falls
+ * back to malloc() and is counted; block_pool_free() recognises both.
+ *
+ * Only the C standard library and GCC atomics are used so the pool also
+ * builds on a host (test/host/test_block_pool.c).
+ */
+
+// Block size and count of each class, smallest first (sizes multiple of 8).
+// The /tasks page reports the high-water mark of each class for sizing.
+#define BLOCK_POOL_CLASS_TABLE(X) \
+    X(64, 16)                     \
+    X(256, 8)                     \
+    X(1024, 4)
+
+#define BLOCK_POOL_CLASSES          3
+
+typedef struct {
+    uint32_t block_size;
+    uint32_t blocks;
+    uint32_t in_use;
+    uint32_t high_water;        // Most blocks in use at once since boot
+    uint32_t allocs;
+    uint32_t exhausted;         // Requests of this size that found the class empty
+} block_pool_class_stats_t;
+
+typedef struct {
+    block_pool_class_stats_t classes[BLOCK_POOL_CLASSES];
+    uint32_t heap_allocs;       // Served by malloc(): too large or all classes empty
+    uint32_t heap_in_use;
+} block_pool_stats_t;
+
+/**
+ * @brief Allocates a block of at least `size` bytes, 8-byte aligned.
+ * @return NULL only if the heap fallback fails too (or size == 0)
+ */
+void *block_pool_alloc(size_t size);
+
+/**
+ * @brief Returns a block from block_pool_alloc(). NULL is ignored.
+ */
+void block_pool_free(void *ptr);
+
+/**
+ * @brief True if `ptr` lies in the static arena (not a heap fallback).
+ */
+bool block_pool_owns(const void *ptr);
+
+void block_pool_get_stats(block_pool_stats_t *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // BLOCK_POOL_H
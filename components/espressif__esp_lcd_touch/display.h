@@ -24,6 +24,7 @@
 #include "esp_rom_sys.h"
 #include "lvgl.h"
 #include "ui/ui.h"
+#include "include/boot_trace.h"
 
 #define I2C_MASTER_SCL_IO           9       /*!< GPIO number used for I2C master clock */
 #define I2C_MASTER_SDA_IO           8       /*!< GPIO number used for I2C master data  */
@@ -84,6 +85,7 @@ static const char *DISPLAY_TAG = "example";
 #define EXAMPLE_LVGL_TASK_PRIORITY     2
 
 static SemaphoreHandle_t lvgl_mux = NULL;
+static lv_disp_t *display_disp = NULL;
 
 // we use two semaphores to sync the VSYNC event and the LVGL task, to avoid potential tearing effect
 #if CONFIG_EXAMPLE_AVOID_TEAR_EFFECT_WITH_SEM
@@ -118,6 +120,12 @@ static void example_lvgl_flush_cb(lv_disp_drv_t *drv, const lv_area_t *area, lv_
     // pass the draw buffer to the driver
     esp_lcd_panel_draw_bitmap(panel_handle, offsetx1, offsety1, offsetx2 + 1, offsety2 + 1, color_map);
     lv_disp_flush_ready(drv);
+
+    static bool first_frame = true;
+    if (first_frame) {
+        first_frame = false;
+        boot_trace_mark("first_frame");
+    }
 }
 
 static void example_increase_lvgl_tick(void *arg)
@@ -217,7 +225,11 @@ static void example_lvgl_touch_cb(lv_indev_drv_t * drv, lv_indev_data_t * data)
         data->state = LV_INDEV_STATE_REL;
     }
 }
-void display(void)
+/**
+ * @brief RGB panel, LVGL and the UI screens. The gauges are drawn as soon
+ *        as this returns; touch input is added by display_touch_init().
+ */
+void display_panel_init(void)
 {
     static lv_disp_draw_buf_t disp_buf; // contains internal graphic buffer(s) called draw buffer(s)
     static lv_disp_drv_t disp_drv;      // contains callback functions
@@ -304,9 +316,10 @@ void display(void)
     gpio_set_level(EXAMPLE_PIN_NUM_BK_LIGHT, EXAMPLE_LCD_BK_LIGHT_ON_LEVEL);
 #endif
 
+    // IO expander: the first step of the touch reset (touch held in reset).
+    // It also switches on the panel, so it is done here, ahead of the UI.
     ESP_ERROR_CHECK(i2c_master_init());
     ESP_LOGI(DISPLAY_TAG, "I2C initialized successfully");
-    gpio_init();
 
     uint8_t write_buf = 0x01;
     i2c_master_write_to_device(I2C_MASTER_NUM, 0x24, &write_buf, 1, I2C_MASTER_TIMEOUT_MS / portTICK_PERIOD_MS);
@@ -314,39 +327,6 @@ void display(void)
     //Reset the touch screen. It is recommended that you reset the touch screen before using it.
     write_buf = 0x2C;
     i2c_master_write_to_device(I2C_MASTER_NUM, 0x38, &write_buf, 1, I2C_MASTER_TIMEOUT_MS / portTICK_PERIOD_MS);
-    esp_rom_delay_us(100 * 1000);
-
-    gpio_set_level(GPIO_INPUT_IO_4,0);
-    esp_rom_delay_us(100 * 1000);
-
-    write_buf = 0x2E;
-    i2c_master_write_to_device(I2C_MASTER_NUM, 0x38, &write_buf, 1, I2C_MASTER_TIMEOUT_MS / portTICK_PERIOD_MS);
-    esp_rom_delay_us(200 * 1000);
-    
-    esp_lcd_touch_handle_t tp = NULL;
-    esp_lcd_panel_io_handle_t tp_io_handle = NULL;
-
-    ESP_LOGI(DISPLAY_TAG, "Initialize I2C");
-
-    esp_lcd_panel_io_i2c_config_t tp_io_config = ESP_LCD_TOUCH_IO_I2C_GT911_CONFIG();
-
-    ESP_LOGI(DISPLAY_TAG, "Initialize touch IO (I2C)");
-    /* Touch IO handle */
-    ESP_ERROR_CHECK(esp_lcd_new_panel_io_i2c((esp_lcd_i2c_bus_handle_t)I2C_MASTER_NUM, &tp_io_config, &tp_io_handle));
-    esp_lcd_touch_config_t tp_cfg = {
-        .x_max = EXAMPLE_LCD_V_RES,
-        .y_max = EXAMPLE_LCD_H_RES,
-        .rst_gpio_num = -1,
-        .int_gpio_num = -1,
-        .flags = {
-            .swap_xy = 0,
-            .mirror_x = 0,
-            .mirror_y = 0,
-        },
-    };
-    /* Initialize touch */
-    ESP_LOGI(DISPLAY_TAG, "Initialize touch controller GT911");
-    ESP_ERROR_CHECK(esp_lcd_touch_new_i2c_gt911(tp_io_handle, &tp_cfg, &tp));
 
     ESP_LOGI(DISPLAY_TAG, "Initialize LVGL library");
     lv_init();
@@ -375,7 +355,7 @@ void display(void)
 #if CONFIG_EXAMPLE_DOUBLE_FB
     disp_drv.full_refresh = true; // the full_refresh mode can maintain the synchronization between the two frame buffers
 #endif
-    lv_disp_t *disp = lv_disp_drv_register(&disp_drv);
+    display_disp = lv_disp_drv_register(&disp_drv);
 
     ESP_LOGI(DISPLAY_TAG, "Install LVGL tick timer");
     // Tick interface for LVGL (using esp_timer to generate 2ms periodic event)
@@ -384,15 +364,6 @@ void display(void)
         .name = "lvgl_tick"
     };
 
-    static lv_indev_drv_t indev_drv;    // Input device driver (Touch)
-    lv_indev_drv_init(&indev_drv);
-    indev_drv.type = LV_INDEV_TYPE_POINTER;
-    indev_drv.disp = disp;
-    indev_drv.read_cb = example_lvgl_touch_cb;
-    indev_drv.user_data = tp;
-
-    lv_indev_drv_register(&indev_drv);
-
     esp_timer_handle_t lvgl_tick_timer = NULL;
     ESP_ERROR_CHECK(esp_timer_create(&lvgl_tick_timer_args, &lvgl_tick_timer));
     ESP_ERROR_CHECK(esp_timer_start_periodic(lvgl_tick_timer, EXAMPLE_LVGL_TICK_PERIOD_MS * 1000));
@@ -416,3 +387,68 @@ void display(void)
         example_lvgl_unlock();
     }
 }
+
+/**
+ * @brief GT911 touch controller and its LVGL input device. The rest of the
+ *        reset sequence waits 400 ms; the waits block only this task.
+ *        Drives GPIO 4, which is also the SD card CS: call after sd_card_init().
+ */
+void display_touch_init(void)
+{
+    // Touch reset continues from the IO expander state set by display_panel_init()
+    gpio_init();
+    vTaskDelay(pdMS_TO_TICKS(100));
+
+    uint8_t write_buf;
+
+    gpio_set_level(GPIO_INPUT_IO_4,0);
+    vTaskDelay(pdMS_TO_TICKS(100));
+
+    write_buf = 0x2E;
+    i2c_master_write_to_device(I2C_MASTER_NUM, 0x38, &write_buf, 1, I2C_MASTER_TIMEOUT_MS / portTICK_PERIOD_MS);
+    vTaskDelay(pdMS_TO_TICKS(200));
+    
+    esp_lcd_touch_handle_t tp = NULL;
+    esp_lcd_panel_io_handle_t tp_io_handle = NULL;
+
+    ESP_LOGI(DISPLAY_TAG, "Initialize I2C");
+
+    esp_lcd_panel_io_i2c_config_t tp_io_config = ESP_LCD_TOUCH_IO_I2C_GT911_CONFIG();
+
+    ESP_LOGI(DISPLAY_TAG, "Initialize touch IO (I2C)");
+    /* Touch IO handle */
+    ESP_ERROR_CHECK(esp_lcd_new_panel_io_i2c((esp_lcd_i2c_bus_handle_t)I2C_MASTER_NUM, &tp_io_config, &tp_io_handle));
+    esp_lcd_touch_config_t tp_cfg = {
+        .x_max = EXAMPLE_LCD_V_RES,
+        .y_max = EXAMPLE_LCD_H_RES,
+        .rst_gpio_num = -1,
+        .int_gpio_num = -1,
+        .flags = {
+            .swap_xy = 0,
+            .mirror_x = 0,
+            .mirror_y = 0,
+        },
+    };
+    /* Initialize touch */
+    ESP_LOGI(DISPLAY_TAG, "Initialize touch controller GT911");
+    ESP_ERROR_CHECK(esp_lcd_touch_new_i2c_gt911(tp_io_handle, &tp_cfg, &tp));
+
+    static lv_indev_drv_t indev_drv;    // Input device driver (Touch)
+    lv_indev_drv_init(&indev_drv);
+    indev_drv.type = LV_INDEV_TYPE_POINTER;
+    indev_drv.disp = display_disp;
+    indev_drv.read_cb = example_lvgl_touch_cb;
+    indev_drv.user_data = tp;
+
+    // The LVGL task is already running
+    if (example_lvgl_lock(-1)) {
+        lv_indev_drv_register(&indev_drv);
+        example_lvgl_unlock();
+    }
+}
+
+void display(void)
+{
+    display_panel_init();
+    display_touch_init();
+}
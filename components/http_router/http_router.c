@@ -0,0 +1,362 @@
+/*
+ * HTTP Router for ECU Dashboard
+ * One esp_http_server instance shared by every module that serves HTTP
+ */
+
+#include "http_router.h"
+#include <string.h>
+#include <unistd.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "esp_timer.h"
+#include "esp_log.h"
+
+static const char *TAG = "HTTP_ROUTER";
+
+typedef struct {
+    httpd_uri_t uri;                // As given by the module
+    bool used;
+} route_t;
+
+typedef struct {
+    int fd;                         // -1 = free
+    int64_t last_used_us;
+    bool stream;
+} session_t;
+
+static route_t routes[HTTP_ROUTER_MAX_ROUTES];
+static session_t sessions[HTTP_ROUTER_MAX_SESSIONS] = {
+    [0 ... HTTP_ROUTER_MAX_SESSIONS - 1] = { .fd = -1 }
+};
+static http_router_close_hook_t close_hooks[HTTP_ROUTER_MAX_CLOSE_HOOKS];
+static http_router_stats_t stats;
+static httpd_handle_t server = NULL;
+
+// Sessions, hooks and counters; taken from the server task and from senders
+static portMUX_TYPE router_lock = portMUX_INITIALIZER_UNLOCKED;
+
+// Routes and the server handle. Boot stages register routes in parallel
+// with the start, so the table and the server change under one mutex.
+static StaticSemaphore_t route_mutex_buf;
+static SemaphoreHandle_t route_mutex = NULL;
+
+static void routes_lock(void)
+{
+    portENTER_CRITICAL(&router_lock);
+    if (route_mutex == NULL) {
+        route_mutex = xSemaphoreCreateMutexStatic(&route_mutex_buf);
+    }
+    portEXIT_CRITICAL(&router_lock);
+    xSemaphoreTake(route_mutex, portMAX_DELAY);
+}
+
+static void routes_unlock(void)
+{
+    xSemaphoreGive(route_mutex);
+}
+
+// ============================================================================
+// SESSIONS
+// ============================================================================
+
+static session_t *session_find(int fd)
+{
+    for (int i = 0; i < HTTP_ROUTER_MAX_SESSIONS; i++) {
+        if (sessions[i].fd == fd) {
+            return &sessions[i];
+        }
+    }
+    return NULL;
+}
+
+// A new session took the last free one: close the least recently used
+// session without a stream so the next connection is accepted at once
+static esp_err_t router_open(httpd_handle_t hd, int sockfd)
+{
+    int64_t now = esp_timer_get_time();
+    int victim = -1;
+
+    portENTER_CRITICAL(&router_lock);
+    session_t *s = session_find(-1);
+    if (s != NULL) {
+        s->fd = sockfd;
+        s->last_used_us = now;
+        s->stream = false;
+        stats.sessions++;
+        if (stats.sessions > stats.max_sessions) {
+            stats.max_sessions = stats.sessions;
+        }
+    }
+    if (stats.sessions >= HTTP_ROUTER_MAX_SESSIONS) {
+        int64_t oldest = INT64_MAX;
+        for (int i = 0; i < HTTP_ROUTER_MAX_SESSIONS; i++) {
+            const session_t *c = &sessions[i];
+            if (c->fd >= 0 && c->fd != sockfd && !c->stream && c->last_used_us < oldest) {
+                oldest = c->last_used_us;
+                victim = c->fd;
+            }
+        }
+        if (victim >= 0) {
+            stats.purged++;
+        }
+    }
+    portEXIT_CRITICAL(&router_lock);
+
+    if (victim >= 0) {
+        ESP_LOGD(TAG, "Sessions full, closing idle fd %d", victim);
+        httpd_sess_trigger_close(hd, victim);
+    }
+    return ESP_OK;
+}
+
+static void router_close(httpd_handle_t hd, int sockfd)
+{
+    http_router_close_hook_t hooks[HTTP_ROUTER_MAX_CLOSE_HOOKS];
+    portENTER_CRITICAL(&router_lock);
+    memcpy(hooks, close_hooks, sizeof(hooks));
+    portEXIT_CRITICAL(&router_lock);
+
+    for (int i = 0; i < HTTP_ROUTER_MAX_CLOSE_HOOKS && hooks[i] != NULL; i++) {
+        hooks[i](sockfd);
+    }
+
+    portENTER_CRITICAL(&router_lock);
+    session_t *s = session_find(sockfd);
+    if (s != NULL) {
+        if (s->stream) {
+            stats.streams--;
+        }
+        s->fd = -1;
+        stats.sessions--;
+    }
+    portEXIT_CRITICAL(&router_lock);
+
+    close(sockfd);
+}
+
+// Every route goes through here: the session counts as used, and the
+// module's handler gets its own user_ctx back
+static esp_err_t router_dispatch(httpd_req_t *req)
+{
+    const route_t *route = (const route_t *)req->user_ctx;
+    int fd = httpd_req_to_sockfd(req);
+
+    portENTER_CRITICAL(&router_lock);
+    session_t *s = session_find(fd);
+    if (s != NULL) {
+        s->last_used_us = esp_timer_get_time();
+    }
+    stats.requests++;
+    portEXIT_CRITICAL(&router_lock);
+
+    req->user_ctx = route->uri.user_ctx;
+    return route->uri.handler(req);
+}
+
+esp_err_t http_router_stream_begin(int sockfd)
+{
+    esp_err_t ret = ESP_OK;
+    portENTER_CRITICAL(&router_lock);
+    session_t *s = session_find(sockfd);
+    if (s == NULL) {
+        ret = ESP_ERR_NOT_FOUND;
+    } else if (!s->stream) {
+        if (stats.streams >= CONFIG_HTTP_ROUTER_MAX_STREAMS) {
+            stats.stream_rejects++;
+            ret = ESP_ERR_NO_MEM;
+        } else {
+            s->stream = true;
+            stats.streams++;
+        }
+    }
+    portEXIT_CRITICAL(&router_lock);
+    return ret;
+}
+
+void http_router_stream_end(int sockfd)
+{
+    portENTER_CRITICAL(&router_lock);
+    session_t *s = session_find(sockfd);
+    if (s != NULL && s->stream) {
+        s->stream = false;
+        s->last_used_us = esp_timer_get_time();
+        stats.streams--;
+    }
+    portEXIT_CRITICAL(&router_lock);
+}
+
+esp_err_t http_router_add_close_hook(http_router_close_hook_t hook)
+{
+    esp_err_t ret = ESP_ERR_NO_MEM;
+    portENTER_CRITICAL(&router_lock);
+    for (int i = 0; i < HTTP_ROUTER_MAX_CLOSE_HOOKS; i++) {
+        if (close_hooks[i] == hook) {
+            ret = ESP_OK;
+            break;
+        }
+        if (close_hooks[i] == NULL) {
+            close_hooks[i] = hook;
+            ret = ESP_OK;
+            break;
+        }
+    }
+    portEXIT_CRITICAL(&router_lock);
+    return ret;
+}
+
+// ============================================================================
+// ROUTES
+// ============================================================================
+
+static esp_err_t route_install(route_t *route)
+{
+    httpd_uri_t uri = route->uri;
+    uri.handler = router_dispatch;
+    uri.user_ctx = route;
+    esp_err_t ret = httpd_register_uri_handler(server, &uri);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to register %s: %s", route->uri.uri, esp_err_to_name(ret));
+    }
+    return ret;
+}
+
+esp_err_t http_router_register(const httpd_uri_t *uri)
+{
+    if (uri == NULL || uri->uri == NULL || uri->handler == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    routes_lock();
+    route_t *free_route = NULL;
+    for (int i = 0; i < HTTP_ROUTER_MAX_ROUTES; i++) {
+        route_t *r = &routes[i];
+        if (!r->used) {
+            if (free_route == NULL) {
+                free_route = r;
+            }
+        } else if (r->uri.method == uri->method && strcmp(r->uri.uri, uri->uri) == 0) {
+            routes_unlock();
+            ESP_LOGE(TAG, "%s is already routed", uri->uri);
+            return ESP_ERR_INVALID_STATE;
+        }
+    }
+    if (free_route == NULL) {
+        routes_unlock();
+        ESP_LOGE(TAG, "No room for route %s", uri->uri);
+        return ESP_ERR_NO_MEM;
+    }
+
+    free_route->uri = *uri;
+    free_route->used = true;
+    esp_err_t ret = ESP_OK;
+    if (server != NULL) {
+        ret = route_install(free_route);
+        if (ret != ESP_OK) {
+            free_route->used = false;
+        }
+    }
+    routes_unlock();
+    return ret;
+}
+
+esp_err_t http_router_unregister(const char *uri, httpd_method_t method)
+{
+    if (uri == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    esp_err_t ret = ESP_ERR_NOT_FOUND;
+    routes_lock();
+    for (int i = 0; i < HTTP_ROUTER_MAX_ROUTES; i++) {
+        route_t *r = &routes[i];
+        if (r->used && r->uri.method == method && strcmp(r->uri.uri, uri) == 0) {
+            if (server != NULL) {
+                httpd_unregister_uri_handler(server, uri, method);
+            }
+            r->used = false;
+            ret = ESP_OK;
+            break;
+        }
+    }
+    routes_unlock();
+    return ret;
+}
+
+// ============================================================================
+// SERVER
+// ============================================================================
+
+esp_err_t http_router_start(void)
+{
+    routes_lock();
+    if (server != NULL) {
+        routes_unlock();
+        return ESP_OK;
+    }
+
+    httpd_config_t config = HTTPD_DEFAULT_CONFIG();
+    config.server_port = HTTP_ROUTER_PORT;
+    config.max_open_sockets = HTTP_ROUTER_MAX_SESSIONS;
+    config.max_uri_handlers = HTTP_ROUTER_MAX_ROUTES;
+    // "/logs/*" serves any file name; exact URIs still match exactly
+    config.uri_match_fn = httpd_uri_match_wildcard;
+    // router_open() purges instead, sparing the streams
+    config.lru_purge_enable = false;
+    config.open_fn = router_open;
+    config.close_fn = router_close;
+
+    ESP_LOGI(TAG, "Starting HTTP server on port %d, %d sessions, %d for streams",
+             config.server_port, config.max_open_sockets, CONFIG_HTTP_ROUTER_MAX_STREAMS);
+
+    esp_err_t ret = httpd_start(&server, &config);
+    if (ret != ESP_OK) {
+        server = NULL;
+        routes_unlock();
+        ESP_LOGE(TAG, "Error starting HTTP server: %s", esp_err_to_name(ret));
+        return ret;
+    }
+
+    for (int i = 0; i < HTTP_ROUTER_MAX_ROUTES; i++) {
+        if (routes[i].used && route_install(&routes[i]) != ESP_OK) {
+            routes[i].used = false;
+        }
+    }
+    routes_unlock();
+    return ESP_OK;
+}
+
+void http_router_stop(void)
+{
+    routes_lock();
+    if (server != NULL) {
+        // Routes stay in the table for the next start
+        httpd_stop(server);
+        server = NULL;
+    }
+    routes_unlock();
+}
+
+httpd_handle_t http_router_handle(void)
+{
+    return server;
+}
+
+void http_router_get_stats(http_router_stats_t *out)
+{
+    if (out == NULL) {
+        return;
+    }
+    uint32_t count = 0;
+    routes_lock();
+    for (int i = 0; i < HTTP_ROUTER_MAX_ROUTES; i++) {
+        if (routes[i].used) {
+            count++;
+        }
+    }
+    routes_unlock();
+
+    portENTER_CRITICAL(&router_lock);
+    *out = stats;
+    portEXIT_CRITICAL(&router_lock);
+    out->routes = count;
+}
@@ -0,0 +1,103 @@
+/*
+ * HTTP Router for ECU Dashboard
+ * One esp_http_server instance shared by every module that serves HTTP
+ *
+ * Modules add their URIs to the routing table with http_router_register(),
+ * before or after http_router_start(); routes added early are registered
+ * when the server starts. All routes share one server task, one control
+ * socket and one pool of sessions.
+ *
+ * Sessions are budgeted instead of purged blindly:
+ *   - Long-lived responses (WebSocket clients, event streams, file
+ *     downloads) claim a stream slot with http_router_stream_begin().
+ *     At most CONFIG_HTTP_ROUTER_MAX_STREAMS sessions hold one, so the
+ *     rest of the pool always stays available for page and API requests.
+ *   - When the last free session is taken, the least recently used session
+ *     that holds no stream slot is closed, so the next browser connection
+ *     is accepted at once. Streams are never purged.
+ *
+ * Modules that keep per-session state add a close hook, which runs before
+ * the socket of any closed session is released.
+ */
+
+#ifndef HTTP_ROUTER_H
+#define HTTP_ROUTER_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "esp_err.h"
+#include "esp_http_server.h"
+#include "sdkconfig.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define HTTP_ROUTER_PORT            80
+#define HTTP_ROUTER_MAX_ROUTES      32
+#define HTTP_ROUTER_MAX_CLOSE_HOOKS 4
+
+// httpd needs three of the lwIP sockets for itself (listen, control, accept)
+#define HTTP_ROUTER_MAX_SESSIONS    (CONFIG_LWIP_MAX_SOCKETS - 3)
+
+#if CONFIG_HTTP_ROUTER_MAX_STREAMS >= HTTP_ROUTER_MAX_SESSIONS
+#error "CONFIG_HTTP_ROUTER_MAX_STREAMS must leave sessions for regular requests"
+#endif
+
+typedef void (*http_router_close_hook_t)(int sockfd);
+
+typedef struct {
+    uint32_t routes;
+    uint32_t sessions;              // Open now
+    uint32_t max_sessions;          // Most open at once since start
+    uint32_t streams;               // Sessions holding a stream slot
+    uint32_t stream_rejects;        // http_router_stream_begin() over budget
+    uint32_t purged;                // Idle sessions closed to make room
+    uint32_t requests;              // Handler calls, WebSocket frames included
+} http_router_stats_t;
+
+/**
+ * @brief Starts the shared server and registers the routes added so far.
+ *        Calling it again while running does nothing.
+ */
+esp_err_t http_router_start(void);
+
+void http_router_stop(void);
+
+/**
+ * @brief Server handle for the async send functions (NULL when stopped).
+ */
+httpd_handle_t http_router_handle(void);
+
+/**
+ * @brief Adds a route. Matching allows a trailing "*" wildcard.
+ *        The handler sees its own user_ctx in req->user_ctx.
+ * @return ESP_OK, ESP_ERR_INVALID_STATE if the URI and method are taken,
+ *         ESP_ERR_NO_MEM when the table is full
+ */
+esp_err_t http_router_register(const httpd_uri_t *uri);
+
+esp_err_t http_router_unregister(const char *uri, httpd_method_t method);
+
+/**
+ * @brief Runs for every closed session, before the socket is closed.
+ */
+esp_err_t http_router_add_close_hook(http_router_close_hook_t hook);
+
+/**
+ * @brief Claims a stream slot for a session that keeps its connection busy
+ *        long after the handler returned. Released by
+ *        http_router_stream_end() or when the session closes.
+ * @return ESP_OK, or ESP_ERR_NO_MEM when the stream budget is used up
+ */
+esp_err_t http_router_stream_begin(int sockfd);
+
+void http_router_stream_end(int sockfd);
+
+void http_router_get_stats(http_router_stats_t *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // HTTP_ROUTER_H
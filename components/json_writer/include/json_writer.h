@@ -0,0 +1,116 @@
+#ifndef JSON_WRITER_H
+#define JSON_WRITER_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "esp_err.h"
+#include "esp_http_server.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Maximum nesting of objects/arrays
+#define JSON_WRITER_MAX_DEPTH 16
+
+// Chunk buffer size used by the HTTP handlers (stack allocated)
+#define JSON_WRITER_CHUNK_SIZE 256
+
+/**
+ * @brief Receives a full chunk buffer, or the tail on json_writer_finish().
+ * @return ESP_OK to continue; any error aborts the document.
+ */
+typedef esp_err_t (*json_sink_t)(void *ctx, const char *data, size_t len);
+
+/**
+ * @brief Streaming JSON writer.
+ *
+ * Tokens are written straight into a caller-owned buffer (usually on the
+ * stack). With a sink the buffer is flushed whenever it fills, so the
+ * document size is unbounded; without one the writer fills the buffer once
+ * and reports ESP_ERR_INVALID_SIZE if the document does not fit. The writer
+ * never allocates. Commas between members are inserted automatically.
+ */
+typedef struct {
+    char *buf;
+    size_t cap;
+    size_t len;
+    json_sink_t sink;
+    void *sink_ctx;
+    uint8_t depth;
+    uint32_t has_items;         // Bit per depth: a member was already written
+    bool after_key;             // Next value belongs to the key just written
+    esp_err_t err;              // First error, sticky
+} json_writer_t;
+
+/**
+ * @brief Writer over a buffer, optionally flushed through a sink.
+ * @param sink May be NULL for a single fixed buffer (NUL-terminated output)
+ */
+void json_writer_init(json_writer_t *w, char *buf, size_t cap, json_sink_t sink, void *sink_ctx);
+
+/**
+ * @brief Writer that streams into an HTTP response with httpd_resp_send_chunk.
+ *        Sets the content type to application/json.
+ */
+void json_writer_init_httpd(json_writer_t *w, httpd_req_t *req, char *buf, size_t cap);
+
+/**
+ * @brief Flushes the remaining bytes. For httpd writers this also ends the
+ *        chunked response.
+ * @return ESP_OK or the first error met while writing
+ */
+esp_err_t json_writer_finish(json_writer_t *w);
+
+/**
+ * @brief Output of a sink-less writer (NUL-terminated).
+ */
+static inline const char *json_writer_str(const json_writer_t *w) { return w->buf; }
+
+void json_obj_begin(json_writer_t *w);
+void json_obj_end(json_writer_t *w);
+void json_arr_begin(json_writer_t *w);
+void json_arr_end(json_writer_t *w);
+
+/**
+ * @brief Member name inside an object. The key is escaped.
+ */
+void json_key(json_writer_t *w, const char *key);
+
+void json_str(json_writer_t *w, const char *s);
+void json_strn(json_writer_t *w, const char *s, size_t max_len);
+void json_int(json_writer_t *w, int64_t v);
+void json_uint(json_writer_t *w, uint64_t v);
+void json_bool(json_writer_t *w, bool v);
+void json_null(json_writer_t *w);
+
+/**
+ * @brief Fixed-point number: mantissa / 10^decimals (json_fixed(w, 1234, 1) -> 123.4).
+ */
+void json_fixed(json_writer_t *w, int64_t mantissa, uint8_t decimals);
+
+/**
+ * @brief Float rounded to `decimals` places through the fixed-point path,
+ *        with the same digits as printf("%.*f"). NaN and infinity are
+ *        written as null.
+ */
+void json_float(json_writer_t *w, float v, uint8_t decimals);
+
+/**
+ * @brief Pre-formatted JSON value written as-is.
+ */
+void json_raw(json_writer_t *w, const char *raw);
+
+// Object member shortcuts
+static inline void json_kv_str(json_writer_t *w, const char *k, const char *v) { json_key(w, k); json_str(w, v); }
+static inline void json_kv_int(json_writer_t *w, const char *k, int64_t v) { json_key(w, k); json_int(w, v); }
+static inline void json_kv_uint(json_writer_t *w, const char *k, uint64_t v) { json_key(w, k); json_uint(w, v); }
+static inline void json_kv_bool(json_writer_t *w, const char *k, bool v) { json_key(w, k); json_bool(w, v); }
+static inline void json_kv_float(json_writer_t *w, const char *k, float v, uint8_t d) { json_key(w, k); json_float(w, v, d); }
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // JSON_WRITER_H
@@ -0,0 +1,279 @@
+#include "json_writer.h"
+#include <string.h>
+#include <math.h>
+
+static const uint64_t pow10_table[] = {
+    1ULL, 10ULL, 100ULL, 1000ULL, 10000ULL, 100000ULL,
+    1000000ULL, 10000000ULL, 100000000ULL, 1000000000ULL
+};
+
+#define JSON_MAX_DECIMALS 9
+
+static void json_put(json_writer_t *w, const char *data, size_t n)
+{
+    while (n > 0 && w->err == ESP_OK) {
+        // Sink-less writers keep one byte for the terminating NUL
+        size_t room = w->cap - w->len - (w->sink ? 0 : 1);
+        if (room == 0) {
+            if (!w->sink) {
+                w->err = ESP_ERR_INVALID_SIZE;
+                return;
+            }
+            w->err = w->sink(w->sink_ctx, w->buf, w->len);
+            w->len = 0;
+            continue;
+        }
+        size_t take = n < room ? n : room;
+        memcpy(w->buf + w->len, data, take);
+        w->len += take;
+        data += take;
+        n -= take;
+    }
+}
+
+static inline void json_putc(json_writer_t *w, char c)
+{
+    if (w->len + (w->sink ? 0 : 1) < w->cap) {
+        w->buf[w->len++] = c;
+    } else {
+        json_put(w, &c, 1);
+    }
+}
+
+// Comma before every member except the first one of a container
+static void json_separator(json_writer_t *w)
+{
+    if (w->after_key) {
+        w->after_key = false;
+        return;
+    }
+    uint32_t bit = 1u << w->depth;
+    if (w->has_items & bit) {
+        json_putc(w, ',');
+    }
+    w->has_items |= bit;
+}
+
+static void json_put_u64(json_writer_t *w, uint64_t v)
+{
+    char tmp[20];
+    int i = sizeof(tmp);
+    do {
+        tmp[--i] = (char)('0' + (v % 10));
+        v /= 10;
+    } while (v);
+    json_put(w, tmp + i, sizeof(tmp) - i);
+}
+
+static void json_put_escaped(json_writer_t *w, const char *s, size_t max_len)
+{
+    static const char hex[] = "0123456789abcdef";
+
+    json_putc(w, '"');
+    const char *run = s;
+    size_t i = 0;
+    for (; i < max_len && s[i] != '\0'; i++) {
+        unsigned char c = (unsigned char)s[i];
+        if (c >= 0x20 && c != '"' && c != '\\') {
+            continue;
+        }
+        // Copy the clean run in one go, then the escape sequence
+        json_put(w, run, (s + i) - run);
+        run = s + i + 1;
+        switch (c) {
+            case '"':  json_put(w, "\\\"", 2); break;
+            case '\\': json_put(w, "\\\\", 2); break;
+            case '\n': json_put(w, "\\n", 2); break;
+            case '\r': json_put(w, "\\r", 2); break;
+            case '\t': json_put(w, "\\t", 2); break;
+            default: {
+                char esc[6] = { '\\', 'u', '0', '0', hex[c >> 4], hex[c & 0x0F] };
+                json_put(w, esc, sizeof(esc));
+                break;
+            }
+        }
+    }
+    json_put(w, run, (s + i) - run);
+    json_putc(w, '"');
+}
+
+void json_writer_init(json_writer_t *w, char *buf, size_t cap, json_sink_t sink, void *sink_ctx)
+{
+    memset(w, 0, sizeof(*w));
+    w->buf = buf;
+    w->cap = cap;
+    w->sink = sink;
+    w->sink_ctx = sink_ctx;
+    w->err = (buf && cap > 1) ? ESP_OK : ESP_ERR_INVALID_ARG;
+}
+
+static esp_err_t json_httpd_sink(void *ctx, const char *data, size_t len)
+{
+    return httpd_resp_send_chunk((httpd_req_t *)ctx, data, len);
+}
+
+void json_writer_init_httpd(json_writer_t *w, httpd_req_t *req, char *buf, size_t cap)
+{
+    json_writer_init(w, buf, cap, json_httpd_sink, req);
+    httpd_resp_set_type(req, "application/json");
+}
+
+esp_err_t json_writer_finish(json_writer_t *w)
+{
+    if (w->sink) {
+        if (w->err == ESP_OK && w->len > 0) {
+            w->err = w->sink(w->sink_ctx, w->buf, w->len);
+        }
+        w->len = 0;
+        if (w->sink == json_httpd_sink) {
+            // Zero-length chunk ends the response even after an error,
+            // so the client is not left waiting
+            esp_err_t end = httpd_resp_send_chunk((httpd_req_t *)w->sink_ctx, NULL, 0);
+            if (w->err == ESP_OK) {
+                w->err = end;
+            }
+        }
+    } else if (w->buf && w->cap > 0) {
+        w->buf[w->len < w->cap ? w->len : w->cap - 1] = '\0';
+    }
+    return w->err;
+}
+
+static void json_open(json_writer_t *w, char c)
+{
+    json_separator(w);
+    json_putc(w, c);
+    if (w->depth + 1 >= JSON_WRITER_MAX_DEPTH) {
+        w->err = ESP_ERR_INVALID_STATE;
+        return;
+    }
+    w->depth++;
+    w->has_items &= ~(1u << w->depth);
+}
+
+static void json_close(json_writer_t *w, char c)
+{
+    if (w->depth == 0) {
+        w->err = ESP_ERR_INVALID_STATE;
+        return;
+    }
+    w->depth--;
+    w->after_key = false;
+    json_putc(w, c);
+}
+
+void json_obj_begin(json_writer_t *w) { json_open(w, '{'); }
+void json_obj_end(json_writer_t *w)   { json_close(w, '}'); }
+void json_arr_begin(json_writer_t *w) { json_open(w, '['); }
+void json_arr_end(json_writer_t *w)   { json_close(w, ']'); }
+
+void json_key(json_writer_t *w, const char *key)
+{
+    json_separator(w);
+    json_put_escaped(w, key ? key : "", SIZE_MAX);
+    json_putc(w, ':');
+    w->after_key = true;
+}
+
+void json_str(json_writer_t *w, const char *s)
+{
+    json_strn(w, s, SIZE_MAX);
+}
+
+void json_strn(json_writer_t *w, const char *s, size_t max_len)
+{
+    if (!s) {
+        json_null(w);
+        return;
+    }
+    json_separator(w);
+    json_put_escaped(w, s, max_len);
+}
+
+void json_int(json_writer_t *w, int64_t v)
+{
+    json_separator(w);
+    if (v < 0) {
+        json_putc(w, '-');
+        json_put_u64(w, (uint64_t)0 - (uint64_t)v);
+    } else {
+        json_put_u64(w, (uint64_t)v);
+    }
+}
+
+void json_uint(json_writer_t *w, uint64_t v)
+{
+    json_separator(w);
+    json_put_u64(w, v);
+}
+
+void json_bool(json_writer_t *w, bool v)
+{
+    json_separator(w);
+    if (v) {
+        json_put(w, "true", 4);
+    } else {
+        json_put(w, "false", 5);
+    }
+}
+
+void json_null(json_writer_t *w)
+{
+    json_separator(w);
+    json_put(w, "null", 4);
+}
+
+void json_fixed(json_writer_t *w, int64_t mantissa, uint8_t decimals)
+{
+    if (decimals > JSON_MAX_DECIMALS) {
+        decimals = JSON_MAX_DECIMALS;
+    }
+    json_separator(w);
+
+    uint64_t abs = (mantissa < 0) ? (uint64_t)0 - (uint64_t)mantissa : (uint64_t)mantissa;
+    if (mantissa < 0) {
+        json_putc(w, '-');
+    }
+    if (decimals == 0) {
+        json_put_u64(w, abs);
+        return;
+    }
+
+    uint64_t scale = pow10_table[decimals];
+    json_put_u64(w, abs / scale);
+
+    // Fractional part, zero-padded to the requested width
+    char frac[JSON_MAX_DECIMALS + 1];
+    uint64_t f = abs % scale;
+    frac[0] = '.';
+    for (int i = decimals; i > 0; i--) {
+        frac[i] = (char)('0' + (f % 10));
+        f /= 10;
+    }
+    json_put(w, frac, decimals + 1);
+}
+
+void json_float(json_writer_t *w, float v, uint8_t decimals)
+{
+    if (decimals > JSON_MAX_DECIMALS) {
+        decimals = JSON_MAX_DECIMALS;
+    }
+    double scaled = (double)v * (double)pow10_table[decimals];
+    if (isnan(scaled) || isinf(scaled) || fabs(scaled) > 9.0e18) {
+        json_null(w);
+        return;
+    }
+    // rint(): exact ties go to even like printf("%.*f"), so replaced
+    // snprintf output stays byte-identical
+    json_fixed(w, (int64_t)rint(scaled), decimals);
+}
+
+void json_raw(json_writer_t *w, const char *raw)
+{
+    if (!raw) {
+        json_null(w);
+        return;
+    }
+    json_separator(w);
+    json_put(w, raw, strlen(raw));
+}
@@ -0,0 +1,55 @@
+#ifndef LZ4_BLOCK_H
+#define LZ4_BLOCK_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Minimal LZ4 block format codec (no frame format, no dictionary).
+ *
+ * Output is a standard LZ4 block, so anything that decodes LZ4 blocks
+ * (liblz4's LZ4_decompress_safe, the python lz4.block module, or the
+ * decoder in tools/canlog_convert.py) reads it. The compressor is a
+ * greedy single-probe matcher: much faster than the reference high
+ * compression modes and close to LZ4's default ratio on repetitive data.
+ *
+ * Only the C standard library is used so the codec builds on a host.
+ */
+
+// Largest input accepted by the compressor (match offsets are 16 bit)
+#define LZ4_BLOCK_MAX_INPUT         65535
+
+// Worst case output size for `n` input bytes
+#define LZ4_BLOCK_COMPRESS_BOUND(n) ((n) + (n) / 255 + 16)
+
+#define LZ4_BLOCK_HASH_BITS         12
+
+// Compressor scratch, kept by the caller so it can live in fast RAM
+typedef struct {
+    uint16_t table[1 << LZ4_BLOCK_HASH_BITS];
+} lz4_block_state_t;
+
+/**
+ * @brief Compresses `src_len` bytes into one LZ4 block.
+ * @return Compressed size, or -1 if it does not fit `dst_cap` or the input
+ *         is too large. Callers usually store the data uncompressed then.
+ */
+int lz4_block_compress(lz4_block_state_t *state, const uint8_t *src, size_t src_len,
+                       uint8_t *dst, size_t dst_cap);
+
+/**
+ * @brief Decompresses one LZ4 block. Never reads or writes out of bounds,
+ *        whatever the input.
+ * @return Decompressed size, or -1 for malformed input or a too small `dst`
+ */
+int lz4_block_decompress(const uint8_t *src, size_t src_len, uint8_t *dst, size_t dst_cap);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // LZ4_BLOCK_H
@@ -0,0 +1,202 @@
+#include "lz4_block.h"
+#include <string.h>
+
+#define MIN_MATCH       4
+#define LAST_LITERALS   5       // The block must end with at least 5 literals
+#define MF_LIMIT        12      // The last match starts at least 12 bytes before the end
+#define MAX_OFFSET      65535
+#define SKIP_TRIGGER    6       // Search step grows by 1 every 2^6 misses
+
+static inline uint32_t read32(const uint8_t *p)
+{
+    uint32_t v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+static inline uint32_t hash4(uint32_t v)
+{
+    return (v * 2654435761u) >> (32 - LZ4_BLOCK_HASH_BITS);
+}
+
+// Writes the 255-continued extra length of a literal or match run
+static uint8_t *put_length(uint8_t *op, size_t len)
+{
+    while (len >= 255) {
+        *op++ = 255;
+        len -= 255;
+    }
+    *op++ = (uint8_t)len;
+    return op;
+}
+
+/**
+ * @brief Emits one sequence: literals [anchor, anchor + lit_len) followed by
+ *        a match (match_len == 0 for the final literal-only sequence).
+ * @return NULL if it does not fit
+ */
+static uint8_t *put_sequence(uint8_t *op, const uint8_t *oend, const uint8_t *anchor,
+                             size_t lit_len, uint16_t offset, size_t match_len)
+{
+    // Token, literal length bytes, literals, offset, match length bytes
+    size_t need = 1 + (lit_len / 255 + 1) + lit_len + (match_len ? 2 + match_len / 255 + 1 : 0);
+    if ((size_t)(oend - op) < need) {
+        return NULL;
+    }
+
+    uint8_t *token = op++;
+    *token = (uint8_t)((lit_len >= 15 ? 15 : lit_len) << 4);
+    if (lit_len >= 15) {
+        op = put_length(op, lit_len - 15);
+    }
+    memcpy(op, anchor, lit_len);
+    op += lit_len;
+
+    if (match_len > 0) {
+        *op++ = (uint8_t)(offset & 0xFF);
+        *op++ = (uint8_t)(offset >> 8);
+        size_t ml = match_len - MIN_MATCH;
+        *token |= (uint8_t)(ml >= 15 ? 15 : ml);
+        if (ml >= 15) {
+            op = put_length(op, ml - 15);
+        }
+    }
+    return op;
+}
+
+int lz4_block_compress(lz4_block_state_t *state, const uint8_t *src, size_t src_len,
+                       uint8_t *dst, size_t dst_cap)
+{
+    if (state == NULL || src == NULL || dst == NULL || src_len > LZ4_BLOCK_MAX_INPUT) {
+        return -1;
+    }
+
+    const uint8_t *ip = src;
+    const uint8_t *anchor = src;
+    const uint8_t *iend = src + src_len;
+    uint8_t *op = dst;
+    const uint8_t *oend = dst + dst_cap;
+
+    if (src_len > MF_LIMIT) {
+        const uint8_t *mflimit = iend - MF_LIMIT;
+        const uint8_t *matchlimit = iend - LAST_LITERALS;
+        uint32_t misses = 0;
+
+        // Positions are relative to src; stale entries are rejected by the compare
+        memset(state->table, 0, sizeof(state->table));
+
+        while (ip < mflimit) {
+            uint32_t seq = read32(ip);
+            uint32_t h = hash4(seq);
+            const uint8_t *ref = src + state->table[h];
+            state->table[h] = (uint16_t)(ip - src);
+
+            if (ref >= ip || ip - ref > MAX_OFFSET || read32(ref) != seq) {
+                ip += 1 + (misses++ >> SKIP_TRIGGER);
+                continue;
+            }
+            misses = 0;
+
+            // Extend backwards over literals, then forwards
+            while (ip > anchor && ref > src && ip[-1] == ref[-1]) {
+                ip--;
+                ref--;
+            }
+            const uint8_t *mp = ip + MIN_MATCH;
+            const uint8_t *rp = ref + MIN_MATCH;
+            while (mp < matchlimit && *mp == *rp) {
+                mp++;
+                rp++;
+            }
+
+            op = put_sequence(op, oend, anchor, (size_t)(ip - anchor),
+                              (uint16_t)(ip - ref), (size_t)(mp - ip));
+            if (op == NULL) {
+                return -1;
+            }
+            ip = mp;
+            anchor = ip;
+
+            // Seed the table inside the match so the next one is found sooner
+            if (ip < mflimit) {
+                state->table[hash4(read32(ip - 2))] = (uint16_t)(ip - 2 - src);
+            }
+        }
+    }
+
+    op = put_sequence(op, oend, anchor, (size_t)(iend - anchor), 0, 0);
+    if (op == NULL) {
+        return -1;
+    }
+    return (int)(op - dst);
+}
+
+int lz4_block_decompress(const uint8_t *src, size_t src_len, uint8_t *dst, size_t dst_cap)
+{
+    if (src == NULL || dst == NULL) {
+        return -1;
+    }
+
+    const uint8_t *ip = src;
+    const uint8_t *iend = src + src_len;
+    uint8_t *op = dst;
+    uint8_t *oend = dst + dst_cap;
+
+    while (ip < iend) {
+        uint8_t token = *ip++;
+
+        size_t lit_len = token >> 4;
+        if (lit_len == 15) {
+            uint8_t b;
+            do {
+                if (ip >= iend) {
+                    return -1;
+                }
+                b = *ip++;
+                lit_len += b;
+            } while (b == 255);
+        }
+        if (lit_len > (size_t)(iend - ip) || lit_len > (size_t)(oend - op)) {
+            return -1;
+        }
+        memcpy(op, ip, lit_len);
+        ip += lit_len;
+        op += lit_len;
+
+        if (ip == iend) {
+            break;              // Last sequence: literals only
+        }
+
+        if (iend - ip < 2) {
+            return -1;
+        }
+        size_t offset = (size_t)ip[0] | ((size_t)ip[1] << 8);
+        ip += 2;
+        if (offset == 0 || offset > (size_t)(op - dst)) {
+            return -1;
+        }
+
+        size_t match_len = token & 0x0F;
+        if (match_len == 15) {
+            uint8_t b;
+            do {
+                if (ip >= iend) {
+                    return -1;
+                }
+                b = *ip++;
+                match_len += b;
+            } while (b == 255);
+        }
+        match_len += MIN_MATCH;
+        if (match_len > (size_t)(oend - op)) {
+            return -1;
+        }
+
+        // Byte copy: the match may overlap the bytes it produces
+        const uint8_t *ref = op - offset;
+        while (match_len--) {
+            *op++ = *ref++;
+        }
+    }
+    return (int)(op - dst);
+}
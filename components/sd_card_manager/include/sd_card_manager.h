@@ -3,8 +3,11 @@
 
 #include "esp_err.h"
 #include <stdbool.h>
+#include <stdint.h>
+#include <stddef.h>
 #include "freertos/FreeRTOS.h"
 #include "freertos/semphr.h"
+#include "freertos/task.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -59,6 +62,134 @@ void sd_card_set_can_trace_enabled(bool enabled);
  */
 bool sd_card_is_can_trace_enabled(void);
 
+/**
+ * @brief Creates a file of `size` bytes whose clusters are allocated up front
+ *        and contiguous, so later writes into it never touch the FAT.
+ *        An existing file at `path` is replaced.
+ *
+ * @param path Full path to the file (e.g., "/sdcard/CAN00001.BIN").
+ * @param size File size in bytes.
+ * @return ESP_OK on success, or an error code on failure (e.g. no contiguous space).
+ */
+esp_err_t sd_card_create_contiguous_file(const char* path, uint64_t size);
+
+/**
+ * @brief Write latency percentiles, in microseconds. Values are the upper
+ *        bound of a histogram bucket (buckets are 1/4 octave wide).
+ */
+typedef struct {
+    uint32_t count;
+    uint32_t p50_us;
+    uint32_t p90_us;
+    uint32_t p99_us;
+    uint32_t p999_us;
+    uint32_t max_us;
+} sd_card_latency_stats_t;
+
+/**
+ * @brief Adds one write duration to the latency histogram. The write
+ *        functions of this component record themselves; code that writes
+ *        through its own FILE handle (e.g. the CAN logger) reports here.
+ */
+void sd_card_record_write_latency(uint32_t duration_us);
+
+/**
+ * @brief Computes percentiles over all writes recorded since the last reset.
+ */
+void sd_card_get_write_latency(sd_card_latency_stats_t *stats);
+
+void sd_card_reset_write_latency(void);
+
+/*
+ * Asynchronous requests
+ *
+ * The functions above block their caller for as long as the card takes.
+ * Requests submitted here are served by one I/O task instead. The caller
+ * waits at most for a free queue slot, and learns the result from a
+ * callback (run in the I/O task, keep it short) or a task notification.
+ *
+ * The I/O task takes whatever is queued as one batch. Appends to the same
+ * file within a batch are written through a single open, so their order
+ * across files may change. Requests on the same file keep their order.
+ */
+
+#define SD_ASYNC_QUEUE_DEPTH    32
+#define SD_REQUEST_PATH_MAX     48
+
+typedef enum {
+    SD_REQUEST_WRITE = 0,       // Replace the file (offset < 0) or overwrite at offset
+    SD_REQUEST_APPEND,          // Append, creating the file if needed
+    SD_REQUEST_READ             // Read up to length bytes from offset
+} sd_request_op_t;
+
+typedef struct sd_request sd_request_t;
+
+typedef void (*sd_request_cb_t)(sd_request_t *req, void *arg);
+
+struct sd_request {
+    sd_request_op_t op;
+    char path[SD_REQUEST_PATH_MAX];
+    uint8_t *buffer;            // Source or destination, owned by the request until completion
+    size_t length;              // Bytes to write, or buffer capacity for reads
+    long offset;
+    sd_request_cb_t callback;   // Optional
+    void *callback_arg;
+    TaskHandle_t notify_task;   // Optional, receives xTaskNotifyGive() on completion
+    bool free_on_complete;      // The I/O task frees the request after the callback
+
+    // Filled in on completion
+    esp_err_t result;
+    size_t transferred;
+    uint32_t latency_us;        // Submission to completion
+
+    int64_t submit_us;          // Internal
+};
+
+typedef struct {
+    uint32_t submitted;
+    uint32_t completed;
+    uint32_t failed;            // Completed with an error
+    uint32_t rejected;          // Queue full within the caller's wait
+    uint32_t merged;            // Appends that shared the open of an earlier one
+    uint32_t queue_depth;       // Requests waiting now
+    uint32_t max_queue_depth;
+    sd_card_latency_stats_t latency;    // Submission to completion
+} sd_card_async_stats_t;
+
+/**
+ * @brief Allocates a request with a `length` byte buffer right after it.
+ *        Callbacks may release it with sd_request_free().
+ * @return NULL if out of memory or the path is too long
+ */
+sd_request_t *sd_request_create(sd_request_op_t op, const char *path, size_t length);
+
+void sd_request_free(sd_request_t *req);
+
+/**
+ * @brief Queues a request for the I/O task.
+ * @param wait Longest time to wait for a queue slot (0 from time-critical tasks)
+ * @return ESP_OK, ESP_ERR_TIMEOUT if the queue stayed full, or
+ *         ESP_ERR_INVALID_STATE without a mounted card. Requests still
+ *         queued when sd_card_deinit() stops the I/O task complete with
+ *         ESP_ERR_INVALID_STATE without being run.
+ */
+esp_err_t sd_card_submit(sd_request_t *req, TickType_t wait);
+
+/**
+ * @brief Copies `data` into a fire-and-forget append request.
+ *        Never waits for a queue slot.
+ */
+esp_err_t sd_card_append_async(const char *path, const void *data, size_t len);
+
+/**
+ * @brief Copies `data` into a request that replaces the file. The request
+ *        is freed after `callback` (may be NULL) has seen the result.
+ *        Never waits for a queue slot.
+ */
+esp_err_t sd_card_write_async(const char *path, const void *data, size_t len,
+                              sd_request_cb_t callback, void *arg);
+
+void sd_card_get_async_stats(sd_card_async_stats_t *stats);
 
 #ifdef __cplusplus
 }
@@ -9,6 +9,10 @@
 #include <sys/unistd.h>
 #include "freertos/FreeRTOS.h"
 #include "freertos/semphr.h"
+#include "freertos/queue.h"
+#include "freertos/task.h"
+#include "esp_timer.h"
+#include <stdlib.h>
 
 static const char *TAG = "SD_CARD";
 
@@ -23,9 +27,37 @@ static SemaphoreHandle_t sd_card_mutex = NULL;
 
 #define MOUNT_POINT "/sdcard"
 
+// Write latency histogram: 4 buckets per power of two, up to ~16 s
+#define LATENCY_SUB_BUCKETS     4
+#define LATENCY_MAX_OCTAVE      24
+#define LATENCY_BUCKETS         (LATENCY_SUB_BUCKETS * LATENCY_MAX_OCTAVE)
+
+typedef struct {
+    uint32_t hist[LATENCY_BUCKETS];
+    uint32_t count;
+    uint32_t max_us;
+} latency_hist_t;
+
+static latency_hist_t s_write_latency;      // Every write to the card
+static latency_hist_t s_request_latency;    // Async requests, submission to completion
+static portMUX_TYPE s_latency_lock = portMUX_INITIALIZER_UNLOCKED;
+
+// Async request queue, served by sd_io_task
+#define SD_IO_TASK_STACK_SIZE   4096
+#define SD_IO_TASK_PRIORITY     3       // Below the CAN logger (4)
+#define SD_IO_BATCH_MAX         16
+
+static QueueHandle_t s_io_queue = NULL;
+static TaskHandle_t s_io_task = NULL;
+static volatile bool s_io_stopping = false;     // sd_io_stop() sent the stop request
+static sd_card_async_stats_t s_async_stats;
+
 static sdmmc_card_t *s_card;
 static sdmmc_host_t s_host = SDSPI_HOST_DEFAULT();
 
+static esp_err_t sd_io_start(void);
+static void sd_io_stop(void);
+
 esp_err_t sd_card_init(void) {
     esp_err_t ret;
 
@@ -36,7 +68,7 @@ esp_err_t sd_card_init(void) {
     // formatted in case when mounting fails.
     esp_vfs_fat_sdmmc_mount_config_t mount_config = {
         .format_if_mount_failed = true,
-        .max_files = 5,
+        .max_files = 8,             // CAN logger keeps two segments open
         .allocation_unit_size = 16 * 1024
     };
 
@@ -90,10 +122,15 @@ esp_err_t sd_card_init(void) {
     }
     ESP_LOGI(TAG, "SD card mutex created");
 
+    if (sd_io_start() != ESP_OK) {
+        ESP_LOGW(TAG, "Async SD requests unavailable");
+    }
+
     return ESP_OK;
 }
 
 esp_err_t sd_card_deinit(void) {
+    sd_io_stop();
     if (s_card) {
         esp_vfs_fat_sdcard_unmount(MOUNT_POINT, s_card);
         ESP_LOGI(TAG, "SD card unmounted");
@@ -110,6 +147,7 @@ esp_err_t sd_card_deinit(void) {
 esp_err_t sd_card_write_file(const char* path, const char* data) {
     if (xSemaphoreTake(sd_card_mutex, portMAX_DELAY) == pdTRUE) {
         ESP_LOGI(TAG, "Writing file: %s", path);
+        int64_t start_us = esp_timer_get_time();
         FILE *f = fopen(path, "w");
         if (f == NULL) {
             ESP_LOGE(TAG, "Failed to open file for writing");
@@ -118,6 +156,7 @@ esp_err_t sd_card_write_file(const char* path, const char* data) {
         }
         fprintf(f, "%s", data);
         fclose(f);
+        sd_card_record_write_latency((uint32_t)(esp_timer_get_time() - start_us));
         ESP_LOGI(TAG, "File written");
         xSemaphoreGive(sd_card_mutex);
         return ESP_OK;
@@ -128,6 +167,7 @@ esp_err_t sd_card_write_file(const char* path, const char* data) {
 esp_err_t sd_card_append_file(const char* path, const char* data) {
     if (xSemaphoreTake(sd_card_mutex, portMAX_DELAY) == pdTRUE) {
         ESP_LOGD(TAG, "Appending to file: %s", path);
+        int64_t start_us = esp_timer_get_time();
         FILE *f = fopen(path, "a");
         if (f == NULL) {
             ESP_LOGE(TAG, "Failed to open file for appending");
@@ -136,12 +176,106 @@ esp_err_t sd_card_append_file(const char* path, const char* data) {
         }
         fprintf(f, "%s", data);
         fclose(f);
+        sd_card_record_write_latency((uint32_t)(esp_timer_get_time() - start_us));
         xSemaphoreGive(sd_card_mutex);
         return ESP_OK;
     }
     return ESP_ERR_TIMEOUT;
 }
 
+esp_err_t sd_card_create_contiguous_file(const char* path, uint64_t size) {
+    if (s_card == NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    int64_t start_us = esp_timer_get_time();
+    // f_expand() needs the file to be empty, so start from scratch
+    unlink(path);
+    esp_err_t ret = esp_vfs_fat_create_contiguous_file(MOUNT_POINT, path, size, true);
+    if (ret != ESP_OK) {
+        ESP_LOGW(TAG, "Failed to preallocate %s (%llu bytes): %s", path,
+                 (unsigned long long)size, esp_err_to_name(ret));
+        return ret;
+    }
+    ESP_LOGI(TAG, "Preallocated %s (%llu KB) in %lld ms", path,
+             (unsigned long long)(size / 1024), (esp_timer_get_time() - start_us) / 1000);
+    return ESP_OK;
+}
+
+static int latency_bucket(uint32_t us) {
+    if (us < LATENCY_SUB_BUCKETS) {
+        return us;
+    }
+    int msb = 31 - __builtin_clz(us);
+    if (msb >= LATENCY_MAX_OCTAVE) {
+        return LATENCY_BUCKETS - 1;
+    }
+    int sub = (us >> (msb - 2)) & (LATENCY_SUB_BUCKETS - 1);
+    return LATENCY_SUB_BUCKETS * (msb - 1) + sub;
+}
+
+// Largest value that falls into a bucket
+static uint32_t latency_bucket_limit(int bucket) {
+    if (bucket < LATENCY_SUB_BUCKETS) {
+        return bucket;
+    }
+    int msb = bucket / LATENCY_SUB_BUCKETS + 1;
+    int sub = bucket % LATENCY_SUB_BUCKETS;
+    return ((uint32_t)(LATENCY_SUB_BUCKETS + sub + 1) << (msb - 2)) - 1;
+}
+
+static void latency_record(latency_hist_t *h, uint32_t duration_us) {
+    int bucket = latency_bucket(duration_us);
+    portENTER_CRITICAL(&s_latency_lock);
+    h->hist[bucket]++;
+    h->count++;
+    if (duration_us > h->max_us) {
+        h->max_us = duration_us;
+    }
+    portEXIT_CRITICAL(&s_latency_lock);
+}
+
+static void latency_percentiles(const latency_hist_t *h, sd_card_latency_stats_t *stats) {
+    uint32_t hist[LATENCY_BUCKETS];
+    portENTER_CRITICAL(&s_latency_lock);
+    memcpy(hist, h->hist, sizeof(hist));
+    stats->count = h->count;
+    stats->max_us = h->max_us;
+    portEXIT_CRITICAL(&s_latency_lock);
+
+    // Walk the histogram once, picking each percentile as its rank is passed
+    const uint32_t permille[] = { 500, 900, 990, 999 };
+    uint32_t *out[] = { &stats->p50_us, &stats->p90_us, &stats->p99_us, &stats->p999_us };
+    uint64_t seen = 0;
+    int next = 0;
+    for (int i = 0; i < LATENCY_BUCKETS && next < 4; i++) {
+        seen += hist[i];
+        while (next < 4 && seen * 1000 >= (uint64_t)stats->count * permille[next] && stats->count > 0) {
+            uint32_t limit = latency_bucket_limit(i);
+            *out[next++] = limit < stats->max_us ? limit : stats->max_us;
+        }
+    }
+    while (next < 4) {
+        *out[next++] = 0;
+    }
+}
+
+void sd_card_record_write_latency(uint32_t duration_us) {
+    latency_record(&s_write_latency, duration_us);
+}
+
+void sd_card_get_write_latency(sd_card_latency_stats_t *stats) {
+    if (stats == NULL) {
+        return;
+    }
+    latency_percentiles(&s_write_latency, stats);
+}
+
+void sd_card_reset_write_latency(void) {
+    portENTER_CRITICAL(&s_latency_lock);
+    memset(&s_write_latency, 0, sizeof(s_write_latency));
+    portEXIT_CRITICAL(&s_latency_lock);
+}
+
 void sd_card_set_can_trace_enabled(bool enabled) {
     g_can_trace_enabled = enabled;
     ESP_LOGI(TAG, "CAN trace logging %s", enabled ? "enabled" : "disabled");
@@ -150,3 +284,307 @@ void sd_card_set_can_trace_enabled(bool enabled) {
 bool sd_card_is_can_trace_enabled(void) {
     return g_can_trace_enabled;
 }
+
+// ----------------------------------------------------------------------------
+// Asynchronous requests
+// ----------------------------------------------------------------------------
+
+sd_request_t *sd_request_create(sd_request_op_t op, const char *path, size_t length) {
+    if (path == NULL || strlen(path) >= SD_REQUEST_PATH_MAX) {
+        return NULL;
+    }
+    sd_request_t *req = calloc(1, sizeof(sd_request_t) + length);
+    if (req == NULL) {
+        return NULL;
+    }
+    req->op = op;
+    strcpy(req->path, path);
+    req->buffer = (uint8_t *)(req + 1);
+    req->length = length;
+    req->offset = (op == SD_REQUEST_WRITE) ? -1 : 0;
+    return req;
+}
+
+void sd_request_free(sd_request_t *req) {
+    free(req);
+}
+
+static void sd_io_complete(sd_request_t *req, esp_err_t result) {
+    req->result = result;
+    req->latency_us = (uint32_t)(esp_timer_get_time() - req->submit_us);
+    latency_record(&s_request_latency, req->latency_us);
+
+    portENTER_CRITICAL(&s_latency_lock);
+    s_async_stats.completed++;
+    if (result != ESP_OK) {
+        s_async_stats.failed++;
+    }
+    portEXIT_CRITICAL(&s_latency_lock);
+
+    // The callback or the notified task may free the request
+    TaskHandle_t notify_task = req->notify_task;
+    bool free_it = req->free_on_complete;
+    if (req->callback) {
+        req->callback(req, req->callback_arg);
+    }
+    if (notify_task) {
+        xTaskNotifyGive(notify_task);
+    }
+    if (free_it) {
+        sd_request_free(req);
+    }
+}
+
+// Runs one write or read with the card mutex held
+static esp_err_t sd_io_execute(sd_request_t *req) {
+    int64_t start_us = esp_timer_get_time();
+    const char *mode = "rb";
+    if (req->op == SD_REQUEST_WRITE) {
+        mode = req->offset < 0 ? "wb" : "r+b";
+    } else if (req->op == SD_REQUEST_APPEND) {
+        mode = "ab";
+    }
+
+    FILE *f = fopen(req->path, mode);
+    if (f == NULL) {
+        ESP_LOGW(TAG, "Failed to open %s", req->path);
+        return (req->op == SD_REQUEST_READ) ? ESP_ERR_NOT_FOUND : ESP_FAIL;
+    }
+    if (req->offset > 0 && fseek(f, req->offset, SEEK_SET) != 0) {
+        fclose(f);
+        return ESP_ERR_INVALID_SIZE;
+    }
+
+    esp_err_t ret = ESP_OK;
+    if (req->op == SD_REQUEST_READ) {
+        req->transferred = fread(req->buffer, 1, req->length, f);
+        if (ferror(f)) {
+            ret = ESP_FAIL;
+        }
+        fclose(f);
+        return ret;
+    }
+
+    req->transferred = fwrite(req->buffer, 1, req->length, f);
+    if (fclose(f) != 0 || req->transferred != req->length) {
+        ret = ESP_FAIL;
+    }
+    sd_card_record_write_latency((uint32_t)(esp_timer_get_time() - start_us));
+    return ret;
+}
+
+/**
+ * @brief Writes batch[first], an append, together with the later appends
+ *        to the same file, up to the first other request on that file.
+ *        Completed entries are cleared from the batch.
+ */
+static void sd_io_append_group(sd_request_t **batch, int count, int first) {
+    int members[SD_IO_BATCH_MAX];
+    int n = 0;
+    const char *path = batch[first]->path;
+
+    members[n++] = first;
+    for (int j = first + 1; j < count; j++) {
+        if (batch[j] == NULL || strcmp(batch[j]->path, path) != 0) {
+            continue;
+        }
+        if (batch[j]->op != SD_REQUEST_APPEND) {
+            break;
+        }
+        members[n++] = j;
+    }
+
+    esp_err_t ret = ESP_OK;
+    xSemaphoreTake(sd_card_mutex, portMAX_DELAY);
+    int64_t start_us = esp_timer_get_time();
+    FILE *f = fopen(path, "ab");
+    if (f == NULL) {
+        ESP_LOGW(TAG, "Failed to open %s for appending", path);
+        ret = ESP_FAIL;
+    } else {
+        for (int i = 0; i < n; i++) {
+            sd_request_t *req = batch[members[i]];
+            req->transferred = fwrite(req->buffer, 1, req->length, f);
+            if (req->transferred != req->length) {
+                ret = ESP_FAIL;
+            }
+        }
+        if (fclose(f) != 0) {
+            ret = ESP_FAIL;
+        }
+        sd_card_record_write_latency((uint32_t)(esp_timer_get_time() - start_us));
+    }
+    xSemaphoreGive(sd_card_mutex);
+
+    portENTER_CRITICAL(&s_latency_lock);
+    s_async_stats.merged += n - 1;
+    portEXIT_CRITICAL(&s_latency_lock);
+
+    for (int i = 0; i < n; i++) {
+        sd_request_t *req = batch[members[i]];
+        batch[members[i]] = NULL;
+        sd_io_complete(req, ret);
+    }
+}
+
+// Completes every request still queued without running it. Used once the
+// stop request was seen: nothing queued after it will be executed.
+static void sd_io_drain(void) {
+    sd_request_t *req;
+    while (xQueueReceive(s_io_queue, &req, 0) == pdTRUE) {
+        if (req != NULL) {
+            sd_io_complete(req, ESP_ERR_INVALID_STATE);
+        }
+    }
+}
+
+static void sd_io_task(void *pvParameters) {
+    sd_request_t *batch[SD_IO_BATCH_MAX];
+    bool stopping = false;
+
+    while (!stopping) {
+        if (xQueueReceive(s_io_queue, &batch[0], portMAX_DELAY) != pdTRUE) {
+            continue;
+        }
+        if (batch[0] == NULL) {
+            break;
+        }
+
+        // Take everything already queued, so appends can be grouped
+        int count = 1;
+        while (count < SD_IO_BATCH_MAX && xQueueReceive(s_io_queue, &batch[count], 0) == pdTRUE) {
+            if (batch[count] == NULL) {
+                stopping = true;
+                break;
+            }
+            count++;
+        }
+
+        for (int i = 0; i < count; i++) {
+            sd_request_t *req = batch[i];
+            if (req == NULL) {
+                continue;
+            }
+            if (req->op == SD_REQUEST_APPEND) {
+                sd_io_append_group(batch, count, i);
+                continue;
+            }
+            xSemaphoreTake(sd_card_mutex, portMAX_DELAY);
+            esp_err_t ret = sd_io_execute(req);
+            xSemaphoreGive(sd_card_mutex);
+            batch[i] = NULL;
+            sd_io_complete(req, ret);
+        }
+    }
+
+    // Requests queued behind the stop request still get their callback
+    sd_io_drain();
+    s_io_task = NULL;
+    vTaskDelete(NULL);
+}
+
+static esp_err_t sd_io_start(void) {
+    s_io_stopping = false;
+    s_io_queue = xQueueCreate(SD_ASYNC_QUEUE_DEPTH, sizeof(sd_request_t *));
+    if (s_io_queue == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+    if (xTaskCreate(sd_io_task, "sd_io", SD_IO_TASK_STACK_SIZE, NULL,
+                    SD_IO_TASK_PRIORITY, &s_io_task) != pdPASS) {
+        vQueueDelete(s_io_queue);
+        s_io_queue = NULL;
+        return ESP_ERR_NO_MEM;
+    }
+    return ESP_OK;
+}
+
+// Lets the I/O task finish what is queued, then removes it. Requests that
+// arrive after the stop request complete with ESP_ERR_INVALID_STATE.
+static void sd_io_stop(void) {
+    if (s_io_queue == NULL) {
+        return;
+    }
+    s_io_stopping = true;
+    sd_request_t *stop = NULL;
+    xQueueSend(s_io_queue, &stop, portMAX_DELAY);
+    for (int i = 0; i < 200 && s_io_task != NULL; i++) {
+        vTaskDelay(pdMS_TO_TICKS(10));
+    }
+    if (s_io_task == NULL) {
+        // A submit that passed its check before the flag was set
+        sd_io_drain();
+        vQueueDelete(s_io_queue);
+        s_io_queue = NULL;
+    }
+}
+
+esp_err_t sd_card_submit(sd_request_t *req, TickType_t wait) {
+    if (req == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (s_io_queue == NULL || s_io_task == NULL || s_io_stopping) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    req->result = ESP_ERR_NOT_FINISHED;
+    req->transferred = 0;
+    req->submit_us = esp_timer_get_time();
+
+    if (xQueueSend(s_io_queue, &req, wait) != pdTRUE) {
+        portENTER_CRITICAL(&s_latency_lock);
+        s_async_stats.rejected++;
+        portEXIT_CRITICAL(&s_latency_lock);
+        return ESP_ERR_TIMEOUT;
+    }
+
+    uint32_t depth = (uint32_t)uxQueueMessagesWaiting(s_io_queue);
+    portENTER_CRITICAL(&s_latency_lock);
+    s_async_stats.submitted++;
+    if (depth > s_async_stats.max_queue_depth) {
+        s_async_stats.max_queue_depth = depth;
+    }
+    portEXIT_CRITICAL(&s_latency_lock);
+    return ESP_OK;
+}
+
+static esp_err_t sd_card_submit_copy(sd_request_op_t op, const char *path, const void *data, size_t len,
+                                     sd_request_cb_t callback, void *arg) {
+    if (data == NULL && len > 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    sd_request_t *req = sd_request_create(op, path, len);
+    if (req == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+    if (len > 0) {
+        memcpy(req->buffer, data, len);
+    }
+    req->callback = callback;
+    req->callback_arg = arg;
+    req->free_on_complete = true;
+
+    esp_err_t ret = sd_card_submit(req, 0);
+    if (ret != ESP_OK) {
+        sd_request_free(req);
+    }
+    return ret;
+}
+
+esp_err_t sd_card_append_async(const char *path, const void *data, size_t len) {
+    return sd_card_submit_copy(SD_REQUEST_APPEND, path, data, len, NULL, NULL);
+}
+
+esp_err_t sd_card_write_async(const char *path, const void *data, size_t len,
+                              sd_request_cb_t callback, void *arg) {
+    return sd_card_submit_copy(SD_REQUEST_WRITE, path, data, len, callback, arg);
+}
+
+void sd_card_get_async_stats(sd_card_async_stats_t *stats) {
+    if (stats == NULL) {
+        return;
+    }
+    portENTER_CRITICAL(&s_latency_lock);
+    *stats = s_async_stats;
+    portEXIT_CRITICAL(&s_latency_lock);
+    stats->queue_depth = s_io_queue ? (uint32_t)uxQueueMessagesWaiting(s_io_queue) : 0;
+    latency_percentiles(&s_request_latency, &stats->latency);
+}
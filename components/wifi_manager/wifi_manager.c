@@ -17,6 +17,8 @@
 #include <nvs_flash.h>
 #include <lwip/sockets.h>
 #include <esp_mac.h>
+#include "json_writer.h"
+#include "http_router.h"
 
 #ifndef MIN
 #define MIN(a, b) ((a) < (b) ? (a) : (b))
@@ -35,7 +37,7 @@ static EventGroupHandle_t s_wifi_event_group;
 /* Global variables */
 static esp_netif_t *sta_netif = NULL;
 static esp_netif_t *ap_netif = NULL;
-static httpd_handle_t http_server = NULL;
+static bool http_routes_added = false;
 static wifi_mgr_config_t wifi_cfg;
 static wifi_status_t current_status = WIFI_STATUS_DISCONNECTED;
 static int retry_count = 0;
@@ -383,31 +385,25 @@ static esp_err_t wifi_scan_get_handler(httpd_req_t *req)
         return ESP_FAIL;
     }
     
-    // Build JSON response
-    char *json_response = malloc(2048);
-    if (!json_response) {
-        httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "Memory allocation failed");
-        return ESP_FAIL;
-    }
-    
-    strcpy(json_response, "{\"networks\":[");
+    // Stream the JSON response in small chunks
+    char chunk[JSON_WRITER_CHUNK_SIZE];
+    json_writer_t w;
+    json_writer_init_httpd(&w, req, chunk, sizeof(chunk));
+    json_obj_begin(&w);
+    json_key(&w, "networks");
+    json_arr_begin(&w);
     for (size_t i = 0; i < result_count; i++) {
-        char network_json[128];
-        snprintf(network_json, sizeof(network_json),
-                "%s{\"ssid\":\"%.32s\",\"rssi\":%d,\"open\":%s}",
-                (i > 0) ? "," : "",
-                scan_results[i].ssid,
-                scan_results[i].rssi,
-                scan_results[i].is_open ? "true" : "false");
-        strcat(json_response, network_json);
+        json_obj_begin(&w);
+        json_key(&w, "ssid");
+        json_strn(&w, scan_results[i].ssid, 32);
+        json_kv_int(&w, "rssi", scan_results[i].rssi);
+        json_kv_bool(&w, "open", scan_results[i].is_open);
+        json_obj_end(&w);
     }
-    strcat(json_response, "]}");
-    
-    httpd_resp_set_type(req, "application/json");
-    httpd_resp_send(req, json_response, strlen(json_response));
-    free(json_response);
-    
-    return ESP_OK;
+    json_arr_end(&w);
+    json_obj_end(&w);
+
+    return json_writer_finish(&w);
 }
 
 static esp_err_t wifi_config_post_handler(httpd_req_t *req)
@@ -463,67 +459,44 @@ static esp_err_t wifi_config_post_handler(httpd_req_t *req)
     return ESP_OK;
 }
 
+/* Configuration pages, on the shared HTTP server ("/" is the dashboard) */
+static const httpd_uri_t wifi_routes[] = {
+    { .uri = "/setup", .method = HTTP_GET,  .handler = root_get_handler },
+    { .uri = "/wifi",  .method = HTTP_GET,  .handler = wifi_config_get_handler },
+    { .uri = "/wifi",  .method = HTTP_POST, .handler = wifi_config_post_handler },
+    { .uri = "/scan",  .method = HTTP_GET,  .handler = wifi_scan_get_handler },
+};
+
 /* Start HTTP server */
 esp_err_t wifi_http_server_start(void)
 {
-    if (http_server != NULL) {
+    if (http_routes_added) {
         return ESP_OK; // Already running
     }
     
-    httpd_config_t config = HTTPD_DEFAULT_CONFIG();
-    config.server_port = HTTP_SERVER_PORT;
-    config.max_open_sockets = 7;
-    
-    ESP_LOGI(TAG, "Starting HTTP server on port %d", config.server_port);
-    
-    if (httpd_start(&http_server, &config) == ESP_OK) {
-        // Register URI handlers
-        httpd_uri_t root_uri = {
-            .uri = "/",
-            .method = HTTP_GET,
-            .handler = root_get_handler,
-            .user_ctx = NULL
-        };
-        httpd_register_uri_handler(http_server, &root_uri);
-        
-        httpd_uri_t wifi_config_get_uri = {
-            .uri = "/wifi",
-            .method = HTTP_GET,
-            .handler = wifi_config_get_handler,
-            .user_ctx = NULL
-        };
-        httpd_register_uri_handler(http_server, &wifi_config_get_uri);
-
-        httpd_uri_t wifi_config_post_uri = {
-            .uri = "/wifi",
-            .method = HTTP_POST,
-            .handler = wifi_config_post_handler,
-            .user_ctx = NULL
-        };
-        httpd_register_uri_handler(http_server, &wifi_config_post_uri);
-        
-        httpd_uri_t scan_uri = {
-            .uri = "/scan",
-            .method = HTTP_GET,
-            .handler = wifi_scan_get_handler,
-            .user_ctx = NULL
-        };
-        httpd_register_uri_handler(http_server, &scan_uri);
-        
-        ESP_LOGI(TAG, "HTTP server started successfully");
-        return ESP_OK;
+    esp_err_t ret = http_router_start();
+    for (size_t i = 0; i < sizeof(wifi_routes) / sizeof(wifi_routes[0]) && ret == ESP_OK; i++) {
+        ret = http_router_register(&wifi_routes[i]);
+    }
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Error adding configuration pages: %s", esp_err_to_name(ret));
+        wifi_http_server_stop();
+        return ESP_FAIL;
     }
     
-    ESP_LOGE(TAG, "Error starting HTTP server!");
-    return ESP_FAIL;
+    http_routes_added = true;
+    ESP_LOGI(TAG, "Configuration pages added at /setup");
+    return ESP_OK;
 }
 
-/* Stop HTTP server */
+/* Stop HTTP server: removes the pages, the shared server keeps running */
 esp_err_t wifi_http_server_stop(void)
 {
-    if (http_server) {
-        httpd_stop(http_server);
-        http_server = NULL;
+    for (size_t i = 0; i < sizeof(wifi_routes) / sizeof(wifi_routes[0]); i++) {
+        http_router_unregister(wifi_routes[i].uri, wifi_routes[i].method);
+    }
+    if (http_routes_added) {
+        http_routes_added = false;
         ESP_LOGI(TAG, "HTTP server stopped");
     }
     return ESP_OK;
@@ -532,7 +505,7 @@ esp_err_t wifi_http_server_stop(void)
 /* Check if HTTP server is running */
 bool wifi_http_server_is_running(void)
 {
-    return (http_server != NULL);
+    return http_routes_added;
 }
 
 /* Start ECU data server */
@@ -27,10 +27,6 @@ extern "C" {
 #define WIFI_AP_CHANNEL             1
 #define WIFI_AP_MAX_CONNECTIONS     4
 
-/* HTTP Server Configuration */
-#define HTTP_SERVER_PORT            8080
-#define WEBSOCKET_SERVER_PORT       8080
-
 /* Wi-Fi Status */
 typedef enum {
     WIFI_STATUS_DISCONNECTED = 0,
@@ -84,7 +80,7 @@ bool wifi_manager_is_connected(void);
 int8_t wifi_manager_get_rssi(void);
 const char* wifi_manager_get_ssid(void);
 
-/* HTTP Server Functions */
+/* HTTP Server Functions: the pages live on the shared server (http_router) */
 esp_err_t wifi_http_server_start(void);
 esp_err_t wifi_http_server_stop(void);
 bool wifi_http_server_is_running(void);
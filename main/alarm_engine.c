@@ -0,0 +1,511 @@
+/*
+ * Alarm Engine for ECU Dashboard
+ * Rules are evaluated only when their input channel changes; subscribers
+ * receive level transitions instead of testing thresholds on every redraw.
+ */
+
+#include "include/alarm_engine.h"
+#include "include/ecu_data.h"
+#include "background_task.h"
+#include "ui/settings_config.h"
+#include "freertos/FreeRTOS.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include <stdio.h>
+#include <string.h>
+
+static const char *TAG = "ALARM_ENGINE";
+
+#define ALARM_LOG_PATH "/sdcard/ALARMS.LOG"
+
+// Transitions buffered between the subscriber and the log flush
+#define ALARM_LOG_RING_SIZE 16
+
+// Compile-time rule table. Order must match alarm_builtin_t.
+static const alarm_rule_t builtin_rules[ALARM_BUILTIN_COUNT] = {
+    [ALARM_RPM_SHIFT]   = { "rpm_shift",   CH_ENGINE_RPM,   ALARM_ABOVE, 5000.0f, 6500.0f, 100.0f, 0,    false },
+    [ALARM_TCU_RPM]     = { "tcu_rpm",     CH_ENGINE_RPM,   ALARM_ABOVE, 4500.0f, 5500.0f, 100.0f, 0,    false },
+    [ALARM_WATER_TEMP]  = { "water_temp",  CH_WATER_TEMP_C, ALARM_ABOVE, 105.0f,  112.0f,  2.0f,   1000, false },
+    [ALARM_OIL_TEMP]    = { "oil_temp",    CH_OIL_TEMP_C,   ALARM_ABOVE, 125.0f,  135.0f,  2.0f,   1000, false },
+    [ALARM_BATTERY_LOW] = { "battery_low", CH_BATTERY_V,    ALARM_BELOW, 12.0f,   11.5f,   0.2f,   2000, false },
+};
+
+// Runtime state of one rule
+typedef struct {
+    alarm_rule_t rule;
+    alarm_level_t level;            // Level reported to subscribers
+    alarm_level_t pending_level;    // Raised level waiting for min_duration_ms
+    int64_t pending_since_us;
+    bool latched;
+    float last_value;
+    alarm_id_t next;                // Next rule on the same channel
+} alarm_state_t;
+
+typedef struct {
+    alarm_subscriber_t callback;
+    void *arg;
+} alarm_subscription_t;
+
+static alarm_state_t alarm_states[ALARM_MAX_RULES];
+static uint8_t alarm_used = 0;
+
+// First rule of each channel, so a channel change only touches its own rules
+static alarm_id_t channel_first_rule[CHANNEL_MAX];
+static float channel_last_value[CHANNEL_MAX];
+static bool channel_evaluated[CHANNEL_MAX];
+
+static alarm_subscription_t alarm_subscribers[ALARM_MAX_SUBSCRIBERS];
+static uint8_t alarm_subscriber_count = 0;
+
+// Fires when the earliest pending minimum duration expires
+static esp_timer_handle_t pending_timer = NULL;
+
+// Transitions waiting for alarm_engine_flush_log() on a background worker
+static alarm_event_t alarm_log_ring[ALARM_LOG_RING_SIZE];
+static uint8_t alarm_log_head = 0;
+static uint8_t alarm_log_count = 0;
+static uint32_t alarm_log_dropped = 0;
+static bool alarm_log_queued = false;      // Flush job submitted, not started yet
+
+static portMUX_TYPE alarm_lock = portMUX_INITIALIZER_UNLOCKED;
+static bool alarm_initialized = false;
+
+/**
+ * @brief Level a value maps to, given the level the rule is currently in.
+ *        Entering a level uses the threshold itself; leaving it needs the
+ *        hysteresis margin.
+ */
+static alarm_level_t alarm_target_level(const alarm_state_t *st, float value)
+{
+    const alarm_rule_t *r = &st->rule;
+
+    // Mirror BELOW rules so both directions share the same comparisons
+    float x = value;
+    float warn = r->warn_threshold;
+    float crit = r->crit_threshold;
+    if (r->direction == ALARM_BELOW) {
+        x = -x;
+        warn = -warn;
+        crit = -crit;
+    }
+
+    float crit_edge = (st->level >= ALARM_LEVEL_CRITICAL) ? crit - r->hysteresis : crit;
+    float warn_edge = (st->level >= ALARM_LEVEL_WARNING) ? warn - r->hysteresis : warn;
+
+    if (x >= crit_edge) {
+        return ALARM_LEVEL_CRITICAL;
+    }
+    if (x >= warn_edge) {
+        return ALARM_LEVEL_WARNING;
+    }
+    return ALARM_LEVEL_OK;
+}
+
+/**
+ * @brief Applies one value to a rule. Must be called with alarm_lock held.
+ * @return true if the rule changed level and *event was filled
+ */
+static bool alarm_update_locked(alarm_id_t id, float value, int64_t now, alarm_event_t *event)
+{
+    alarm_state_t *st = &alarm_states[id];
+    st->last_value = value;
+
+    alarm_level_t target = alarm_target_level(st, value);
+    if (st->latched && target < st->level) {
+        target = st->level;
+    }
+
+    if (target == st->level) {
+        st->pending_level = st->level;
+        return false;
+    }
+
+    // Raised levels must hold for the minimum duration; clearing is
+    // already debounced by the hysteresis
+    if (target > st->level && st->rule.min_duration_ms > 0) {
+        if (st->pending_level != target) {
+            st->pending_level = target;
+            st->pending_since_us = now;
+            return false;
+        }
+        if (now - st->pending_since_us < (int64_t)st->rule.min_duration_ms * 1000) {
+            return false;
+        }
+    }
+
+    event->alarm = id;
+    event->old_level = st->level;
+    event->new_level = target;
+    event->value = value;
+    event->timestamp_us = now;
+
+    st->level = target;
+    st->pending_level = target;
+    st->latched = st->rule.latch && target != ALARM_LEVEL_OK;
+    return true;
+}
+
+/**
+ * @brief Time until the earliest pending level matures, or -1 if none.
+ *        Must be called with alarm_lock held.
+ */
+static int64_t alarm_next_deadline_locked(int64_t now)
+{
+    int64_t earliest = -1;
+    for (uint8_t i = 0; i < alarm_used; i++) {
+        const alarm_state_t *st = &alarm_states[i];
+        if (st->pending_level <= st->level) {
+            continue;
+        }
+        int64_t left = st->pending_since_us + (int64_t)st->rule.min_duration_ms * 1000 - now;
+        if (left < 0) {
+            left = 0;
+        }
+        if (earliest < 0 || left < earliest) {
+            earliest = left;
+        }
+    }
+    return earliest;
+}
+
+static void alarm_arm_timer(int64_t delay_us)
+{
+    if (!pending_timer || delay_us < 0) {
+        return;
+    }
+    if (esp_timer_is_active(pending_timer)) {
+        esp_timer_stop(pending_timer);
+    }
+    // +1 ms so the deadline has passed when the callback reads the clock
+    esp_timer_start_once(pending_timer, delay_us + 1000);
+}
+
+static void alarm_dispatch(const alarm_event_t *events, uint8_t count)
+{
+    for (uint8_t e = 0; e < count; e++) {
+        for (uint8_t s = 0; s < alarm_subscriber_count; s++) {
+            alarm_subscribers[s].callback(&events[e], alarm_subscribers[s].arg);
+        }
+    }
+}
+
+static void alarm_pending_timer_cb(void *arg)
+{
+    alarm_event_t events[ALARM_MAX_RULES];
+    uint8_t count = 0;
+    int64_t now = esp_timer_get_time();
+
+    portENTER_CRITICAL(&alarm_lock);
+    for (uint8_t i = 0; i < alarm_used; i++) {
+        if (alarm_states[i].pending_level > alarm_states[i].level &&
+            alarm_update_locked(i, alarm_states[i].last_value, now, &events[count])) {
+            count++;
+        }
+    }
+    int64_t next = alarm_next_deadline_locked(now);
+    portEXIT_CRITICAL(&alarm_lock);
+
+    alarm_arm_timer(next);
+    alarm_dispatch(events, count);
+}
+
+void alarm_engine_evaluate(channel_id_t channel, float value)
+{
+    if (!alarm_initialized || channel >= CHANNEL_MAX) {
+        return;
+    }
+
+    alarm_event_t events[ALARM_MAX_RULES];
+    uint8_t count = 0;
+    bool pending = false;
+    int64_t now = esp_timer_get_time();
+
+    portENTER_CRITICAL(&alarm_lock);
+    if (channel_evaluated[channel] && channel_last_value[channel] == value) {
+        portEXIT_CRITICAL(&alarm_lock);
+        return;
+    }
+    channel_evaluated[channel] = true;
+    channel_last_value[channel] = value;
+
+    for (alarm_id_t id = channel_first_rule[channel]; id != ALARM_INVALID; id = alarm_states[id].next) {
+        alarm_level_t was_pending = alarm_states[id].pending_level;
+        if (alarm_update_locked(id, value, now, &events[count])) {
+            count++;
+        } else if (alarm_states[id].pending_level > alarm_states[id].level &&
+                   alarm_states[id].pending_level != was_pending) {
+            pending = true;
+        }
+    }
+    int64_t next = pending ? alarm_next_deadline_locked(now) : -1;
+    portEXIT_CRITICAL(&alarm_lock);
+
+    alarm_arm_timer(next);
+    alarm_dispatch(events, count);
+}
+
+static void alarm_channel_listener(channel_id_t id, float value)
+{
+    alarm_engine_evaluate(id, value);
+}
+
+/**
+ * @brief Built-in subscriber: queues the transition for the event log.
+ *        Formatting, the web data stream and the SD write happen in
+ *        alarm_engine_flush_log() on a background worker; here the event is
+ *        only copied into the ring, and the first event of a batch queues
+ *        the flush job (no payload, so nothing is allocated).
+ *        In demo mode the transitions come from the gauge animation sweep,
+ *        not from the engine, so they are not logged.
+ */
+static void alarm_event_log_cb(const alarm_event_t *event, void *arg)
+{
+    bool kick;
+
+    if (demo_mode_get_enabled()) {
+        return;
+    }
+
+    portENTER_CRITICAL(&alarm_lock);
+    if (alarm_log_count == ALARM_LOG_RING_SIZE) {
+        // Worker is behind: keep the newest transitions
+        alarm_log_head = (alarm_log_head + 1) % ALARM_LOG_RING_SIZE;
+        alarm_log_count--;
+        alarm_log_dropped++;
+    }
+    alarm_log_ring[(alarm_log_head + alarm_log_count) % ALARM_LOG_RING_SIZE] = *event;
+    alarm_log_count++;
+    kick = !alarm_log_queued;
+    alarm_log_queued = true;
+    portEXIT_CRITICAL(&alarm_lock);
+
+    if (kick) {
+        background_task_t task = {
+            .type = BG_TASK_ALARM_LOG,
+            .priority = BG_PRIORITY_NORMAL,
+            .dedup_key = BG_DEDUP_KEY(BG_TASK_ALARM_LOG, 0)
+        };
+        if (background_task_add(&task) != ESP_OK) {
+            // Queue full: the next transition tries again
+            portENTER_CRITICAL(&alarm_lock);
+            alarm_log_queued = false;
+            portEXIT_CRITICAL(&alarm_lock);
+        }
+    }
+}
+
+esp_err_t alarm_engine_flush_log(void)
+{
+    alarm_event_t events[ALARM_LOG_RING_SIZE];
+    uint8_t count = 0;
+    uint32_t dropped;
+
+    // Cleared before draining, so a transition during the write queues a new flush
+    portENTER_CRITICAL(&alarm_lock);
+    alarm_log_queued = false;
+    while (alarm_log_count > 0) {
+        events[count++] = alarm_log_ring[alarm_log_head];
+        alarm_log_head = (alarm_log_head + 1) % ALARM_LOG_RING_SIZE;
+        alarm_log_count--;
+    }
+    dropped = alarm_log_dropped;
+    alarm_log_dropped = 0;
+    portEXIT_CRITICAL(&alarm_lock);
+
+    if (dropped > 0) {
+        ESP_LOGW(TAG, "%lu alarm events dropped from the log", (unsigned long)dropped);
+    }
+    if (count == 0) {
+        return ESP_OK;
+    }
+
+    char sd_text[ALARM_LOG_RING_SIZE * 64];
+    size_t sd_len = 0;
+
+    for (uint8_t i = 0; i < count; i++) {
+        const alarm_event_t *event = &events[i];
+        const alarm_rule_t *rule = &alarm_states[event->alarm].rule;
+        char line[96];
+
+        snprintf(line, sizeof(line), "Alarm %s: %s -> %s (%.1f)",
+                 rule->name,
+                 alarm_level_to_string(event->old_level),
+                 alarm_level_to_string(event->new_level),
+                 event->value);
+
+        log_type_t type = LOG_SUCCESS;
+        if (event->new_level == ALARM_LEVEL_CRITICAL) {
+            type = LOG_ERROR;
+        } else if (event->new_level == ALARM_LEVEL_WARNING) {
+            type = LOG_WARNING;
+        }
+        data_stream_add_entry(line, type);
+
+        int n = snprintf(sd_text + sd_len, sizeof(sd_text) - sd_len, "%lld,%s,%s,%s,%.2f\n",
+                         event->timestamp_us / 1000,
+                         rule->name,
+                         alarm_level_to_string(event->old_level),
+                         alarm_level_to_string(event->new_level),
+                         event->value);
+        if (n > 0 && (size_t)n < sizeof(sd_text) - sd_len) {
+            sd_len += n;
+        } else {
+            sd_text[sd_len] = '\0';   // Drop the line that did not fit
+        }
+    }
+
+    // One append per batch
+    return sd_len > 0 ? background_sd_append_async(ALARM_LOG_PATH, sd_text) : ESP_OK;
+}
+
+/**
+ * @brief Built-in subscriber: mirrors the TCU level into CH_TCU_STATUS so
+ *        it travels with the other channels (JSON, telemetry frames, logs).
+ */
+static void alarm_status_channel_cb(const alarm_event_t *event, void *arg)
+{
+    if (event->alarm == ALARM_TCU_RPM) {
+        channel_set(CH_TCU_STATUS, (float)event->new_level);
+    }
+}
+
+esp_err_t alarm_engine_init(void)
+{
+    if (alarm_initialized) {
+        return ESP_OK;
+    }
+
+    memset(alarm_states, 0, sizeof(alarm_states));
+    memset(channel_first_rule, ALARM_INVALID, sizeof(channel_first_rule));
+    memset(channel_evaluated, 0, sizeof(channel_evaluated));
+    alarm_used = 0;
+
+    const esp_timer_create_args_t timer_args = {
+        .callback = alarm_pending_timer_cb,
+        .name = "alarm_pending"
+    };
+    esp_err_t ret = esp_timer_create(&timer_args, &pending_timer);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to create pending timer: %s", esp_err_to_name(ret));
+        return ret;
+    }
+
+    alarm_initialized = true;
+
+    for (int i = 0; i < ALARM_BUILTIN_COUNT; i++) {
+        alarm_engine_add_rule(&builtin_rules[i], NULL);
+    }
+    alarm_engine_subscribe(alarm_event_log_cb, NULL);
+    alarm_engine_subscribe(alarm_status_channel_cb, NULL);
+
+    ret = channel_registry_add_listener(alarm_channel_listener);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to register channel listener: %s", esp_err_to_name(ret));
+        return ret;
+    }
+
+    ESP_LOGI(TAG, "Alarm engine initialized with %d rules", alarm_used);
+    return ESP_OK;
+}
+
+esp_err_t alarm_engine_add_rule(const alarm_rule_t *rule, alarm_id_t *out_id)
+{
+    if (!alarm_initialized || !rule || !rule->name || channel_get_def(rule->channel) == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    portENTER_CRITICAL(&alarm_lock);
+    if (alarm_used >= ALARM_MAX_RULES) {
+        portEXIT_CRITICAL(&alarm_lock);
+        ESP_LOGE(TAG, "Alarm table full, cannot add '%s'", rule->name);
+        return ESP_ERR_NO_MEM;
+    }
+    alarm_id_t id = alarm_used;
+    alarm_state_t *st = &alarm_states[id];
+    memset(st, 0, sizeof(*st));
+    st->rule = *rule;
+    st->level = ALARM_LEVEL_OK;
+    st->pending_level = ALARM_LEVEL_OK;
+
+    // Append to the channel's rule list so evaluation order follows table order
+    st->next = ALARM_INVALID;
+    alarm_id_t *link = &channel_first_rule[rule->channel];
+    while (*link != ALARM_INVALID) {
+        link = &alarm_states[*link].next;
+    }
+    *link = id;
+    alarm_used = id + 1;
+    portEXIT_CRITICAL(&alarm_lock);
+
+    if (out_id) {
+        *out_id = id;
+    }
+    return ESP_OK;
+}
+
+esp_err_t alarm_engine_subscribe(alarm_subscriber_t subscriber, void *arg)
+{
+    if (!subscriber) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    portENTER_CRITICAL(&alarm_lock);
+    if (alarm_subscriber_count >= ALARM_MAX_SUBSCRIBERS) {
+        portEXIT_CRITICAL(&alarm_lock);
+        return ESP_ERR_NO_MEM;
+    }
+    alarm_subscribers[alarm_subscriber_count].callback = subscriber;
+    alarm_subscribers[alarm_subscriber_count].arg = arg;
+    alarm_subscriber_count++;
+    portEXIT_CRITICAL(&alarm_lock);
+    return ESP_OK;
+}
+
+void alarm_engine_acknowledge(alarm_id_t id)
+{
+    if (id >= alarm_used) {
+        return;
+    }
+
+    alarm_event_t event;
+    bool changed;
+
+    portENTER_CRITICAL(&alarm_lock);
+    alarm_states[id].latched = false;
+    changed = alarm_update_locked(id, alarm_states[id].last_value, esp_timer_get_time(), &event);
+    portEXIT_CRITICAL(&alarm_lock);
+
+    if (changed) {
+        alarm_dispatch(&event, 1);
+    }
+}
+
+alarm_level_t alarm_engine_get_level(alarm_id_t id)
+{
+    if (id >= alarm_used) {
+        return ALARM_LEVEL_OK;
+    }
+    return alarm_states[id].level;
+}
+
+const alarm_rule_t *alarm_engine_get_rule(alarm_id_t id)
+{
+    if (id >= alarm_used) {
+        return NULL;
+    }
+    return &alarm_states[id].rule;
+}
+
+uint8_t alarm_engine_count(void)
+{
+    return alarm_used;
+}
+
+const char *alarm_level_to_string(alarm_level_t level)
+{
+    switch (level) {
+        case ALARM_LEVEL_WARNING:  return "WARNING";
+        case ALARM_LEVEL_CRITICAL: return "CRITICAL";
+        default:                   return "OK";
+    }
+}
@@ -0,0 +1,245 @@
+/*
+ * Background Queue Benchmark for ECU Dashboard
+ * Mixed synthetic jobs through the real background queue
+ */
+
+#include "background_bench.h"
+#include "background_task.h"
+#include "block_pool.h"
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_timer.h"
+#include "esp_log.h"
+
+static const char *TAG = "BG_BENCH";
+
+#define BENCH_TIMEOUT_MS        60000
+#define BENCH_SUBMIT_WAIT_MS    2000
+
+typedef enum {
+    BENCH_CPU,
+    BENCH_COMPRESS,
+    BENCH_NVS,
+    BENCH_SD,
+} bench_kind_t;
+
+typedef struct {
+    int64_t submit_us;
+    uint32_t latency_us;
+    uint32_t seq;                   // Order among the nvs jobs
+    bench_kind_t kind;
+} bench_job_t;
+
+// One run at a time; the queue only passes pointers to these
+static bench_job_t *bench_jobs;
+static uint32_t bench_done;
+static uint32_t bench_failed;
+static uint32_t bench_nvs_next;
+static uint32_t bench_order_errors;
+static int64_t bench_last_us;
+
+static bench_kind_t bench_kind(uint32_t i)
+{
+    switch (i % 10) {
+        case 3:  return BENCH_COMPRESS;
+        case 4:
+        case 8:  return BENCH_NVS;
+        case 9:  return BENCH_SD;
+        default: return BENCH_CPU;
+    }
+}
+
+static void bench_busy(uint32_t us)
+{
+    int64_t end = esp_timer_get_time() + us;
+    while (esp_timer_get_time() < end) {
+    }
+}
+
+static esp_err_t bench_job(void *arg)
+{
+    bench_job_t *job = (bench_job_t *)arg;
+    switch (job->kind) {
+        case BENCH_CPU:
+            bench_busy(500);
+            break;
+        case BENCH_COMPRESS:
+            bench_busy(5000);
+            break;
+        case BENCH_NVS:
+            // Serialized by the affinity key: a job out of order is a pool bug
+            if (job->seq != bench_nvs_next) {
+                __atomic_fetch_add(&bench_order_errors, 1, __ATOMIC_RELAXED);
+            }
+            bench_nvs_next = job->seq + 1;
+            vTaskDelay(pdMS_TO_TICKS(10));
+            break;
+        case BENCH_SD:
+            vTaskDelay(pdMS_TO_TICKS(40));
+            break;
+    }
+    return ESP_OK;
+}
+
+static void bench_done_cb(esp_err_t result, void *arg)
+{
+    bench_job_t *job = (bench_job_t *)arg;
+    int64_t now = esp_timer_get_time();
+    job->latency_us = (uint32_t)(now - job->submit_us);
+    if (result != ESP_OK) {
+        __atomic_fetch_add(&bench_failed, 1, __ATOMIC_RELAXED);
+    }
+    __atomic_store_n(&bench_last_us, now, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&bench_done, 1, __ATOMIC_RELEASE);
+}
+
+static int bench_cmp_u32(const void *a, const void *b)
+{
+    uint32_t x = *(const uint32_t *)a;
+    uint32_t y = *(const uint32_t *)b;
+    return (x > y) - (x < y);
+}
+
+esp_err_t background_bench_run(uint32_t workers, uint32_t jobs, background_bench_result_t *result)
+{
+    if (jobs == 0 || !result) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    background_stats_t stats;
+    background_task_get_stats(&stats);
+    uint32_t previous = stats.active_workers;
+    esp_err_t ret = background_task_set_active_workers(workers);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+
+    bench_jobs = calloc(jobs, sizeof(bench_job_t));
+    uint32_t *latency = calloc(jobs, sizeof(uint32_t));
+    if (!bench_jobs || !latency) {
+        free(bench_jobs);
+        free(latency);
+        bench_jobs = NULL;
+        background_task_set_active_workers(previous);
+        return ESP_ERR_NO_MEM;
+    }
+    bench_done = 0;
+    bench_failed = 0;
+    bench_nvs_next = 0;
+    bench_order_errors = 0;
+
+    uint32_t nvs_key = background_affinity_key("bench_nvs");
+    uint32_t nvs_seq = 0;
+    int64_t start_us = esp_timer_get_time();
+    bench_last_us = start_us;
+
+    for (uint32_t i = 0; i < jobs; i++) {
+        bench_job_t *job = &bench_jobs[i];
+        job->kind = bench_kind(i);
+        if (job->kind == BENCH_NVS) {
+            job->seq = nvs_seq++;
+        }
+
+        background_custom_op_t *op = block_pool_alloc(sizeof(*op));
+        if (!op) {
+            __atomic_fetch_add(&bench_failed, 1, __ATOMIC_RELAXED);
+            __atomic_fetch_add(&bench_done, 1, __ATOMIC_RELEASE);
+            continue;
+        }
+        op->fn = bench_job;
+        op->arg = job;
+
+        background_task_t task = {
+            .type = BG_TASK_CUSTOM,
+            .data = op,
+            .data_size = sizeof(*op),
+            .callback = bench_done_cb,
+            .callback_arg = job,
+            .affinity_key = job->kind == BENCH_NVS ? nvs_key : BG_AFFINITY_NONE,
+        };
+        // Closed loop: the submission waits while the queue is full
+        job->submit_us = esp_timer_get_time();
+        if (background_task_submit(&task, pdMS_TO_TICKS(BENCH_SUBMIT_WAIT_MS)) != ESP_OK) {
+            block_pool_free(op);
+            __atomic_fetch_add(&bench_failed, 1, __ATOMIC_RELAXED);
+            __atomic_fetch_add(&bench_done, 1, __ATOMIC_RELEASE);
+        }
+    }
+
+    while (__atomic_load_n(&bench_done, __ATOMIC_ACQUIRE) < jobs &&
+           esp_timer_get_time() - start_us < (int64_t)BENCH_TIMEOUT_MS * 1000) {
+        vTaskDelay(pdMS_TO_TICKS(10));
+    }
+    bool complete = __atomic_load_n(&bench_done, __ATOMIC_ACQUIRE) == jobs;
+
+    if (complete) {
+        for (uint32_t i = 0; i < jobs; i++) {
+            latency[i] = bench_jobs[i].latency_us;
+        }
+        qsort(latency, jobs, sizeof(uint32_t), bench_cmp_u32);
+
+        memset(result, 0, sizeof(*result));
+        result->workers = workers;
+        result->jobs = jobs;
+        result->elapsed_us = (uint32_t)(bench_last_us - start_us);
+        result->jobs_per_s = result->elapsed_us > 0
+            ? (uint32_t)((uint64_t)jobs * 1000000 / result->elapsed_us) : 0;
+        result->p50_us = latency[(jobs - 1) * 50 / 100];
+        result->p95_us = latency[(jobs - 1) * 95 / 100];
+        result->p99_us = latency[(jobs - 1) * 99 / 100];
+        result->max_us = latency[jobs - 1];
+        result->order_errors = bench_order_errors;
+        result->failed = bench_failed;
+    }
+
+    // Jobs still queued after a timeout point into bench_jobs: keep it
+    if (complete) {
+        free(bench_jobs);
+        bench_jobs = NULL;
+    }
+    free(latency);
+    background_task_set_active_workers(previous);
+    return complete ? ESP_OK : ESP_ERR_TIMEOUT;
+}
+
+static void bench_log(const background_bench_result_t *r)
+{
+    ESP_LOGI(TAG, "%lu worker(s): %lu jobs in %lu ms, %lu jobs/s, latency p50 %lu us, "
+             "p95 %lu us, p99 %lu us, max %lu us, order errors %lu, failed %lu",
+             (unsigned long)r->workers, (unsigned long)r->jobs, (unsigned long)(r->elapsed_us / 1000),
+             (unsigned long)r->jobs_per_s, (unsigned long)r->p50_us, (unsigned long)r->p95_us,
+             (unsigned long)r->p99_us, (unsigned long)r->max_us,
+             (unsigned long)r->order_errors, (unsigned long)r->failed);
+}
+
+void background_bench_compare(uint32_t jobs)
+{
+    background_stats_t stats;
+    background_task_get_stats(&stats);
+
+    background_bench_result_t single, pool;
+    if (background_bench_run(1, jobs, &single) != ESP_OK) {
+        ESP_LOGE(TAG, "Single worker run did not finish");
+        return;
+    }
+    bench_log(&single);
+
+    if (stats.worker_count < 2) {
+        ESP_LOGI(TAG, "Only one worker configured, nothing to compare");
+        return;
+    }
+    if (background_bench_run(stats.worker_count, jobs, &pool) != ESP_OK) {
+        ESP_LOGE(TAG, "Pool run did not finish");
+        return;
+    }
+    bench_log(&pool);
+
+    ESP_LOGI(TAG, "Pool of %u: throughput x%lu.%02lu, p99 latency %lu%% of single worker",
+             (unsigned)stats.worker_count,
+             (unsigned long)(pool.jobs_per_s / (single.jobs_per_s ? single.jobs_per_s : 1)),
+             (unsigned long)(pool.jobs_per_s * 100 / (single.jobs_per_s ? single.jobs_per_s : 1) % 100),
+             (unsigned long)(single.p99_us ? (uint64_t)pool.p99_us * 100 / single.p99_us : 0));
+}
@@ -5,148 +5,593 @@
 
 #include "background_task.h"
 #include "esp_log.h"
-#include "nvs.h"
-#include "nvs_flash.h"
 #include "freertos/task.h"
-#include "freertos/queue.h"
+#include "esp_system.h"
+#include "esp_timer.h"
+#include <stdio.h>
 #include <string.h>
+#include <stdlib.h>
 #include "ui/settings_config.h" // For settings_save()
+#include "sd_card_manager.h"
+#include "block_pool.h"
+#include "include/nvs_cache.h"
+#include "include/alarm_engine.h"
 
 static const char *TAG = "BACKGROUND_TASK";
 
-// Очередь для фоновых задач
-static QueueHandle_t background_queue = NULL;
-
-// Задача FreeRTOS для обработки фоновых операций
-static TaskHandle_t background_task_handle = NULL;
-
-// Статические буферы для избежания malloc в background_nvs_save_async
-static uint8_t static_data_buffer[256];
-static nvs_operation_t static_nvs_operation;
-
 // Максимальный размер очереди
 #define BACKGROUND_QUEUE_SIZE 10
 
-// Размер стека для фоновой задачи
+// Места, доступные только задачам BG_PRIORITY_HIGH
+#define BACKGROUND_QUEUE_RESERVED 2
+
+// Шаг ожидания места в очереди в background_task_submit()
+#define BACKGROUND_SUBMIT_POLL_MS 10
+
+// Размер стека для каждого обработчика
 #define BACKGROUND_TASK_STACK_SIZE 4096
 
 // Приоритет фоновой задачи
 #define BACKGROUND_TASK_PRIORITY 5
 
+#define BACKGROUND_WORKERS CONFIG_BACKGROUND_WORKERS
+
+_Static_assert(BACKGROUND_WORKERS >= 1 && BACKGROUND_WORKERS <= BACKGROUND_MAX_WORKERS,
+               "CONFIG_BACKGROUND_WORKERS out of range");
+
+// Описатели (futures) задач, поставленных через background_task_submit_handle()
+#define BACKGROUND_MAX_HANDLES 16
+
+// Место в очереди
+typedef struct {
+    background_task_t task;
+    uint32_t order;                 // Порядок постановки внутри приоритета
+    int64_t enqueued_us;
+    int64_t deadline_us;            // 0 - без срока
+    uint32_t key;                   // Ключ сериализации (affinity_key или dedup_key)
+    int8_t future;                  // Индекс описателя или -1
+    bool used;
+} background_slot_t;
+
+// Обработчик со своей очередью. Места в ней на всю очередь: все принятые
+// задачи помещаются в очередь любого обработчика
+typedef struct {
+    background_slot_t queue[BACKGROUND_QUEUE_SIZE];
+    uint32_t queued;                // Занятых мест в queue
+    TaskHandle_t handle;
+    esp_timer_handle_t overrun_timer;   // Срабатывает, если задача не уложилась в срок
+    background_task_type_t running_type;
+    uint32_t running_key;           // Ключ выполняющейся задачи или BG_AFFINITY_NONE
+    bool busy;
+    uint8_t index;
+} background_worker_t;
+
+typedef enum {
+    FUTURE_FREE = 0,
+    FUTURE_QUEUED,
+    FUTURE_RUNNING,
+    FUTURE_DONE
+} background_future_state_t;
+
+// Состояние задачи для её описателя; живёт до background_task_release()
+typedef struct {
+    background_future_state_t state;
+    uint32_t gen;                   // Старшие биты описателя: старый описатель не найдёт новую задачу
+    esp_err_t result;
+    bool released;                  // Освободить по завершении
+    TaskHandle_t waiter;            // Ждёт в background_task_wait()
+    background_callback_t continuation;
+    void *continuation_arg;
+} background_future_t;
+
+// Очереди для фоновых задач: у каждого обработчика небольшой массив, выборка
+// по приоритету и порядку. FreeRTOS очередь не умеет ни того, ни замены по
+// ключу. Обработчик берёт задачи из своей очереди, а если в ней нечего начать -
+// крадёт из очереди самого загруженного. Все очереди под одним спинлоком:
+// порядок задач с одним ключом, замена по ключу, отмена и допуск по
+// заполнению смотрят сразу во все очереди, а задач всего несколько.
+static uint32_t background_pending = 0;     // Задач во всех очередях
+static uint32_t background_order = 0;
+static bool background_ready = false;
+static background_stats_t background_stats;
+static background_future_t background_futures[BACKGROUND_MAX_HANDLES];
+static uint32_t background_future_gen = 0;
+static portMUX_TYPE background_lock = portMUX_INITIALIZER_UNLOCKED;
+
+// Задачи FreeRTOS для обработки фоновых операций
+static background_worker_t background_workers[BACKGROUND_WORKERS];
+static uint32_t background_worker_count = 0;
+static uint32_t background_active_workers = 0;
+static uint32_t background_next_worker = 0;
+
+static const char *const background_type_names[BG_TASK_TYPE_COUNT] = {
+    [BG_TASK_NVS_SAVE]        = "nvs_save",
+    [BG_TASK_SETTINGS_SAVE]   = "settings_save",
+    [BG_TASK_SETTINGS_EXPORT] = "settings_export",
+    [BG_TASK_NVS_LOAD]        = "nvs_load",
+    [BG_TASK_NVS_ERASE]       = "nvs_erase",
+    [BG_TASK_SYSTEM_RESET]    = "system_reset",
+    [BG_TASK_SD_APPEND]       = "sd_append",
+    [BG_TASK_NVS_FLUSH]       = "nvs_flush",
+    [BG_TASK_ALARM_LOG]       = "alarm_log",
+    [BG_TASK_CUSTOM]          = "custom",
+};
+
 /**
- * @brief Основная функция фоновой задачи
- * @param pvParameters Параметры задачи (не используются)
+ * @brief Сколько задач может стоять в очереди, чтобы задача этого
+ *        приоритета ещё была принята
  */
-static void background_task_worker(void *pvParameters)
+static uint32_t background_admission_limit(background_priority_t priority)
 {
-    background_task_t task;
+    if (priority >= BG_PRIORITY_HIGH) {
+        return BACKGROUND_QUEUE_SIZE;
+    }
+    if (priority <= BG_PRIORITY_LOW) {
+        return BACKGROUND_QUEUE_SIZE / 2;
+    }
+    return BACKGROUND_QUEUE_SIZE - BACKGROUND_QUEUE_RESERVED;
+}
 
-    ESP_LOGI(TAG, "Background task worker started");
+// ============================================================================
+// ОПИСАТЕЛИ
+// ============================================================================
 
-    while (1) {
-        // Ожидание задачи из очереди
-        if (xQueueReceive(background_queue, &task, portMAX_DELAY) == pdTRUE) {
-            esp_err_t result = ESP_OK;
-
-            ESP_LOGD(TAG, "Processing background task type: %d", task.type);
-
-            switch (task.type) {
-                case BG_TASK_NVS_SAVE: {
-                    nvs_operation_t *nvs_op = (nvs_operation_t *)task.data;
-                    if (nvs_op) {
-                        nvs_handle_t nvs_handle;
-                        result = nvs_open(nvs_op->namespace, NVS_READWRITE, &nvs_handle);
-                        if (result == ESP_OK) {
-                            result = nvs_set_blob(nvs_handle, nvs_op->key, nvs_op->value, nvs_op->size);
-                            if (result == ESP_OK) {
-                                result = nvs_commit(nvs_handle);
-                            }
-                            nvs_close(nvs_handle);
-                        }
-
-                        // Освобождаем память только если использовалась динамическая память
-                        // Статические буферы не освобождаем
-                        if (nvs_op != &static_nvs_operation) {
-                            // Использовалась динамическая память
-                            free(nvs_op->value);
-                            free(nvs_op);
-                        }
-                        // Для статической памяти ничего не делаем - она будет переиспользована
-                    }
-                    break;
-                }
+/**
+ * @brief Описатель по значению. Вызывается под background_lock.
+ */
+static background_future_t *background_future_find(background_handle_t handle)
+{
+    uint32_t index = (handle & 0xFF) - 1;
+    if (handle == BG_HANDLE_INVALID || index >= BACKGROUND_MAX_HANDLES) {
+        return NULL;
+    }
+    background_future_t *f = &background_futures[index];
+    return (f->state != FUTURE_FREE && f->gen == (handle >> 8)) ? f : NULL;
+}
 
-                case BG_TASK_SETTINGS_SAVE: {
-                    if (task.data) {
-                        settings_save((const touch_settings_t *)task.data);
-                        // The data was malloc'd in trigger_settings_save, so we must free it here.
-                        free(task.data);
-                    } else {
-                        ESP_LOGE(TAG, "BG_TASK_SETTINGS_SAVE received null data!");
-                        result = ESP_ERR_INVALID_ARG;
-                    }
-                    break;
-                }
+/**
+ * @brief Занимает описатель. Вызывается под background_lock.
+ * @return Индекс или -1
+ */
+static int background_future_alloc(background_handle_t *handle)
+{
+    for (int i = 0; i < BACKGROUND_MAX_HANDLES; i++) {
+        background_future_t *f = &background_futures[i];
+        if (f->state == FUTURE_FREE) {
+            background_future_gen = (background_future_gen + 1) & 0xFFFFFF;
+            if (background_future_gen == 0) {
+                background_future_gen = 1;
+            }
+            memset(f, 0, sizeof(*f));
+            f->state = FUTURE_QUEUED;
+            f->gen = background_future_gen;
+            *handle = (f->gen << 8) | (uint32_t)(i + 1);
+            return i;
+        }
+    }
+    return -1;
+}
 
-                case BG_TASK_NVS_LOAD: {
-                    nvs_operation_t *nvs_op = (nvs_operation_t *)task.data;
-                    if (nvs_op) {
-                        nvs_handle_t nvs_handle;
-                        result = nvs_open(nvs_op->namespace, NVS_READONLY, &nvs_handle);
-                        if (result == ESP_OK) {
-                            result = nvs_get_blob(nvs_handle, nvs_op->key, nvs_op->value, &nvs_op->size);
-                            nvs_close(nvs_handle);
-                        }
-                        free(nvs_op);
-                    }
-                    break;
-                }
+/**
+ * @brief Завершает описатель: будит ожидающего и вызывает продолжение
+ */
+static void background_future_complete(int future, esp_err_t result)
+{
+    if (future < 0) {
+        return;
+    }
 
-                case BG_TASK_NVS_ERASE: {
-                    nvs_operation_t *nvs_op = (nvs_operation_t *)task.data;
-                    if (nvs_op) {
-                        nvs_handle_t nvs_handle;
-                        result = nvs_open(nvs_op->namespace, NVS_READWRITE, &nvs_handle);
-                        if (result == ESP_OK) {
-                            result = nvs_erase_key(nvs_handle, nvs_op->key);
-                            if (result == ESP_OK) {
-                                result = nvs_commit(nvs_handle);
-                            }
-                            nvs_close(nvs_handle);
-                        }
-                        free(nvs_op);
-                    }
-                    break;
-                }
+    portENTER_CRITICAL(&background_lock);
+    background_future_t *f = &background_futures[future];
+    f->state = FUTURE_DONE;
+    f->result = result;
+    TaskHandle_t waiter = f->waiter;
+    background_callback_t continuation = f->continuation;
+    void *continuation_arg = f->continuation_arg;
+    f->waiter = NULL;
+    f->continuation = NULL;
+    if (f->released) {
+        f->state = FUTURE_FREE;
+    }
+    portEXIT_CRITICAL(&background_lock);
 
-                case BG_TASK_SYSTEM_RESET: {
-                    ESP_LOGI(TAG, "System reset requested");
-                    // Здесь можно добавить дополнительную логику перед перезагрузкой
-                    vTaskDelay(pdMS_TO_TICKS(100)); // Небольшая задержка
-                    esp_restart();
-                    break;
-                }
+    if (waiter) {
+        xTaskNotifyGive(waiter);
+    }
+    if (continuation) {
+        continuation(result, continuation_arg);
+    }
+}
 
-                case BG_TASK_CUSTOM: {
-                    // Пользовательская операция - пока не реализована
-                    ESP_LOGW(TAG, "Custom background task not implemented");
-                    result = ESP_ERR_NOT_SUPPORTED;
-                    break;
+/**
+ * @brief Завершение задачи: её callback, затем описатель
+ */
+static void background_finish(const background_task_t *task, int future, esp_err_t result)
+{
+    if (task->callback) {
+        task->callback(result, task->callback_arg);
+    }
+    background_future_complete(future, result);
+}
+
+// ============================================================================
+// ОЧЕРЕДИ И ВЫПОЛНЕНИЕ
+// ============================================================================
+
+static uint32_t background_serial_key(const background_task_t *task)
+{
+    return task->affinity_key != BG_AFFINITY_NONE ? task->affinity_key : task->dedup_key;
+}
+
+static bool background_slot_before(const background_slot_t *a, const background_slot_t *b)
+{
+    return a->task.priority > b->task.priority ||
+           (a->task.priority == b->task.priority && (int32_t)(a->order - b->order) < 0);
+}
+
+/**
+ * @brief Можно ли начать задачу: с её ключом ничего не выполняется и
+ *        не стоит раньше. Вызывается под background_lock.
+ */
+static bool background_slot_ready(const background_slot_t *slot)
+{
+    if (slot->key == BG_AFFINITY_NONE) {
+        return true;
+    }
+    for (uint32_t w = 0; w < background_worker_count; w++) {
+        if (background_workers[w].busy && background_workers[w].running_key == slot->key) {
+            return false;
+        }
+    }
+    for (uint32_t w = 0; w < background_worker_count; w++) {
+        for (int i = 0; i < BACKGROUND_QUEUE_SIZE; i++) {
+            const background_slot_t *other = &background_workers[w].queue[i];
+            if (other->used && other != slot && other->key == slot->key &&
+                (int32_t)(other->order - slot->order) < 0) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Очередь для новой задачи: по ключу, иначе наименее загруженная.
+ *        Вызывается под background_lock.
+ */
+static background_worker_t *background_pick_worker(uint32_t key)
+{
+    if (key != BG_AFFINITY_NONE) {
+        return &background_workers[key % background_active_workers];
+    }
+
+    uint32_t start = background_next_worker++ % background_active_workers;
+    background_worker_t *best = &background_workers[start];
+    for (uint32_t n = 0; n < background_active_workers; n++) {
+        background_worker_t *w = &background_workers[(start + n) % background_active_workers];
+        if (w->queued + (w->busy ? 1 : 0) < best->queued + (best->busy ? 1 : 0)) {
+            best = w;
+        }
+    }
+    return best;
+}
+
+/**
+ * @brief Ставит задачу в очередь обработчика. Вызывается под background_lock;
+ *        место есть всегда, очередь вмещает все принятые задачи.
+ */
+static void background_queue_put(background_worker_t *worker, const background_slot_t *slot)
+{
+    for (int i = 0; i < BACKGROUND_QUEUE_SIZE; i++) {
+        background_slot_t *free_slot = &worker->queue[i];
+        if (!free_slot->used) {
+            *free_slot = *slot;
+            free_slot->used = true;
+            worker->queued++;
+            return;
+        }
+    }
+}
+
+/**
+ * @brief Лучшая задача очереди, которую можно начать. Вызывается под background_lock.
+ */
+static background_slot_t *background_queue_best(background_worker_t *worker)
+{
+    background_slot_t *best = NULL;
+    for (int i = 0; i < BACKGROUND_QUEUE_SIZE; i++) {
+        background_slot_t *slot = &worker->queue[i];
+        if (slot->used && background_slot_ready(slot) &&
+            (best == NULL || background_slot_before(slot, best))) {
+            best = slot;
+        }
+    }
+    return best;
+}
+
+/**
+ * @brief Ожидающая задача в любой из очередей: по описателю, если он задан,
+ *        иначе по типу и ключу объединения. Вызывается под background_lock.
+ * @param owner Получает обработчика, в чьей очереди задача (может быть NULL)
+ */
+static background_slot_t *background_find_slot(background_task_type_t type, uint32_t dedup_key,
+                                               int future, background_worker_t **owner)
+{
+    for (uint32_t w = 0; w < background_worker_count; w++) {
+        for (int i = 0; i < BACKGROUND_QUEUE_SIZE; i++) {
+            background_slot_t *slot = &background_workers[w].queue[i];
+            if (!slot->used) {
+                continue;
+            }
+            if (future >= 0 ? slot->future == future
+                            : (slot->task.type == type && slot->task.dedup_key == dedup_key)) {
+                if (owner) {
+                    *owner = &background_workers[w];
                 }
+                return slot;
+            }
+        }
+    }
+    return NULL;
+}
 
-                default:
-                    ESP_LOGW(TAG, "Unknown background task type: %d", task.type);
-                    result = ESP_ERR_INVALID_ARG;
-                    break;
+static void background_wake(uint32_t mask)
+{
+    for (uint32_t w = 0; w < background_worker_count; w++) {
+        if ((mask & (1u << w)) && background_workers[w].handle) {
+            xTaskNotifyGive(background_workers[w].handle);
+        }
+    }
+}
+
+/**
+ * @brief Забирает для обработчика задачу с наивысшим приоритетом, самую
+ *        раннюю из них: из своей очереди, а если в ней нечего начать -
+ *        крадёт из очереди, где задач больше всего
+ * @return false если начать нечего
+ */
+static bool background_take(background_worker_t *worker, background_slot_t *out)
+{
+    portENTER_CRITICAL(&background_lock);
+    if (worker->index >= background_active_workers) {
+        portEXIT_CRITICAL(&background_lock);
+        return false;
+    }
+    background_worker_t *owner = worker;
+    background_slot_t *best = background_queue_best(worker);
+    if (best == NULL) {
+        // Жертва - самая длинная очередь, где есть что начать
+        for (uint32_t w = 0; w < background_worker_count; w++) {
+            background_worker_t *victim = &background_workers[w];
+            if (victim == worker || (best != NULL && victim->queued <= owner->queued)) {
+                continue;
+            }
+            background_slot_t *slot = background_queue_best(victim);
+            if (slot != NULL) {
+                best = slot;
+                owner = victim;
+            }
+        }
+    }
+    if (best != NULL) {
+        *out = *best;
+        best->used = false;
+        owner->queued--;
+        background_pending--;
+        if (best->future >= 0) {
+            background_futures[best->future].state = FUTURE_RUNNING;
+        }
+        if (owner != worker) {
+            background_stats.workers[worker->index].stolen++;
+        }
+        worker->busy = true;
+        worker->running_key = best->key;
+        worker->running_type = best->task.type;
+    }
+    portEXIT_CRITICAL(&background_lock);
+    return best != NULL;
+}
+
+/**
+ * @brief Выполнение одной задачи
+ */
+static esp_err_t background_run(background_task_t *task)
+{
+    esp_err_t result = ESP_OK;
+
+    switch (task->type) {
+        case BG_TASK_NVS_SAVE: {
+            nvs_operation_t *nvs_op = (nvs_operation_t *)task->data;
+            if (nvs_op) {
+                // В кэш; во flash попадёт со следующей записью кэша
+                result = nvs_cache_set_blob(nvs_op->namespace, nvs_op->key, nvs_op->value, nvs_op->size);
+
+                // Операция и копия значения - один блок пула
+                block_pool_free(nvs_op);
+            }
+            break;
+        }
+
+        case BG_TASK_SETTINGS_SAVE: {
+            if (task->data) {
+                // Копия настроек от вызывающего, освобождаем здесь
+                result = settings_save((const touch_settings_t *)task->data);
+                block_pool_free(task->data);
+            } else {
+                // Без копии сохраняются настройки на момент выполнения, поэтому
+                // объединённые сохранения записывают последнее состояние
+                result = settings_save_current();
+            }
+            break;
+        }
+
+        case BG_TASK_SETTINGS_EXPORT: {
+            result = settings_export_to_sd();
+            break;
+        }
+
+        case BG_TASK_NVS_LOAD: {
+            nvs_operation_t *nvs_op = (nvs_operation_t *)task->data;
+            if (nvs_op) {
+                result = nvs_cache_get_blob(nvs_op->namespace, nvs_op->key, nvs_op->value, &nvs_op->size);
+                block_pool_free(nvs_op);
+            }
+            break;
+        }
+
+        case BG_TASK_NVS_ERASE: {
+            nvs_operation_t *nvs_op = (nvs_operation_t *)task->data;
+            if (nvs_op) {
+                result = nvs_cache_erase_key(nvs_op->namespace, nvs_op->key);
+                block_pool_free(nvs_op);
+            }
+            break;
+        }
+
+        case BG_TASK_NVS_FLUSH: {
+            result = nvs_cache_flush();
+            break;
+        }
+
+        case BG_TASK_ALARM_LOG: {
+            result = alarm_engine_flush_log();
+            break;
+        }
+
+        case BG_TASK_SYSTEM_RESET: {
+            ESP_LOGI(TAG, "System reset requested");
+            // Здесь можно добавить дополнительную логику перед перезагрузкой
+            vTaskDelay(pdMS_TO_TICKS(100)); // Небольшая задержка
+            esp_restart();
+            break;
+        }
+
+        case BG_TASK_SD_APPEND: {
+            sd_append_operation_t *sd_op = (sd_append_operation_t *)task->data;
+            if (sd_op) {
+                result = sd_card_append_file(sd_op->path, sd_op->text);
+                block_pool_free(sd_op);
             }
+            break;
+        }
 
-            // Вызов callback функции если она указана
-            if (task.callback) {
-                task.callback(result);
+        case BG_TASK_CUSTOM: {
+            background_custom_op_t *op = (background_custom_op_t *)task->data;
+            if (op && op->fn) {
+                result = op->fn(op->arg);
+            } else {
+                result = ESP_ERR_INVALID_ARG;
             }
+            block_pool_free(op);
+            break;
+        }
+
+        default:
+            ESP_LOGW(TAG, "Unknown background task type: %d", task->type);
+            result = ESP_ERR_INVALID_ARG;
+            break;
+    }
+
+    return result;
+}
+
+static void background_overrun_cb(void *arg)
+{
+    background_worker_t *worker = (background_worker_t *)arg;
+    portENTER_CRITICAL(&background_lock);
+    background_task_type_t type = worker->running_type;
+    background_stats.types[type].overruns++;
+    portEXIT_CRITICAL(&background_lock);
+    ESP_LOGE(TAG, "Background job %s still running past its deadline on worker %u",
+             background_task_type_name(type), (unsigned)worker->index);
+}
+
+/**
+ * @brief Основная функция обработчика очереди
+ * @param pvParameters Обработчик (background_worker_t)
+ */
+static void background_task_worker(void *pvParameters)
+{
+    background_worker_t *worker = (background_worker_t *)pvParameters;
+    background_slot_t slot;
+    background_task_t *task = &slot.task;
+
+    ESP_LOGI(TAG, "Background worker %u started on core %d", (unsigned)worker->index, xPortGetCoreID());
+
+    while (1) {
+        // Ожидание задачи: постановка будит обработчик её очереди и свободный
+        if (!background_take(worker, &slot)) {
+            ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+            continue;
+        }
+
+        ESP_LOGD(TAG, "Worker %u processing background task type: %d", (unsigned)worker->index, task->type);
+
+        int64_t start_us = esp_timer_get_time();
+        if (slot.deadline_us != 0 && start_us >= slot.deadline_us) {
+            // Срок истёк в очереди: результат уже никому не нужен
+            portENTER_CRITICAL(&background_lock);
+            background_stats.types[task->type].expired++;
+            worker->busy = false;
+            worker->running_key = BG_AFFINITY_NONE;
+            portEXIT_CRITICAL(&background_lock);
+            ESP_LOGW(TAG, "Background job %s expired after %lu ms in queue",
+                     background_task_type_name(task->type),
+                     (unsigned long)((start_us - slot.enqueued_us) / 1000));
+            block_pool_free(task->data);
+            background_finish(task, slot.future, ESP_ERR_TIMEOUT);
+            continue;
+        }
+        if (slot.deadline_us != 0 && worker->overrun_timer) {
+            esp_timer_start_once(worker->overrun_timer, (uint64_t)(slot.deadline_us - start_us));
+        }
+
+        esp_err_t result = background_run(task);
+
+        if (slot.deadline_us != 0 && worker->overrun_timer) {
+            esp_timer_stop(worker->overrun_timer);
+        }
+        int64_t end_us = esp_timer_get_time();
+        uint32_t wait_us = (uint32_t)(start_us - slot.enqueued_us);
+        uint32_t run_us = (uint32_t)(end_us - start_us);
 
-            ESP_LOGD(TAG, "Background task completed with result: %s", esp_err_to_name(result));
+        portENTER_CRITICAL(&background_lock);
+        background_type_stats_t *st = &background_stats.types[task->type];
+        st->completed++;
+        if (result != ESP_OK) {
+            st->failed++;
+        }
+        st->total_wait_us += wait_us;
+        st->total_run_us += run_us;
+        if (wait_us > st->max_wait_us) {
+            st->max_wait_us = wait_us;
+        }
+        if (run_us > st->max_run_us) {
+            st->max_run_us = run_us;
+        }
+        background_worker_stats_t *ws = &background_stats.workers[worker->index];
+        ws->completed++;
+        ws->busy_us += run_us;
+        // Задачи с тем же ключом теперь можно начать: свободные обработчики
+        // просыпаются и проверяют, нет ли среди них их задач
+        uint32_t wake = 0;
+        if (worker->running_key != BG_AFFINITY_NONE) {
+            for (uint32_t w = 0; w < background_active_workers; w++) {
+                if (w != worker->index && !background_workers[w].busy) {
+                    wake |= 1u << w;
+                }
+            }
         }
+        worker->busy = false;
+        worker->running_key = BG_AFFINITY_NONE;
+        portEXIT_CRITICAL(&background_lock);
+        background_wake(wake);
+
+        // Callback, затем ожидающий описателя и продолжение
+        background_finish(task, slot.future, result);
+
+        ESP_LOGD(TAG, "Background task completed with result: %s (waited %lu us, ran %lu us)",
+                 esp_err_to_name(result), (unsigned long)wait_us, (unsigned long)run_us);
     }
 }
 
@@ -158,31 +603,61 @@ esp_err_t background_task_init(void)
 {
     ESP_LOGI(TAG, "Initializing background task system");
 
-    // Создание очереди для задач
-    background_queue = xQueueCreate(BACKGROUND_QUEUE_SIZE, sizeof(background_task_t));
-    if (background_queue == NULL) {
-        ESP_LOGE(TAG, "Failed to create background task queue");
-        return ESP_ERR_NO_MEM;
+    memset(background_futures, 0, sizeof(background_futures));
+    memset(&background_stats, 0, sizeof(background_stats));
+    background_pending = 0;
+    background_worker_count = 0;
+
+    // Обработчики поочерёдно на обоих ядрах
+    for (uint32_t i = 0; i < BACKGROUND_WORKERS; i++) {
+        background_worker_t *worker = &background_workers[i];
+        worker->index = (uint8_t)i;
+        memset(worker->queue, 0, sizeof(worker->queue));
+        worker->queued = 0;
+        worker->busy = false;
+        worker->running_key = BG_AFFINITY_NONE;
+
+        const esp_timer_create_args_t overrun_args = {
+            .callback = background_overrun_cb,
+            .arg = worker,
+            .name = "bg_overrun"
+        };
+        if (worker->overrun_timer == NULL && esp_timer_create(&overrun_args, &worker->overrun_timer) != ESP_OK) {
+            ESP_LOGW(TAG, "No overrun timer, deadlines of running jobs are not reported");
+            worker->overrun_timer = NULL;
+        }
+
+        char name[configMAX_TASK_NAME_LEN];
+        snprintf(name, sizeof(name), "bg_worker%u", (unsigned)i);
+        BaseType_t core = (BaseType_t)(i % portNUM_PROCESSORS);
+        background_stats.workers[i].core = (uint8_t)core;
+
+        BaseType_t ret = xTaskCreatePinnedToCore(
+            background_task_worker,
+            name,
+            BACKGROUND_TASK_STACK_SIZE,
+            worker,
+            BACKGROUND_TASK_PRIORITY,
+            &worker->handle,
+            core
+        );
+
+        if (ret != pdPASS) {
+            ESP_LOGE(TAG, "Failed to create background worker %u", (unsigned)i);
+            worker->handle = NULL;
+            break;
+        }
+        background_worker_count++;
     }
 
-    // Создание фоновой задачи
-    BaseType_t ret = xTaskCreate(
-        background_task_worker,
-        "bg_worker",
-        BACKGROUND_TASK_STACK_SIZE,
-        NULL,
-        BACKGROUND_TASK_PRIORITY,
-        &background_task_handle
-    );
-
-    if (ret != pdPASS) {
-        ESP_LOGE(TAG, "Failed to create background task");
-        vQueueDelete(background_queue);
-        background_queue = NULL;
+    if (background_worker_count == 0) {
         return ESP_ERR_NO_MEM;
     }
+    background_active_workers = background_worker_count;
+    background_stats.worker_count = (uint8_t)background_worker_count;
+    background_ready = true;
 
-    ESP_LOGI(TAG, "Background task system initialized successfully");
+    ESP_LOGI(TAG, "Background task system initialized with %lu workers", (unsigned long)background_worker_count);
     return ESP_OK;
 }
 
@@ -193,37 +668,378 @@ void background_task_deinit(void)
 {
     ESP_LOGI(TAG, "Deinitializing background task system");
 
-    if (background_task_handle) {
-        vTaskDelete(background_task_handle);
-        background_task_handle = NULL;
+    background_ready = false;
+    for (uint32_t i = 0; i < background_worker_count; i++) {
+        background_worker_t *worker = &background_workers[i];
+        if (worker->handle) {
+            vTaskDelete(worker->handle);
+            worker->handle = NULL;
+        }
+        if (worker->overrun_timer) {
+            esp_timer_stop(worker->overrun_timer);
+        }
+        worker->busy = false;
     }
+    background_worker_count = 0;
+    background_active_workers = 0;
 
-    if (background_queue) {
-        vQueueDelete(background_queue);
-        background_queue = NULL;
+    // Ожидающие задачи не выполнятся: как при отмене, данные освобождаются,
+    // а callback и описатель получают ESP_ERR_INVALID_STATE
+    background_slot_t drained[BACKGROUND_QUEUE_SIZE];
+    int drained_count = 0;
+    portENTER_CRITICAL(&background_lock);
+    for (uint32_t w = 0; w < BACKGROUND_WORKERS; w++) {
+        background_worker_t *worker = &background_workers[w];
+        for (int i = 0; i < BACKGROUND_QUEUE_SIZE; i++) {
+            background_slot_t *slot = &worker->queue[i];
+            if (slot->used) {
+                drained[drained_count++] = *slot;
+                background_stats.types[slot->task.type].cancelled++;
+            }
+            slot->used = false;
+        }
+        worker->queued = 0;
+    }
+    background_pending = 0;
+    portEXIT_CRITICAL(&background_lock);
+
+    for (int i = 0; i < drained_count; i++) {
+        block_pool_free(drained[i].task.data);
+        background_finish(&drained[i].task, drained[i].future, ESP_ERR_INVALID_STATE);
+    }
+
+    // Задачи, прерванные вместе с обработчиком, тоже завершают описатели,
+    // чтобы ожидающие не висели до таймаута
+    for (int i = 0; i < BACKGROUND_MAX_HANDLES; i++) {
+        portENTER_CRITICAL(&background_lock);
+        bool running = background_futures[i].state == FUTURE_RUNNING;
+        portEXIT_CRITICAL(&background_lock);
+        if (running) {
+            background_future_complete(i, ESP_ERR_INVALID_STATE);
+        }
+    }
+    if (drained_count > 0) {
+        ESP_LOGW(TAG, "%d pending background jobs dropped", drained_count);
     }
 }
 
 /**
- * @brief Добавление задачи в очередь фоновой обработки
- * @param task Указатель на структуру задачи
- * @return ESP_OK при успехе, иначе код ошибки
+ * @brief Одна попытка постановки: замена по ключу или свободное место
+ * @param future Описатель новой задачи или -1
+ * @return ESP_OK или ESP_ERR_TIMEOUT если места для приоритета нет
  */
-esp_err_t background_task_add(background_task_t *task)
+static esp_err_t background_try_enqueue(const background_task_t *task, int future)
 {
-    if (!background_queue || !task) {
+    background_task_t replaced = { 0 };
+    int replaced_future = -1;
+    bool coalesced = false;
+    bool stored = false;
+    uint32_t wake = 0;
+    uint32_t key = background_serial_key(task);
+    int64_t now = esp_timer_get_time();
+    int64_t deadline_us = task->timeout ? now + (int64_t)pdTICKS_TO_MS(task->timeout) * 1000 : 0;
+
+    portENTER_CRITICAL(&background_lock);
+    background_type_stats_t *st = &background_stats.types[task->type];
+
+    background_slot_t *slot = NULL;
+    if (task->dedup_key != BG_DEDUP_NONE) {
+        slot = background_find_slot(task->type, task->dedup_key, -1, NULL);
+    }
+    if (slot != NULL) {
+        // Новые данные на старом месте очереди; приоритет - больший из двух
+        replaced = slot->task;
+        replaced_future = slot->future;
+        slot->task = *task;
+        if (replaced.priority > task->priority) {
+            slot->task.priority = replaced.priority;
+        }
+        slot->deadline_us = deadline_us;
+        slot->key = key;
+        slot->future = (int8_t)future;
+        st->submitted++;
+        st->coalesced++;
+        coalesced = true;
+    } else if (background_pending < background_admission_limit(task->priority)) {
+        background_worker_t *owner = background_pick_worker(key);
+        background_slot_t entry = {
+            .task = *task,
+            .order = background_order++,
+            .enqueued_us = now,
+            .deadline_us = deadline_us,
+            .key = key,
+            .future = (int8_t)future,
+        };
+        background_queue_put(owner, &entry);
+        background_pending++;
+        if (background_pending > background_stats.max_pending) {
+            background_stats.max_pending = background_pending;
+        }
+        st->submitted++;
+        stored = true;
+
+        // Владелец очереди, а если он занят - ещё и свободный, чтобы украл
+        wake = 1u << owner->index;
+        if (owner->busy) {
+            for (uint32_t w = 0; w < background_active_workers; w++) {
+                if (!background_workers[w].busy) {
+                    wake |= 1u << w;
+                    break;
+                }
+            }
+        }
+    }
+    portEXIT_CRITICAL(&background_lock);
+
+    if (coalesced) {
+        if (replaced.data != NULL && replaced.data != task->data) {
+            block_pool_free(replaced.data);
+        }
+        if (replaced.callback != NULL && replaced.callback != task->callback) {
+            replaced.callback(ESP_ERR_INVALID_STATE, replaced.callback_arg);
+        }
+        background_future_complete(replaced_future, ESP_ERR_INVALID_STATE);
+        return ESP_OK;
+    }
+    if (stored) {
+        background_wake(wake);
+        return ESP_OK;
+    }
+    return ESP_ERR_TIMEOUT;
+}
+
+static esp_err_t background_submit(const background_task_t *task, TickType_t wait, int future)
+{
+    TickType_t start = xTaskGetTickCount();
+    while (1) {
+        esp_err_t ret = background_try_enqueue(task, future);
+        if (ret == ESP_OK) {
+            return ESP_OK;
+        }
+        TickType_t waited = xTaskGetTickCount() - start;
+        if (waited >= wait) {
+            break;
+        }
+        TickType_t step = pdMS_TO_TICKS(BACKGROUND_SUBMIT_POLL_MS);
+        vTaskDelay(step < wait - waited ? step : wait - waited);
+    }
+
+    // Явный отказ: вызывающий решает, повторить позже или сообщить пользователю
+    portENTER_CRITICAL(&background_lock);
+    background_stats.types[task->type].rejected++;
+    portEXIT_CRITICAL(&background_lock);
+    ESP_LOGW(TAG, "Background queue full for %s (priority %d)",
+             background_task_type_name(task->type), task->priority);
+    return ESP_ERR_TIMEOUT;
+}
+
+esp_err_t background_task_submit(const background_task_t *task, TickType_t wait)
+{
+    if (!task || task->type >= BG_TASK_TYPE_COUNT) {
         return ESP_ERR_INVALID_ARG;
     }
+    if (!background_ready) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    return background_submit(task, wait, -1);
+}
 
-    // Убираем блокировку - если очередь полна, возвращаем ошибку немедленно
-    if (xQueueSend(background_queue, task, 0) != pdTRUE) {
-        ESP_LOGW(TAG, "Failed to add task to background queue - queue full");
-        return ESP_ERR_TIMEOUT;
+esp_err_t background_task_submit_handle(const background_task_t *task, TickType_t wait,
+                                        background_handle_t *handle)
+{
+    if (!task || task->type >= BG_TASK_TYPE_COUNT || !handle) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    *handle = BG_HANDLE_INVALID;
+    if (!background_ready) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    background_handle_t h;
+    portENTER_CRITICAL(&background_lock);
+    int future = background_future_alloc(&h);
+    portEXIT_CRITICAL(&background_lock);
+    if (future < 0) {
+        ESP_LOGW(TAG, "No free background job handle");
+        return ESP_ERR_NO_MEM;
     }
 
+    esp_err_t ret = background_submit(task, wait, future);
+    if (ret != ESP_OK) {
+        portENTER_CRITICAL(&background_lock);
+        background_futures[future].state = FUTURE_FREE;
+        portEXIT_CRITICAL(&background_lock);
+        return ret;
+    }
+    *handle = h;
     return ESP_OK;
 }
 
+esp_err_t background_task_wait(background_handle_t handle, TickType_t timeout, esp_err_t *result)
+{
+    TaskHandle_t self = xTaskGetCurrentTaskHandle();
+    TickType_t start = xTaskGetTickCount();
+
+    while (1) {
+        portENTER_CRITICAL(&background_lock);
+        background_future_t *f = background_future_find(handle);
+        if (f == NULL) {
+            portEXIT_CRITICAL(&background_lock);
+            return ESP_ERR_INVALID_ARG;
+        }
+        if (f->state == FUTURE_DONE) {
+            if (result) {
+                *result = f->result;
+            }
+            portEXIT_CRITICAL(&background_lock);
+            return ESP_OK;
+        }
+        TickType_t waited = xTaskGetTickCount() - start;
+        if (waited >= timeout) {
+            if (f->waiter == self) {
+                f->waiter = NULL;
+            }
+            portEXIT_CRITICAL(&background_lock);
+            return ESP_ERR_TIMEOUT;
+        }
+        f->waiter = self;
+        portEXIT_CRITICAL(&background_lock);
+
+        // Будит background_future_complete(); состояние проверяется заново
+        ulTaskNotifyTake(pdTRUE, timeout - waited);
+    }
+}
+
+esp_err_t background_task_cancel(background_handle_t handle)
+{
+    background_slot_t cancelled = { 0 };
+    bool found = false;
+
+    portENTER_CRITICAL(&background_lock);
+    background_future_t *f = background_future_find(handle);
+    if (f != NULL && f->state == FUTURE_QUEUED) {
+        background_worker_t *owner;
+        background_slot_t *slot = background_find_slot(BG_TASK_TYPE_COUNT, BG_DEDUP_NONE,
+                                                       (int)(f - background_futures), &owner);
+        if (slot != NULL) {
+            cancelled = *slot;
+            slot->used = false;
+            owner->queued--;
+            background_pending--;
+            background_stats.types[slot->task.type].cancelled++;
+            found = true;
+        }
+    }
+    portEXIT_CRITICAL(&background_lock);
+
+    if (!found) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    block_pool_free(cancelled.task.data);
+    background_finish(&cancelled.task, cancelled.future, ESP_ERR_INVALID_STATE);
+    return ESP_OK;
+}
+
+esp_err_t background_task_then(background_handle_t handle, background_callback_t continuation, void *arg)
+{
+    if (!continuation) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    portENTER_CRITICAL(&background_lock);
+    background_future_t *f = background_future_find(handle);
+    if (f == NULL) {
+        portEXIT_CRITICAL(&background_lock);
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (f->continuation != NULL) {
+        portEXIT_CRITICAL(&background_lock);
+        return ESP_ERR_INVALID_STATE;
+    }
+    if (f->state != FUTURE_DONE) {
+        f->continuation = continuation;
+        f->continuation_arg = arg;
+        portEXIT_CRITICAL(&background_lock);
+        return ESP_OK;
+    }
+    esp_err_t result = f->result;
+    portEXIT_CRITICAL(&background_lock);
+
+    // Уже завершена: продолжение выполняется сразу
+    continuation(result, arg);
+    return ESP_OK;
+}
+
+bool background_task_is_pending(background_handle_t handle)
+{
+    portENTER_CRITICAL(&background_lock);
+    background_future_t *f = background_future_find(handle);
+    bool pending = f != NULL && (f->state == FUTURE_QUEUED || f->state == FUTURE_RUNNING);
+    portEXIT_CRITICAL(&background_lock);
+    return pending;
+}
+
+void background_task_release(background_handle_t handle)
+{
+    portENTER_CRITICAL(&background_lock);
+    background_future_t *f = background_future_find(handle);
+    if (f != NULL) {
+        if (f->state == FUTURE_DONE) {
+            f->state = FUTURE_FREE;
+        } else {
+            f->released = true;
+        }
+    }
+    portEXIT_CRITICAL(&background_lock);
+}
+
+uint32_t background_affinity_key(const char *name)
+{
+    uint32_t hash = 2166136261u;
+    for (const char *c = name; c && *c; c++) {
+        hash = (hash ^ (uint8_t)*c) * 16777619u;
+    }
+    return hash != BG_AFFINITY_NONE ? hash : 1;
+}
+
+esp_err_t background_task_set_active_workers(uint32_t count)
+{
+    if (count == 0 || count > background_worker_count) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    portENTER_CRITICAL(&background_lock);
+    background_active_workers = count;
+    // Задачи из очередей отключённых обработчиков переходят в очереди активных
+    for (uint32_t w = count; w < background_worker_count; w++) {
+        background_worker_t *worker = &background_workers[w];
+        for (int i = 0; i < BACKGROUND_QUEUE_SIZE; i++) {
+            background_slot_t *slot = &worker->queue[i];
+            if (slot->used) {
+                background_queue_put(background_pick_worker(slot->key), slot);
+                slot->used = false;
+            }
+        }
+        worker->queued = 0;
+    }
+    portEXIT_CRITICAL(&background_lock);
+
+    ESP_LOGI(TAG, "Background workers active: %lu of %lu",
+             (unsigned long)count, (unsigned long)background_worker_count);
+    background_wake((1u << count) - 1);
+    return ESP_OK;
+}
+
+/**
+ * @brief Добавление задачи в очередь фоновой обработки
+ * @param task Указатель на структуру задачи
+ * @return ESP_OK при успехе, иначе код ошибки
+ */
+esp_err_t background_task_add(background_task_t *task)
+{
+    return background_task_submit(task, 0);
+}
+
 /**
  * @brief Синхронное выполнение NVS операции сохранения
  * @param namespace NVS namespace
@@ -238,19 +1054,8 @@ esp_err_t background_nvs_save(const char *namespace, const char *key, const void
         return ESP_ERR_INVALID_ARG;
     }
 
-    nvs_handle_t nvs_handle;
-    esp_err_t ret = nvs_open(namespace, NVS_READWRITE, &nvs_handle);
-    if (ret != ESP_OK) {
-        return ret;
-    }
-
-    ret = nvs_set_blob(nvs_handle, key, value, size);
-    if (ret == ESP_OK) {
-        ret = nvs_commit(nvs_handle);
-    }
-
-    nvs_close(nvs_handle);
-    return ret;
+    // Запись в кэш; flash пишется пакетом после паузы в изменениях
+    return nvs_cache_set_blob(namespace, key, value, size);
 }
 
 /**
@@ -267,15 +1072,7 @@ esp_err_t background_nvs_load(const char *namespace, const char *key, void *valu
         return ESP_ERR_INVALID_ARG;
     }
 
-    nvs_handle_t nvs_handle;
-    esp_err_t ret = nvs_open(namespace, NVS_READONLY, &nvs_handle);
-    if (ret != ESP_OK) {
-        return ret;
-    }
-
-    ret = nvs_get_blob(nvs_handle, key, value, &size);
-    nvs_close(nvs_handle);
-    return ret;
+    return nvs_cache_get_blob(namespace, key, value, &size);
 }
 
 /**
@@ -290,19 +1087,7 @@ esp_err_t background_nvs_erase(const char *namespace, const char *key)
         return ESP_ERR_INVALID_ARG;
     }
 
-    nvs_handle_t nvs_handle;
-    esp_err_t ret = nvs_open(namespace, NVS_READWRITE, &nvs_handle);
-    if (ret != ESP_OK) {
-        return ret;
-    }
-
-    ret = nvs_erase_key(nvs_handle, key);
-    if (ret == ESP_OK) {
-        ret = nvs_commit(nvs_handle);
-    }
-
-    nvs_close(nvs_handle);
-    return ret;
+    return nvs_cache_erase_key(namespace, key);
 }
 
 /**
@@ -316,34 +1101,20 @@ esp_err_t background_nvs_erase(const char *namespace, const char *key)
  * @return ESP_OK при успехе, иначе код ошибки
  */
 esp_err_t background_nvs_save_async(const char *namespace, const char *key, const void *value, size_t size,
-                                   void (*callback)(esp_err_t), void *callback_arg)
+                                   background_callback_t callback, void *callback_arg)
 {
     if (!namespace || !key || !value || size == 0) {
         return ESP_ERR_INVALID_ARG;
     }
 
-    void *value_copy;
-    nvs_operation_t *nvs_op;
-
-    if (size <= sizeof(static_data_buffer)) {
-        // Используем статический буфер для избежания malloc
-        value_copy = static_data_buffer;
-        nvs_op = &static_nvs_operation;
-        memcpy(value_copy, value, size);
-    } else {
-        // Для больших данных используем динамическую память
-        value_copy = malloc(size);
-        if (!value_copy) {
-            return ESP_ERR_NO_MEM;
-        }
-        memcpy(value_copy, value, size);
-
-        nvs_op = malloc(sizeof(nvs_operation_t));
-        if (!nvs_op) {
-            free(value_copy);
-            return ESP_ERR_NO_MEM;
-        }
+    // Операция и копия значения одним блоком пула: у каждого сохранения своя
+    // копия, даже если предыдущее ещё в очереди
+    nvs_operation_t *nvs_op = block_pool_alloc(sizeof(nvs_operation_t) + size);
+    if (!nvs_op) {
+        return ESP_ERR_NO_MEM;
     }
+    void *value_copy = nvs_op + 1;
+    memcpy(value_copy, value, size);
 
     // Заполнение структуры операции
     nvs_op->namespace = namespace;
@@ -351,28 +1122,43 @@ esp_err_t background_nvs_save_async(const char *namespace, const char *key, cons
     nvs_op->value = value_copy;
     nvs_op->size = size;
 
-    // Создание фоновой задачи
+    // Создание фоновой задачи; записи одного namespace идут по порядку
     background_task_t task = {
         .type = BG_TASK_NVS_SAVE,
         .data = nvs_op,
         .data_size = sizeof(nvs_operation_t),
         .callback = callback,
         .callback_arg = callback_arg,
-        .timeout = pdMS_TO_TICKS(5000) // 5 секунд таймаут
+        .timeout = pdMS_TO_TICKS(5000), // 5 секунд таймаут
+        .affinity_key = background_affinity_key(namespace)
     };
 
     esp_err_t result = background_task_add(&task);
 
-    // Если задача не была добавлена и мы использовали динамическую память, освобождаем её
-    if (result != ESP_OK && size > sizeof(static_data_buffer)) {
-        // Освобождаем динамическую память при ошибке
-        free(value_copy);
-        free(nvs_op);
+    // Задача не добавлена: блок возвращается в пул
+    if (result != ESP_OK) {
+        block_pool_free(nvs_op);
     }
 
     return result;
 }
 
+/**
+ * @brief Асинхронная дозапись текста в файл на SD карте
+ * @param path Путь к файлу (строковая константа)
+ * @param text Текст для дозаписи (копируется)
+ * @return ESP_OK при успехе, иначе код ошибки
+ */
+esp_err_t background_sd_append_async(const char *path, const char *text)
+{
+    if (!path || !text) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    // Обслуживается задачей ввода-вывода SD, которая объединяет дозаписи в один файл
+    return sd_card_append_async(path, text, strlen(text));
+}
+
 /**
  * @brief Получение статуса очереди задач
  * @param pending_count Указатель для количества ожидающих задач
@@ -384,10 +1170,38 @@ esp_err_t background_task_get_status(UBaseType_t *pending_count)
         return ESP_ERR_INVALID_ARG;
     }
 
-    if (!background_queue) {
+    if (!background_ready) {
         return ESP_ERR_INVALID_STATE;
     }
 
-    *pending_count = uxQueueMessagesWaiting(background_queue);
+    portENTER_CRITICAL(&background_lock);
+    *pending_count = background_pending;
+    portEXIT_CRITICAL(&background_lock);
     return ESP_OK;
 }
+
+void background_task_get_stats(background_stats_t *stats)
+{
+    if (!stats) {
+        return;
+    }
+    portENTER_CRITICAL(&background_lock);
+    *stats = background_stats;
+    stats->pending = background_pending;
+    stats->active_workers = (uint8_t)background_active_workers;
+    stats->handles_in_use = 0;
+    for (int i = 0; i < BACKGROUND_MAX_HANDLES; i++) {
+        if (background_futures[i].state != FUTURE_FREE) {
+            stats->handles_in_use++;
+        }
+    }
+    portEXIT_CRITICAL(&background_lock);
+}
+
+const char *background_task_type_name(background_task_type_t type)
+{
+    if ((unsigned)type >= BG_TASK_TYPE_COUNT || background_type_names[type] == NULL) {
+        return "unknown";
+    }
+    return background_type_names[type];
+}
@@ -6,30 +6,116 @@
 #ifndef BACKGROUND_TASK_H
 #define BACKGROUND_TASK_H
 
+#include <stdbool.h>
 #include "esp_err.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/queue.h"
+#include "sdkconfig.h"
+
+// Обработчики очереди (задачи bg_workerN), CONFIG_BACKGROUND_WORKERS из menuconfig
+#define BACKGROUND_MAX_WORKERS      4
 
 // Типы операций для фоновой обработки
 typedef enum {
     BG_TASK_NVS_SAVE,           // Сохранение в NVS
-    BG_TASK_SETTINGS_SAVE,      // Сохранение настроек (NVS + SD)
+    BG_TASK_SETTINGS_SAVE,      // Сохранение настроек в NVS
+    BG_TASK_SETTINGS_EXPORT,    // Запись копии настроек на SD карту
     BG_TASK_NVS_LOAD,           // Загрузка из NVS
     BG_TASK_NVS_ERASE,          // Удаление из NVS
     BG_TASK_SYSTEM_RESET,       // Сброс системы
-    BG_TASK_CUSTOM              // Пользовательская операция
+    BG_TASK_SD_APPEND,          // Дозапись строки в файл на SD карте
+    BG_TASK_NVS_FLUSH,          // Запись изменённых ключей кэша NVS во flash
+    BG_TASK_ALARM_LOG,          // Запись событий тревог в журнал (alarm_engine)
+    BG_TASK_CUSTOM,             // Пользовательская функция (data - background_custom_op_t)
+    BG_TASK_TYPE_COUNT
 } background_task_type_t;
 
+// Приоритет задачи. NORMAL = 0, чтобы задачи без явного приоритета
+// (нулевая инициализация) оставались обычными.
+typedef enum {
+    BG_PRIORITY_LOW = -1,       // Выполняется последней, первой получает отказ
+    BG_PRIORITY_NORMAL = 0,
+    BG_PRIORITY_HIGH = 1        // Может занять резервные места очереди
+} background_priority_t;
+
+// Ключ объединения: задача с тем же типом и ключом заменяет ожидающую
+#define BG_DEDUP_NONE               0
+#define BG_DEDUP_KEY(type, id)      ((((uint32_t)(type) + 1) << 16) | ((uint32_t)(id) & 0xFFFF))
+
+// Ключ сериализации: задачи с одним ключом выполняются по одной, в порядке
+// постановки, на любом из обработчиков. Без ключа сериализуются задачи
+// с одинаковым dedup_key.
+#define BG_AFFINITY_NONE            0
+
+// Завершение задачи: результат и callback_arg / аргумент продолжения.
+// Вызывается в задаче bg_workerN (или в вызывающей, если задача уже завершена).
+typedef void (*background_callback_t)(esp_err_t result, void *arg);
+
+// Описатель задачи для ожидания, отмены и продолжения (future).
+// 0 - недействительный; описатель нужно освободить background_task_release().
+typedef uint32_t background_handle_t;
+
+#define BG_HANDLE_INVALID           0
+
 // Структура фоновой задачи
 typedef struct {
     background_task_type_t type;    // Тип операции
-    void *data;                     // Данные для операции
+    void *data;                     // Данные для операции; принадлежащие очереди
+                                    // выделяются block_pool_alloc() (malloc тоже допустим)
     size_t data_size;               // Размер данных
-    void (*callback)(esp_err_t);    // Callback функция по завершении
+    background_callback_t callback; // Callback функция по завершении
     void *callback_arg;             // Аргумент для callback
-    TickType_t timeout;             // Таймаут операции
+    TickType_t timeout;             // Срок от постановки до завершения (0 - без срока):
+                                    // не начатая к сроку задача завершается с ESP_ERR_TIMEOUT,
+                                    // выполняющаяся дольше срока попадает в журнал и overruns
+    background_priority_t priority; // Порядок выполнения и доступ к резерву очереди
+    uint32_t dedup_key;             // BG_DEDUP_NONE или BG_DEDUP_KEY(); data такой задачи
+                                    // должна быть NULL или своей (освобождается при замене)
+    uint32_t affinity_key;          // BG_AFFINITY_NONE или background_affinity_key()
 } background_task_t;
 
+// Данные BG_TASK_CUSTOM; принадлежат очереди, как nvs_operation_t
+typedef esp_err_t (*background_custom_fn_t)(void *arg);
+
+typedef struct {
+    background_custom_fn_t fn;
+    void *arg;
+} background_custom_op_t;
+
+// Счётчики по типу задачи
+typedef struct {
+    uint32_t submitted;             // Принято в очередь (включая замены)
+    uint32_t completed;
+    uint32_t failed;                // Завершились с ошибкой (входят в completed)
+    uint32_t coalesced;             // Заменили ожидающую задачу с тем же ключом
+    uint32_t rejected;              // Очередь заполнена для этого приоритета
+    uint32_t cancelled;             // Отменены до начала выполнения
+    uint32_t expired;               // Срок истёк в очереди, не выполнялись
+    uint32_t overruns;              // Выполнялись дольше срока
+    uint64_t total_wait_us;         // Время в очереди, сумма по completed
+    uint32_t max_wait_us;
+    uint64_t total_run_us;          // Время выполнения, сумма по completed
+    uint32_t max_run_us;
+} background_type_stats_t;
+
+// Счётчики обработчика
+typedef struct {
+    uint32_t completed;             // Выполнено, включая украденные
+    uint32_t stolen;                // Взяты из очереди другого обработчика
+    uint64_t busy_us;               // Время выполнения задач
+    uint8_t core;
+} background_worker_stats_t;
+
+typedef struct {
+    background_type_stats_t types[BG_TASK_TYPE_COUNT];
+    background_worker_stats_t workers[BACKGROUND_MAX_WORKERS];
+    uint8_t worker_count;           // Создано обработчиков
+    uint8_t active_workers;         // Из них берут задачи
+    uint32_t pending;               // Задач в очереди сейчас
+    uint32_t max_pending;
+    uint32_t handles_in_use;        // Неосвобождённые описатели
+} background_stats_t;
+
 // Структура для NVS операций
 typedef struct {
     const char *namespace;           // NVS namespace
@@ -38,6 +124,12 @@ typedef struct {
     size_t size;                     // Размер значения
 } nvs_operation_t;
 
+// Структура для дозаписи на SD карту (текст хранится сразу за структурой)
+typedef struct {
+    const char *path;                // Путь к файлу (строка должна жить до завершения операции)
+    char text[];                     // Текст для дозаписи
+} sd_append_operation_t;
+
 /**
  * @brief Инициализация фоновой задачи
  * @return ESP_OK при успехе, иначе код ошибки
@@ -45,19 +137,57 @@ typedef struct {
 esp_err_t background_task_init(void);
 
 /**
- * @brief Деинициализация фоновой задачи
+ * @brief Деинициализация фоновой задачи. Задачи из очереди не выполняются:
+ *        их данные освобождаются, callback и описатели получают
+ *        ESP_ERR_INVALID_STATE, как при background_task_cancel()
  */
 void background_task_deinit(void);
 
 /**
- * @brief Добавление задачи в очередь фоновой обработки
- * @param task Указатель на структуру задачи
- * @return ESP_OK при успехе, иначе код ошибки
+ * @brief Добавление задачи в очередь фоновой обработки без ожидания
+ * @param task Указатель на структуру задачи (копируется)
+ * @return ESP_OK, ESP_ERR_TIMEOUT если очередь заполнена для приоритета задачи
  */
 esp_err_t background_task_add(background_task_t *task);
 
+/**
+ * @brief Добавление задачи с ожиданием места в очереди.
+ *
+ * У каждого обработчика своя очередь. Задача ставится в одну из них:
+ * с ключом сериализации - по ключу, иначе - в наименее загруженную.
+ * Обработчик выполняет задачи своей очереди по приоритету, внутри
+ * приоритета - по порядку постановки, а когда в ней нечего начать - крадёт
+ * из самой длинной чужой. Задача с ключом не начинается, пока
+ * выполняется или стоит раньше неё задача с тем же ключом. Допуск - по
+ * числу задач во всех очередях вместе: LOW принимаются, пока занято меньше
+ * половины мест, NORMAL - пока свободно больше резерва, HIGH - до конца.
+ * Задача с ключом объединения заменяет ожидающую задачу того же типа
+ * и ключа, сохраняя её место в очереди; callback заменённой задачи
+ * вызывается с ESP_ERR_INVALID_STATE, если он отличается от нового,
+ * а её описатель завершается с ESP_ERR_INVALID_STATE.
+ *
+ * @param task Указатель на структуру задачи (копируется)
+ * @param wait Сколько ждать места в очереди (0 - не ждать)
+ * @return ESP_OK, ESP_ERR_INVALID_ARG, ESP_ERR_INVALID_STATE до инициализации,
+ *         ESP_ERR_TIMEOUT если место не освободилось (задача не принята)
+ */
+esp_err_t background_task_submit(const background_task_t *task, TickType_t wait);
+
+/**
+ * @brief Ключ сериализации по имени (FNV-1a), никогда не BG_AFFINITY_NONE
+ */
+uint32_t background_affinity_key(const char *name);
+
+/**
+ * @brief Сколько обработчиков берут задачи (1..worker_count). Остальные
+ *        доделывают текущую задачу и ждут; их очереди переходят к активным.
+ * @return ESP_OK, ESP_ERR_INVALID_ARG
+ */
+esp_err_t background_task_set_active_workers(uint32_t count);
+
 /**
  * @brief Синхронное выполнение NVS операции сохранения
+ *        Через кэш nvs_cache: flash пишется позже, пакетом по namespace
  * @param namespace NVS namespace
  * @param key NVS ключ
  * @param value Указатель на данные
@@ -67,7 +197,7 @@ esp_err_t background_task_add(background_task_t *task);
 esp_err_t background_nvs_save(const char *namespace, const char *key, const void *value, size_t size);
 
 /**
- * @brief Синхронное выполнение NVS операции загрузки
+ * @brief Синхронное выполнение NVS операции загрузки (из кэша nvs_cache)
  * @param namespace NVS namespace
  * @param key NVS ключ
  * @param value Указатель на буфер для данных
@@ -84,6 +214,51 @@ esp_err_t background_nvs_load(const char *namespace, const char *key, void *valu
  */
 esp_err_t background_nvs_erase(const char *namespace, const char *key);
 
+/**
+ * @brief То же, что background_task_submit(), но возвращает описатель
+ *        для ожидания, отмены и продолжения
+ * @param handle Описатель; освобождается background_task_release()
+ * @return Как background_task_submit(), ESP_ERR_NO_MEM если заняты все описатели
+ */
+esp_err_t background_task_submit_handle(const background_task_t *task, TickType_t wait,
+                                        background_handle_t *handle);
+
+/**
+ * @brief Ожидание завершения задачи через уведомление вызывающей задачи
+ *        (xTaskNotifyGive, как в запросах SD). Одновременно ждать может
+ *        только одна задача.
+ * @param result Результат задачи (ESP_ERR_INVALID_STATE - заменена или отменена,
+ *               ESP_ERR_TIMEOUT - истёк срок в очереди)
+ * @return ESP_OK если задача завершена, ESP_ERR_TIMEOUT если нет,
+ *         ESP_ERR_INVALID_ARG для неизвестного описателя
+ */
+esp_err_t background_task_wait(background_handle_t handle, TickType_t timeout, esp_err_t *result);
+
+/**
+ * @brief Отмена задачи, ещё не начавшей выполнение. Её данные
+ *        освобождаются, callback и продолжение получают ESP_ERR_INVALID_STATE.
+ * @return ESP_OK, ESP_ERR_INVALID_STATE если задача уже выполняется или завершена
+ */
+esp_err_t background_task_cancel(background_handle_t handle);
+
+/**
+ * @brief Продолжение: вызывается один раз по завершении задачи в bg_workerN,
+ *        или сразу в вызывающей задаче, если задача уже завершена.
+ * @return ESP_OK, ESP_ERR_INVALID_STATE если продолжение уже задано
+ */
+esp_err_t background_task_then(background_handle_t handle, background_callback_t continuation, void *arg);
+
+/**
+ * @brief true пока задача в очереди или выполняется
+ */
+bool background_task_is_pending(background_handle_t handle);
+
+/**
+ * @brief Освобождение описателя. Незавершённая задача выполнится как
+ *        обычно (с продолжением), описатель освободится по её завершении.
+ */
+void background_task_release(background_handle_t handle);
+
 /**
  * @brief Асинхронное выполнение NVS операции сохранения
  * @param namespace NVS namespace
@@ -95,7 +270,15 @@ esp_err_t background_nvs_erase(const char *namespace, const char *key);
  * @return ESP_OK при успехе, иначе код ошибки
  */
 esp_err_t background_nvs_save_async(const char *namespace, const char *key, const void *value, size_t size,
-                                   void (*callback)(esp_err_t), void *callback_arg);
+                                   background_callback_t callback, void *callback_arg);
+
+/**
+ * @brief Асинхронная дозапись текста в файл на SD карте
+ * @param path Путь к файлу (строковая константа)
+ * @param text Текст для дозаписи (копируется)
+ * @return ESP_OK при успехе, иначе код ошибки
+ */
+esp_err_t background_sd_append_async(const char *path, const char *text);
 
 /**
  * @brief Получение статуса очереди задач
@@ -104,4 +287,14 @@ esp_err_t background_nvs_save_async(const char *namespace, const char *key, cons
  */
 esp_err_t background_task_get_status(UBaseType_t *pending_count);
 
+/**
+ * @brief Копия счётчиков очереди и задач по типам
+ */
+void background_task_get_stats(background_stats_t *stats);
+
+/**
+ * @brief Имя типа задачи для логов и метрик ("settings_save")
+ */
+const char *background_task_type_name(background_task_type_t type);
+
 #endif // BACKGROUND_TASK_H
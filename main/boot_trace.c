@@ -0,0 +1,204 @@
+/*
+ * Boot Trace for ECU Dashboard
+ * Start and end times of the boot stages, and a runner for stages that
+ * do not depend on each other
+ */
+
+#include "boot_trace.h"
+#include <stdio.h>
+#include <string.h>
+#include <stdbool.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/event_groups.h"
+#include "esp_timer.h"
+#include "esp_log.h"
+
+static const char *TAG = "BOOT";
+
+static boot_trace_entry_t entries[BOOT_TRACE_MAX_ENTRIES];
+static size_t entry_count = 0;
+static portMUX_TYPE trace_lock = portMUX_INITIALIZER_UNLOCKED;
+
+// One stage task of boot_trace_run_stages()
+typedef struct {
+    const boot_stage_t *stage;
+    uint32_t bit;
+    esp_err_t result;
+} stage_ctx_t;
+
+static stage_ctx_t stage_ctx[BOOT_STAGE_MAX];
+
+// Static: a stage task may still be inside xEventGroupSetBits() when the
+// runner wakes up on the other core, so the group is never deleted
+static StaticEventGroup_t stage_group_buf;
+static EventGroupHandle_t stage_group = NULL;
+
+static int trace_add(const char *name, int64_t now, bool milestone)
+{
+    int id = -1;
+    portENTER_CRITICAL(&trace_lock);
+    if (entry_count < BOOT_TRACE_MAX_ENTRIES) {
+        id = (int)entry_count++;
+        boot_trace_entry_t *e = &entries[id];
+        strncpy(e->name, name, sizeof(e->name) - 1);
+        e->name[sizeof(e->name) - 1] = '\0';
+        e->start_us = now;
+        e->end_us = milestone ? now : 0;
+        e->result = ESP_OK;
+        e->core = (int8_t)xPortGetCoreID();
+    }
+    portEXIT_CRITICAL(&trace_lock);
+    return id;
+}
+
+int boot_trace_begin(const char *name)
+{
+    if (name == NULL) {
+        return -1;
+    }
+    return trace_add(name, esp_timer_get_time(), false);
+}
+
+void boot_trace_end(int id, esp_err_t result)
+{
+    int64_t now = esp_timer_get_time();
+    portENTER_CRITICAL(&trace_lock);
+    if (id >= 0 && (size_t)id < entry_count) {
+        entries[id].end_us = now;
+        entries[id].result = result;
+    }
+    portEXIT_CRITICAL(&trace_lock);
+}
+
+void boot_trace_mark(const char *name)
+{
+    if (name == NULL) {
+        return;
+    }
+    int64_t now = esp_timer_get_time();
+    trace_add(name, now, true);
+    ESP_LOGI(TAG, "%s at %lu ms", name, (unsigned long)(now / 1000));
+}
+
+size_t boot_trace_get(boot_trace_entry_t *out, size_t max)
+{
+    if (out == NULL) {
+        return 0;
+    }
+    portENTER_CRITICAL(&trace_lock);
+    size_t n = entry_count < max ? entry_count : max;
+    memcpy(out, entries, n * sizeof(boot_trace_entry_t));
+    portEXIT_CRITICAL(&trace_lock);
+    return n;
+}
+
+void boot_trace_log(void)
+{
+    static boot_trace_entry_t copy[BOOT_TRACE_MAX_ENTRIES];
+    size_t n = boot_trace_get(copy, BOOT_TRACE_MAX_ENTRIES);
+
+    ESP_LOGI(TAG, "%-16s %8s %8s %4s  %s", "stage", "start ms", "took ms", "core", "result");
+    for (size_t i = 0; i < n; i++) {
+        const boot_trace_entry_t *e = &copy[i];
+        if (e->end_us == e->start_us) {
+            ESP_LOGI(TAG, "%-16s %8lu %8s %4d", e->name, (unsigned long)(e->start_us / 1000), "-", e->core);
+        } else if (e->end_us == 0) {
+            ESP_LOGI(TAG, "%-16s %8lu %8s %4d  running", e->name, (unsigned long)(e->start_us / 1000), "-", e->core);
+        } else {
+            ESP_LOGI(TAG, "%-16s %8lu %8lu %4d  %s", e->name, (unsigned long)(e->start_us / 1000),
+                     (unsigned long)((e->end_us - e->start_us) / 1000), e->core, esp_err_to_name(e->result));
+        }
+    }
+}
+
+// ============================================================================
+// STAGE RUNNER
+// ============================================================================
+
+static void stage_task(void *arg)
+{
+    stage_ctx_t *ctx = (stage_ctx_t *)arg;
+    const boot_stage_t *stage = ctx->stage;
+
+    if (stage->after != 0) {
+        xEventGroupWaitBits(stage_group, stage->after, pdFALSE, pdTRUE, portMAX_DELAY);
+    }
+
+    int id = boot_trace_begin(stage->name);
+    esp_err_t ret = stage->fn ? stage->fn() : ESP_OK;
+    boot_trace_end(id, ret);
+    if (ret != ESP_OK) {
+        ESP_LOGW(TAG, "Stage %s failed: %s", stage->name, esp_err_to_name(ret));
+    }
+
+    ctx->result = ret;
+    xEventGroupSetBits(stage_group, ctx->bit);
+    vTaskDelete(NULL);
+}
+
+/**
+ * @brief Every `after` names an existing stage and the table has no cycle
+ */
+static bool stages_valid(const boot_stage_t *stages, size_t count)
+{
+    uint32_t all = (count >= 32) ? UINT32_MAX : (1u << count) - 1;
+    for (size_t i = 0; i < count; i++) {
+        if ((stages[i].after & ~all) != 0 || (stages[i].after & BOOT_STAGE(i)) != 0) {
+            return false;
+        }
+    }
+
+    // Stages whose dependencies are all resolved resolve in turn; a cycle stalls
+    uint32_t resolved = 0;
+    bool progress = true;
+    while (progress) {
+        progress = false;
+        for (size_t i = 0; i < count; i++) {
+            if (!(resolved & BOOT_STAGE(i)) && (stages[i].after & ~resolved) == 0) {
+                resolved |= BOOT_STAGE(i);
+                progress = true;
+            }
+        }
+    }
+    return resolved == all;
+}
+
+esp_err_t boot_trace_run_stages(const boot_stage_t *stages, size_t count)
+{
+    if (stages == NULL || count == 0 || count > BOOT_STAGE_MAX || !stages_valid(stages, count)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    if (stage_group == NULL) {
+        stage_group = xEventGroupCreateStatic(&stage_group_buf);
+    }
+    xEventGroupClearBits(stage_group, BOOT_STAGE(count) - 1);
+
+    UBaseType_t priority = uxTaskPriorityGet(NULL);
+    for (size_t i = 0; i < count; i++) {
+        stage_ctx_t *ctx = &stage_ctx[i];
+        ctx->stage = &stages[i];
+        ctx->bit = BOOT_STAGE(i);
+        ctx->result = ESP_OK;
+
+        char name[configMAX_TASK_NAME_LEN];
+        snprintf(name, sizeof(name), "boot_%s", stages[i].name);
+        uint32_t stack = stages[i].stack_size ? stages[i].stack_size : BOOT_STAGE_STACK_DEFAULT;
+        if (xTaskCreatePinnedToCore(stage_task, name, stack, ctx, priority, NULL, stages[i].core) != pdPASS) {
+            // Dependent stages still run and find this one's work missing
+            ESP_LOGE(TAG, "No task for stage %s", stages[i].name);
+            ctx->result = ESP_ERR_NO_MEM;
+            xEventGroupSetBits(stage_group, ctx->bit);
+        }
+    }
+
+    xEventGroupWaitBits(stage_group, BOOT_STAGE(count) - 1, pdFALSE, pdTRUE, portMAX_DELAY);
+
+    for (size_t i = 0; i < count; i++) {
+        if (stage_ctx[i].result != ESP_OK) {
+            return stage_ctx[i].result;
+        }
+    }
+    return ESP_OK;
+}
@@ -0,0 +1,368 @@
+/*
+ * CAN Trace Reader for ECU Dashboard
+ * Block-verified decoding and index-assisted seeking, see can_log_reader.h
+ */
+
+#include "include/can_log_reader.h"
+#include "lz4_block.h"
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+
+#ifdef ESP_PLATFORM
+#include "esp_heap_caps.h"
+#include "esp_rom_crc.h"
+#endif
+
+// ============================================================================
+// PLATFORM HELPERS
+// ============================================================================
+
+static uint32_t log_crc32(const uint8_t *buf, size_t len)
+{
+#ifdef ESP_PLATFORM
+    return esp_rom_crc32_le(0, buf, len);
+#else
+    // Same polynomial and conditioning as esp_rom_crc32_le(0, ...) and zlib
+    uint32_t crc = 0xFFFFFFFFu;
+    for (size_t i = 0; i < len; i++) {
+        crc ^= buf[i];
+        for (int k = 0; k < 8; k++) {
+            crc = (crc >> 1) ^ (0xEDB88320u & (0u - (crc & 1u)));
+        }
+    }
+    return ~crc;
+#endif
+}
+
+static void *log_alloc(size_t size)
+{
+#ifdef ESP_PLATFORM
+    void *p = heap_caps_malloc(size, MALLOC_CAP_SPIRAM);
+    if (p != NULL) {
+        return p;
+    }
+#endif
+    return malloc(size);
+}
+
+// ============================================================================
+// BLOCK ACCESS
+// ============================================================================
+
+/**
+ * @brief Reads and checks the header of data block `seq`.
+ * @return false past the end of the data (unused or stale blocks)
+ */
+static bool read_block_header(can_log_reader_t *r, uint32_t seq, can_log_block_header_t *hdr)
+{
+    if (seq == 0 || seq >= r->block_limit) {
+        return false;
+    }
+    long offset = (long)seq * (long)r->header.block_size;
+    if (fseek(r->file, offset, SEEK_SET) != 0 || fread(hdr, sizeof(*hdr), 1, r->file) != 1) {
+        return false;
+    }
+    return hdr->magic == CAN_LOG_BLOCK_MAGIC &&
+           hdr->sequence == seq &&
+           hdr->file_id == r->header.file_id &&
+           ((hdr->flags & CAN_LOG_BLOCK_FLAG_LZ4) || hdr->record_count <= CAN_LOG_RECORDS_PER_BLOCK);
+}
+
+typedef enum {
+    BLOCK_LOADED,
+    BLOCK_END,
+    BLOCK_BAD_CRC
+} block_load_t;
+
+static block_load_t load_block(can_log_reader_t *r, uint32_t seq)
+{
+    can_log_block_header_t *hdr = (can_log_block_header_t *)r->block;
+    if (!read_block_header(r, seq, hdr)) {
+        return BLOCK_END;
+    }
+
+    bool lz4 = (hdr->flags & CAN_LOG_BLOCK_FLAG_LZ4) != 0;
+    size_t len = lz4 ? hdr->payload_size : (size_t)hdr->record_count * sizeof(can_log_record_t);
+    uint8_t *payload = r->block + sizeof(*hdr);
+    r->block_seq = seq;
+    r->record_pos = 0;
+    r->record_count = 0;
+    r->chunk_offset = r->chunk_end = 0;
+
+    if (len > CAN_LOG_BLOCK_SIZE - sizeof(*hdr) || fread(payload, 1, len, r->file) != len) {
+        return BLOCK_END;
+    }
+    if (log_crc32(payload, len) != hdr->crc32) {
+        r->crc_errors++;
+        return BLOCK_BAD_CRC;
+    }
+    if (lz4) {
+        r->chunk_offset = sizeof(*hdr);
+        r->chunk_end = (uint32_t)(sizeof(*hdr) + len);
+    } else {
+        r->records = (const can_log_record_t *)payload;
+        r->record_count = hdr->record_count;
+    }
+    r->time_us = hdr->base_time_us;
+    return BLOCK_LOADED;
+}
+
+// Inverse of the writer's byte planes: byte i of record j is at i * n + j
+static void unshuffle_records(const uint8_t *src, size_t n, uint8_t *dst)
+{
+    for (size_t i = 0; i < sizeof(can_log_record_t); i++) {
+        for (size_t j = 0; j < n; j++) {
+            dst[j * sizeof(can_log_record_t) + i] = src[i * n + j];
+        }
+    }
+}
+
+/**
+ * @brief Makes the next chunk of an LZ4 block the current record run.
+ * @return false at the end of the block, or if the rest of it is corrupt
+ */
+static bool load_chunk(can_log_reader_t *r)
+{
+    can_log_chunk_header_t chunk;
+    if (r->chunk_end - r->chunk_offset < sizeof(chunk)) {
+        return false;
+    }
+    memcpy(&chunk, r->block + r->chunk_offset, sizeof(chunk));
+    const uint8_t *stored = r->block + r->chunk_offset + sizeof(chunk);
+    size_t raw_len = (size_t)chunk.record_count * sizeof(can_log_record_t);
+    bool ok = chunk.record_count > 0 && chunk.record_count <= CAN_LOG_CHUNK_MAX_RECORDS &&
+              chunk.stored_size <= r->chunk_end - r->chunk_offset - sizeof(chunk);
+
+    if (ok && chunk.stored_size == raw_len) {
+        r->records = (const can_log_record_t *)stored;
+    } else if (ok && lz4_block_decompress(stored, chunk.stored_size, r->shuffled,
+                                          CAN_LOG_CHUNK_MAX_RECORDS * sizeof(can_log_record_t)) == (int)raw_len) {
+        unshuffle_records(r->shuffled, chunk.record_count, r->chunk);
+        r->records = (const can_log_record_t *)r->chunk;
+    } else {
+        // The CRC matched, so the writer produced this; give up on the block
+        r->crc_errors++;
+        r->chunk_offset = r->chunk_end;
+        return false;
+    }
+    r->chunk_offset += (uint32_t)(sizeof(chunk) + chunk.stored_size);
+    r->record_pos = 0;
+    r->record_count = chunk.record_count;
+    return true;
+}
+
+// ============================================================================
+// INDEX
+// ============================================================================
+
+static void load_index(can_log_reader_t *r)
+{
+    r->index_loaded = true;
+    if (r->index_path[0] == '\0') {
+        return;
+    }
+    FILE *f = fopen(r->index_path, "rb");
+    if (f == NULL) {
+        return;
+    }
+
+    can_log_index_header_t hdr;
+    long size = 0;
+    if (fread(&hdr, sizeof(hdr), 1, f) == 1 &&
+        hdr.magic == CAN_LOG_INDEX_MAGIC && hdr.file_id == r->header.file_id &&
+        fseek(f, 0, SEEK_END) == 0 && (size = ftell(f)) > (long)sizeof(hdr)) {
+        uint32_t count = (uint32_t)((size - (long)sizeof(hdr)) / sizeof(can_log_index_entry_t));
+        r->index = log_alloc(count * sizeof(can_log_index_entry_t));
+        if (r->index != NULL) {
+            fseek(f, sizeof(hdr), SEEK_SET);
+            r->index_count = (uint32_t)fread(r->index, sizeof(can_log_index_entry_t), count, f);
+        }
+    }
+    fclose(f);
+}
+
+/**
+ * @brief Last block whose base time is <= time_us, searching the block
+ *        headers between lo (known good) and hi (exclusive bound).
+ */
+static uint32_t search_blocks(can_log_reader_t *r, uint32_t lo, uint32_t hi, uint64_t time_us)
+{
+    can_log_block_header_t hdr;
+    // Valid blocks form a prefix of the file and their base times grow,
+    // so "valid and starts at or before time_us" is monotone
+    while (hi - lo > 1) {
+        uint32_t mid = lo + (hi - lo) / 2;
+        if (read_block_header(r, mid, &hdr) && hdr.base_time_us <= time_us) {
+            lo = mid;
+        } else {
+            hi = mid;
+        }
+    }
+    return lo;
+}
+
+// ============================================================================
+// PUBLIC API
+// ============================================================================
+
+int can_log_reader_open(can_log_reader_t *r, const char *path)
+{
+    if (r == NULL || path == NULL) {
+        return CAN_LOG_ERR_INVALID;
+    }
+    memset(r, 0, sizeof(*r));
+
+    r->file = fopen(path, "rb");
+    if (r->file == NULL) {
+        return CAN_LOG_ERR_IO;
+    }
+
+    can_log_file_header_t *h = &r->header;
+    if (fread(h, sizeof(*h), 1, r->file) != 1) {
+        can_log_reader_close(r);
+        return CAN_LOG_ERR_FORMAT;
+    }
+    if (h->magic != CAN_LOG_FILE_MAGIC ||
+        h->version < CAN_LOG_FORMAT_MIN_VERSION || h->version > CAN_LOG_FORMAT_VERSION ||
+        h->header_size != sizeof(*h) || h->block_size != CAN_LOG_BLOCK_SIZE ||
+        h->record_size != sizeof(can_log_record_t) ||
+        log_crc32((const uint8_t *)h, offsetof(can_log_file_header_t, crc32)) != h->crc32) {
+        can_log_reader_close(r);
+        return CAN_LOG_ERR_FORMAT;
+    }
+
+    // The last block of a closed segment is cut off after its data
+    fseek(r->file, 0, SEEK_END);
+    r->block_limit = (uint32_t)((ftell(r->file) + (long)h->block_size - 1) / (long)h->block_size);
+
+    r->block = log_alloc(CAN_LOG_BLOCK_SIZE);
+    r->chunk = log_alloc(CAN_LOG_CHUNK_MAX_RECORDS * sizeof(can_log_record_t));
+    r->shuffled = log_alloc(CAN_LOG_CHUNK_MAX_RECORDS * sizeof(can_log_record_t));
+    if (r->block == NULL || r->chunk == NULL || r->shuffled == NULL) {
+        can_log_reader_close(r);
+        return CAN_LOG_ERR_NO_MEM;
+    }
+
+    // CANnnnnn.BIN -> CANnnnnn.IDX
+    size_t len = strlen(path);
+    if (len > 4 && len < sizeof(r->index_path) && strcasecmp(path + len - 4, ".BIN") == 0) {
+        memcpy(r->index_path, path, len - 4);
+        memcpy(r->index_path + len - 4, ".IDX", 5);
+    }
+    return CAN_LOG_OK;
+}
+
+void can_log_reader_close(can_log_reader_t *r)
+{
+    if (r == NULL) {
+        return;
+    }
+    if (r->file != NULL) {
+        fclose(r->file);
+    }
+    free(r->index);
+    free(r->block);
+    free(r->chunk);
+    free(r->shuffled);
+    memset(r, 0, sizeof(*r));
+}
+
+int can_log_reader_find_block(can_log_reader_t *r, uint64_t time_us, uint32_t *block_seq)
+{
+    if (r == NULL || r->file == NULL || block_seq == NULL) {
+        return CAN_LOG_ERR_INVALID;
+    }
+    if (!r->index_loaded) {
+        load_index(r);
+    }
+
+    uint32_t lo = 1;
+    uint32_t hi = r->block_limit;
+
+    if (r->index != NULL && r->index_count > 0) {
+        // Last index entry at or before time_us, then search up to the next entry
+        uint32_t a = 0;
+        uint32_t b = r->index_count;
+        while (a < b) {
+            uint32_t mid = a + (b - a) / 2;
+            if (r->index[mid].time_us <= time_us) {
+                a = mid + 1;
+            } else {
+                b = mid;
+            }
+        }
+        if (a > 0) {
+            lo = r->index[a - 1].block;
+        }
+        if (a < r->index_count) {
+            hi = r->index[a].block;
+        }
+        // The index may lag behind the data (written on flush); the search
+        // below covers the blocks after its last entry
+    }
+
+    *block_seq = search_blocks(r, lo, hi, time_us);
+    return CAN_LOG_OK;
+}
+
+int can_log_reader_seek_time(can_log_reader_t *r, uint64_t time_us)
+{
+    uint32_t seq;
+    int ret = can_log_reader_find_block(r, time_us, &seq);
+    if (ret != CAN_LOG_OK) {
+        return ret;
+    }
+    // next() continues with block_seq + 1
+    r->block_seq = seq - 1;
+    r->record_pos = 0;
+    r->record_count = 0;
+    r->chunk_offset = r->chunk_end = 0;
+    r->skip_before_us = time_us;
+    return CAN_LOG_OK;
+}
+
+int can_log_reader_next(can_log_reader_t *r, can_log_frame_t *frame)
+{
+    if (r == NULL || r->file == NULL || frame == NULL) {
+        return CAN_LOG_ERR_INVALID;
+    }
+
+    while (1) {
+        while (r->record_pos < r->record_count) {
+            const can_log_record_t *rec = &r->records[r->record_pos++];
+
+            if (rec->id_flags & CAN_LOG_FLAG_TIME) {
+                memcpy(&r->time_us, rec->data, sizeof(r->time_us));
+                continue;
+            }
+            r->time_us += rec->delta_dlc & CAN_LOG_DELTA_MAX;
+            if (r->time_us < r->skip_before_us) {
+                continue;
+            }
+
+            frame->time_us = r->time_us;
+            frame->identifier = rec->id_flags & CAN_LOG_ID_MASK;
+            frame->extended = (rec->id_flags & CAN_LOG_FLAG_EXTENDED) != 0;
+            frame->rtr = (rec->id_flags & CAN_LOG_FLAG_RTR) != 0;
+            frame->dlc = (uint8_t)((rec->delta_dlc >> CAN_LOG_DLC_SHIFT) & 0x0F);
+            memcpy(frame->data, rec->data, sizeof(frame->data));
+            return CAN_LOG_OK;
+        }
+
+        if (load_chunk(r)) {
+            continue;
+        }
+
+        // Blocks with a bad CRC are skipped; the next block re-anchors time
+        // (load_block advances block_seq even when the CRC fails)
+        block_load_t res;
+        do {
+            res = load_block(r, r->block_seq + 1);
+        } while (res == BLOCK_BAD_CRC);
+
+        if (res == BLOCK_END) {
+            return CAN_LOG_END;
+        }
+    }
+}
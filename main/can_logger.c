@@ -0,0 +1,893 @@
+/*
+ * CAN Trace Logger for ECU Dashboard
+ * Ping-pong PSRAM buffers filled by the CAN task, written by the logger task
+ * as blocks of the format in can_log_format.h
+ */
+
+#include "include/can_logger.h"
+#include "include/canbus.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_app_desc.h"
+#include "esp_heap_caps.h"
+#include "esp_log.h"
+#include "esp_random.h"
+#include "esp_rom_crc.h"
+#include "esp_timer.h"
+#include "sd_card_manager.h"
+#include "lz4_block.h"
+#include <dirent.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <unistd.h>
+
+static const char *TAG = "CAN_LOGGER";
+
+#define CAN_LOGGER_TASK_STACK_SIZE  4096
+#define CAN_LOGGER_TASK_PRIORITY    4       // Below the CAN task (10)
+#define CAN_LOGGER_TASK_CORE        1       // WiFi, esp_timer and app_main run on core 0
+#define CAN_LOGGER_STOP_TIMEOUT_MS  2000
+
+typedef struct {
+    uint8_t *data;              // CAN_LOGGER_BLOCK_SIZE bytes in PSRAM, starting with the block header
+    size_t fill;                // Bytes written by the producer, header included
+    bool full;                  // Waiting for the logger task; the producer must not touch it
+} log_buffer_t;
+
+static log_buffer_t buffers[2];
+static uint8_t active_buffer = 0;   // Buffer the producer is filling
+
+static portMUX_TYPE logger_lock = portMUX_INITIALIZER_UNLOCKED;
+static TaskHandle_t logger_task_handle = NULL;
+static bool logger_running = false;
+static volatile bool stop_requested = false;
+
+// Segment files, owned by the logger task once it runs
+typedef struct {
+    FILE *file;
+    FILE *index;                // CANnnnnn.IDX, NULL if it could not be created
+    uint32_t number;            // CANnnnnn.BIN
+    uint32_t file_id;
+    uint32_t next_index_block;  // Next block that gets an index entry
+    char path[32];
+} log_segment_t;
+
+static log_segment_t current_segment;
+static log_segment_t next_segment;          // Prepared ahead of rotation (file == NULL if not yet)
+static uint32_t session_segment_index = 0;
+static char current_path[32] = "";          // Copy for can_logger_get_path(), under logger_lock
+static long current_data_size = 0;          // Bytes of the segment that hold data, under logger_lock
+
+static can_logger_config_t logger_config;
+static can_logger_stats_t logger_stats;
+
+// Write position, owned by the logger task. Each segment grows block by
+// block; the active block is rewritten from its start on every partial
+// flush so full writes stay block aligned.
+static long block_offset;
+static size_t partial_written;
+
+// Compressed output (config.compress), owned by the logger task
+typedef struct {
+    uint8_t *block;             // Output block in PSRAM, starting with the block header
+    size_t fill;                // Header plus chunks
+    uint32_t records;
+    bool dirty;                 // Changed since it was last written
+    size_t consumed[2];         // Bytes of each ping-pong buffer already compressed
+    uint64_t chain_time_us;     // Time of the last compressed record
+    lz4_block_state_t *lz4;     // Internal RAM: the hash table is hit for every input byte
+    uint8_t *shuffled;          // Internal RAM, compressor input
+    uint8_t *chunk;             // One compressed chunk
+} log_compressor_t;
+
+static log_compressor_t compressor;
+
+#define CHUNK_MAX_BYTES     (CAN_LOG_CHUNK_MAX_RECORDS * sizeof(can_log_record_t))
+
+// Producer state, owned by the ingest path (serialized by canbus_ingest_frame)
+static int64_t last_record_us = 0;
+static bool need_time_marker = true;
+
+/**
+ * @brief Starts a data block in an empty buffer. The sequence, file id,
+ *        record count and CRC are filled in by the logger task, which knows
+ *        the segment the block ends up in.
+ */
+static void block_begin(log_buffer_t *b)
+{
+    can_log_block_header_t *hdr = (can_log_block_header_t *)b->data;
+    memset(hdr, 0, sizeof(*hdr));
+    hdr->magic = CAN_LOG_BLOCK_MAGIC;
+    hdr->base_time_us = (uint64_t)last_record_us;
+    b->fill = sizeof(*hdr);
+}
+
+// ============================================================================
+// PRODUCER (CAN task)
+// ============================================================================
+
+/**
+ * @brief Copies one record into the active buffer, switching buffers when it
+ *        is full. Runs in a short critical section, no blocking calls.
+ * @return false if the record was dropped
+ */
+static bool logger_push(const can_log_record_t *rec)
+{
+    bool notify = false;
+    bool stored = false;
+
+    portENTER_CRITICAL(&logger_lock);
+    if (logger_running) {
+        log_buffer_t *b = &buffers[active_buffer];
+        if (b->fill + sizeof(*rec) > CAN_LOGGER_BLOCK_SIZE) {
+            log_buffer_t *next = &buffers[active_buffer ^ 1];
+            if (!next->full) {
+                b->full = true;
+                block_begin(next);
+                active_buffer ^= 1;
+                b = next;
+                notify = true;
+            } else {
+                b = NULL;
+            }
+        }
+        if (b) {
+            memcpy(b->data + b->fill, rec, sizeof(*rec));
+            b->fill += sizeof(*rec);
+            stored = true;
+        }
+    }
+    portEXIT_CRITICAL(&logger_lock);
+
+    if (notify) {
+        xTaskNotifyGive(logger_task_handle);
+    }
+    return stored;
+}
+
+void can_logger_log_frame(const twai_message_t *message)
+{
+    if (!logger_running || message == NULL) {
+        return;
+    }
+
+    int64_t now = esp_timer_get_time();
+    can_log_record_t rec;
+
+    if (need_time_marker || (now - last_record_us) > CAN_LOG_DELTA_MAX) {
+        rec.delta_dlc = 0;
+        rec.id_flags = CAN_LOG_FLAG_TIME;
+        memcpy(rec.data, &now, sizeof(now));
+        if (!logger_push(&rec)) {
+            goto dropped;
+        }
+        last_record_us = now;
+        need_time_marker = false;
+    }
+
+    rec.delta_dlc = (uint32_t)(now - last_record_us) |
+                    ((uint32_t)(message->data_length_code & 0x0F) << CAN_LOG_DLC_SHIFT);
+    rec.id_flags = message->identifier & CAN_LOG_ID_MASK;
+    if (message->extd) {
+        rec.id_flags |= CAN_LOG_FLAG_EXTENDED;
+    }
+    if (message->rtr) {
+        rec.id_flags |= CAN_LOG_FLAG_RTR;
+    }
+    memcpy(rec.data, message->data, sizeof(rec.data));
+
+    if (logger_push(&rec)) {
+        last_record_us = now;
+        portENTER_CRITICAL(&logger_lock);
+        logger_stats.frames_logged++;
+        portEXIT_CRITICAL(&logger_lock);
+        return;
+    }
+
+dropped:
+    // The delta chain is broken; re-anchor it with the next stored frame
+    need_time_marker = true;
+    portENTER_CRITICAL(&logger_lock);
+    logger_stats.frames_dropped++;
+    portEXIT_CRITICAL(&logger_lock);
+}
+
+// ============================================================================
+// SEGMENT FILES
+// ============================================================================
+
+static inline long segment_size_bytes(void)
+{
+    return (long)logger_config.segment_size_mb * 1024 * 1024;
+}
+
+static esp_err_t logger_write_at(FILE *file, long offset, const uint8_t *data, size_t len)
+{
+    int64_t start_us = esp_timer_get_time();
+    bool ok = fseek(file, offset, SEEK_SET) == 0 &&
+              fwrite(data, 1, len, file) == len;
+    uint32_t elapsed_us = (uint32_t)(esp_timer_get_time() - start_us);
+
+    sd_card_record_write_latency(elapsed_us);
+
+    portENTER_CRITICAL(&logger_lock);
+    if (ok) {
+        logger_stats.bytes_written += len;
+        logger_stats.last_write_us = elapsed_us;
+        if (elapsed_us > logger_stats.max_write_us) {
+            logger_stats.max_write_us = elapsed_us;
+        }
+    } else {
+        logger_stats.write_errors++;
+    }
+    portEXIT_CRITICAL(&logger_lock);
+
+    if (!ok) {
+        ESP_LOGW(TAG, "Write of %u bytes at %ld failed", (unsigned)len, offset);
+        return ESP_FAIL;
+    }
+    return ESP_OK;
+}
+
+/**
+ * @brief Finds the lowest and highest CANnnnnn.BIN numbers on the card.
+ * @return Number of segment files
+ */
+static uint32_t logger_scan_segments(uint32_t *lowest, uint32_t *highest)
+{
+    uint32_t count = 0;
+    *lowest = UINT32_MAX;
+    *highest = 0;
+
+    DIR *dir = opendir(CAN_LOGGER_DIR);
+    if (dir == NULL) {
+        return 0;
+    }
+    struct dirent *entry;
+    size_t prefix_len = strlen(CAN_LOGGER_PREFIX);
+    size_t ext_len = strlen(CAN_LOGGER_EXT);
+    while ((entry = readdir(dir)) != NULL) {
+        const char *name = entry->d_name;
+        size_t len = strlen(name);
+        if (len <= prefix_len + ext_len ||
+            strncasecmp(name, CAN_LOGGER_PREFIX, prefix_len) != 0 ||
+            strcasecmp(name + len - ext_len, CAN_LOGGER_EXT) != 0) {
+            continue;
+        }
+        uint32_t number = strtoul(name + prefix_len, NULL, 10);
+        if (number < *lowest) {
+            *lowest = number;
+        }
+        if (number > *highest) {
+            *highest = number;
+        }
+        count++;
+    }
+    closedir(dir);
+    return count;
+}
+
+static void segment_path(uint32_t number, const char *ext, char *path, size_t len)
+{
+    snprintf(path, len, "%s/%s%05lu%s", CAN_LOGGER_DIR, CAN_LOGGER_PREFIX,
+             (unsigned long)number, ext);
+}
+
+/**
+ * @brief Deletes the oldest segments so that one more fits the retention limit.
+ *        The segment being written always has a higher number than the oldest.
+ */
+static void logger_apply_retention(void)
+{
+    uint32_t lowest, highest;
+    while (logger_scan_segments(&lowest, &highest) >= logger_config.retention_segments) {
+        if (lowest == current_segment.number && current_segment.file != NULL) {
+            break;
+        }
+        char path[32];
+        segment_path(lowest, CAN_LOGGER_INDEX_EXT, path, sizeof(path));
+        unlink(path);
+        segment_path(lowest, CAN_LOGGER_EXT, path, sizeof(path));
+        if (unlink(path) != 0) {
+            ESP_LOGW(TAG, "Failed to delete old segment %s", path);
+            break;
+        }
+        ESP_LOGI(TAG, "Retention: deleted %s", path);
+        portENTER_CRITICAL(&logger_lock);
+        logger_stats.segments_deleted++;
+        portEXIT_CRITICAL(&logger_lock);
+    }
+}
+
+void can_logger_init_file_header(can_log_file_header_t *hdr, uint32_t file_id,
+                                 uint32_t segment, uint64_t start_time_us)
+{
+    const esp_app_desc_t *app = esp_app_get_description();
+    memset(hdr, 0, sizeof(*hdr));
+    hdr->magic = CAN_LOG_FILE_MAGIC;
+    hdr->version = CAN_LOG_FORMAT_VERSION;
+    hdr->header_size = sizeof(*hdr);
+    hdr->block_size = CAN_LOGGER_BLOCK_SIZE;
+    hdr->record_size = sizeof(can_log_record_t);
+    hdr->bitrate = CANBUS_BITRATE;
+    hdr->start_time_us = start_time_us;
+    strncpy(hdr->firmware_version, app->version, sizeof(hdr->firmware_version) - 1);
+    strncpy(hdr->idf_version, app->idf_ver, sizeof(hdr->idf_version) - 1);
+    hdr->file_id = file_id;
+    hdr->segment = segment;
+    hdr->crc32 = esp_rom_crc32_le(0, (const uint8_t *)hdr, offsetof(can_log_file_header_t, crc32));
+}
+
+/**
+ * @brief Creates the next segment: retention, preallocation and header.
+ *        Slow (FAT allocation); runs while the current segment still has room.
+ */
+static esp_err_t logger_prepare_segment(log_segment_t *seg)
+{
+    uint32_t lowest, highest;
+    logger_apply_retention();
+    logger_scan_segments(&lowest, &highest);
+
+    memset(seg, 0, sizeof(*seg));
+    seg->number = highest + 1;
+    seg->file_id = esp_random();
+    seg->next_index_block = 1;
+    segment_path(seg->number, CAN_LOGGER_EXT, seg->path, sizeof(seg->path));
+
+    if (sd_card_create_contiguous_file(seg->path, (uint64_t)segment_size_bytes()) == ESP_OK) {
+        seg->file = fopen(seg->path, "r+b");
+    } else {
+        // Still log, just without the latency guarantee
+        portENTER_CRITICAL(&logger_lock);
+        logger_stats.prealloc_failures++;
+        portEXIT_CRITICAL(&logger_lock);
+        seg->file = fopen(seg->path, "w+b");
+    }
+    if (seg->file == NULL) {
+        ESP_LOGE(TAG, "Failed to open segment %s", seg->path);
+        return ESP_FAIL;
+    }
+    // Blocks go straight to FATFS, without a second copy in a stdio buffer
+    setvbuf(seg->file, NULL, _IONBF, 0);
+
+    can_log_file_header_t hdr;
+    can_logger_init_file_header(&hdr, seg->file_id, session_segment_index++,
+                                (uint64_t)esp_timer_get_time());
+
+    if (logger_write_at(seg->file, 0, (const uint8_t *)&hdr, sizeof(hdr)) != ESP_OK) {
+        fclose(seg->file);
+        seg->file = NULL;
+        return ESP_FAIL;
+    }
+
+    // The index is small and append-only, so normal buffered stdio is fine
+    char index_path[32];
+    segment_path(seg->number, CAN_LOGGER_INDEX_EXT, index_path, sizeof(index_path));
+    seg->index = fopen(index_path, "wb");
+    if (seg->index != NULL) {
+        can_log_index_header_t idx = {
+            .magic = CAN_LOG_INDEX_MAGIC,
+            .file_id = seg->file_id,
+            .interval_blocks = logger_config.index_interval_blocks,
+        };
+        fwrite(&idx, sizeof(idx), 1, seg->index);
+    } else {
+        ESP_LOGW(TAG, "Failed to create %s, seeking will scan block headers", index_path);
+    }
+
+    portENTER_CRITICAL(&logger_lock);
+    logger_stats.segments_created++;
+    portEXIT_CRITICAL(&logger_lock);
+    return ESP_OK;
+}
+
+/**
+ * @brief Closes a segment. The unused preallocated tail is cut off so the
+ *        file only holds data (and downloads stay small).
+ */
+static void logger_close_segment(log_segment_t *seg, long used_bytes)
+{
+    if (seg->index != NULL) {
+        fclose(seg->index);
+        seg->index = NULL;
+    }
+    if (seg->file == NULL) {
+        return;
+    }
+    fflush(seg->file);
+    if (used_bytes >= 0) {
+        ftruncate(fileno(seg->file), used_bytes);
+    }
+    fsync(fileno(seg->file));
+    fclose(seg->file);
+    seg->file = NULL;
+}
+
+static void logger_publish_path(void)
+{
+    portENTER_CRITICAL(&logger_lock);
+    snprintf(current_path, sizeof(current_path), "%s", current_segment.file ? current_segment.path : "");
+    current_data_size = current_segment.file ? CAN_LOGGER_BLOCK_SIZE : 0;
+    portEXIT_CRITICAL(&logger_lock);
+}
+
+// ============================================================================
+// BLOCK WRITES
+// ============================================================================
+
+/**
+ * @brief Completes the header of a block holding `fill` bytes and writes it.
+ *        The producer only appends past `fill`, so the buffer is not copied.
+ * @param records Records in an LZ4 block; plain blocks count their payload
+ */
+static esp_err_t logger_write_block(long offset, uint8_t *data, size_t fill, uint32_t records)
+{
+    can_log_block_header_t *hdr = (can_log_block_header_t *)data;
+    size_t payload_len = fill - sizeof(*hdr);
+    hdr->sequence = (uint32_t)(offset / CAN_LOGGER_BLOCK_SIZE);
+    hdr->file_id = current_segment.file_id;
+    if (hdr->flags & CAN_LOG_BLOCK_FLAG_LZ4) {
+        hdr->record_count = (uint16_t)records;
+        hdr->payload_size = (uint16_t)payload_len;
+    } else {
+        hdr->record_count = (uint16_t)(payload_len / sizeof(can_log_record_t));
+    }
+    hdr->crc32 = esp_rom_crc32_le(0, data + sizeof(*hdr), payload_len);
+    esp_err_t ret = logger_write_at(current_segment.file, offset, data, fill);
+    if (ret == ESP_OK) {
+        portENTER_CRITICAL(&logger_lock);
+        if (offset + (long)fill > current_data_size) {
+            current_data_size = offset + (long)fill;
+        }
+        portEXIT_CRITICAL(&logger_lock);
+    }
+
+    // Index the block once it is on the card (first partial or full write)
+    log_segment_t *seg = &current_segment;
+    if (ret == ESP_OK && seg->index != NULL && hdr->sequence == seg->next_index_block) {
+        can_log_index_entry_t entry = {
+            .time_us = hdr->base_time_us,
+            .block = hdr->sequence,
+        };
+        fwrite(&entry, sizeof(entry), 1, seg->index);
+        seg->next_index_block += logger_config.index_interval_blocks;
+    }
+    return ret;
+}
+
+static void logger_count_block(void)
+{
+    portENTER_CRITICAL(&logger_lock);
+    logger_stats.blocks_written++;
+    portEXIT_CRITICAL(&logger_lock);
+}
+
+/**
+ * @brief Switches to the next segment once the current one is full. The
+ *        next one is normally ready, so this is only a close and a swap.
+ *        If it is not, the current file keeps growing rather than lose data.
+ */
+static void logger_rotate_if_full(void)
+{
+    if (block_offset < segment_size_bytes() || stop_requested) {
+        return;
+    }
+    if (next_segment.file == NULL) {
+        logger_prepare_segment(&next_segment);
+    }
+    if (next_segment.file == NULL) {
+        return;
+    }
+    logger_close_segment(&current_segment, block_offset);
+    current_segment = next_segment;
+    next_segment.file = NULL;
+    next_segment.index = NULL;
+    block_offset = CAN_LOGGER_BLOCK_SIZE;
+    partial_written = 0;
+    // A partly filled output block was cut off with the old segment
+    compressor.dirty = compressor.records > 0;
+    logger_publish_path();
+    ESP_LOGI(TAG, "Rotated to %s", current_segment.path);
+}
+
+// ============================================================================
+// COMPRESSION
+// ============================================================================
+
+static void compressor_begin_block(void)
+{
+    can_log_block_header_t *hdr = (can_log_block_header_t *)compressor.block;
+    memset(hdr, 0, sizeof(*hdr));
+    hdr->magic = CAN_LOG_BLOCK_MAGIC;
+    hdr->flags = CAN_LOG_BLOCK_FLAG_LZ4;
+    hdr->base_time_us = compressor.chain_time_us;
+    compressor.fill = sizeof(*hdr);
+    compressor.records = 0;
+    compressor.dirty = false;
+}
+
+// Writes the output block as far as it is filled (rewritten until full)
+static void compressor_write(void)
+{
+    if (compressor.dirty &&
+        logger_write_block(block_offset, compressor.block, compressor.fill, compressor.records) == ESP_OK) {
+        partial_written = compressor.fill;
+        compressor.dirty = false;
+    }
+}
+
+static void compressor_next_block(void)
+{
+    compressor_write();
+    logger_count_block();
+    block_offset += CAN_LOGGER_BLOCK_SIZE;
+    partial_written = 0;
+    compressor_begin_block();
+    logger_rotate_if_full();
+}
+
+// Byte planes: byte i of record j goes to i * n + j
+static void shuffle_records(const uint8_t *src, size_t n, uint8_t *dst)
+{
+    for (size_t j = 0; j < n; j++) {
+        for (size_t i = 0; i < sizeof(can_log_record_t); i++) {
+            dst[i * n + j] = src[j * sizeof(can_log_record_t) + i];
+        }
+    }
+}
+
+/**
+ * @brief Compresses whole records into chunks of the output block, writing
+ *        the block out whenever the next chunk does not fit.
+ */
+static void compressor_add(const uint8_t *data, size_t len)
+{
+    int64_t compress_us = 0;
+    uint64_t stored_total = 0;
+    size_t input_len = len;
+
+    while (len >= sizeof(can_log_record_t)) {
+        size_t n = len / sizeof(can_log_record_t);
+        if (n > CAN_LOG_CHUNK_MAX_RECORDS) {
+            n = CAN_LOG_CHUNK_MAX_RECORDS;
+        }
+        size_t raw_len = n * sizeof(can_log_record_t);
+
+        int64_t start_us = esp_timer_get_time();
+        // Output must be smaller than the input, equal size means "stored"
+        shuffle_records(data, n, compressor.shuffled);
+        int clen = lz4_block_compress(compressor.lz4, compressor.shuffled, raw_len,
+                                      compressor.chunk, raw_len - 1);
+        const uint8_t *stored = clen > 0 ? compressor.chunk : data;
+        size_t stored_len = clen > 0 ? (size_t)clen : raw_len;
+
+        // Follow the delta chain so every block knows its base time
+        const can_log_record_t *rec = (const can_log_record_t *)data;
+        uint64_t chain_time_us = compressor.chain_time_us;
+        for (size_t i = 0; i < n; i++) {
+            if (rec[i].id_flags & CAN_LOG_FLAG_TIME) {
+                memcpy(&chain_time_us, rec[i].data, sizeof(chain_time_us));
+            } else {
+                chain_time_us += rec[i].delta_dlc & CAN_LOG_DELTA_MAX;
+            }
+        }
+        compress_us += esp_timer_get_time() - start_us;
+
+        size_t need = sizeof(can_log_chunk_header_t) + stored_len;
+        if (compressor.fill + need > CAN_LOGGER_BLOCK_SIZE || compressor.records + n > UINT16_MAX) {
+            compressor_next_block();
+        }
+
+        can_log_chunk_header_t chunk = {
+            .record_count = (uint16_t)n,
+            .stored_size = (uint16_t)stored_len,
+        };
+        memcpy(compressor.block + compressor.fill, &chunk, sizeof(chunk));
+        memcpy(compressor.block + compressor.fill + sizeof(chunk), stored, stored_len);
+        compressor.fill += need;
+        compressor.records += n;
+        compressor.dirty = true;
+        compressor.chain_time_us = chain_time_us;
+
+        stored_total += need;
+        data += raw_len;
+        len -= raw_len;
+    }
+
+    portENTER_CRITICAL(&logger_lock);
+    logger_stats.compress_in_bytes += input_len - len;
+    logger_stats.compress_out_bytes += stored_total;
+    logger_stats.compress_us += (uint64_t)compress_us;
+    if ((uint32_t)compress_us > logger_stats.compress_max_us) {
+        logger_stats.compress_max_us = (uint32_t)compress_us;
+    }
+    portEXIT_CRITICAL(&logger_lock);
+}
+
+// ============================================================================
+// LOGGER TASK
+// ============================================================================
+
+/**
+ * @brief Writes (or compresses) the full buffer, if any, then rotates.
+ *        At most one buffer is full at a time, and it is older than the
+ *        active one.
+ */
+static void logger_drain_full(bool compress)
+{
+    for (int i = 0; i < 2; i++) {
+        log_buffer_t *b = &buffers[i];
+        if (!b->full) {
+            continue;
+        }
+        if (compress) {
+            compressor_add(b->data + compressor.consumed[i], b->fill - compressor.consumed[i]);
+            compressor.consumed[i] = sizeof(can_log_block_header_t);
+        } else {
+            if (logger_write_block(block_offset, b->data, b->fill, 0) == ESP_OK) {
+                logger_count_block();
+            }
+            block_offset += CAN_LOGGER_BLOCK_SIZE;
+            partial_written = 0;
+        }
+
+        portENTER_CRITICAL(&logger_lock);
+        b->full = false;
+        portEXIT_CRITICAL(&logger_lock);
+    }
+
+    logger_rotate_if_full();
+}
+
+static void can_logger_task(void *pvParameters)
+{
+    bool compress = logger_config.compress;
+    int64_t last_flush_us = esp_timer_get_time();
+    int64_t last_fsync_us = last_flush_us;
+
+    block_offset = CAN_LOGGER_BLOCK_SIZE;
+    partial_written = 0;
+
+    ESP_LOGI(TAG, "Logger task started on core %d, writing %s%s", xPortGetCoreID(),
+             current_segment.path, compress ? " (LZ4)" : "");
+
+    while (1) {
+        ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(logger_config.flush_interval_ms));
+        bool stopping = stop_requested;
+
+        logger_drain_full(compress);
+
+        int64_t now = esp_timer_get_time();
+        if (stopping || (now - last_flush_us) >= (int64_t)logger_config.flush_interval_ms * 1000) {
+            // The producer may have switched buffers while the full one was
+            // written or the segment rotated. The active buffer's records are
+            // newer than a full buffer's, so it is only taken once no full
+            // buffer is left, checked together with the snapshot.
+            uint8_t active;
+            size_t fill;
+            bool older_full;
+            do {
+                portENTER_CRITICAL(&logger_lock);
+                active = active_buffer;
+                older_full = buffers[active ^ 1].full;
+                fill = buffers[active].fill;
+                portEXIT_CRITICAL(&logger_lock);
+                if (older_full) {
+                    logger_drain_full(compress);
+                }
+            } while (older_full);
+            log_buffer_t *b = &buffers[active];
+
+            if (compress) {
+                // Records below fill are final; the producer only appends
+                if (fill > compressor.consumed[active]) {
+                    compressor_add(b->data + compressor.consumed[active], fill - compressor.consumed[active]);
+                    compressor.consumed[active] = fill;
+                }
+                compressor_write();
+            } else if (fill > partial_written && fill > sizeof(can_log_block_header_t) &&
+                       logger_write_block(block_offset, b->data, fill, 0) == ESP_OK) {
+                partial_written = fill;
+            }
+            last_flush_us = now;
+        }
+
+        if (stopping) {
+            break;
+        }
+
+        if (logger_config.fsync_interval_ms > 0 &&
+            (now - last_fsync_us) >= (int64_t)logger_config.fsync_interval_ms * 1000) {
+            fsync(fileno(current_segment.file));
+            if (current_segment.index != NULL) {
+                fflush(current_segment.index);
+                fsync(fileno(current_segment.index));
+            }
+            last_fsync_us = now;
+        }
+
+        // Prepare the next segment at half way, well before it is needed
+        if (next_segment.file == NULL && block_offset >= segment_size_bytes() / 2) {
+            logger_prepare_segment(&next_segment);
+        }
+    }
+
+    logger_close_segment(&current_segment, block_offset + (long)partial_written);
+    if (next_segment.file != NULL) {
+        // Never written to; do not leave an empty 64 MB file behind
+        char index_path[32];
+        logger_close_segment(&next_segment, -1);
+        unlink(next_segment.path);
+        segment_path(next_segment.number, CAN_LOGGER_INDEX_EXT, index_path, sizeof(index_path));
+        unlink(index_path);
+    }
+    logger_publish_path();
+
+    ESP_LOGI(TAG, "Logger task stopped (%lu frames, %lu dropped)",
+             (unsigned long)logger_stats.frames_logged, (unsigned long)logger_stats.frames_dropped);
+
+    logger_task_handle = NULL;
+    vTaskDelete(NULL);
+}
+
+// ============================================================================
+// CONTROL
+// ============================================================================
+
+esp_err_t can_logger_start(const can_logger_config_t *config)
+{
+    if (logger_task_handle != NULL) {
+        ESP_LOGW(TAG, "Logger already running");
+        return ESP_OK;
+    }
+
+    can_logger_config_t defaults = CAN_LOGGER_CONFIG_DEFAULT();
+    logger_config = config ? *config : defaults;
+    if (logger_config.flush_interval_ms == 0) {
+        logger_config.flush_interval_ms = defaults.flush_interval_ms;
+    }
+    if (logger_config.segment_size_mb == 0) {
+        logger_config.segment_size_mb = defaults.segment_size_mb;
+    }
+    if (logger_config.retention_segments < 2) {
+        logger_config.retention_segments = 2;
+    }
+    if (logger_config.index_interval_blocks == 0) {
+        logger_config.index_interval_blocks = defaults.index_interval_blocks;
+    }
+
+    for (int i = 0; i < 2; i++) {
+        if (buffers[i].data == NULL) {
+            buffers[i].data = heap_caps_malloc(CAN_LOGGER_BLOCK_SIZE, MALLOC_CAP_SPIRAM);
+        }
+        if (buffers[i].data == NULL) {
+            ESP_LOGE(TAG, "Failed to allocate log buffers in PSRAM");
+            return ESP_ERR_NO_MEM;
+        }
+        buffers[i].fill = 0;
+        buffers[i].full = false;
+    }
+    active_buffer = 0;
+
+    if (logger_config.compress) {
+        if (compressor.block == NULL) {
+            compressor.block = heap_caps_malloc(CAN_LOGGER_BLOCK_SIZE, MALLOC_CAP_SPIRAM);
+        }
+        if (compressor.lz4 == NULL) {
+            compressor.lz4 = heap_caps_malloc(sizeof(lz4_block_state_t), MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+        }
+        if (compressor.shuffled == NULL) {
+            compressor.shuffled = heap_caps_malloc(CHUNK_MAX_BYTES, MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+        }
+        if (compressor.chunk == NULL) {
+            compressor.chunk = heap_caps_malloc(CHUNK_MAX_BYTES, MALLOC_CAP_SPIRAM);
+        }
+        if (compressor.block == NULL || compressor.lz4 == NULL ||
+            compressor.shuffled == NULL || compressor.chunk == NULL) {
+            ESP_LOGW(TAG, "No memory for compression, logging uncompressed");
+            logger_config.compress = false;
+        }
+    }
+
+    memset(&logger_stats, 0, sizeof(logger_stats));
+    session_segment_index = 0;
+    memset(&next_segment, 0, sizeof(next_segment));
+    memset(&current_segment, 0, sizeof(current_segment));
+    if (logger_prepare_segment(&current_segment) != ESP_OK) {
+        return ESP_FAIL;
+    }
+    logger_publish_path();
+
+    last_record_us = esp_timer_get_time();
+    need_time_marker = true;
+    block_begin(&buffers[0]);
+    if (logger_config.compress) {
+        compressor.consumed[0] = compressor.consumed[1] = sizeof(can_log_block_header_t);
+        compressor.chain_time_us = (uint64_t)last_record_us;
+        compressor_begin_block();
+    }
+    stop_requested = false;
+
+    BaseType_t ok = xTaskCreatePinnedToCore(can_logger_task, "can_logger", CAN_LOGGER_TASK_STACK_SIZE,
+                                            NULL, CAN_LOGGER_TASK_PRIORITY, &logger_task_handle,
+                                            CAN_LOGGER_TASK_CORE);
+    if (ok != pdPASS) {
+        ESP_LOGE(TAG, "Failed to create logger task");
+        logger_close_segment(&current_segment, CAN_LOGGER_BLOCK_SIZE);
+        logger_publish_path();
+        logger_task_handle = NULL;
+        return ESP_FAIL;
+    }
+
+    portENTER_CRITICAL(&logger_lock);
+    logger_running = true;
+    portEXIT_CRITICAL(&logger_lock);
+
+    ESP_LOGI(TAG, "CAN logger started: %s, %lu MB segments, keep %lu, flush %lu ms, fsync %lu ms%s",
+             current_segment.path, (unsigned long)logger_config.segment_size_mb,
+             (unsigned long)logger_config.retention_segments,
+             (unsigned long)logger_config.flush_interval_ms, (unsigned long)logger_config.fsync_interval_ms,
+             logger_config.compress ? ", LZ4" : "");
+    return ESP_OK;
+}
+
+esp_err_t can_logger_stop(void)
+{
+    TaskHandle_t task = logger_task_handle;
+    if (task == NULL) {
+        return ESP_OK;
+    }
+
+    // No push can be in progress once the flag is cleared under the lock
+    portENTER_CRITICAL(&logger_lock);
+    logger_running = false;
+    portEXIT_CRITICAL(&logger_lock);
+
+    stop_requested = true;
+    xTaskNotifyGive(task);
+
+    for (int waited = 0; logger_task_handle != NULL; waited += 10) {
+        if (waited >= CAN_LOGGER_STOP_TIMEOUT_MS) {
+            ESP_LOGE(TAG, "Logger task did not stop in time");
+            return ESP_ERR_TIMEOUT;
+        }
+        vTaskDelay(pdMS_TO_TICKS(10));
+    }
+    return ESP_OK;
+}
+
+bool can_logger_is_running(void)
+{
+    return logger_running;
+}
+
+void can_logger_get_path(char *path, size_t len)
+{
+    if (path == NULL || len == 0) {
+        return;
+    }
+    portENTER_CRITICAL(&logger_lock);
+    snprintf(path, len, "%s", current_path);
+    portEXIT_CRITICAL(&logger_lock);
+}
+
+long can_logger_get_data_size(void)
+{
+    portENTER_CRITICAL(&logger_lock);
+    long size = current_data_size;
+    portEXIT_CRITICAL(&logger_lock);
+    return size;
+}
+
+void can_logger_get_stats(can_logger_stats_t *stats)
+{
+    if (stats == NULL) {
+        return;
+    }
+    portENTER_CRITICAL(&logger_lock);
+    *stats = logger_stats;
+    portEXIT_CRITICAL(&logger_lock);
+}
@@ -1,5 +1,5 @@
 #include "include/can_parser.h"
-#include "include/ecu_data.h"
+#include "include/channel_registry.h"
 #include "esp_log.h"
 #include <string.h>
 
@@ -25,58 +25,51 @@ void parse_can_message(const twai_message_t* message) {
         return;
     }
 
-    // Get a pointer to the global ECU data struct.
-    // The canbus_task is responsible for locking the mutex before calling this.
-    ecu_data_t* ecu_data = ecu_data_get();
-    if (!ecu_data) {
-        return;
-    }
-
     float raw_value_percent = 0.0f;
 
     switch (message->identifier) {
         case 0x280: // RPM, TPS, Pedal Pos, Target Torque, Actual Torque
-            ecu_data->engine_rpm = ((message->data[2] << 8) | message->data[3]) * 0.25f;
-            ecu_data->tps_position = message->data[7] * 0.3937f;
-            ecu_data->abs_pedal_pos = message->data[4] * 0.4f;
+            channel_set(CH_ENGINE_RPM, ((message->data[2] << 8) | message->data[3]) * 0.25f);
+            channel_set(CH_TPS_POSITION, message->data[7] * 0.3937f);
+            channel_set(CH_ABS_PEDAL_POS, message->data[4] * 0.4f);
 
             // Torque values are first calculated as %, then converted to Nm
             raw_value_percent = message->data[5] * 0.3937f;
-            ecu_data->eng_trg_nm = (raw_value_percent / 100.0f) * g_max_torque_nm;
+            channel_set(CH_ENG_TRG_NM, (raw_value_percent / 100.0f) * g_max_torque_nm);
 
             // TODO: Resolve data conflict for Engine Actual Torque (eng_act_nm).
             // The user specification maps eng_act_nm to byte 3, but this byte is already
             // used as the low byte for the 16-bit engine_rpm value.
             // Disabling eng_act_nm parsing for now to prioritize engine_rpm.
             // raw_value_percent = message->data[3] * 0.3937f;
-            // ecu_data->eng_act_nm = (raw_value_percent / 100.0f) * g_max_torque_nm;
+            // channel_set(CH_ENG_ACT_NM, (raw_value_percent / 100.0f) * g_max_torque_nm);
             break;
 
         case 0x580: // MAP
             // Formula: raw * 0.01 = kPa
-            ecu_data->map_kpa = ((message->data[2] << 8) | message->data[3]) * 0.01f;
+            channel_set(CH_MAP_KPA, ((message->data[2] << 8) | message->data[3]) * 0.01f);
             break;
 
         case 0x390: // Wastegate
-            ecu_data->wg_set_percent = message->data[1] / 2.0f;
-            ecu_data->wg_pos_percent = message->data[2] / 2.0f;
+            channel_set(CH_WG_SET_PERCENT, message->data[1] / 2.0f);
+            channel_set(CH_WG_POS_PERCENT, message->data[2] / 2.0f);
             break;
 
         case 0x394: // Blow-Off Valve
-            ecu_data->bov_percent = (message->data[0] / 255.0f) * 50.0f;
+            channel_set(CH_BOV_PERCENT, (message->data[0] / 255.0f) * 50.0f);
             break;
 
         case 0x488: // TCU Torque
             raw_value_percent = message->data[1] * 0.39f;
-            ecu_data->tcu_tq_req_nm = (raw_value_percent / 100.0f) * g_max_torque_nm;
+            channel_set(CH_TCU_TQ_REQ_NM, (raw_value_percent / 100.0f) * g_max_torque_nm);
 
             raw_value_percent = message->data[2] * 0.39f;
-            ecu_data->tcu_tq_act_nm = (raw_value_percent / 100.0f) * g_max_torque_nm;
+            channel_set(CH_TCU_TQ_ACT_NM, (raw_value_percent / 100.0f) * g_max_torque_nm);
             break;
 
         case 0x288: // Torque Limit
             raw_value_percent = message->data[5] * 0.4f;
-            ecu_data->limit_tq_nm = (raw_value_percent / 100.0f) * g_max_torque_nm;
+            channel_set(CH_LIMIT_TQ_NM, (raw_value_percent / 100.0f) * g_max_torque_nm);
             break;
 
         default:
@@ -84,6 +77,5 @@ void parse_can_message(const twai_message_t* message) {
             break;
     }
 
-    // After parsing and updating the local copy, update the global structure.
-    // The calling function (canbus_task) is responsible for calling ecu_data_update.
+    // Each channel_set() is visible to the UI, logger and web API immediately.
 }
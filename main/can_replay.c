@@ -0,0 +1,498 @@
+/*
+ * CAN Trace Replay for ECU Dashboard
+ * Reads recorded traces and paces them into a frame sink, see can_replay.h
+ */
+
+#include "include/can_replay.h"
+#include <ctype.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+
+#ifdef ESP_PLATFORM
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "include/canbus.h"
+#else
+#include <time.h>
+#endif
+
+// Lines longer than this are counted as parse errors
+#define REPLAY_LINE_MAX     128
+
+// ============================================================================
+// PLATFORM HELPERS
+// ============================================================================
+
+static uint64_t replay_now_us(void)
+{
+#ifdef ESP_PLATFORM
+    return (uint64_t)esp_timer_get_time();
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000ULL + (uint64_t)ts.tv_nsec / 1000ULL;
+#endif
+}
+
+// Sleeps up to `us`; on the device the resolution is one RTOS tick, so
+// frames closer together than a tick are sent as a burst
+static void replay_sleep_us(uint64_t us)
+{
+#ifdef ESP_PLATFORM
+    TickType_t ticks = (TickType_t)(us / (portTICK_PERIOD_MS * 1000ULL));
+    if (ticks > 0) {
+        vTaskDelay(ticks);
+    }
+#else
+    struct timespec ts = {
+        .tv_sec = (time_t)(us / 1000000ULL),
+        .tv_nsec = (long)(us % 1000000ULL) * 1000L
+    };
+    nanosleep(&ts, NULL);
+#endif
+}
+
+// Lets lower priority tasks (and the idle task watchdog) run during
+// as-fast-as-possible replay
+static void replay_yield(void)
+{
+#ifdef ESP_PLATFORM
+    vTaskDelay(1);
+#endif
+}
+
+// ============================================================================
+// TEXT PARSERS
+// ============================================================================
+
+// "12.345678" -> 12345678 µs without going through float
+static bool parse_seconds(const char **p, uint64_t *us)
+{
+    char *end;
+    uint64_t sec = strtoull(*p, &end, 10);
+    if (end == *p) {
+        return false;
+    }
+    uint64_t frac = 0;
+    int digits = 0;
+    if (*end == '.') {
+        end++;
+        while (isdigit((unsigned char)*end)) {
+            if (digits < 6) {
+                frac = frac * 10 + (uint64_t)(*end - '0');
+                digits++;
+            }
+            end++;
+        }
+    }
+    while (digits++ < 6) {
+        frac *= 10;
+    }
+    *us = sec * 1000000ULL + frac;
+    *p = end;
+    return true;
+}
+
+static int hex_nibble(char c)
+{
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+// Hex byte string, optionally separated by `sep` (0 = packed), up to 8 bytes
+static int parse_hex_bytes(const char *s, char sep, uint8_t *out)
+{
+    int count = 0;
+    while (count < 8) {
+        while (sep != 0 && *s == sep) {
+            s++;
+        }
+        int hi = hex_nibble(s[0]);
+        int lo = hi < 0 ? -1 : hex_nibble(s[1]);
+        if (lo < 0) {
+            break;
+        }
+        out[count++] = (uint8_t)((hi << 4) | lo);
+        s += 2;
+    }
+    return count;
+}
+
+// Legacy can_trace.csv: "ms,ID,d0,d1,d2,d3,d4,d5,d6,d7", the DLC was not recorded
+static bool parse_legacy_csv(const char *line, can_log_frame_t *frame)
+{
+    char *end;
+    uint64_t ms = strtoull(line, &end, 10);
+    if (end == line || *end != ',') {
+        return false;
+    }
+    unsigned long id = strtoul(end + 1, &end, 16);
+    if (*end != ',') {
+        return false;
+    }
+    memset(frame, 0, sizeof(*frame));
+    frame->time_us = ms * 1000ULL;
+    frame->identifier = (uint32_t)id & CAN_LOG_ID_MASK;
+    frame->extended = id > 0x7FF;
+    frame->dlc = (uint8_t)parse_hex_bytes(end + 1, ',', frame->data);
+    return frame->dlc == 8;
+}
+
+// canlog_convert.py CSV: "timestamp_s,id,extended,rtr,dlc,data"
+static bool parse_tool_csv(const char *line, can_log_frame_t *frame)
+{
+    const char *p = line;
+    memset(frame, 0, sizeof(*frame));
+    if (!parse_seconds(&p, &frame->time_us) || *p != ',') {
+        return false;
+    }
+    char *end;
+    frame->identifier = (uint32_t)strtoul(p + 1, &end, 16) & CAN_LOG_ID_MASK;
+    int ext, rtr, dlc;
+    int consumed = 0;
+    if (sscanf(end, ",%d,%d,%d,%n", &ext, &rtr, &dlc, &consumed) != 3 || consumed == 0 ||
+        dlc < 0 || dlc > 15) {
+        return false;
+    }
+    frame->extended = ext != 0;
+    frame->rtr = rtr != 0;
+    frame->dlc = (uint8_t)dlc;
+    parse_hex_bytes(end + consumed, ' ', frame->data);
+    return true;
+}
+
+// candump -L: "(1699999999.123456) can0 1F334455#DEADBEEF" or "123#R"
+static bool parse_candump(const char *line, can_log_frame_t *frame)
+{
+    const char *p = line;
+    memset(frame, 0, sizeof(*frame));
+    if (*p++ != '(' || !parse_seconds(&p, &frame->time_us) || *p != ')') {
+        return false;
+    }
+    p++;
+    while (*p == ' ') p++;                 // Interface name
+    while (*p != ' ' && *p != '\0') p++;
+    while (*p == ' ') p++;
+
+    const char *id_start = p;
+    char *end;
+    frame->identifier = (uint32_t)strtoul(p, &end, 16) & CAN_LOG_ID_MASK;
+    if (end == id_start || *end != '#' || end[1] == '#') {
+        return false;                       // CAN FD frames ("##") are not supported
+    }
+    frame->extended = (end - id_start) > 3;
+    p = end + 1;
+    if (*p == 'R' || *p == 'r') {
+        frame->rtr = true;
+        frame->dlc = isdigit((unsigned char)p[1]) ? (uint8_t)(p[1] - '0') : 0;
+        return true;
+    }
+    frame->dlc = (uint8_t)parse_hex_bytes(p, 0, frame->data);
+    return true;
+}
+
+static can_replay_format_t detect_text_format(const char *first_line)
+{
+    if (first_line[0] == '(') {
+        return CAN_REPLAY_FORMAT_CANDUMP;
+    }
+    if (strncmp(first_line, "timestamp_s,", 12) == 0) {
+        return CAN_REPLAY_FORMAT_TOOL_CSV;
+    }
+    return CAN_REPLAY_FORMAT_LEGACY_CSV;
+}
+
+// ============================================================================
+// SOURCE
+// ============================================================================
+
+int can_replay_open(can_replay_source_t *src, const char *path, can_replay_format_t format)
+{
+    if (src == NULL || path == NULL) {
+        return CAN_LOG_ERR_INVALID;
+    }
+    memset(src, 0, sizeof(*src));
+
+    size_t len = strlen(path);
+    if (format == CAN_REPLAY_FORMAT_AUTO && len > 4 && strcasecmp(path + len - 4, ".BIN") == 0) {
+        format = CAN_REPLAY_FORMAT_BINARY;
+    }
+    if (format == CAN_REPLAY_FORMAT_BINARY) {
+        src->format = format;
+        return can_log_reader_open(&src->reader, path);
+    }
+
+    src->text = fopen(path, "r");
+    if (src->text == NULL) {
+        return CAN_LOG_ERR_IO;
+    }
+    if (format == CAN_REPLAY_FORMAT_AUTO) {
+        char line[REPLAY_LINE_MAX];
+        format = CAN_REPLAY_FORMAT_LEGACY_CSV;
+        if (fgets(line, sizeof(line), src->text) != NULL) {
+            format = detect_text_format(line);
+        }
+        rewind(src->text);
+    }
+    src->format = format;
+    return CAN_LOG_OK;
+}
+
+int can_replay_next(can_replay_source_t *src, can_log_frame_t *frame)
+{
+    if (src == NULL || frame == NULL) {
+        return CAN_LOG_ERR_INVALID;
+    }
+    if (src->format == CAN_REPLAY_FORMAT_BINARY) {
+        return can_log_reader_next(&src->reader, frame);
+    }
+    if (src->text == NULL) {
+        return CAN_LOG_ERR_INVALID;
+    }
+
+    char line[REPLAY_LINE_MAX];
+    while (fgets(line, sizeof(line), src->text) != NULL) {
+        src->line++;
+        size_t len = strlen(line);
+        if (len > 0 && line[len - 1] != '\n' && !feof(src->text)) {
+            // Overlong line: drop the rest of it
+            int c;
+            while ((c = fgetc(src->text)) != EOF && c != '\n') {
+            }
+            src->parse_errors++;
+            continue;
+        }
+        while (len > 0 && (line[len - 1] == '\n' || line[len - 1] == '\r')) {
+            line[--len] = '\0';
+        }
+        if (len == 0) {
+            continue;
+        }
+
+        bool ok;
+        switch (src->format) {
+            case CAN_REPLAY_FORMAT_CANDUMP:
+                ok = parse_candump(line, frame);
+                break;
+            case CAN_REPLAY_FORMAT_TOOL_CSV:
+                if (src->line == 1) {
+                    continue;               // Column header
+                }
+                ok = parse_tool_csv(line, frame);
+                break;
+            default:
+                ok = parse_legacy_csv(line, frame);
+                break;
+        }
+        if (ok) {
+            return CAN_LOG_OK;
+        }
+        src->parse_errors++;
+    }
+    return ferror(src->text) ? CAN_LOG_ERR_IO : CAN_LOG_END;
+}
+
+void can_replay_close(can_replay_source_t *src)
+{
+    if (src == NULL) {
+        return;
+    }
+    if (src->format == CAN_REPLAY_FORMAT_BINARY) {
+        can_log_reader_close(&src->reader);
+    }
+    if (src->text != NULL) {
+        fclose(src->text);
+    }
+    memset(src, 0, sizeof(*src));
+}
+
+// ============================================================================
+// PACED REPLAY
+// ============================================================================
+
+int can_replay_run(const char *path, const can_replay_config_t *config,
+                   can_replay_sink_t sink, void *ctx,
+                   volatile bool *stop, can_replay_stats_t *stats)
+{
+    if (path == NULL || sink == NULL) {
+        return CAN_LOG_ERR_INVALID;
+    }
+    can_replay_config_t cfg = CAN_REPLAY_DEFAULT_CONFIG();
+    if (config != NULL) {
+        cfg = *config;
+    }
+    can_replay_stats_t local_stats;
+    if (stats == NULL) {
+        stats = &local_stats;
+    }
+    memset(stats, 0, sizeof(*stats));
+
+    uint64_t wall_start = replay_now_us();
+    uint64_t trace_done_us = 0;
+    int ret = CAN_LOG_OK;
+    bool again;
+
+    do {
+        can_replay_source_t src;
+        ret = can_replay_open(&src, path, CAN_REPLAY_FORMAT_AUTO);
+        if (ret != CAN_LOG_OK) {
+            break;
+        }
+
+        can_log_frame_t frame;
+        uint64_t pass_wall_start = replay_now_us();
+        uint64_t first_us = 0;
+        uint64_t offset_us = 0;
+        uint32_t pass_frames = 0;
+        bool finished = false;
+
+        while (stop == NULL || !*stop) {
+            ret = can_replay_next(&src, &frame);
+            if (ret != CAN_LOG_OK) {
+                finished = (ret == CAN_LOG_END);
+                break;
+            }
+            if (pass_frames == 0) {
+                first_us = frame.time_us;
+            }
+            // Timestamps going backwards (e.g. a reboot inside a text trace)
+            // are replayed without delay
+            if (frame.time_us > first_us + offset_us) {
+                offset_us = frame.time_us - first_us;
+            }
+
+            if (cfg.speed > 0.0f) {
+                uint64_t target = pass_wall_start + (uint64_t)((double)offset_us / cfg.speed);
+                uint64_t now = replay_now_us();
+                if (target > now) {
+                    replay_sleep_us(target - now);
+                } else if (now - target > stats->max_lag_us) {
+                    stats->max_lag_us = (uint32_t)(now - target);
+                }
+            } else if ((pass_frames & 0xFF) == 0xFF) {
+                replay_yield();
+            }
+
+            sink(&frame, ctx);
+            pass_frames++;
+            stats->frames++;
+            stats->trace_us = trace_done_us + offset_us;
+        }
+
+        stats->parse_errors += src.parse_errors;
+        stats->crc_errors += src.reader.crc_errors;
+        can_replay_close(&src);
+
+        trace_done_us += offset_us;
+        if (finished) {
+            stats->loops++;
+            ret = CAN_LOG_OK;
+        }
+        // An empty trace would loop forever without a frame
+        again = finished && cfg.loop && pass_frames > 0;
+    } while (again && (stop == NULL || !*stop));
+
+    stats->elapsed_us = replay_now_us() - wall_start;
+    return ret;
+}
+
+// ============================================================================
+// DEVICE TASK
+// ============================================================================
+
+#ifdef ESP_PLATFORM
+
+static const char *TAG = "CAN_REPLAY";
+
+#define REPLAY_TASK_STACK_SIZE  4096
+#define REPLAY_TASK_PRIORITY    5       // Below can_task (10), like the UI tasks
+
+static TaskHandle_t s_replay_task = NULL;
+static volatile bool s_stop_requested = false;
+static can_replay_stats_t s_stats;      // Written by the replay task only
+static can_replay_config_t s_config;
+static char s_path[64];
+
+static void replay_sink(const can_log_frame_t *frame, void *ctx)
+{
+    (void)ctx;
+    twai_message_t message = {0};
+    message.identifier = frame->identifier;
+    message.extd = frame->extended;
+    message.rtr = frame->rtr;
+    message.data_length_code = frame->dlc;
+    memcpy(message.data, frame->data, sizeof(message.data));
+    canbus_ingest_frame(&message);
+}
+
+static void can_replay_task(void *pvParameters)
+{
+    ESP_LOGI(TAG, "Replaying %s at %.1fx%s", s_path, s_config.speed,
+             s_config.loop ? " (loop)" : "");
+
+    int ret = can_replay_run(s_path, &s_config, replay_sink, NULL, &s_stop_requested, &s_stats);
+    if (ret != CAN_LOG_OK) {
+        ESP_LOGE(TAG, "Replay of %s failed: %d", s_path, ret);
+    }
+
+    uint64_t elapsed_ms = s_stats.elapsed_us / 1000;
+    ESP_LOGI(TAG, "Replay done: %lu frames in %llu ms (%lu frames/s), max lag %lu us, "
+             "%lu parse errors, %lu CRC errors",
+             (unsigned long)s_stats.frames, elapsed_ms,
+             (unsigned long)(elapsed_ms > 0 ? (uint64_t)s_stats.frames * 1000 / elapsed_ms : 0),
+             (unsigned long)s_stats.max_lag_us,
+             (unsigned long)s_stats.parse_errors, (unsigned long)s_stats.crc_errors);
+
+    s_replay_task = NULL;
+    vTaskDelete(NULL);
+}
+
+esp_err_t can_replay_start(const char *path, const can_replay_config_t *config)
+{
+    if (path == NULL || strlen(path) >= sizeof(s_path)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (s_replay_task != NULL) {
+        ESP_LOGW(TAG, "Replay already running");
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    snprintf(s_path, sizeof(s_path), "%s", path);
+    can_replay_config_t defaults = CAN_REPLAY_DEFAULT_CONFIG();
+    s_config = config != NULL ? *config : defaults;
+    s_stop_requested = false;
+
+    BaseType_t ok = xTaskCreate(can_replay_task, "can_replay", REPLAY_TASK_STACK_SIZE,
+                                NULL, REPLAY_TASK_PRIORITY, &s_replay_task);
+    if (ok != pdPASS) {
+        s_replay_task = NULL;
+        ESP_LOGE(TAG, "Failed to create replay task");
+        return ESP_ERR_NO_MEM;
+    }
+    return ESP_OK;
+}
+
+void can_replay_stop(void)
+{
+    s_stop_requested = true;
+}
+
+bool can_replay_is_running(void)
+{
+    return s_replay_task != NULL;
+}
+
+void can_replay_get_stats(can_replay_stats_t *stats)
+{
+    if (stats != NULL) {
+        // Informational counters: a copy taken mid-update may be slightly stale
+        *stats = s_stats;
+    }
+}
+
+#endif // ESP_PLATFORM
@@ -2,6 +2,20 @@
 /*
  * CAN WebSocket Server for ECU Dashboard
  * Broadcasts CAN data over WebSocket for Android/Web clients
+ *
+ * The broadcast task serializes one JSON snapshot per tick and sends the
+ * same text frame to every client whose rate allows it. Before sending,
+ * one select() with a zero timeout finds the sockets with room in their
+ * send buffer; a client that is backing up skips the tick and gets the
+ * next snapshot instead (each snapshot is complete, nothing is queued per
+ * client), so a slow phone never makes the sender wait. A client that
+ * stays backed up for WS_STALL_CLOSE_MS is closed.
+ *
+ * Clients that connect with ?format=bin get the same snapshot as binary
+ * telemetry frames instead (telemetry_frame.h). Each of them has its own
+ * encoder: after the first keyframe only the channels that changed since
+ * the last frame that client received are sent. A skipped tick leaves the
+ * encoder untouched, so the next delta is against what the client has.
  */
 
 #include "freertos/FreeRTOS.h"
@@ -12,28 +26,169 @@
 #include "driver/twai.h"
 #include <string.h>
 #include "esp_system.h"
+#include "esp_timer.h"
+#include <stdlib.h>
+#include <sys/select.h>
+#include "lwip/sockets.h"
+#include "http_router.h"
 #include "include/can_websocket.h"
 #include "ui/settings_config.h"
+#include "json_writer.h"
+#include "include/channel_registry.h"
+#include "include/telemetry_frame.h"
+#include "include/ecu_data.h"
 
 static const char *TAG = "CAN_WEBSOCKET";
 
+#define WS_TICK_MS              100     // Broadcast task period, highest client rate
+#define WS_MAX_HZ               (1000 / WS_TICK_MS)
+#define WS_STALL_CLOSE_MS       5000    // Backed up this long: the client is closed
+#define WS_MAX_RX_FRAME         32      // Longest text frame accepted from a client
+
 // Forward declarations
 static esp_err_t ws_handler(httpd_req_t *req);
 static esp_err_t data_handler(httpd_req_t *req);
+static esp_err_t stats_handler(httpd_req_t *req);
 
 // Global CAN data (moved to header for external access)
 static can_data_t g_can_data = {0};
-static httpd_handle_t ws_server = NULL;
 
-// WebSocket handler for basic HTTP upgrade
+// Connected WebSocket client
+typedef struct {
+    int fd;                         // -1 = free
+    uint32_t interval_us;           // Minimum time between frames (rate limit)
+    int64_t last_sent_us;
+    int64_t stalled_since_us;       // 0 = send buffer had room at the last try
+    uint32_t sent;
+    uint32_t coalesced;             // Ticks skipped because the socket was backing up
+    bool binary;                    // Telemetry frames instead of JSON text
+    telemetry_encoder_t enc;        // State of the frames this client received
+} ws_client_t;
+
+static ws_client_t ws_clients[CAN_WS_MAX_CLIENTS];
+static can_websocket_stats_t ws_stats;
+static portMUX_TYPE ws_lock = portMUX_INITIALIZER_UNLOCKED;
+
+// ============================================================================
+// CLIENTS
+// ============================================================================
+
+static uint32_t ws_interval_for_hz(uint32_t hz)
+{
+    if (hz == 0 || hz > WS_MAX_HZ) {
+        hz = WS_MAX_HZ;
+    }
+    return 1000000 / hz;
+}
+
+static esp_err_t ws_client_add(int fd, uint32_t hz, bool binary)
+{
+    esp_err_t ret = ESP_ERR_NO_MEM;
+    portENTER_CRITICAL(&ws_lock);
+    for (int i = 0; i < CAN_WS_MAX_CLIENTS; i++) {
+        if (ws_clients[i].fd < 0) {
+            memset(&ws_clients[i], 0, sizeof(ws_clients[i]));
+            ws_clients[i].fd = fd;
+            ws_clients[i].interval_us = ws_interval_for_hz(hz);
+            ws_clients[i].binary = binary;
+            telemetry_encoder_init(&ws_clients[i].enc);
+            ws_stats.clients++;
+            ws_stats.connects++;
+            ret = ESP_OK;
+            break;
+        }
+    }
+    portEXIT_CRITICAL(&ws_lock);
+    return ret;
+}
+
+static void ws_client_remove(int fd)
+{
+    portENTER_CRITICAL(&ws_lock);
+    for (int i = 0; i < CAN_WS_MAX_CLIENTS; i++) {
+        if (ws_clients[i].fd == fd) {
+            ws_clients[i].fd = -1;
+            ws_stats.clients--;
+            break;
+        }
+    }
+    portEXIT_CRITICAL(&ws_lock);
+}
+
+static void ws_client_set_rate(int fd, uint32_t hz)
+{
+    portENTER_CRITICAL(&ws_lock);
+    for (int i = 0; i < CAN_WS_MAX_CLIENTS; i++) {
+        if (ws_clients[i].fd == fd) {
+            ws_clients[i].interval_us = ws_interval_for_hz(hz);
+            break;
+        }
+    }
+    portEXIT_CRITICAL(&ws_lock);
+}
+
+// Router close hook: every closed session passes here, WebSocket or not
+static void ws_closed(int sockfd)
+{
+    ws_client_remove(sockfd);
+}
+
+// WebSocket handler: the handshake registers the client, text frames
+// "hz=N" change its rate. Ping, pong and close are answered by the server.
 static esp_err_t ws_handler(httpd_req_t *req)
 {
+    int fd = httpd_req_to_sockfd(req);
+
     if (req->method == HTTP_GET) {
-        ESP_LOGI(TAG, "Handshake done, new WebSocket connection opened");
+        // ws://host/ws?hz=5 - frames per second, at most WS_MAX_HZ
+        // ws://host/ws?format=bin - binary telemetry frames
+        uint32_t hz = WS_MAX_HZ;
+        bool binary = false;
+        char query[32];
+        char value[8];
+        if (httpd_req_get_url_query_str(req, query, sizeof(query)) == ESP_OK) {
+            if (httpd_query_key_value(query, "hz", value, sizeof(value)) == ESP_OK) {
+                hz = (uint32_t)atoi(value);
+            }
+            if (httpd_query_key_value(query, "format", value, sizeof(value)) == ESP_OK) {
+                binary = strcmp(value, "bin") == 0;
+            }
+        }
+
+        // The client keeps its session: it needs a stream slot of the shared server
+        if (http_router_stream_begin(fd) != ESP_OK) {
+            ESP_LOGW(TAG, "No stream slot for WebSocket fd %d", fd);
+            return ESP_FAIL;
+        }
+        if (ws_client_add(fd, hz, binary) != ESP_OK) {
+            ESP_LOGW(TAG, "No free WebSocket client slot for fd %d", fd);
+            return ESP_FAIL;
+        }
+        ESP_LOGI(TAG, "Handshake done, new WebSocket connection opened (fd %d, %s)",
+                 fd, binary ? "binary" : "JSON");
         return ESP_OK;
     }
-    
-    // For now, just return OK since we're not handling complex WebSocket frames
+
+    httpd_ws_frame_t frame = { 0 };
+    esp_err_t ret = httpd_ws_recv_frame(req, &frame, 0);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+    if (frame.len > WS_MAX_RX_FRAME) {
+        // Not a command of ours; closing is cheaper than draining it
+        return ESP_FAIL;
+    }
+
+    uint8_t buf[WS_MAX_RX_FRAME + 1];
+    frame.payload = buf;
+    ret = httpd_ws_recv_frame(req, &frame, WS_MAX_RX_FRAME);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+    buf[frame.len] = '\0';
+    if (frame.type == HTTPD_WS_TYPE_TEXT && strncmp((const char *)buf, "hz=", 3) == 0) {
+        ws_client_set_rate(fd, (uint32_t)atoi((const char *)buf + 3));
+    }
     return ESP_OK;
 }
 
@@ -41,60 +196,15 @@ static esp_err_t ws_handler(httpd_req_t *req)
 static esp_err_t data_handler(httpd_req_t *req)
 {
     if (req->method == HTTP_GET) {
-        // Check if demo mode is enabled
-        bool demo_enabled = demo_mode_get_enabled();
-        ESP_LOGI(TAG, "🔌 WebSocket server - demo mode check: %s", demo_enabled ? "ENABLED" : "DISABLED");
-
-        if (demo_enabled) {
-            // Demo mode enabled - return real or simulated data
-            if (g_can_data.data_valid) {
-                char json_data[256];
-                snprintf(json_data, sizeof(json_data),
-                    "{\"map_pressure\":%d,\"wastegate_pos\":%d,\"tps_position\":%d,"
-                    "\"engine_rpm\":%d,\"target_boost\":%d,\"tcu_status\":%d}",
-                    g_can_data.map_pressure, g_can_data.wastegate_pos, g_can_data.tps_position,
-                    g_can_data.engine_rpm, g_can_data.target_boost, g_can_data.tcu_status);
-
-                httpd_resp_set_type(req, "application/json");
-                httpd_resp_send(req, json_data, HTTPD_RESP_USE_STRLEN);
-                ESP_LOGD(TAG, "CAN data sent (demo mode)");
-            } else {
-                // No real data, generate demo data
-                static int demo_counter = 0;
-                demo_counter++;
-
-                // Generate demo data using simple periodic functions
-                int cycle = demo_counter % 100;
-                float phase = cycle / 100.0f;
-                float map_pressure = 120.0f + 30.0f * (cycle > 50 ? (100 - cycle) : cycle) / 50.0f;
-                float wastegate_pos = 45.0f + 25.0f * phase;
-                float tps_position = 35.0f + 30.0f * phase;
-                float engine_rpm = 2500.0f + 500.0f * phase;
-                float target_boost = 180.0f + 20.0f * phase;
-                int tcu_status = (demo_counter % 100 > 95) ? 1 : 0;
-
-                char json_data[256];
-                snprintf(json_data, sizeof(json_data),
-                    "{\"map_pressure\":%.1f,\"wastegate_pos\":%.1f,\"tps_position\":%.1f,"
-                    "\"engine_rpm\":%.0f,\"target_boost\":%.1f,\"tcu_status\":%d}",
-                    map_pressure, wastegate_pos, tps_position, engine_rpm, target_boost, tcu_status);
-
-                httpd_resp_set_type(req, "application/json");
-                httpd_resp_send(req, json_data, HTTPD_RESP_USE_STRLEN);
-                ESP_LOGD(TAG, "Demo CAN data sent");
-            }
-        } else {
-            // Demo mode disabled - return zero values
-            char json_data[256];
-            snprintf(json_data, sizeof(json_data),
-                "{\"map_pressure\":0.0,\"wastegate_pos\":0.0,\"tps_position\":0.0,"
-                "\"engine_rpm\":0,\"target_boost\":0.0,\"tcu_status\":0}");
-
-            httpd_resp_set_type(req, "application/json");
-            httpd_resp_send(req, json_data, HTTPD_RESP_USE_STRLEN);
-            ESP_LOGI(TAG, "❌ WebSocket demo mode disabled, zero values sent to client");
-        }
-        return ESP_OK;
+        // The same values as the broadcast, live or demo
+        channel_snapshot_t snap;
+        ecu_data_live_snapshot(&snap);
+
+        char chunk[JSON_WRITER_CHUNK_SIZE];
+        json_writer_t w;
+        json_writer_init_httpd(&w, req, chunk, sizeof(chunk));
+        ecu_data_write_gauges_json(&w, &snap);
+        return json_writer_finish(&w);
     }
 
     return ESP_FAIL;
@@ -102,51 +212,234 @@ static esp_err_t data_handler(httpd_req_t *req)
 
 
 
-// Broadcast CAN data to all connected clients via HTTP
-void broadcast_can_data(void)
+// Encodes the next frame of a binary client against its own encoder and
+// sends it. The new encoder state is returned in *enc; the caller keeps it
+// only if the frame went out.
+static bool ws_send_telemetry(httpd_handle_t server, int fd, const channel_snapshot_t *snap,
+                              telemetry_encoder_t *enc)
 {
-    bool demo_enabled = demo_mode_get_enabled();
-    ESP_LOGD(TAG, "📡 Broadcast check - demo mode: %s", demo_enabled ? "ENABLED" : "DISABLED");
+    bool found = false;
+    portENTER_CRITICAL(&ws_lock);
+    for (int i = 0; i < CAN_WS_MAX_CLIENTS; i++) {
+        if (ws_clients[i].fd == fd) {
+            *enc = ws_clients[i].enc;
+            found = true;
+            break;
+        }
+    }
+    portEXIT_CRITICAL(&ws_lock);
+    if (!found) {
+        return false;
+    }
 
-    if (!demo_enabled) {
-        // Demo mode disabled - don't broadcast
-        ESP_LOGI(TAG, "🚫 Broadcast cancelled - demo mode disabled");
-        return;
+    uint8_t buf[TELEMETRY_FRAME_MAX_SIZE];
+    int len = telemetry_frame_encode_snapshot(enc, snap, false, buf, sizeof(buf));
+    if (len < 0) {
+        return false;
     }
+    httpd_ws_frame_t frame = {
+        .final = true,
+        .type = HTTPD_WS_TYPE_BINARY,
+        .payload = buf,
+        .len = (size_t)len,
+    };
+    return httpd_ws_send_frame_async(server, fd, &frame) == ESP_OK;
+}
 
-    if (!g_can_data.data_valid) {
-        // No real data, generate demo data for broadcast
-        static int demo_counter = 0;
-        demo_counter++;
-
-        // Generate demo data using simple periodic functions
-        int cycle = demo_counter % 100;
-        float phase = cycle / 100.0f;
-        float map_pressure = 120.0f + 30.0f * (cycle > 50 ? (100 - cycle) : cycle) / 50.0f;
-        float wastegate_pos = 45.0f + 25.0f * phase;
-        float tps_position = 35.0f + 30.0f * phase;
-        float engine_rpm = 2500.0f + 500.0f * phase;
-        float target_boost = 180.0f + 20.0f * phase;
-        int tcu_status = (demo_counter % 100 > 95) ? 1 : 0;
-
-        char json_data[256];
-        snprintf(json_data, sizeof(json_data),
-            "{\"map_pressure\":%.1f,\"wastegate_pos\":%.1f,\"tps_position\":%.1f,"
-            "\"engine_rpm\":%.0f,\"target_boost\":%.1f,\"tcu_status\":%d}",
-            map_pressure, wastegate_pos, tps_position, engine_rpm, target_boost, tcu_status);
-
-        ESP_LOGD(TAG, "Broadcasting demo CAN data: %s", json_data);
+// Serializes one snapshot and sends it to every client that is due and
+// has room in its send buffer. Called once per tick by the broadcast task.
+void broadcast_can_data(void)
+{
+    // One snapshot per tick for every client, text and binary alike: live
+    // registry values, with the demo sweep on the gauge channels in demo
+    // mode. The same values /data, /data.bin and /events serve right now.
+    channel_snapshot_t snap;
+    ecu_data_live_snapshot(&snap);
+
+    // Clients whose rate allows a frame this tick (half a tick of slack
+    // keeps task jitter from skipping a whole period)
+    int64_t start_us = esp_timer_get_time();
+    int due[CAN_WS_MAX_CLIENTS];
+    bool due_binary[CAN_WS_MAX_CLIENTS];
+    int due_count = 0;
+    bool any_text = false;
+    portENTER_CRITICAL(&ws_lock);
+    for (int i = 0; i < CAN_WS_MAX_CLIENTS; i++) {
+        const ws_client_t *c = &ws_clients[i];
+        if (c->fd >= 0 && start_us - c->last_sent_us >= (int64_t)c->interval_us - WS_TICK_MS * 500) {
+            due_binary[due_count] = c->binary;
+            due[due_count++] = c->fd;
+            any_text |= !c->binary;
+        }
+    }
+    portEXIT_CRITICAL(&ws_lock);
+    httpd_handle_t server = http_router_handle();
+    if (due_count == 0 || server == NULL) {
         return;
     }
 
-    char json_data[256];
-    snprintf(json_data, sizeof(json_data),
-        "{\"map_pressure\":%d,\"wastegate_pos\":%d,\"tps_position\":%d,"
-        "\"engine_rpm\":%d,\"target_boost\":%d,\"tcu_status\":%d}",
-        g_can_data.map_pressure, g_can_data.wastegate_pos, g_can_data.tps_position,
-        g_can_data.engine_rpm, g_can_data.target_boost, g_can_data.tcu_status);
+    // One serialization for all text clients
+    char json_data[JSON_WRITER_CHUNK_SIZE];
+    const char *text = NULL;
+    if (any_text) {
+        json_writer_t w;
+        json_writer_init(&w, json_data, sizeof(json_data), NULL, NULL);
+        ecu_data_write_gauges_json(&w, &snap);
+        if (json_writer_finish(&w) != ESP_OK) {
+            return;
+        }
+        text = json_writer_str(&w);
+    }
+    int64_t serialized_us = esp_timer_get_time();
+
+    // Which of them can take a frame without blocking
+    fd_set writable;
+    FD_ZERO(&writable);
+    int max_fd = -1;
+    for (int i = 0; i < due_count; i++) {
+        FD_SET(due[i], &writable);
+        if (due[i] > max_fd) {
+            max_fd = due[i];
+        }
+    }
+    struct timeval no_wait = { 0, 0 };
+    if (select(max_fd + 1, NULL, &writable, NULL, &no_wait) < 0) {
+        FD_ZERO(&writable);
+    }
 
-    ESP_LOGD(TAG, "Broadcasting CAN data: %s", json_data);
+    httpd_ws_frame_t text_frame = {
+        .final = true,
+        .type = HTTPD_WS_TYPE_TEXT,
+        .payload = (uint8_t *)text,
+        .len = text ? strlen(text) : 0,
+    };
+
+    uint32_t sent = 0;
+    uint32_t coalesced = 0;
+    for (int i = 0; i < due_count; i++) {
+        int fd = due[i];
+        bool ok = false;
+        bool failed = false;
+        bool room = FD_ISSET(fd, &writable);
+        telemetry_encoder_t enc;
+        // The fd may have been closed and reused by a plain HTTP session
+        if (room && httpd_ws_get_fd_info(server, fd) == HTTPD_WS_CLIENT_WEBSOCKET) {
+            if (due_binary[i]) {
+                ok = ws_send_telemetry(server, fd, &snap, &enc);
+            } else {
+                ok = httpd_ws_send_frame_async(server, fd, &text_frame) == ESP_OK;
+            }
+            failed = !ok;
+        }
+
+        int64_t now = esp_timer_get_time();
+        bool close_stalled = false;
+        portENTER_CRITICAL(&ws_lock);
+        for (int j = 0; j < CAN_WS_MAX_CLIENTS; j++) {
+            ws_client_t *c = &ws_clients[j];
+            if (c->fd != fd) {
+                continue;
+            }
+            if (ok) {
+                if (due_binary[i] && c->binary) {
+                    c->enc = enc;
+                }
+                c->sent++;
+                c->last_sent_us = now;
+                c->stalled_since_us = 0;
+                sent++;
+            } else if (!room) {
+                c->coalesced++;
+                coalesced++;
+                if (c->stalled_since_us == 0) {
+                    c->stalled_since_us = now;
+                } else if (now - c->stalled_since_us > (int64_t)WS_STALL_CLOSE_MS * 1000) {
+                    c->stalled_since_us = now;
+                    close_stalled = true;
+                }
+            }
+            break;
+        }
+        if (close_stalled || failed) {
+            ws_stats.clients_closed++;
+        }
+        portEXIT_CRITICAL(&ws_lock);
+
+        if (close_stalled) {
+            ESP_LOGW(TAG, "WebSocket client fd %d backed up for %d ms, closing", fd, WS_STALL_CLOSE_MS);
+        }
+        if (close_stalled || failed) {
+            httpd_sess_trigger_close(server, fd);
+        }
+    }
+
+    int64_t end_us = esp_timer_get_time();
+    uint32_t fanout_us = (uint32_t)(end_us - start_us);
+    portENTER_CRITICAL(&ws_lock);
+    ws_stats.ticks++;
+    ws_stats.frames_sent += sent;
+    ws_stats.frames_coalesced += coalesced;
+    ws_stats.last_serialize_us = (uint32_t)(serialized_us - start_us);
+    ws_stats.last_fanout_us = fanout_us;
+    ws_stats.total_fanout_us += fanout_us;
+    if (fanout_us > ws_stats.max_fanout_us) {
+        ws_stats.max_fanout_us = fanout_us;
+    }
+    portEXIT_CRITICAL(&ws_lock);
+}
+
+void can_websocket_get_stats(can_websocket_stats_t *stats)
+{
+    if (!stats) {
+        return;
+    }
+    portENTER_CRITICAL(&ws_lock);
+    *stats = ws_stats;
+    portEXIT_CRITICAL(&ws_lock);
+}
+
+// Server-side fan-out cost and per-client counters (used by tools/ws_load_test.py)
+static esp_err_t stats_handler(httpd_req_t *req)
+{
+    can_websocket_stats_t stats;
+    ws_client_t clients[CAN_WS_MAX_CLIENTS];
+    portENTER_CRITICAL(&ws_lock);
+    stats = ws_stats;
+    memcpy(clients, ws_clients, sizeof(clients));
+    portEXIT_CRITICAL(&ws_lock);
+
+    char chunk[JSON_WRITER_CHUNK_SIZE];
+    json_writer_t w;
+    json_writer_init_httpd(&w, req, chunk, sizeof(chunk));
+    json_obj_begin(&w);
+    json_kv_uint(&w, "clients", stats.clients);
+    json_kv_uint(&w, "connects", stats.connects);
+    json_kv_uint(&w, "clients_closed", stats.clients_closed);
+    json_kv_uint(&w, "ticks", stats.ticks);
+    json_kv_uint(&w, "frames_sent", stats.frames_sent);
+    json_kv_uint(&w, "frames_coalesced", stats.frames_coalesced);
+    json_kv_uint(&w, "last_serialize_us", stats.last_serialize_us);
+    json_kv_uint(&w, "last_fanout_us", stats.last_fanout_us);
+    json_kv_uint(&w, "avg_fanout_us", stats.ticks > 0 ? (uint32_t)(stats.total_fanout_us / stats.ticks) : 0);
+    json_kv_uint(&w, "max_fanout_us", stats.max_fanout_us);
+    json_kv_uint(&w, "total_fanout_us", stats.total_fanout_us);
+    json_key(&w, "client_list");
+    json_arr_begin(&w);
+    for (int i = 0; i < CAN_WS_MAX_CLIENTS; i++) {
+        if (clients[i].fd < 0) {
+            continue;
+        }
+        json_obj_begin(&w);
+        json_kv_int(&w, "fd", clients[i].fd);
+        json_kv_uint(&w, "hz", 1000000 / clients[i].interval_us);
+        json_kv_str(&w, "format", clients[i].binary ? "bin" : "json");
+        json_kv_uint(&w, "sent", clients[i].sent);
+        json_kv_uint(&w, "coalesced", clients[i].coalesced);
+        json_obj_end(&w);
+    }
+    json_arr_end(&w);
+    json_obj_end(&w);
+    return json_writer_finish(&w);
 }
 
 // Update CAN data from main CAN task
@@ -169,8 +462,7 @@ void update_websocket_can_data(uint16_t rpm, uint16_t map, uint8_t tps,
         ESP_LOGD(TAG, "✅ CAN data updated - RPM: %d, MAP: %d, TPS: %d, Wastegate: %d, Boost: %d, TCU: %d",
                   rpm, map, tps, wastegate, target_boost, tcu_status);
 
-        // Broadcast updated data
-        broadcast_can_data();
+        // Sent with the next broadcast tick, not from the caller's task
     } else {
         // Demo mode disabled - clear data
         g_can_data.engine_rpm = 0;
@@ -185,47 +477,42 @@ void update_websocket_can_data(uint16_t rpm, uint16_t map, uint8_t tps,
     }
 }
 
-// Start WebSocket server (simplified HTTP server for now)
+// Routes on the shared server. /ws/data answers a single poll with the
+// values the broadcast sends.
+static const httpd_uri_t ws_routes[] = {
+    { .uri = "/ws",       .method = HTTP_GET, .handler = ws_handler, .is_websocket = true },
+    { .uri = "/ws/data",  .method = HTTP_GET, .handler = data_handler },
+    { .uri = "/ws/stats", .method = HTTP_GET, .handler = stats_handler },
+};
+
+// Start WebSocket server: adds the WebSocket routes to the shared server
 esp_err_t start_websocket_server(void)
 {
-    httpd_config_t config = HTTPD_DEFAULT_CONFIG();
-    config.server_port = 8081;  // Use different port to avoid conflict with main HTTP server
-    config.max_open_sockets = 7;
-
-    ESP_LOGI(TAG, "Starting WebSocket server on port: '%d'", config.server_port);
-    
-    if (httpd_start(&ws_server, &config) == ESP_OK) {
-        httpd_uri_t ws_uri = {
-            .uri = "/ws",
-            .method = HTTP_GET,
-            .handler = ws_handler,
-            .user_ctx = NULL
-        };
-        httpd_register_uri_handler(ws_server, &ws_uri);
-        
-        // Add data endpoint
-        httpd_uri_t data_uri = {
-            .uri = "/data",
-            .method = HTTP_GET,
-            .handler = data_handler,
-            .user_ctx = NULL
-        };
-        httpd_register_uri_handler(ws_server, &data_uri);
-        
-        ESP_LOGI(TAG, "WebSocket server started");
-        return ESP_OK;
+    portENTER_CRITICAL(&ws_lock);
+    for (int i = 0; i < CAN_WS_MAX_CLIENTS; i++) {
+        ws_clients[i].fd = -1;
     }
-    
-    ESP_LOGE(TAG, "Error starting WebSocket server");
-    return ESP_FAIL;
+    memset(&ws_stats, 0, sizeof(ws_stats));
+    portEXIT_CRITICAL(&ws_lock);
+
+    esp_err_t ret = http_router_add_close_hook(ws_closed);
+    for (size_t i = 0; i < sizeof(ws_routes) / sizeof(ws_routes[0]) && ret == ESP_OK; i++) {
+        ret = http_router_register(&ws_routes[i]);
+    }
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Error adding WebSocket routes: %s", esp_err_to_name(ret));
+        return ret;
+    }
+
+    ESP_LOGI(TAG, "WebSocket server started");
+    return ESP_OK;
 }
 
-// Stop WebSocket server
+// Stop WebSocket server: removes the routes, connected clients stay until they close
 void stop_websocket_server(void)
 {
-    if (ws_server) {
-        httpd_stop(ws_server);
-        ws_server = NULL;
+    for (size_t i = 0; i < sizeof(ws_routes) / sizeof(ws_routes[0]); i++) {
+        http_router_unregister(ws_routes[i].uri, ws_routes[i].method);
     }
 }
 
@@ -234,7 +521,7 @@ void websocket_broadcast_task(void *pvParameters)
 {
     while (1) {
         broadcast_can_data();
-        vTaskDelay(pdMS_TO_TICKS(100)); // Broadcast at 10Hz
+        vTaskDelay(pdMS_TO_TICKS(WS_TICK_MS)); // Broadcast at 10Hz
     }
 }
 
@@ -3,6 +3,7 @@
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 #include "freertos/queue.h"
+#include "freertos/semphr.h"
 #include <string.h>
 #include "esp_timer.h"
 #include "include/web_server.h"
@@ -11,6 +12,8 @@
 #include "ui/screens/ui_Screen3.h"
 #include "include/can_parser.h"
 #include "sd_card_manager.h"
+#include "include/can_logger.h"
+#include "include/event_capture.h"
 
 static const char *CAN_TAG = "CANBUS";
 
@@ -23,6 +26,13 @@ static twai_filter_config_t f_config = TWAI_FILTER_CONFIG_ACCEPT_ALL();
 static bool canbus_initialized = false;
 static bool canbus_running = false;
 
+// Live frames (canbus_task) and replayed frames (can_replay.c) arrive on
+// different tasks. The parser, the trace logger and the Screen3 sniffer
+// keep per-stream state, so frames go through the ingest path one at a time.
+static portMUX_TYPE ingest_init_lock = portMUX_INITIALIZER_UNLOCKED;
+static StaticSemaphore_t ingest_mutex_buf;
+static SemaphoreHandle_t ingest_mutex = NULL;
+
 esp_err_t canbus_init(void)
 {
     if (canbus_initialized) {
@@ -30,6 +40,9 @@ esp_err_t canbus_init(void)
         return ESP_OK;
     }
     
+    // Deeper RX queue so short stalls of this task do not lose frames
+    g_config.rx_queue_len = 64;
+
     esp_err_t ret = twai_driver_install(&g_config, &t_config, &f_config);
     if (ret != ESP_OK) {
         ESP_LOGE(CAN_TAG, "Failed to install TWAI driver: %s", esp_err_to_name(ret));
@@ -82,6 +95,39 @@ esp_err_t canbus_stop(void)
     return ESP_OK;
 }
 
+// Shared by the TWAI receive task and trace replay (can_replay.c), so
+// replayed traffic exercises exactly the same path as the bus
+void canbus_ingest_frame(const twai_message_t *message)
+{
+    portENTER_CRITICAL(&ingest_init_lock);
+    if (ingest_mutex == NULL) {
+        ingest_mutex = xSemaphoreCreateMutexStatic(&ingest_mutex_buf);
+    }
+    portEXIT_CRITICAL(&ingest_init_lock);
+    // Priority inheritance lifts the replay task while the CAN task waits
+    xSemaphoreTake(ingest_mutex, portMAX_DELAY);
+
+    // 1. Parse the received CAN message using the new parser.
+    // The parser will update the global g_ecu_data struct.
+    parse_can_message(message);
+
+    // 2. The global data structure is now updated.
+    // The UI task will periodically read this data to update the gauges.
+
+    // 3. Send raw CAN message to Screen3 sniffer for debugging.
+    ui_process_real_can_message(message->identifier, message->data, message->data_length_code);
+
+    // 4. Hand the frame to the SD trace logger (copy only, never blocks)
+    if (sd_card_is_can_trace_enabled()) {
+        can_logger_log_frame(message);
+    }
+
+    // 5. Keep the frame for event capture (lock-free copy, may trigger an event)
+    event_capture_frame(message);
+
+    xSemaphoreGive(ingest_mutex);
+}
+
 // The canbus_task is now much simpler. It receives a message and passes it to the new parser.
 void canbus_task(void *pvParameters)
 {
@@ -98,27 +144,7 @@ void canbus_task(void *pvParameters)
             consecutive_errors = 0;
             last_message_time = xTaskGetTickCount();
 
-            // 1. Parse the received CAN message using the new parser.
-            // The parser will update the global g_ecu_data struct.
-            parse_can_message(&message);
-
-            // 2. The global data structure is now updated.
-            // The UI task will periodically read this data to update the gauges.
-
-            // 3. Send raw CAN message to Screen3 sniffer for debugging.
-            ui_process_real_can_message(message.identifier, message.data, message.data_length_code);
-
-            // 4. Log CAN trace to SD card if enabled
-            if (sd_card_is_can_trace_enabled()) {
-                char trace_buffer[100];
-                // Format: timestamp,ID,d0,d1,d2,d3,d4,d5,d6,d7
-                snprintf(trace_buffer, sizeof(trace_buffer), "%llu,%X,%02X,%02X,%02X,%02X,%02X,%02X,%02X,%02X\n",
-                         esp_timer_get_time() / 1000,
-                         message.identifier,
-                         message.data[0], message.data[1], message.data[2], message.data[3],
-                         message.data[4], message.data[5], message.data[6], message.data[7]);
-                sd_card_append_file("/sdcard/can_trace.csv", trace_buffer);
-            }
+            canbus_ingest_frame(&message);
 
         } else if (ret == ESP_ERR_TIMEOUT) {
             // Timeout is normal if there's no traffic on the bus.
@@ -150,6 +176,7 @@ void canbus_task(void *pvParameters)
                 }
             }
         }
-        vTaskDelay(pdMS_TO_TICKS(10));
+        // No delay here: twai_receive() blocks, and sleeping after every
+        // frame would cap the task at 100 frames/s on a busy bus.
     }
 }
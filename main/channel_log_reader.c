@@ -0,0 +1,278 @@
+/*
+ * Channel Log Reader for ECU Dashboard
+ * Single-channel decoding of columnar channel logs, see channel_log_reader.h
+ */
+
+#include "include/channel_log_reader.h"
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef ESP_PLATFORM
+#include "esp_heap_caps.h"
+#include "esp_rom_crc.h"
+#endif
+
+// ============================================================================
+// PLATFORM HELPERS
+// ============================================================================
+
+static uint32_t log_crc32(uint32_t crc, const uint8_t *buf, size_t len)
+{
+#ifdef ESP_PLATFORM
+    return esp_rom_crc32_le(crc, buf, len);
+#else
+    // Same polynomial and conditioning as esp_rom_crc32_le() and zlib
+    crc = ~crc;
+    for (size_t i = 0; i < len; i++) {
+        crc ^= buf[i];
+        for (int k = 0; k < 8; k++) {
+            crc = (crc >> 1) ^ (0xEDB88320u & (0u - (crc & 1u)));
+        }
+    }
+    return ~crc;
+#endif
+}
+
+static void *log_alloc(size_t size)
+{
+#ifdef ESP_PLATFORM
+    void *p = heap_caps_malloc(size, MALLOC_CAP_SPIRAM);
+    if (p != NULL) {
+        return p;
+    }
+#endif
+    return malloc(size);
+}
+
+// ============================================================================
+// OPEN / SELECT
+// ============================================================================
+
+int channel_log_reader_open(channel_log_reader_t *r, const char *path)
+{
+    if (r == NULL || path == NULL) {
+        return CAN_LOG_ERR_INVALID;
+    }
+    memset(r, 0, sizeof(*r));
+
+    r->file = fopen(path, "rb");
+    if (r->file == NULL) {
+        return CAN_LOG_ERR_IO;
+    }
+
+    channel_log_file_header_t *hdr = &r->header;
+    if (fread(hdr, sizeof(*hdr), 1, r->file) != 1) {
+        channel_log_reader_close(r);
+        return CAN_LOG_ERR_IO;
+    }
+    size_t table_size = (size_t)hdr->channel_count * sizeof(channel_log_channel_t);
+    if (hdr->magic != CHANNEL_LOG_FILE_MAGIC ||
+        hdr->version != CHANNEL_LOG_FORMAT_VERSION ||
+        hdr->header_size != sizeof(*hdr) ||
+        hdr->page_size != CHANNEL_LOG_PAGE_SIZE ||
+        hdr->tick_us == 0 ||
+        hdr->channel_count > CHANNEL_LOG_MAX_CHANNELS ||
+        hdr->channel_size != sizeof(channel_log_channel_t) ||
+        fread(r->channels, 1, table_size, r->file) != table_size) {
+        channel_log_reader_close(r);
+        return CAN_LOG_ERR_FORMAT;
+    }
+    uint32_t crc = log_crc32(0, (const uint8_t *)hdr, offsetof(channel_log_file_header_t, crc32));
+    if (log_crc32(crc, (const uint8_t *)r->channels, table_size) != hdr->crc32) {
+        channel_log_reader_close(r);
+        return CAN_LOG_ERR_FORMAT;
+    }
+    // The writer never stores more; callers size their text output on it
+    for (int i = 0; i < hdr->channel_count; i++) {
+        if (r->channels[i].precision > CHANNEL_LOG_MAX_PRECISION) {
+            channel_log_reader_close(r);
+            return CAN_LOG_ERR_FORMAT;
+        }
+    }
+
+    r->dir = log_alloc(CHANNEL_LOG_PAGE_BLOCKS * sizeof(channel_log_dir_entry_t));
+    r->block = log_alloc(CHANNEL_LOG_BLOCK_MAX);
+    if (r->dir == NULL || r->block == NULL) {
+        channel_log_reader_close(r);
+        return CAN_LOG_ERR_NO_MEM;
+    }
+    return CAN_LOG_OK;
+}
+
+void channel_log_reader_close(channel_log_reader_t *r)
+{
+    if (r == NULL) {
+        return;
+    }
+    if (r->file != NULL) {
+        fclose(r->file);
+        r->file = NULL;
+    }
+    free(r->dir);
+    free(r->block);
+    r->dir = NULL;
+    r->block = NULL;
+}
+
+int channel_log_reader_find(const channel_log_reader_t *r, const char *name)
+{
+    for (int i = 0; i < r->header.channel_count; i++) {
+        if (strncmp(r->channels[i].name, name, sizeof(r->channels[i].name)) == 0) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+int channel_log_reader_select(channel_log_reader_t *r, uint8_t channel, uint64_t from_us, uint64_t to_us)
+{
+    if (r->file == NULL || channel >= r->header.channel_count) {
+        return CAN_LOG_ERR_INVALID;
+    }
+    uint64_t from_tick = from_us / r->header.tick_us;
+    uint64_t to_tick = to_us > 0 ? to_us / r->header.tick_us : UINT32_MAX;
+
+    r->channel = channel;
+    r->from_tick = from_tick > UINT32_MAX ? UINT32_MAX : (uint32_t)from_tick;
+    r->to_tick = to_tick > UINT32_MAX ? UINT32_MAX : (uint32_t)to_tick;
+    r->scale = 1.0 / pow(10.0, r->channels[channel].precision);
+    r->page_seq = 1;
+    r->dir_count = 0;
+    r->dir_pos = 0;
+    r->samples_left = 0;
+    return CAN_LOG_OK;
+}
+
+// ============================================================================
+// DECODING
+// ============================================================================
+
+/**
+ * @brief Reads the header and directory of the next page that has blocks
+ *        of the selected channel in the selected time span.
+ * @return false at the end of the data
+ */
+static bool load_next_page(channel_log_reader_t *r)
+{
+    channel_log_page_header_t hdr;
+    while (1) {
+        uint32_t seq = r->page_seq;
+        long offset = (long)seq * CHANNEL_LOG_PAGE_SIZE;
+        if (fseek(r->file, offset, SEEK_SET) != 0 || fread(&hdr, sizeof(hdr), 1, r->file) != 1 ||
+            hdr.magic != CHANNEL_LOG_PAGE_MAGIC || hdr.sequence != seq ||
+            hdr.file_id != r->header.file_id) {
+            return false;
+        }
+        r->page_seq++;
+
+        if (!(hdr.channel_mask & (1u << r->channel)) || hdr.last_tick < r->from_tick) {
+            continue;
+        }
+        size_t dir_size = (size_t)hdr.block_count * sizeof(channel_log_dir_entry_t);
+        if (hdr.block_count > CHANNEL_LOG_PAGE_BLOCKS ||
+            fread(r->dir, 1, dir_size, r->file) != dir_size ||
+            log_crc32(0, (const uint8_t *)r->dir, dir_size) != hdr.crc32) {
+            r->crc_errors++;
+            continue;
+        }
+        r->dir_count = hdr.block_count;
+        r->dir_pos = 0;
+        r->pages_read++;
+        return true;
+    }
+}
+
+typedef enum {
+    ENTRY_LOADED,
+    ENTRY_SKIPPED,
+    ENTRY_PAST_END              // The channel's blocks from here on are after to_tick
+} entry_load_t;
+
+static entry_load_t load_entry(channel_log_reader_t *r, const channel_log_dir_entry_t *e)
+{
+    if (e->channel != r->channel || e->last_tick < r->from_tick) {
+        return ENTRY_SKIPPED;
+    }
+    if (e->first_tick > r->to_tick) {
+        return ENTRY_PAST_END;
+    }
+    long offset = (long)(r->page_seq - 1) * CHANNEL_LOG_PAGE_SIZE + e->offset;
+    if (e->sample_count == 0 || e->size > CHANNEL_LOG_BLOCK_MAX ||
+        (size_t)e->offset + e->size > CHANNEL_LOG_PAGE_SIZE ||
+        fseek(r->file, offset, SEEK_SET) != 0 ||
+        fread(r->block, 1, e->size, r->file) != e->size ||
+        log_crc32(0, r->block, e->size) != e->crc32) {
+        r->crc_errors++;
+        return ENTRY_SKIPPED;
+    }
+    r->block_size = e->size;
+    r->block_pos = 0;
+    r->samples_left = e->sample_count;
+    r->first_pending = true;
+    r->tick = e->first_tick;
+    r->value = e->first_value;
+    r->blocks_read++;
+    return ENTRY_LOADED;
+}
+
+static bool get_varint(channel_log_reader_t *r, uint32_t *out)
+{
+    uint32_t v = 0;
+    for (int shift = 0; shift < 35 && r->block_pos < r->block_size; shift += 7) {
+        uint8_t b = r->block[r->block_pos++];
+        v |= (uint32_t)(b & 0x7F) << shift;
+        if ((b & 0x80) == 0) {
+            *out = v;
+            return true;
+        }
+    }
+    return false;
+}
+
+int channel_log_reader_next(channel_log_reader_t *r, channel_log_sample_t *sample)
+{
+    if (r == NULL || r->file == NULL || r->dir == NULL || sample == NULL) {
+        return CAN_LOG_ERR_INVALID;
+    }
+
+    while (1) {
+        if (r->samples_left > 0) {
+            // The first sample of a block comes from its directory entry
+            if (r->first_pending) {
+                r->first_pending = false;
+            } else {
+                uint32_t dt, dv;
+                if (!get_varint(r, &dt) || !get_varint(r, &dv)) {
+                    r->crc_errors++;
+                    r->samples_left = 0;
+                    continue;
+                }
+                r->tick += dt;
+                r->value = (int32_t)((uint32_t)r->value + (uint32_t)channel_log_unzigzag(dv));
+            }
+            r->samples_left--;
+            if (r->tick < r->from_tick) {
+                continue;
+            }
+            if (r->tick > r->to_tick) {
+                return CAN_LOG_END;
+            }
+            sample->time_us = r->header.start_time_us + (uint64_t)r->tick * r->header.tick_us;
+            sample->value = r->value * r->scale;
+            return CAN_LOG_OK;
+        }
+
+        if (r->dir_pos < r->dir_count) {
+            entry_load_t ret = load_entry(r, &r->dir[r->dir_pos++]);
+            if (ret == ENTRY_PAST_END) {
+                return CAN_LOG_END;
+            }
+            continue;
+        }
+
+        if (!load_next_page(r)) {
+            return CAN_LOG_END;
+        }
+    }
+}
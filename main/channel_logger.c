@@ -0,0 +1,800 @@
+/*
+ * Channel Logger for ECU Dashboard
+ * A sampling timer delta-encodes channels into per-channel column blocks;
+ * the logger task writes the pages they are packed into
+ */
+
+#include "include/channel_logger.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_app_desc.h"
+#include "esp_heap_caps.h"
+#include "esp_log.h"
+#include "esp_random.h"
+#include "esp_rom_crc.h"
+#include "esp_timer.h"
+#include "sd_card_manager.h"
+#include <dirent.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <unistd.h>
+
+static const char *TAG = "CH_LOGGER";
+
+#define CH_LOGGER_TASK_STACK_SIZE   4096
+#define CH_LOGGER_TASK_PRIORITY     3       // Below the CAN trace logger (4)
+#define CH_LOGGER_TASK_CORE         1       // Away from WiFi, like the trace logger
+#define CH_LOGGER_STOP_TIMEOUT_MS   2000
+
+#if CHANNEL_MAX > CHANNEL_LOG_MAX_CHANNELS
+#error "channel_mask of the page header needs one bit per channel"
+#endif
+
+// Sampling periods of the built-in channels: driver inputs and boost are
+// fast, temperatures and status change slowly. 0 = use default_period_ms.
+static const uint16_t builtin_period_ms[CH_BUILTIN_COUNT] = {
+    [CH_ENGINE_RPM]        = 20,
+    [CH_TPS_POSITION]      = 20,
+    [CH_ABS_PEDAL_POS]     = 20,
+    [CH_MAP_KPA]           = 20,
+    [CH_WG_SET_PERCENT]    = 50,
+    [CH_WG_POS_PERCENT]    = 50,
+    [CH_BOV_PERCENT]       = 50,
+    [CH_TARGET_BOOST_KPA]  = 50,
+    [CH_TCU_TQ_REQ_NM]     = 50,
+    [CH_TCU_TQ_ACT_NM]     = 50,
+    [CH_ENG_TRG_NM]        = 50,
+    [CH_ENG_ACT_NM]        = 50,
+    [CH_LIMIT_TQ_NM]       = 100,
+    [CH_OIL_PRESSURE_BAR]  = 100,
+    [CH_OIL_TEMP_C]        = 1000,
+    [CH_WATER_TEMP_C]      = 1000,
+    [CH_FUEL_PRESSURE_BAR] = 100,
+    [CH_BATTERY_V]         = 500,
+    [CH_TCU_STATUS]        = 500,
+};
+
+// Column being filled for one channel, owned by the sampling timer
+typedef struct {
+    uint8_t *data;              // CHANNEL_LOG_BLOCK_MAX bytes in PSRAM, samples after the first
+    uint16_t size;
+    uint16_t count;             // Samples, the first one included (0 = empty)
+    uint32_t first_tick;
+    int32_t first_value;
+    uint32_t last_tick;
+    int32_t last_value;
+    int32_t min_value;
+    int32_t max_value;
+    uint32_t last_seq;          // Registry update counter at the last sample
+    uint32_t next_tick;         // Next tick the channel is due
+} column_t;
+
+// Page of closed blocks. The timer appends past block_count and data_end
+// and publishes both under page_lock; the logger task writes the part
+// below them, which never changes again.
+typedef struct {
+    uint8_t *data;              // CHANNEL_LOG_PAGE_SIZE bytes in PSRAM
+    uint16_t block_count;
+    uint16_t data_end;
+    uint32_t first_tick;
+    uint32_t last_tick;
+    uint32_t channel_mask;
+    bool full;                  // Waiting for the logger task; the timer must not touch it
+} log_page_t;
+
+static column_t columns[CHANNEL_MAX];
+static log_page_t pages[2];
+static uint8_t active_page = 0;
+
+// Periods in ms set with channel_logger_set_period(), and in ticks while running
+static uint32_t period_ms[CHANNEL_MAX];
+static bool period_set[CHANNEL_MAX];
+static volatile uint32_t period_ticks[CHANNEL_MAX];
+
+static portMUX_TYPE page_lock = portMUX_INITIALIZER_UNLOCKED;
+static portMUX_TYPE stats_lock = portMUX_INITIALIZER_UNLOCKED;
+static TaskHandle_t logger_task_handle = NULL;
+static esp_timer_handle_t sample_timer = NULL;
+static bool logger_running = false;
+static volatile bool stop_requested = false;
+static volatile bool flush_requested = false;
+static volatile bool final_flush_done = false;  // Set by the timer after the last close
+
+static channel_logger_config_t logger_config;
+static channel_logger_stats_t logger_stats;
+static int64_t session_start_us;                // Tick 0 of every file of the session
+static uint32_t tick_us;
+static uint32_t next_flush_tick;
+
+// Output file, owned by the logger task
+static FILE *log_file = NULL;
+static uint32_t file_number = 0;
+static uint32_t file_id = 0;
+static uint32_t page_seq = 1;                   // Sequence of the page being filled
+static uint16_t page_written_end = 0;           // Active page: data_end at its last rewrite
+static char current_path[32] = "";              // Copy for channel_logger_get_path(), under stats_lock
+
+// ============================================================================
+// ENCODING (sampling timer)
+// ============================================================================
+
+static uint32_t default_period_ms(channel_id_t id)
+{
+    if (id < CH_BUILTIN_COUNT && builtin_period_ms[id] != 0) {
+        return builtin_period_ms[id];
+    }
+    return logger_config.default_period_ms != 0 ? logger_config.default_period_ms : 100;
+}
+
+static int32_t scale_value(float value, uint8_t precision)
+{
+    static const float pow10[CHANNEL_LOG_MAX_PRECISION + 1] = { 1, 10, 100, 1e3f, 1e4f, 1e5f, 1e6f };
+    double scaled = (double)value * pow10[precision > CHANNEL_LOG_MAX_PRECISION ? CHANNEL_LOG_MAX_PRECISION : precision];
+    if (!(scaled > INT32_MIN)) {
+        return INT32_MIN;       // NaN included
+    }
+    if (scaled >= INT32_MAX) {
+        return INT32_MAX;
+    }
+    return (int32_t)lround(scaled);
+}
+
+static size_t put_varint(uint8_t *p, uint32_t v)
+{
+    size_t n = 0;
+    while (v >= 0x80) {
+        p[n++] = (uint8_t)(v | 0x80);
+        v >>= 7;
+    }
+    p[n++] = (uint8_t)v;
+    return n;
+}
+
+static void column_reset(column_t *col)
+{
+    col->size = 0;
+    col->count = 0;
+}
+
+/**
+ * @brief Marks the active page full, hands it to the logger task and
+ *        continues on the other page.
+ * @return The new active page, or NULL if the other one is still waiting
+ */
+static log_page_t *page_switch(void)
+{
+    log_page_t *next = &pages[active_page ^ 1];
+    if (next->full) {
+        return NULL;
+    }
+    portENTER_CRITICAL(&page_lock);
+    pages[active_page].full = true;
+    active_page ^= 1;
+    portEXIT_CRITICAL(&page_lock);
+    xTaskNotifyGive(logger_task_handle);
+    return next;
+}
+
+/**
+ * @brief Moves a column into the active page as one block.
+ */
+static void column_close(channel_id_t ch, column_t *col)
+{
+    if (col->count == 0) {
+        return;
+    }
+
+    log_page_t *page = &pages[active_page];
+    if (page->block_count >= CHANNEL_LOG_PAGE_BLOCKS ||
+        (size_t)page->data_end + col->size > CHANNEL_LOG_PAGE_SIZE) {
+        page = page_switch();
+    }
+    if (page == NULL) {
+        column_reset(col);
+        portENTER_CRITICAL(&stats_lock);
+        logger_stats.blocks_dropped++;
+        portEXIT_CRITICAL(&stats_lock);
+        return;
+    }
+
+    channel_log_dir_entry_t *entry = (channel_log_dir_entry_t *)
+        (page->data + sizeof(channel_log_page_header_t)) + page->block_count;
+    entry->channel = ch;
+    entry->reserved = 0;
+    entry->sample_count = col->count;
+    entry->offset = page->data_end;
+    entry->size = col->size;
+    entry->first_tick = col->first_tick;
+    entry->first_value = col->first_value;
+    entry->last_tick = col->last_tick;
+    entry->min_value = col->min_value;
+    entry->max_value = col->max_value;
+    entry->crc32 = esp_rom_crc32_le(0, col->data, col->size);
+    memcpy(page->data + page->data_end, col->data, col->size);
+
+    // Publish after the entry and the samples are in place
+    portENTER_CRITICAL(&page_lock);
+    if (page->block_count == 0 || col->first_tick < page->first_tick) {
+        page->first_tick = col->first_tick;
+    }
+    if (col->last_tick > page->last_tick) {
+        page->last_tick = col->last_tick;
+    }
+    page->channel_mask |= 1u << ch;
+    page->data_end += col->size;
+    page->block_count++;
+    portEXIT_CRITICAL(&page_lock);
+
+    column_reset(col);
+    portENTER_CRITICAL(&stats_lock);
+    logger_stats.blocks_closed++;
+    portEXIT_CRITICAL(&stats_lock);
+}
+
+static void column_add(channel_id_t ch, column_t *col, uint32_t tick, int32_t value)
+{
+    if (col->count == 0) {
+        col->first_tick = tick;
+        col->first_value = value;
+        col->min_value = value;
+        col->max_value = value;
+    } else {
+        // Deltas wrap in 32 bits; the reader adds them back the same way
+        int32_t delta = (int32_t)((uint32_t)value - (uint32_t)col->last_value);
+        col->size += put_varint(col->data + col->size, tick - col->last_tick);
+        col->size += put_varint(col->data + col->size, channel_log_zigzag(delta));
+        if (value < col->min_value) {
+            col->min_value = value;
+        }
+        if (value > col->max_value) {
+            col->max_value = value;
+        }
+    }
+    col->last_tick = tick;
+    col->last_value = value;
+    col->count++;
+
+    if (col->size > CHANNEL_LOG_BLOCK_MAX - CHANNEL_LOG_SAMPLE_MAX || col->count == UINT16_MAX) {
+        column_close(ch, col);
+    }
+}
+
+static void close_all_columns(void)
+{
+    for (channel_id_t ch = 0; ch < CHANNEL_MAX; ch++) {
+        column_close(ch, &columns[ch]);
+    }
+}
+
+static void sample_timer_cb(void *arg)
+{
+    int64_t start_us = esp_timer_get_time();
+    uint32_t tick = (uint32_t)((start_us - session_start_us) / tick_us);
+
+    if (stop_requested) {
+        // Last run: hand everything to the logger task and stop sampling
+        esp_timer_stop(sample_timer);
+        if (!final_flush_done) {
+            close_all_columns();
+            final_flush_done = true;
+            xTaskNotifyGive(logger_task_handle);
+        }
+        return;
+    }
+
+    channel_snapshot_t snap;
+    bool have_snap = false;
+    uint32_t logged = 0, stale = 0;
+    uint8_t count = channel_count();
+
+    for (channel_id_t ch = 0; ch < count; ch++) {
+        uint32_t period = period_ticks[ch];
+        column_t *col = &columns[ch];
+        if (period == 0 || tick < col->next_tick) {
+            continue;
+        }
+        col->next_tick = tick - tick % period + period;
+
+        if (!have_snap) {
+            channel_snapshot(&snap);
+            have_snap = true;
+        }
+        if (ch >= snap.count || snap.seq[ch] == 0 || snap.seq[ch] == col->last_seq) {
+            stale++;
+            continue;
+        }
+        col->last_seq = snap.seq[ch];
+        const channel_def_t *def = channel_get_def(ch);
+        column_add(ch, col, tick, scale_value(snap.values[ch], def ? def->precision : 0));
+        logged++;
+    }
+
+    if (tick >= next_flush_tick) {
+        next_flush_tick = tick + logger_config.flush_interval_ms * 1000 / tick_us;
+        close_all_columns();
+        flush_requested = true;
+        xTaskNotifyGive(logger_task_handle);
+    }
+
+    uint32_t elapsed_us = (uint32_t)(esp_timer_get_time() - start_us);
+    portENTER_CRITICAL(&stats_lock);
+    logger_stats.samples_logged += logged;
+    logger_stats.samples_stale += stale;
+    if (elapsed_us > logger_stats.max_sample_us) {
+        logger_stats.max_sample_us = elapsed_us;
+    }
+    portEXIT_CRITICAL(&stats_lock);
+}
+
+// ============================================================================
+// FILES (logger task)
+// ============================================================================
+
+static esp_err_t logger_write_at(long offset, const void *data, size_t len)
+{
+    int64_t start_us = esp_timer_get_time();
+    bool ok = fseek(log_file, offset, SEEK_SET) == 0 &&
+              fwrite(data, 1, len, log_file) == len;
+    uint32_t elapsed_us = (uint32_t)(esp_timer_get_time() - start_us);
+
+    sd_card_record_write_latency(elapsed_us);
+
+    portENTER_CRITICAL(&stats_lock);
+    if (ok) {
+        logger_stats.bytes_written += len;
+        if (elapsed_us > logger_stats.max_write_us) {
+            logger_stats.max_write_us = elapsed_us;
+        }
+    } else {
+        logger_stats.write_errors++;
+    }
+    portEXIT_CRITICAL(&stats_lock);
+
+    if (!ok) {
+        ESP_LOGW(TAG, "Write of %u bytes at %ld failed", (unsigned)len, offset);
+        return ESP_FAIL;
+    }
+    return ESP_OK;
+}
+
+static void file_path(uint32_t number, char *path, size_t len)
+{
+    snprintf(path, len, "%s/%s%05lu%s", CHANNEL_LOGGER_DIR, CHANNEL_LOGGER_PREFIX,
+             (unsigned long)number, CHANNEL_LOGGER_EXT);
+}
+
+/**
+ * @brief Finds the lowest and highest CHNnnnnn.COL numbers on the card.
+ * @return Number of channel log files
+ */
+static uint32_t logger_scan_files(uint32_t *lowest, uint32_t *highest)
+{
+    uint32_t count = 0;
+    *lowest = UINT32_MAX;
+    *highest = 0;
+
+    DIR *dir = opendir(CHANNEL_LOGGER_DIR);
+    if (dir == NULL) {
+        return 0;
+    }
+    struct dirent *entry;
+    size_t prefix_len = strlen(CHANNEL_LOGGER_PREFIX);
+    size_t ext_len = strlen(CHANNEL_LOGGER_EXT);
+    while ((entry = readdir(dir)) != NULL) {
+        const char *name = entry->d_name;
+        size_t len = strlen(name);
+        if (len <= prefix_len + ext_len ||
+            strncasecmp(name, CHANNEL_LOGGER_PREFIX, prefix_len) != 0 ||
+            strcasecmp(name + len - ext_len, CHANNEL_LOGGER_EXT) != 0) {
+            continue;
+        }
+        uint32_t number = strtoul(name + prefix_len, NULL, 10);
+        if (number < *lowest) {
+            *lowest = number;
+        }
+        if (number > *highest) {
+            *highest = number;
+        }
+        count++;
+    }
+    closedir(dir);
+    return count;
+}
+
+/**
+ * @brief Deletes the oldest files so that one more fits the retention limit.
+ */
+static void logger_apply_retention(void)
+{
+    uint32_t lowest, highest;
+    while (logger_scan_files(&lowest, &highest) >= logger_config.retention_files) {
+        char path[32];
+        file_path(lowest, path, sizeof(path));
+        if (unlink(path) != 0) {
+            ESP_LOGW(TAG, "Failed to delete old file %s", path);
+            break;
+        }
+        ESP_LOGI(TAG, "Retention: deleted %s", path);
+        portENTER_CRITICAL(&stats_lock);
+        logger_stats.files_deleted++;
+        portEXIT_CRITICAL(&stats_lock);
+    }
+}
+
+/**
+ * @brief Closes the current file (if any) and opens the next one with its
+ *        header and channel table in page 0.
+ */
+static esp_err_t logger_open_file(void)
+{
+    if (log_file != NULL) {
+        fclose(log_file);
+        log_file = NULL;
+    }
+    logger_apply_retention();
+
+    uint32_t lowest, highest;
+    logger_scan_files(&lowest, &highest);
+    file_number = highest + 1;
+
+    char path[32];
+    file_path(file_number, path, sizeof(path));
+    log_file = fopen(path, "w+b");
+    if (log_file == NULL) {
+        ESP_LOGE(TAG, "Failed to create %s", path);
+        portENTER_CRITICAL(&stats_lock);
+        current_path[0] = '\0';
+        portEXIT_CRITICAL(&stats_lock);
+        return ESP_FAIL;
+    }
+
+    // Page 0: header and channel table; the rest of the page stays unused
+    uint8_t count = channel_count();
+    size_t table_size = count * sizeof(channel_log_channel_t);
+    uint8_t *page0 = calloc(1, sizeof(channel_log_file_header_t) + table_size);
+    if (page0 == NULL) {
+        // No header could be written: drop the file instead of logging into it
+        ESP_LOGE(TAG, "No memory for the header of %s", path);
+        fclose(log_file);
+        log_file = NULL;
+        unlink(path);
+        portENTER_CRITICAL(&stats_lock);
+        current_path[0] = '\0';
+        portEXIT_CRITICAL(&stats_lock);
+        return ESP_ERR_NO_MEM;
+    }
+    channel_log_file_header_t *hdr = (channel_log_file_header_t *)page0;
+    channel_log_channel_t *table = (channel_log_channel_t *)(page0 + sizeof(*hdr));
+    const esp_app_desc_t *app = esp_app_get_description();
+
+    file_id = esp_random();
+    hdr->magic = CHANNEL_LOG_FILE_MAGIC;
+    hdr->version = CHANNEL_LOG_FORMAT_VERSION;
+    hdr->header_size = sizeof(*hdr);
+    hdr->page_size = CHANNEL_LOG_PAGE_SIZE;
+    hdr->tick_us = tick_us;
+    hdr->start_time_us = (uint64_t)session_start_us;
+    strncpy(hdr->firmware_version, app->version, sizeof(hdr->firmware_version) - 1);
+    hdr->file_id = file_id;
+    hdr->channel_count = count;
+    hdr->channel_size = sizeof(channel_log_channel_t);
+    for (channel_id_t ch = 0; ch < count; ch++) {
+        const channel_def_t *def = channel_get_def(ch);
+        strncpy(table[ch].name, def->name, sizeof(table[ch].name) - 1);
+        strncpy(table[ch].unit, def->unit, sizeof(table[ch].unit) - 1);
+        table[ch].precision = def->precision > CHANNEL_LOG_MAX_PRECISION ? CHANNEL_LOG_MAX_PRECISION : def->precision;
+        table[ch].period_ticks = period_ticks[ch];
+    }
+    uint32_t crc = esp_rom_crc32_le(0, page0, offsetof(channel_log_file_header_t, crc32));
+    hdr->crc32 = esp_rom_crc32_le(crc, (const uint8_t *)table, table_size);
+
+    esp_err_t ret = logger_write_at(0, page0, sizeof(*hdr) + table_size);
+    free(page0);
+
+    page_seq = 1;
+    page_written_end = 0;
+
+    portENTER_CRITICAL(&stats_lock);
+    snprintf(current_path, sizeof(current_path), "%s", path);
+    logger_stats.files_created++;
+    portEXIT_CRITICAL(&stats_lock);
+
+    ESP_LOGI(TAG, "Channel log %s opened (%u channels)", path, count);
+    return ret;
+}
+
+/**
+ * @brief Writes the header, directory and blocks of a page up to the
+ *        given counts, at the page's place in the file.
+ */
+static esp_err_t logger_write_page(const log_page_t *page, uint16_t block_count, uint16_t data_end,
+                                   uint32_t first_tick, uint32_t last_tick, uint32_t channel_mask)
+{
+    channel_log_page_header_t hdr = {
+        .magic = CHANNEL_LOG_PAGE_MAGIC,
+        .sequence = page_seq,
+        .file_id = file_id,
+        .first_tick = first_tick,
+        .last_tick = last_tick,
+        .channel_mask = channel_mask,
+        .block_count = block_count,
+        .data_end = data_end,
+    };
+    const uint8_t *dir = page->data + sizeof(hdr);
+    hdr.crc32 = esp_rom_crc32_le(0, dir, block_count * sizeof(channel_log_dir_entry_t));
+
+    long offset = (long)page_seq * CHANNEL_LOG_PAGE_SIZE;
+    esp_err_t ret = logger_write_at(offset, &hdr, sizeof(hdr));
+    if (ret == ESP_OK) {
+        ret = logger_write_at(offset + (long)sizeof(hdr), dir, data_end - sizeof(hdr));
+    }
+    return ret;
+}
+
+static void page_reset(log_page_t *page)
+{
+    page->block_count = 0;
+    page->data_end = CHANNEL_LOG_DATA_OFFSET;
+    page->first_tick = 0;
+    page->last_tick = 0;
+    page->channel_mask = 0;
+}
+
+// ============================================================================
+// LOGGER TASK
+// ============================================================================
+
+static void channel_logger_task(void *pvParameters)
+{
+    ESP_LOGI(TAG, "Channel logger task started on core %d", xPortGetCoreID());
+
+    while (1) {
+        ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(logger_config.flush_interval_ms));
+        bool stopping = stop_requested && final_flush_done;
+
+        // At most one page is full at a time, and it is older than the active one
+        for (int i = 0; i < 2; i++) {
+            log_page_t *page = &pages[i];
+            if (!page->full) {
+                continue;
+            }
+            if (log_file != NULL &&
+                logger_write_page(page, page->block_count, page->data_end,
+                                  page->first_tick, page->last_tick, page->channel_mask) == ESP_OK) {
+                portENTER_CRITICAL(&stats_lock);
+                logger_stats.pages_written++;
+                portEXIT_CRITICAL(&stats_lock);
+            }
+            page_seq++;
+            page_written_end = 0;
+            if (log_file != NULL &&
+                (long)(page_seq + 1) * CHANNEL_LOG_PAGE_SIZE > (long)logger_config.file_size_mb * 1024 * 1024) {
+                logger_open_file();
+            }
+
+            portENTER_CRITICAL(&page_lock);
+            page_reset(page);
+            page->full = false;
+            portEXIT_CRITICAL(&page_lock);
+        }
+
+        // Rewrite the page being filled so closed blocks reach the card
+        if (flush_requested || stopping) {
+            flush_requested = false;
+            portENTER_CRITICAL(&page_lock);
+            log_page_t *page = &pages[active_page];
+            // A page filled since the loop above owns page_seq and goes out first
+            bool behind = pages[active_page ^ 1].full;
+            uint16_t block_count = page->block_count;
+            uint16_t data_end = page->data_end;
+            uint32_t first_tick = page->first_tick;
+            uint32_t last_tick = page->last_tick;
+            uint32_t channel_mask = page->channel_mask;
+            portEXIT_CRITICAL(&page_lock);
+
+            if (behind) {
+                flush_requested = true;     // Retried on the notification of the switch
+                continue;
+            }
+            if (block_count > 0 && data_end != page_written_end && log_file != NULL &&
+                logger_write_page(page, block_count, data_end, first_tick, last_tick, channel_mask) == ESP_OK) {
+                page_written_end = data_end;
+            }
+            if (log_file != NULL) {
+                fflush(log_file);
+                fsync(fileno(log_file));
+            }
+        }
+
+        if (stopping) {
+            break;
+        }
+    }
+
+    if (log_file != NULL) {
+        fclose(log_file);
+        log_file = NULL;
+    }
+    portENTER_CRITICAL(&stats_lock);
+    current_path[0] = '\0';
+    portEXIT_CRITICAL(&stats_lock);
+
+    ESP_LOGI(TAG, "Channel logger stopped (%lu samples, %lu blocks dropped)",
+             (unsigned long)logger_stats.samples_logged, (unsigned long)logger_stats.blocks_dropped);
+
+    logger_task_handle = NULL;
+    vTaskDelete(NULL);
+}
+
+// ============================================================================
+// CONTROL
+// ============================================================================
+
+esp_err_t channel_logger_set_period(channel_id_t id, uint32_t period)
+{
+    if (id >= CHANNEL_MAX || channel_get_def(id) == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    period_ms[id] = period;
+    period_set[id] = true;
+    if (tick_us > 0) {
+        uint32_t tick_ms = tick_us / 1000;
+        period_ticks[id] = period == 0 ? 0 : (period + tick_ms - 1) / tick_ms;
+    }
+    return ESP_OK;
+}
+
+uint32_t channel_logger_get_period(channel_id_t id)
+{
+    if (id >= CHANNEL_MAX || channel_get_def(id) == NULL) {
+        return 0;
+    }
+    return period_set[id] ? period_ms[id] : default_period_ms(id);
+}
+
+esp_err_t channel_logger_start(const channel_logger_config_t *config)
+{
+    if (logger_task_handle != NULL) {
+        ESP_LOGW(TAG, "Channel logger already running");
+        return ESP_OK;
+    }
+
+    channel_logger_config_t defaults = CHANNEL_LOGGER_CONFIG_DEFAULT();
+    logger_config = config ? *config : defaults;
+    if (logger_config.tick_ms == 0) {
+        logger_config.tick_ms = defaults.tick_ms;
+    }
+    if (logger_config.flush_interval_ms < logger_config.tick_ms) {
+        logger_config.flush_interval_ms = defaults.flush_interval_ms;
+    }
+    if (logger_config.file_size_mb == 0) {
+        logger_config.file_size_mb = defaults.file_size_mb;
+    }
+    if (logger_config.retention_files < 2) {
+        logger_config.retention_files = 2;
+    }
+    tick_us = logger_config.tick_ms * 1000;
+
+    for (int i = 0; i < 2; i++) {
+        if (pages[i].data == NULL) {
+            pages[i].data = heap_caps_malloc(CHANNEL_LOG_PAGE_SIZE, MALLOC_CAP_SPIRAM);
+        }
+        if (pages[i].data == NULL) {
+            ESP_LOGE(TAG, "Failed to allocate pages in PSRAM");
+            return ESP_ERR_NO_MEM;
+        }
+        page_reset(&pages[i]);
+        pages[i].full = false;
+    }
+    active_page = 0;
+
+    for (channel_id_t ch = 0; ch < CHANNEL_MAX; ch++) {
+        column_t *col = &columns[ch];
+        if (col->data == NULL) {
+            col->data = heap_caps_malloc(CHANNEL_LOG_BLOCK_MAX, MALLOC_CAP_SPIRAM);
+            if (col->data == NULL) {
+                ESP_LOGE(TAG, "Failed to allocate column buffers in PSRAM");
+                return ESP_ERR_NO_MEM;
+            }
+        }
+        column_reset(col);
+        col->last_seq = 0;
+        col->next_tick = 0;
+        // Channels defined later are logged at the default period from the next start
+        uint32_t period = channel_logger_get_period(ch);
+        period_ticks[ch] = period == 0 ? 0 : (period + logger_config.tick_ms - 1) / logger_config.tick_ms;
+    }
+
+    memset(&logger_stats, 0, sizeof(logger_stats));
+    session_start_us = esp_timer_get_time();
+    next_flush_tick = logger_config.flush_interval_ms / logger_config.tick_ms;
+    stop_requested = false;
+    flush_requested = false;
+    final_flush_done = false;
+
+    if (logger_open_file() != ESP_OK) {
+        return ESP_FAIL;
+    }
+
+    BaseType_t ok = xTaskCreatePinnedToCore(channel_logger_task, "ch_logger", CH_LOGGER_TASK_STACK_SIZE,
+                                            NULL, CH_LOGGER_TASK_PRIORITY, &logger_task_handle,
+                                            CH_LOGGER_TASK_CORE);
+    if (ok != pdPASS) {
+        ESP_LOGE(TAG, "Failed to create channel logger task");
+        fclose(log_file);
+        log_file = NULL;
+        logger_task_handle = NULL;
+        return ESP_FAIL;
+    }
+
+    if (sample_timer == NULL) {
+        const esp_timer_create_args_t timer_args = {
+            .callback = sample_timer_cb,
+            .name = "ch_logger"
+        };
+        if (esp_timer_create(&timer_args, &sample_timer) != ESP_OK) {
+            sample_timer = NULL;
+        }
+    }
+    if (sample_timer == NULL || esp_timer_start_periodic(sample_timer, tick_us) != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to start the sampling timer");
+        final_flush_done = true;
+        stop_requested = true;
+        xTaskNotifyGive(logger_task_handle);
+        return ESP_FAIL;
+    }
+
+    logger_running = true;
+    ESP_LOGI(TAG, "Channel logger started: tick %lu ms, flush %lu ms, %lu MB files, keep %lu",
+             (unsigned long)logger_config.tick_ms, (unsigned long)logger_config.flush_interval_ms,
+             (unsigned long)logger_config.file_size_mb, (unsigned long)logger_config.retention_files);
+    return ESP_OK;
+}
+
+esp_err_t channel_logger_stop(void)
+{
+    if (logger_task_handle == NULL) {
+        return ESP_OK;
+    }
+    logger_running = false;
+
+    // The next timer run closes the open blocks and stops the timer
+    stop_requested = true;
+
+    for (int waited = 0; logger_task_handle != NULL; waited += 10) {
+        if (waited >= CH_LOGGER_STOP_TIMEOUT_MS) {
+            ESP_LOGE(TAG, "Channel logger task did not stop in time");
+            return ESP_ERR_TIMEOUT;
+        }
+        vTaskDelay(pdMS_TO_TICKS(10));
+    }
+    return ESP_OK;
+}
+
+bool channel_logger_is_running(void)
+{
+    return logger_running;
+}
+
+void channel_logger_get_path(char *path, size_t len)
+{
+    if (path == NULL || len == 0) {
+        return;
+    }
+    portENTER_CRITICAL(&stats_lock);
+    snprintf(path, len, "%s", current_path);
+    portEXIT_CRITICAL(&stats_lock);
+}
+
+void channel_logger_get_stats(channel_logger_stats_t *stats)
+{
+    if (stats == NULL) {
+        return;
+    }
+    portENTER_CRITICAL(&stats_lock);
+    *stats = logger_stats;
+    portEXIT_CRITICAL(&stats_lock);
+}
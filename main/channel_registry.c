@@ -0,0 +1,214 @@
+/*
+ * Channel Registry for ECU Dashboard
+ * Dense array of numbered channels shared by decoders, UI, logger and web API
+ */
+
+#include "include/channel_registry.h"
+#include "freertos/FreeRTOS.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include <string.h>
+
+static const char *TAG = "CHANNELS";
+
+// Compile-time channel table. Order must match channel_builtin_t.
+static const channel_def_t builtin_channels[CH_BUILTIN_COUNT] = {
+    [CH_ENGINE_RPM]        = { "engine_rpm",      "RPM", 0.0f,   8000.0f, 0, CH_STORAGE_U16 },
+    [CH_TPS_POSITION]      = { "tps_position",    "%",   0.0f,   100.0f,  1, CH_STORAGE_U16 },
+    [CH_ABS_PEDAL_POS]     = { "abs_pedal_pos",   "%",   0.0f,   100.0f,  1, CH_STORAGE_U16 },
+    [CH_MAP_KPA]           = { "map_kpa",         "kPa", 100.0f, 250.0f,  0, CH_STORAGE_U16 },
+    [CH_WG_SET_PERCENT]    = { "wg_set_percent",  "%",   0.0f,   100.0f,  1, CH_STORAGE_U16 },
+    [CH_WG_POS_PERCENT]    = { "wg_pos_percent",  "%",   0.0f,   100.0f,  1, CH_STORAGE_U16 },
+    [CH_BOV_PERCENT]       = { "bov_percent",     "%",   0.0f,   50.0f,   1, CH_STORAGE_U16 },
+    [CH_TARGET_BOOST_KPA]  = { "target_boost",    "kPa", 100.0f, 250.0f,  0, CH_STORAGE_U16 },
+    [CH_TCU_TQ_REQ_NM]     = { "tcu_tq_req_nm",   "Nm",  0.0f,   500.0f,  0, CH_STORAGE_I16 },
+    [CH_TCU_TQ_ACT_NM]     = { "tcu_tq_act_nm",   "Nm",  0.0f,   500.0f,  0, CH_STORAGE_I16 },
+    [CH_ENG_TRG_NM]        = { "eng_trg_nm",      "Nm",  0.0f,   500.0f,  0, CH_STORAGE_I16 },
+    [CH_ENG_ACT_NM]        = { "eng_act_nm",      "Nm",  0.0f,   500.0f,  0, CH_STORAGE_I16 },
+    [CH_LIMIT_TQ_NM]       = { "limit_tq_nm",     "Nm",  0.0f,   500.0f,  0, CH_STORAGE_I16 },
+    [CH_OIL_PRESSURE_BAR]  = { "oil_pressure",    "bar", 0.0f,   10.0f,   1, CH_STORAGE_U8  },
+    [CH_OIL_TEMP_C]        = { "oil_temp",        "C",   60.0f,  140.0f,  0, CH_STORAGE_I16 },
+    [CH_WATER_TEMP_C]      = { "water_temp",      "C",   60.0f,  120.0f,  0, CH_STORAGE_I16 },
+    [CH_FUEL_PRESSURE_BAR] = { "fuel_pressure",   "bar", 0.0f,   8.0f,    1, CH_STORAGE_U8  },
+    [CH_BATTERY_V]         = { "battery_voltage", "V",   11.0f,  15.0f,   1, CH_STORAGE_U8  },
+    [CH_TCU_STATUS]        = { "tcu_status",      "",    0.0f,   2.0f,    0, CH_STORAGE_U8  },
+};
+
+// Registry storage: all arrays are indexed by channel_id_t
+static channel_def_t channel_defs[CHANNEL_MAX];
+static float channel_values[CHANNEL_MAX];
+static uint32_t channel_seq[CHANNEL_MAX];
+static int64_t channel_stamp_us[CHANNEL_MAX];
+static uint8_t channel_used = 0;
+static bool channel_initialized = false;
+
+// Change listeners (alarm engine, loggers)
+static channel_listener_t channel_listeners[CHANNEL_MAX_LISTENERS];
+static uint8_t channel_listener_count = 0;
+
+// Short critical sections only - the CAN task writes, UI/web tasks read
+static portMUX_TYPE channel_lock = portMUX_INITIALIZER_UNLOCKED;
+
+void channel_registry_init(void)
+{
+    if (channel_initialized) {
+        return;
+    }
+
+    memcpy(channel_defs, builtin_channels, sizeof(builtin_channels));
+    memset(channel_values, 0, sizeof(channel_values));
+    memset(channel_seq, 0, sizeof(channel_seq));
+    memset(channel_stamp_us, 0, sizeof(channel_stamp_us));
+    channel_used = CH_BUILTIN_COUNT;
+    channel_initialized = true;
+
+    ESP_LOGI(TAG, "Channel registry initialized with %d built-in channels", channel_used);
+}
+
+esp_err_t channel_registry_define(const channel_def_t *def, channel_id_t *out_id)
+{
+    if (!def || def->name[0] == '\0') {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    // The duplicate check and the insert happen under one lock, so two
+    // tasks defining the same name cannot both get a new entry
+    portENTER_CRITICAL(&channel_lock);
+    for (uint8_t i = 0; i < channel_used; i++) {
+        if (strncmp(channel_defs[i].name, def->name, CHANNEL_NAME_MAX_LEN - 1) == 0) {
+            portEXIT_CRITICAL(&channel_lock);
+            ESP_LOGW(TAG, "Channel '%s' already defined", channel_defs[i].name);
+            return ESP_ERR_INVALID_STATE;
+        }
+    }
+    if (channel_used >= CHANNEL_MAX) {
+        portEXIT_CRITICAL(&channel_lock);
+        ESP_LOGE(TAG, "Channel registry full, cannot add '%s'", def->name);
+        return ESP_ERR_NO_MEM;
+    }
+    channel_id_t id = channel_used;
+    channel_defs[id] = *def;
+    channel_defs[id].name[CHANNEL_NAME_MAX_LEN - 1] = '\0';
+    channel_defs[id].unit[CHANNEL_UNIT_MAX_LEN - 1] = '\0';
+    channel_values[id] = 0.0f;
+    channel_seq[id] = 0;
+    channel_stamp_us[id] = 0;
+    // Publish the index last so readers never see a half-written definition
+    channel_used = id + 1;
+    portEXIT_CRITICAL(&channel_lock);
+
+    if (out_id) {
+        *out_id = id;
+    }
+    ESP_LOGI(TAG, "Runtime channel %d defined: %s [%s]", id, def->name, def->unit);
+    return ESP_OK;
+}
+
+uint8_t channel_count(void)
+{
+    return channel_used;
+}
+
+const channel_def_t *channel_get_def(channel_id_t id)
+{
+    if (id >= channel_used) {
+        return NULL;
+    }
+    return &channel_defs[id];
+}
+
+channel_id_t channel_find(const char *name)
+{
+    if (!name) {
+        return CHANNEL_INVALID;
+    }
+    for (uint8_t i = 0; i < channel_used; i++) {
+        if (strcmp(channel_defs[i].name, name) == 0) {
+            return i;
+        }
+    }
+    return CHANNEL_INVALID;
+}
+
+void channel_set(channel_id_t id, float value)
+{
+    if (id >= channel_used) {
+        return;
+    }
+    int64_t now = esp_timer_get_time();
+
+    portENTER_CRITICAL(&channel_lock);
+    bool changed = (channel_seq[id] == 0) || (channel_values[id] != value);
+    channel_values[id] = value;
+    channel_stamp_us[id] = now;
+    channel_seq[id]++;
+    portEXIT_CRITICAL(&channel_lock);
+
+    if (!changed) {
+        return;
+    }
+    for (uint8_t i = 0; i < channel_listener_count; i++) {
+        channel_listeners[i](id, value);
+    }
+}
+
+esp_err_t channel_registry_add_listener(channel_listener_t listener)
+{
+    if (!listener) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    portENTER_CRITICAL(&channel_lock);
+    if (channel_listener_count >= CHANNEL_MAX_LISTENERS) {
+        portEXIT_CRITICAL(&channel_lock);
+        return ESP_ERR_NO_MEM;
+    }
+    channel_listeners[channel_listener_count] = listener;
+    channel_listener_count++;
+    portEXIT_CRITICAL(&channel_lock);
+    return ESP_OK;
+}
+
+float channel_get(channel_id_t id)
+{
+    if (id >= channel_used) {
+        return 0.0f;
+    }
+    // Aligned 32-bit loads are atomic on the ESP32-S3
+    return channel_values[id];
+}
+
+uint32_t channel_get_seq(channel_id_t id)
+{
+    if (id >= channel_used) {
+        return 0;
+    }
+    return channel_seq[id];
+}
+
+int64_t channel_get_timestamp(channel_id_t id)
+{
+    if (id >= channel_used) {
+        return 0;
+    }
+    portENTER_CRITICAL(&channel_lock);
+    int64_t stamp = channel_stamp_us[id];
+    portEXIT_CRITICAL(&channel_lock);
+    return stamp;
+}
+
+void channel_snapshot(channel_snapshot_t *snap)
+{
+    if (!snap) {
+        return;
+    }
+
+    portENTER_CRITICAL(&channel_lock);
+    uint8_t count = channel_used;
+    memcpy(snap->values, channel_values, count * sizeof(float));
+    memcpy(snap->seq, channel_seq, count * sizeof(uint32_t));
+    portEXIT_CRITICAL(&channel_lock);
+
+    snap->count = count;
+    snap->timestamp_us = esp_timer_get_time();
+}
@@ -4,6 +4,8 @@
  */
 
 #include "include/ecu_data.h"
+#include "include/alarm_engine.h"
+#include "ui/settings_config.h"
 #include "esp_log.h"
 #include "esp_timer.h"
 #include <stdio.h>
@@ -14,10 +16,6 @@
 
 static const char *TAG = "ECU_DATA";
 
-// Global ECU data
-static ecu_data_t g_ecu_data = {0};
-static SemaphoreHandle_t ecu_data_mutex = NULL;
-
 // System settings
 static system_settings_t g_system_settings = {
     .max_boost_limit = 250.0f,
@@ -35,13 +33,8 @@ static bool data_stream_initialized = false;
 // Initialize ECU data system
 void ecu_data_init(void)
 {
-    if (ecu_data_mutex == NULL) {
-        ecu_data_mutex = xSemaphoreCreateMutex();
-    }
-
-    // Initialize ECU data with default values
-    memset(&g_ecu_data, 0, sizeof(ecu_data_t));
-    g_ecu_data.timestamp = esp_timer_get_time() / 1000; // milliseconds
+    // All live values are held by the channel registry
+    channel_registry_init();
 
     // Initialize data stream
     memset(data_stream, 0, sizeof(data_stream));
@@ -50,66 +43,72 @@ void ecu_data_init(void)
     ESP_LOGI(TAG, "ECU data system initialized");
 }
 
-// Update ECU data (thread-safe)
-void ecu_data_update(ecu_data_t *data)
+// Write all registered channels as a JSON object: {"timestamp":...,"engine_rpm":850,...}
+void ecu_data_write_json(json_writer_t *w)
 {
-    if (!data || !ecu_data_mutex) return;
-
-    if (xSemaphoreTake(ecu_data_mutex, pdMS_TO_TICKS(100)) == pdTRUE) {
-        memcpy(&g_ecu_data, data, sizeof(ecu_data_t));
-        g_ecu_data.timestamp = esp_timer_get_time() / 1000; // milliseconds
-
-        xSemaphoreGive(ecu_data_mutex);
+    channel_snapshot_t snap;
+    channel_snapshot(&snap);
+
+    json_obj_begin(w);
+    json_kv_int(w, "timestamp", snap.timestamp_us / 1000);
+    for (uint8_t i = 0; i < snap.count; i++) {
+        const channel_def_t *def = channel_get_def(i);
+        json_kv_float(w, def->name, snap.values[i], def->precision);
     }
+    json_obj_end(w);
 }
 
-// Get current ECU data (thread-safe)
-ecu_data_t* ecu_data_get(void)
-{
-    return &g_ecu_data; // For now, return direct pointer (should be protected by mutex in caller)
-}
+// Demo cycle for the web transports. The LCD demo runs from LVGL animations
+// and does not write channels, so the web side generates its own values.
+// One cycle has 100 steps; 100 ms per step is a 10 s sweep. The position
+// comes from the clock, so every client sees the same values at the same
+// speed however many of them read it.
+#define ECU_DEMO_STEP_MS        100
 
-// Get a thread-safe copy of the current ECU data
-void ecu_data_get_copy(ecu_data_t *data_copy)
+void ecu_data_live_snapshot(channel_snapshot_t *snap)
 {
-    if (!data_copy || !ecu_data_mutex) return;
-
-    if (xSemaphoreTake(ecu_data_mutex, pdMS_TO_TICKS(100)) == pdTRUE) {
-        memcpy(data_copy, &g_ecu_data, sizeof(ecu_data_t));
-        xSemaphoreGive(ecu_data_mutex);
+    channel_snapshot(snap);
+    if (!demo_mode_get_enabled()) {
+        return;
     }
-}
 
-// Convert ECU data to JSON string
-char* ecu_data_to_json(const ecu_data_t *data)
-{
-    // TODO: Update this function to serialize the new ecu_data_t struct if needed for the web server.
-    static char json_buffer[20] = "{}";
-    return json_buffer;
+    int cycle = (int)((esp_timer_get_time() / (ECU_DEMO_STEP_MS * 1000)) % 100);
+    float phase = cycle / 100.0f;
+    const struct { channel_id_t id; float value; } demo[] = {
+        { CH_MAP_KPA,          120.0f + 30.0f * (cycle > 50 ? (100 - cycle) : cycle) / 50.0f },
+        { CH_WG_POS_PERCENT,   45.0f + 25.0f * phase },
+        { CH_TPS_POSITION,     35.0f + 30.0f * phase },
+        { CH_ENGINE_RPM,       2500.0f + 500.0f * phase },
+        { CH_TARGET_BOOST_KPA, 180.0f + 20.0f * phase },
+    };
+    for (size_t i = 0; i < sizeof(demo) / sizeof(demo[0]); i++) {
+        snap->values[demo[i].id] = demo[i].value;
+        snap->seq[demo[i].id] |= 1;     // Counts as written for the telemetry encoder
+    }
 }
 
-// Parse ECU data from JSON string
-bool ecu_data_from_json(const char *json_str, ecu_data_t *data)
+void ecu_data_write_gauges_json(json_writer_t *w, const channel_snapshot_t *snap)
 {
-    // TODO: Update this function if needed.
-    return false;
+    json_obj_begin(w);
+    json_kv_float(w, "map_pressure", snap->values[CH_MAP_KPA], 1);
+    json_kv_float(w, "wastegate_pos", snap->values[CH_WG_POS_PERCENT], 1);
+    json_kv_float(w, "tps_position", snap->values[CH_TPS_POSITION], 1);
+    json_kv_float(w, "engine_rpm", snap->values[CH_ENGINE_RPM], 0);
+    json_kv_float(w, "target_boost", snap->values[CH_TARGET_BOOST_KPA], 1);
+    json_kv_int(w, "tcu_status", alarm_engine_get_level(ALARM_TCU_RPM));
+    json_obj_end(w);
 }
 
-// Simulate ECU data for testing
-void ecu_data_simulate(ecu_data_t *data)
+// Simulate ECU data for testing by writing directly into the channels
+void ecu_data_simulate(void)
 {
-    // TODO: Update this function to simulate the new data fields if needed for testing.
-    if (!data) return;
-
     static float sim_time = 0;
     sim_time += 0.1f;
 
     // Simulate realistic ECU data
-    data->engine_rpm = 800 + 200 * sin(sim_time * 0.5f) + 100 * sin(sim_time * 2.0f);
-    data->map_kpa = 100 + 50 * sin(sim_time * 0.8f) + 20 * sin(sim_time * 1.5f);
-    data->tps_position = 20 + 30 * sin(sim_time * 0.3f) + 10 * sin(sim_time * 1.2f);
-
-    data->timestamp = esp_timer_get_time() / 1000;
+    channel_set(CH_ENGINE_RPM, 800 + 200 * sin(sim_time * 0.5f) + 100 * sin(sim_time * 2.0f));
+    channel_set(CH_MAP_KPA, 100 + 50 * sin(sim_time * 0.8f) + 20 * sin(sim_time * 1.5f));
+    channel_set(CH_TPS_POSITION, 20 + 30 * sin(sim_time * 0.3f) + 10 * sin(sim_time * 1.2f));
 }
 
 // ============================================================================
@@ -160,22 +159,15 @@ void data_stream_clear(void)
     data_stream_index = 0;
 }
 
-char* data_stream_to_json(void)
+void data_stream_write_json(json_writer_t *w)
 {
-    static char json_buffer[4096];
-    char *ptr = json_buffer;
-
-    ptr += sprintf(ptr, "[");
+    json_arr_begin(w);
 
     for (int i = 0; i < DATA_STREAM_SIZE; i++) {
         int index = (data_stream_index - 1 - i + DATA_STREAM_SIZE) % DATA_STREAM_SIZE;
 
         if (data_stream[index].timestamp == 0) continue; // Skip empty entries
 
-        if (ptr > json_buffer + 1) {
-            ptr += sprintf(ptr, ",");
-        }
-
         const char *type_str;
         switch (data_stream[index].type) {
             case LOG_INFO: type_str = "info"; break;
@@ -185,24 +177,34 @@ char* data_stream_to_json(void)
             default: type_str = "info"; break;
         }
 
-        ptr += sprintf(ptr, "{\"timestamp\":%llu,\"message\":\"%s\",\"type\":\"%s\"}",
-                       data_stream[index].timestamp,
-                       data_stream[index].message,
-                       type_str);
+        json_obj_begin(w);
+        json_kv_uint(w, "timestamp", data_stream[index].timestamp);
+        json_key(w, "message");
+        json_strn(w, data_stream[index].message, sizeof(data_stream[index].message));
+        json_kv_str(w, "type", type_str);
+        json_obj_end(w);
     }
 
-    ptr += sprintf(ptr, "]");
-    return json_buffer;
+    json_arr_end(w);
 }
 
 // ============================================================================
 // SIMPLE DATA FUNCTIONS FOR WIFI SERVER
 // ============================================================================
 
-char* ecu_data_to_string(const ecu_data_t *data)
+char* ecu_data_to_string(void)
 {
-    // TODO: Update this function if needed for the web server.
-    static char buffer[32] = "No data";
+    static char buffer[512];
+    char *ptr = buffer;
+    char *end = buffer + sizeof(buffer);
+
+    buffer[0] = '\0';
+    for (uint8_t i = 0; i < channel_count() && ptr < end - 48; i++) {
+        const channel_def_t *def = channel_get_def(i);
+        ptr += snprintf(ptr, end - ptr, "%s=%.*f%s\n",
+                        def->name, def->precision, channel_get(i), def->unit);
+    }
+
     return buffer;
 }
 
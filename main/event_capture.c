@@ -0,0 +1,738 @@
+/*
+ * Event Capture for ECU Dashboard
+ * Lock-free frame ring filled by the receive path, timer-sampled channel
+ * ring, and a capture task that streams the window around a trigger to SD
+ */
+
+#include "include/event_capture.h"
+#include "include/can_logger.h"
+#include "include/channel_registry.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_heap_caps.h"
+#include "esp_log.h"
+#include "esp_random.h"
+#include "esp_rom_crc.h"
+#include "esp_timer.h"
+#include <dirent.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <unistd.h>
+
+static const char *TAG = "EVENT_CAPTURE";
+
+#define CAPTURE_TASK_STACK_SIZE     4096
+#define CAPTURE_TASK_PRIORITY       3       // Below the CAN logger (4)
+#define CAPTURE_TASK_CORE           1       // Same core as the CAN logger, away from WiFi
+#define CAPTURE_MARGIN_S            3       // Ring headroom for a slow card while saving
+#define CAPTURE_POLL_MS             100     // Capture task wakeups while following the post window
+#define CAPTURE_IDLE_GRACE_US       500000  // Stop waiting this long after the window on a quiet bus
+#define CAPTURE_CAN_REARM_US        1000000 // A watched identifier must be absent this long to fire again
+
+// Flipped into the sequence of a slot while its frame is being written
+#define SEQ_WRITING                 0x80000000u
+
+#define EVENT_BIN_EXT               ".BIN"
+#define EVENT_CSV_EXT               ".CSV"
+
+// One received frame. `seq` is the reservation number of the frame in the
+// slot, so the reader can tell a valid slot from one that is being written
+// or has already been reused (a per-slot sequence lock).
+typedef struct {
+    uint32_t seq;
+    uint32_t id_flags;          // Identifier and CAN_LOG_FLAG_RTR / CAN_LOG_FLAG_EXTENDED
+    int64_t time_us;
+    uint8_t dlc;
+    uint8_t data[8];
+} ring_frame_t;
+
+typedef struct {
+    int64_t time_us;
+    uint8_t count;
+    float values[CHANNEL_MAX];
+} ring_sample_t;
+
+typedef enum {
+    SLOT_OK = 0,
+    SLOT_PENDING,               // Reserved, the producer is still copying
+    SLOT_LOST                   // Overwritten by newer frames
+} slot_state_t;
+
+typedef struct {
+    alarm_id_t alarm;
+    alarm_level_t level;
+} alarm_trigger_t;
+
+typedef struct {
+    uint32_t id;
+    uint32_t mask;
+    int64_t last_seen_us;       // Written by the receive path only
+} can_trigger_t;
+
+static event_capture_config_t capture_config;
+static event_capture_stats_t capture_stats;
+
+// Frame ring (PSRAM). frame_reserve counts reserved slots and stays in
+// internal RAM, where the atomic add is native.
+static ring_frame_t *frame_ring = NULL;
+static uint32_t frame_capacity = 0;
+static uint32_t frame_reserve = 0;
+
+// Channel sample ring (PSRAM), written by the sampling timer
+static ring_sample_t *sample_ring = NULL;
+static uint32_t sample_capacity = 0;
+static uint32_t sample_head = 0;
+static esp_timer_handle_t sample_timer = NULL;
+
+// Triggers. Entries are filled in before the count is raised, so the
+// receive path can walk them without a lock.
+static alarm_trigger_t alarm_triggers[EVENT_CAPTURE_MAX_ALARMS];
+static volatile uint8_t alarm_trigger_count = 0;
+static can_trigger_t can_triggers[EVENT_CAPTURE_MAX_CAN_IDS];
+static volatile uint8_t can_trigger_count = 0;
+
+// Pending event, under capture_lock
+static bool capture_busy = false;
+static int64_t trigger_time_us = 0;
+static char trigger_reason[EVENT_CAPTURE_REASON_LEN];
+
+// Output block of the capture task (PSRAM)
+static uint8_t *capture_block = NULL;
+
+static portMUX_TYPE capture_lock = portMUX_INITIALIZER_UNLOCKED;
+static TaskHandle_t capture_task_handle = NULL;
+static bool capture_initialized = false;
+
+// Alarms that save an event by default; display rules (RPM) fire too often
+static const alarm_builtin_t default_alarm_triggers[] = {
+    ALARM_WATER_TEMP,
+    ALARM_OIL_TEMP,
+    ALARM_BATTERY_LOW,
+};
+
+// ============================================================================
+// PRODUCERS (receive path, sampling timer)
+// ============================================================================
+
+/**
+ * @brief Accepts a trigger unless an event is already being saved.
+ */
+static bool capture_fire(const char *reason, int64_t time_us)
+{
+    bool accepted = false;
+
+    portENTER_CRITICAL(&capture_lock);
+    if (!capture_busy) {
+        capture_busy = true;
+        trigger_time_us = time_us;
+        strncpy(trigger_reason, reason, sizeof(trigger_reason) - 1);
+        trigger_reason[sizeof(trigger_reason) - 1] = '\0';
+        accepted = true;
+    } else {
+        capture_stats.triggers_ignored++;
+    }
+    portEXIT_CRITICAL(&capture_lock);
+
+    if (accepted) {
+        xTaskNotifyGive(capture_task_handle);
+    }
+    return accepted;
+}
+
+void event_capture_frame(const twai_message_t *message)
+{
+    if (!capture_initialized || message == NULL) {
+        return;
+    }
+
+    int64_t now = esp_timer_get_time();
+    uint32_t id = message->identifier & CAN_LOG_ID_MASK;
+
+    // Reserve a slot, invalidate it, copy, then publish the sequence
+    uint32_t s = __atomic_fetch_add(&frame_reserve, 1, __ATOMIC_RELAXED);
+    ring_frame_t *f = &frame_ring[s % frame_capacity];
+    __atomic_store_n(&f->seq, s ^ SEQ_WRITING, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    f->id_flags = id;
+    if (message->extd) {
+        f->id_flags |= CAN_LOG_FLAG_EXTENDED;
+    }
+    if (message->rtr) {
+        f->id_flags |= CAN_LOG_FLAG_RTR;
+    }
+    f->time_us = now;
+    f->dlc = message->data_length_code & 0x0F;
+    memcpy(f->data, message->data, sizeof(f->data));
+    __atomic_store_n(&f->seq, s, __ATOMIC_RELEASE);
+
+    uint8_t count = can_trigger_count;
+    for (uint8_t i = 0; i < count; i++) {
+        can_trigger_t *t = &can_triggers[i];
+        if ((id & t->mask) != (t->id & t->mask)) {
+            continue;
+        }
+        // Fire on the first frame after a quiet period, not on every repetition
+        bool fire = (now - t->last_seen_us) > CAPTURE_CAN_REARM_US;
+        t->last_seen_us = now;
+        if (fire) {
+            char reason[EVENT_CAPTURE_REASON_LEN];
+            snprintf(reason, sizeof(reason), "can_0x%03lX", (unsigned long)id);
+            capture_fire(reason, now);
+        }
+    }
+}
+
+static void sample_timer_cb(void *arg)
+{
+    channel_snapshot_t snap;
+    channel_snapshot(&snap);
+
+    portENTER_CRITICAL(&capture_lock);
+    ring_sample_t *s = &sample_ring[sample_head % sample_capacity];
+    s->time_us = snap.timestamp_us;
+    s->count = snap.count;
+    memcpy(s->values, snap.values, sizeof(s->values));
+    sample_head++;
+    portEXIT_CRITICAL(&capture_lock);
+}
+
+static void capture_alarm_cb(const alarm_event_t *event, void *arg)
+{
+    uint8_t count = alarm_trigger_count;
+    for (uint8_t i = 0; i < count; i++) {
+        const alarm_trigger_t *t = &alarm_triggers[i];
+        if (t->alarm == event->alarm && event->new_level >= t->level && event->old_level < t->level) {
+            const alarm_rule_t *rule = alarm_engine_get_rule(event->alarm);
+            capture_fire(rule ? rule->name : "alarm", event->timestamp_us);
+            return;
+        }
+    }
+}
+
+// ============================================================================
+// RING READERS (capture task)
+// ============================================================================
+
+static slot_state_t frame_ring_read(uint32_t s, ring_frame_t *out)
+{
+    const ring_frame_t *f = &frame_ring[s % frame_capacity];
+    uint32_t before = __atomic_load_n(&f->seq, __ATOMIC_ACQUIRE);
+    if (before != s) {
+        uint32_t reserved = __atomic_load_n(&frame_reserve, __ATOMIC_RELAXED);
+        return (reserved - s >= frame_capacity) ? SLOT_LOST : SLOT_PENDING;
+    }
+    memcpy(out, f, sizeof(*out));
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    return (__atomic_load_n(&f->seq, __ATOMIC_RELAXED) == s) ? SLOT_OK : SLOT_LOST;
+}
+
+/**
+ * @brief First frame at or after start_us still in the ring. Timestamps
+ *        grow with the reservation number, so this is a binary search.
+ */
+static uint32_t frame_ring_find(int64_t start_us)
+{
+    uint32_t hi = __atomic_load_n(&frame_reserve, __ATOMIC_ACQUIRE);
+    // Before the first wrap of the counter only `hi` frames exist
+    uint32_t lo = hi - (hi < frame_capacity ? hi : frame_capacity);
+
+    while (lo != hi) {
+        uint32_t mid = lo + (hi - lo) / 2;
+        ring_frame_t f;
+        slot_state_t state = frame_ring_read(mid, &f);
+        if (state == SLOT_LOST || (state == SLOT_OK && f.time_us < start_us)) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return lo;
+}
+
+static bool sample_ring_read(uint32_t s, ring_sample_t *out)
+{
+    bool valid;
+    portENTER_CRITICAL(&capture_lock);
+    valid = (sample_head - s) - 1 < sample_capacity;
+    if (valid) {
+        memcpy(out, &sample_ring[s % sample_capacity], sizeof(*out));
+    }
+    portEXIT_CRITICAL(&capture_lock);
+    return valid;
+}
+
+// ============================================================================
+// EVENT FILES
+// ============================================================================
+
+/**
+ * @brief Number for the next EVTnnnnn files: one above the highest on the card.
+ */
+static uint32_t capture_next_number(void)
+{
+    uint32_t highest = 0;
+    DIR *dir = opendir(EVENT_CAPTURE_DIR);
+    if (dir == NULL) {
+        return 1;
+    }
+    struct dirent *entry;
+    size_t prefix_len = strlen(EVENT_CAPTURE_PREFIX);
+    while ((entry = readdir(dir)) != NULL) {
+        const char *name = entry->d_name;
+        size_t len = strlen(name);
+        if (len <= prefix_len + strlen(EVENT_BIN_EXT) ||
+            strncasecmp(name, EVENT_CAPTURE_PREFIX, prefix_len) != 0 ||
+            strcasecmp(name + len - strlen(EVENT_BIN_EXT), EVENT_BIN_EXT) != 0) {
+            continue;
+        }
+        uint32_t number = strtoul(name + prefix_len, NULL, 10);
+        if (number > highest) {
+            highest = number;
+        }
+    }
+    closedir(dir);
+    return highest + 1;
+}
+
+static void event_path(uint32_t number, const char *ext, char *path, size_t len)
+{
+    snprintf(path, len, "%s/%s%05lu%s", EVENT_CAPTURE_DIR, EVENT_CAPTURE_PREFIX,
+             (unsigned long)number, ext);
+}
+
+// Data block being filled in capture_block
+typedef struct {
+    FILE *file;
+    uint32_t file_id;
+    uint32_t sequence;
+    size_t fill;
+    int64_t chain_us;           // Time of the previous record
+    esp_err_t error;
+} event_writer_t;
+
+static void writer_begin_block(event_writer_t *w)
+{
+    can_log_block_header_t *hdr = (can_log_block_header_t *)capture_block;
+    memset(hdr, 0, sizeof(*hdr));
+    hdr->magic = CAN_LOG_BLOCK_MAGIC;
+    hdr->sequence = w->sequence;
+    hdr->base_time_us = (uint64_t)w->chain_us;
+    hdr->file_id = w->file_id;
+    w->fill = sizeof(*hdr);
+}
+
+/**
+ * @brief Writes the current block (only its used bytes if it is the last).
+ */
+static void writer_flush_block(event_writer_t *w, bool last)
+{
+    can_log_block_header_t *hdr = (can_log_block_header_t *)capture_block;
+    size_t payload_len = w->fill - sizeof(*hdr);
+    if (payload_len == 0 || w->error != ESP_OK) {
+        return;
+    }
+    hdr->record_count = (uint16_t)(payload_len / sizeof(can_log_record_t));
+    hdr->crc32 = esp_rom_crc32_le(0, capture_block + sizeof(*hdr), payload_len);
+
+    size_t len = last ? w->fill : CAN_LOG_BLOCK_SIZE;
+    if (fwrite(capture_block, 1, len, w->file) != len) {
+        w->error = ESP_FAIL;
+        return;
+    }
+    w->sequence++;
+    writer_begin_block(w);
+}
+
+static void writer_put(event_writer_t *w, const can_log_record_t *rec)
+{
+    if (w->fill + sizeof(*rec) > CAN_LOG_BLOCK_SIZE) {
+        writer_flush_block(w, false);
+    }
+    memcpy(capture_block + w->fill, rec, sizeof(*rec));
+    w->fill += sizeof(*rec);
+}
+
+static void writer_add_frame(event_writer_t *w, const ring_frame_t *f)
+{
+    can_log_record_t rec;
+    int64_t delta = f->time_us - w->chain_us;
+
+    if (delta > CAN_LOG_DELTA_MAX) {
+        rec.delta_dlc = 0;
+        rec.id_flags = CAN_LOG_FLAG_TIME;
+        memcpy(rec.data, &f->time_us, sizeof(f->time_us));
+        writer_put(w, &rec);
+        w->chain_us = f->time_us;
+        delta = 0;
+    } else if (delta < 0) {
+        // Two producers (CAN task and replay) can publish slightly out of order
+        delta = 0;
+    }
+
+    rec.delta_dlc = (uint32_t)delta | ((uint32_t)f->dlc << CAN_LOG_DLC_SHIFT);
+    rec.id_flags = f->id_flags;
+    memcpy(rec.data, f->data, sizeof(rec.data));
+    writer_put(w, &rec);
+    w->chain_us += delta;
+}
+
+/**
+ * @brief Streams the frames of [start_us, end_us] from the ring into an
+ *        EVT file, following the post-trigger window as it is received.
+ */
+static esp_err_t capture_save_frames(const char *path, int64_t start_us, int64_t end_us,
+                                     uint32_t *saved, uint32_t *lost)
+{
+    event_writer_t w = {
+        .file_id = esp_random(),
+        .sequence = 1,
+        .chain_us = start_us,
+        .error = ESP_OK,
+    };
+    *saved = 0;
+    *lost = 0;
+
+    w.file = fopen(path, "wb");
+    if (w.file == NULL) {
+        ESP_LOGE(TAG, "Failed to create %s", path);
+        return ESP_FAIL;
+    }
+    setvbuf(w.file, NULL, _IONBF, 0);
+
+    // Block 0: the file header, padded to a full block
+    can_log_file_header_t hdr;
+    can_logger_init_file_header(&hdr, w.file_id, 0, (uint64_t)start_us);
+    memset(capture_block, 0, CAN_LOG_BLOCK_SIZE);
+    memcpy(capture_block, &hdr, sizeof(hdr));
+    if (fwrite(capture_block, 1, CAN_LOG_BLOCK_SIZE, w.file) != CAN_LOG_BLOCK_SIZE) {
+        fclose(w.file);
+        return ESP_FAIL;
+    }
+    writer_begin_block(&w);
+
+    uint32_t s = frame_ring_find(start_us);
+    bool done = false;
+    while (!done && w.error == ESP_OK) {
+        uint32_t reserved = __atomic_load_n(&frame_reserve, __ATOMIC_ACQUIRE);
+
+        // A stalled card let the producers lap us: skip to what is left
+        if (reserved - s > frame_capacity) {
+            *lost += reserved - s - frame_capacity;
+            s = reserved - frame_capacity;
+        }
+
+        while (s != reserved) {
+            ring_frame_t f;
+            slot_state_t state = frame_ring_read(s, &f);
+            if (state == SLOT_PENDING) {
+                break;
+            }
+            s++;
+            if (state == SLOT_LOST) {
+                (*lost)++;
+                continue;
+            }
+            if (f.time_us < start_us) {
+                continue;
+            }
+            if (f.time_us > end_us) {
+                done = true;
+                break;
+            }
+            writer_add_frame(&w, &f);
+            (*saved)++;
+        }
+
+        if (!done) {
+            if (esp_timer_get_time() > end_us + CAPTURE_IDLE_GRACE_US) {
+                break;
+            }
+            vTaskDelay(pdMS_TO_TICKS(CAPTURE_POLL_MS));
+        }
+    }
+
+    writer_flush_block(&w, true);
+    if (fclose(w.file) != 0) {
+        w.error = ESP_FAIL;
+    }
+    return w.error;
+}
+
+/**
+ * @brief Writes the channel samples of [start_us, end_us] as CSV, time in
+ *        seconds relative to the trigger.
+ */
+static esp_err_t capture_save_samples(const char *path, uint32_t number, const char *reason,
+                                      int64_t start_us, int64_t trigger_us, int64_t end_us,
+                                      uint32_t *saved)
+{
+    *saved = 0;
+    FILE *file = fopen(path, "w");
+    if (file == NULL) {
+        ESP_LOGE(TAG, "Failed to create %s", path);
+        return ESP_FAIL;
+    }
+    setvbuf(file, NULL, _IOFBF, 4096);
+
+    uint8_t count = channel_count();
+    fprintf(file, "# %s%05lu reason=%s trigger_us=%lld\n", EVENT_CAPTURE_PREFIX,
+            (unsigned long)number, reason, (long long)trigger_us);
+    fputs("time_s", file);
+    for (channel_id_t ch = 0; ch < count; ch++) {
+        const channel_def_t *def = channel_get_def(ch);
+        fprintf(file, ",%s", def ? def->name : "");
+    }
+    fputc('\n', file);
+
+    portENTER_CRITICAL(&capture_lock);
+    uint32_t head = sample_head;
+    portEXIT_CRITICAL(&capture_lock);
+
+    uint32_t s = head - (head < sample_capacity ? head : sample_capacity);
+    for (; s != head; s++) {
+        ring_sample_t sample;
+        if (!sample_ring_read(s, &sample) ||
+            sample.time_us < start_us || sample.time_us > end_us) {
+            continue;
+        }
+        fprintf(file, "%.3f", (double)(sample.time_us - trigger_us) / 1e6);
+        for (channel_id_t ch = 0; ch < count; ch++) {
+            const channel_def_t *def = channel_get_def(ch);
+            if (ch < sample.count && def != NULL) {
+                fprintf(file, ",%.*f", def->precision, (double)sample.values[ch]);
+            } else {
+                fputc(',', file);
+            }
+        }
+        fputc('\n', file);
+        (*saved)++;
+    }
+
+    bool failed = ferror(file) != 0;
+    if (fclose(file) != 0 || failed) {
+        return ESP_FAIL;
+    }
+    return ESP_OK;
+}
+
+// ============================================================================
+// CAPTURE TASK
+// ============================================================================
+
+static void capture_save_event(void)
+{
+    char reason[EVENT_CAPTURE_REASON_LEN];
+    int64_t trigger_us;
+
+    portENTER_CRITICAL(&capture_lock);
+    trigger_us = trigger_time_us;
+    memcpy(reason, trigger_reason, sizeof(reason));
+    portEXIT_CRITICAL(&capture_lock);
+
+    int64_t start_us = trigger_us - (int64_t)capture_config.pre_trigger_s * 1000000;
+    int64_t end_us = trigger_us + (int64_t)capture_config.post_trigger_s * 1000000;
+    if (start_us < 0) {
+        start_us = 0;
+    }
+
+    uint32_t number = capture_next_number();
+    char bin_path[32];
+    char csv_path[32];
+    event_path(number, EVENT_BIN_EXT, bin_path, sizeof(bin_path));
+    event_path(number, EVENT_CSV_EXT, csv_path, sizeof(csv_path));
+    ESP_LOGI(TAG, "Event '%s': saving %s", reason, bin_path);
+
+    uint32_t frames = 0, lost = 0, samples = 0;
+    esp_err_t ret = capture_save_frames(bin_path, start_us, end_us, &frames, &lost);
+    if (ret == ESP_OK) {
+        ret = capture_save_samples(csv_path, number, reason, start_us, trigger_us, end_us, &samples);
+    }
+
+    portENTER_CRITICAL(&capture_lock);
+    capture_stats.frames_saved += frames;
+    capture_stats.frames_lost += lost;
+    capture_stats.samples_saved += samples;
+    if (ret == ESP_OK) {
+        capture_stats.events_saved++;
+        capture_stats.last_event = number;
+        memcpy(capture_stats.last_reason, reason, sizeof(capture_stats.last_reason));
+    } else {
+        capture_stats.write_errors++;
+    }
+    capture_busy = false;
+    portEXIT_CRITICAL(&capture_lock);
+
+    if (ret == ESP_OK) {
+        ESP_LOGI(TAG, "Saved %s: %lu frames (%lu lost), %lu samples", bin_path,
+                 (unsigned long)frames, (unsigned long)lost, (unsigned long)samples);
+    } else {
+        ESP_LOGE(TAG, "Failed to save event %s", bin_path);
+    }
+}
+
+static void event_capture_task(void *pvParameters)
+{
+    ESP_LOGI(TAG, "Capture task started on core %d", xPortGetCoreID());
+
+    while (1) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        if (event_capture_is_busy()) {
+            capture_save_event();
+        }
+    }
+}
+
+// ============================================================================
+// CONTROL
+// ============================================================================
+
+esp_err_t event_capture_init(const event_capture_config_t *config)
+{
+    if (capture_initialized) {
+        return ESP_OK;
+    }
+
+    event_capture_config_t defaults = EVENT_CAPTURE_CONFIG_DEFAULT();
+    capture_config = config ? *config : defaults;
+    if (capture_config.max_frame_rate == 0) {
+        capture_config.max_frame_rate = defaults.max_frame_rate;
+    }
+    if (capture_config.sample_period_ms == 0) {
+        capture_config.sample_period_ms = defaults.sample_period_ms;
+    }
+
+    // The frame ring only needs the pre-trigger history: the post window is
+    // saved while it is received
+    frame_capacity = capture_config.max_frame_rate * (capture_config.pre_trigger_s + CAPTURE_MARGIN_S);
+    sample_capacity = (capture_config.pre_trigger_s + capture_config.post_trigger_s + CAPTURE_MARGIN_S) *
+                      1000 / capture_config.sample_period_ms;
+
+    frame_ring = heap_caps_calloc(frame_capacity, sizeof(ring_frame_t), MALLOC_CAP_SPIRAM);
+    sample_ring = heap_caps_calloc(sample_capacity, sizeof(ring_sample_t), MALLOC_CAP_SPIRAM);
+    capture_block = heap_caps_malloc(CAN_LOG_BLOCK_SIZE, MALLOC_CAP_SPIRAM);
+    if (frame_ring == NULL || sample_ring == NULL || capture_block == NULL) {
+        ESP_LOGE(TAG, "Failed to allocate capture rings (%lu frames)", (unsigned long)frame_capacity);
+        goto fail;
+    }
+    // No slot holds a valid frame yet: sequence 0 must not match slot 0
+    for (uint32_t i = 0; i < frame_capacity; i++) {
+        frame_ring[i].seq = SEQ_WRITING;
+    }
+
+    BaseType_t created = xTaskCreatePinnedToCore(event_capture_task, "event_capture",
+                                                 CAPTURE_TASK_STACK_SIZE, NULL,
+                                                 CAPTURE_TASK_PRIORITY, &capture_task_handle,
+                                                 CAPTURE_TASK_CORE);
+    if (created != pdPASS) {
+        ESP_LOGE(TAG, "Failed to create capture task");
+        goto fail;
+    }
+
+    const esp_timer_create_args_t timer_args = {
+        .callback = sample_timer_cb,
+        .name = "event_sample"
+    };
+    if (esp_timer_create(&timer_args, &sample_timer) != ESP_OK ||
+        esp_timer_start_periodic(sample_timer, (uint64_t)capture_config.sample_period_ms * 1000) != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to start channel sampling");
+        vTaskDelete(capture_task_handle);
+        capture_task_handle = NULL;
+        goto fail;
+    }
+
+    capture_initialized = true;
+
+    alarm_engine_subscribe(capture_alarm_cb, NULL);
+    for (size_t i = 0; i < sizeof(default_alarm_triggers) / sizeof(default_alarm_triggers[0]); i++) {
+        event_capture_watch_alarm(default_alarm_triggers[i], ALARM_LEVEL_CRITICAL);
+    }
+
+    ESP_LOGI(TAG, "Event capture ready: %lus before, %lus after, %lu frame ring (%lu KB PSRAM)",
+             (unsigned long)capture_config.pre_trigger_s, (unsigned long)capture_config.post_trigger_s,
+             (unsigned long)frame_capacity,
+             (unsigned long)((frame_capacity * sizeof(ring_frame_t) +
+                              sample_capacity * sizeof(ring_sample_t)) / 1024));
+    return ESP_OK;
+
+fail:
+    if (sample_timer != NULL) {
+        esp_timer_delete(sample_timer);
+        sample_timer = NULL;
+    }
+    heap_caps_free(frame_ring);
+    heap_caps_free(sample_ring);
+    heap_caps_free(capture_block);
+    frame_ring = NULL;
+    sample_ring = NULL;
+    capture_block = NULL;
+    return ESP_ERR_NO_MEM;
+}
+
+esp_err_t event_capture_watch_alarm(alarm_id_t id, alarm_level_t level)
+{
+    if (!capture_initialized || alarm_engine_get_rule(id) == NULL || level == ALARM_LEVEL_OK) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    esp_err_t ret = ESP_OK;
+    portENTER_CRITICAL(&capture_lock);
+    if (alarm_trigger_count < EVENT_CAPTURE_MAX_ALARMS) {
+        alarm_triggers[alarm_trigger_count].alarm = id;
+        alarm_triggers[alarm_trigger_count].level = level;
+        alarm_trigger_count++;
+    } else {
+        ret = ESP_ERR_NO_MEM;
+    }
+    portEXIT_CRITICAL(&capture_lock);
+    return ret;
+}
+
+esp_err_t event_capture_watch_can_id(uint32_t id, uint32_t mask)
+{
+    if (!capture_initialized) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    esp_err_t ret = ESP_OK;
+    portENTER_CRITICAL(&capture_lock);
+    if (can_trigger_count < EVENT_CAPTURE_MAX_CAN_IDS) {
+        can_trigger_t *t = &can_triggers[can_trigger_count];
+        t->id = id & CAN_LOG_ID_MASK;
+        t->mask = mask & CAN_LOG_ID_MASK;
+        t->last_seen_us = -CAPTURE_CAN_REARM_US - 1;
+        can_trigger_count++;
+    } else {
+        ret = ESP_ERR_NO_MEM;
+    }
+    portEXIT_CRITICAL(&capture_lock);
+    return ret;
+}
+
+esp_err_t event_capture_trigger(const char *reason)
+{
+    if (!capture_initialized) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    return capture_fire(reason ? reason : "manual", esp_timer_get_time()) ? ESP_OK : ESP_ERR_TIMEOUT;
+}
+
+bool event_capture_is_busy(void)
+{
+    bool busy;
+    portENTER_CRITICAL(&capture_lock);
+    busy = capture_busy;
+    portEXIT_CRITICAL(&capture_lock);
+    return busy;
+}
+
+void event_capture_get_stats(event_capture_stats_t *stats)
+{
+    if (stats == NULL) {
+        return;
+    }
+    portENTER_CRITICAL(&capture_lock);
+    *stats = capture_stats;
+    portEXIT_CRITICAL(&capture_lock);
+}
@@ -0,0 +1,62 @@
+/*
+ * HTTP Range header parsing for ECU Dashboard
+ */
+
+#include "include/http_range.h"
+#include <ctype.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Digits only: strtol() alone would also take signs and leading spaces
+static bool range_number(const char *str, long *out, const char **rest)
+{
+    if (!isdigit((unsigned char)*str)) {
+        return false;
+    }
+    char *end;
+    *out = strtol(str, &end, 10);
+    *rest = end;
+    return true;
+}
+
+http_range_result_t http_range_parse(const char *value, long size, long *start, long *end)
+{
+    if (strncmp(value, "bytes=", 6) != 0 || strchr(value, ',') != NULL) {
+        return HTTP_RANGE_NONE;
+    }
+    const char *spec = value + 6;
+    const char *rest;
+
+    if (*spec == '-') {
+        // Suffix range: the last N bytes
+        long suffix;
+        if (!range_number(spec + 1, &suffix, &rest) || *rest != '\0') {
+            return HTTP_RANGE_NONE;
+        }
+        if (suffix == 0 || size == 0) {
+            return HTTP_RANGE_UNSATISFIABLE;
+        }
+        *start = suffix >= size ? 0 : size - suffix;
+        *end = size - 1;
+        return HTTP_RANGE_OK;
+    }
+
+    long first;
+    if (!range_number(spec, &first, &rest) || *rest != '-') {
+        return HTTP_RANGE_NONE;
+    }
+    const char *last_str = rest + 1;
+    long last = size - 1;
+    if (*last_str != '\0') {
+        if (!range_number(last_str, &last, &rest) || *rest != '\0' || last < first) {
+            return HTTP_RANGE_NONE;
+        }
+    }
+    if (first >= size) {
+        return HTTP_RANGE_UNSATISFIABLE;
+    }
+    *start = first;
+    *end = last < size ? last : size - 1;
+    return HTTP_RANGE_OK;
+}
@@ -0,0 +1,139 @@
+/*
+ * Alarm Engine for ECU Dashboard
+ * Per-channel threshold rules with hysteresis, minimum duration and latch
+ */
+
+#ifndef ALARM_ENGINE_H
+#define ALARM_ENGINE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "esp_err.h"
+#include "channel_registry.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define ALARM_MAX_RULES         16
+#define ALARM_MAX_SUBSCRIBERS   6
+
+// Built-in rules. Like the channel numbering, these indices are stable so
+// the UI and web code can refer to a rule without looking it up by name.
+typedef enum {
+    ALARM_RPM_SHIFT = 0,        // RPM arc colour on Screen1
+    ALARM_TCU_RPM,              // TCU LED and status label
+    ALARM_WATER_TEMP,
+    ALARM_OIL_TEMP,
+    ALARM_BATTERY_LOW,
+
+    ALARM_BUILTIN_COUNT
+} alarm_builtin_t;
+
+typedef uint8_t alarm_id_t;
+
+#define ALARM_INVALID 0xFF
+
+typedef enum {
+    ALARM_LEVEL_OK = 0,
+    ALARM_LEVEL_WARNING,
+    ALARM_LEVEL_CRITICAL
+} alarm_level_t;
+
+typedef enum {
+    ALARM_ABOVE = 0,            // Raised when the value climbs to the threshold
+    ALARM_BELOW                 // Raised when the value falls to the threshold
+} alarm_direction_t;
+
+// Rule definition
+typedef struct {
+    const char *name;           // Short key used in logs and JSON ("tcu_rpm")
+    channel_id_t channel;       // Input channel
+    alarm_direction_t direction;
+    float warn_threshold;       // Entering WARNING
+    float crit_threshold;       // Entering CRITICAL
+    float hysteresis;           // Margin needed to leave a level again
+    uint32_t min_duration_ms;   // A raised level must hold this long (0 = immediately)
+    bool latch;                 // Keep the highest level until acknowledged
+} alarm_rule_t;
+
+// State transition delivered to subscribers
+typedef struct {
+    alarm_id_t alarm;
+    alarm_level_t old_level;
+    alarm_level_t new_level;
+    float value;                // Channel value that caused the transition
+    int64_t timestamp_us;
+} alarm_event_t;
+
+// Subscribers run in the context that produced the transition (CAN task,
+// LVGL task in demo mode, or the esp_timer task for minimum durations), so
+// they must only record the event and return.
+typedef void (*alarm_subscriber_t)(const alarm_event_t *event, void *arg);
+
+/**
+ * @brief Loads the built-in rules and starts listening to the channel registry.
+ *        The registry must be initialized first.
+ * @return ESP_OK on success, otherwise an error code
+ */
+esp_err_t alarm_engine_init(void);
+
+/**
+ * @brief Adds a rule after the built-in ones.
+ * @param rule Rule definition (copied; the name string must stay valid)
+ * @param out_id Receives the rule index (may be NULL)
+ * @return ESP_OK, ESP_ERR_INVALID_ARG or ESP_ERR_NO_MEM if the table is full
+ */
+esp_err_t alarm_engine_add_rule(const alarm_rule_t *rule, alarm_id_t *out_id);
+
+/**
+ * @brief Registers a transition subscriber.
+ * @return ESP_OK, ESP_ERR_INVALID_ARG or ESP_ERR_NO_MEM if all slots are used
+ */
+esp_err_t alarm_engine_subscribe(alarm_subscriber_t subscriber, void *arg);
+
+/**
+ * @brief Evaluates the rules of a channel against a value.
+ *        Normally called through the registry listener; the demo animations
+ *        call it directly because they do not write channels.
+ *        Unchanged values are ignored.
+ */
+void alarm_engine_evaluate(channel_id_t channel, float value);
+
+/**
+ * @brief Clears the latch of a rule and re-evaluates it with the last value.
+ */
+void alarm_engine_acknowledge(alarm_id_t id);
+
+/**
+ * @brief Current level of a rule (ALARM_LEVEL_OK for unknown ids).
+ */
+alarm_level_t alarm_engine_get_level(alarm_id_t id);
+
+/**
+ * @brief Rule definition by index, or NULL.
+ */
+const alarm_rule_t *alarm_engine_get_rule(alarm_id_t id);
+
+/**
+ * @brief Number of rules in use.
+ */
+uint8_t alarm_engine_count(void);
+
+/**
+ * @brief Writes the buffered transitions to the web data stream and
+ *        ALARMS.LOG. Runs as the BG_TASK_ALARM_LOG background job.
+ *        Transitions raised while demo mode is on are not buffered.
+ */
+esp_err_t alarm_engine_flush_log(void);
+
+/**
+ * @brief Human-readable level name ("OK", "WARNING", "CRITICAL").
+ */
+const char *alarm_level_to_string(alarm_level_t level);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // ALARM_ENGINE_H
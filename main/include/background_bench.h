@@ -0,0 +1,59 @@
+/*
+ * Background Queue Benchmark for ECU Dashboard
+ * Mixed synthetic jobs through the real background queue
+ *
+ * Each run submits the same job mix with the pool limited to a number of
+ * workers and measures throughput and the latency from submission to
+ * completion of every job:
+ *
+ *   6 of 10   cpu       0.5 ms busy
+ *   1 of 10   compress  5 ms busy
+ *   2 of 10   nvs       10 ms blocked, one affinity key (must stay in order)
+ *   1 of 10   sd        40 ms blocked
+ *
+ * Enabled with CONFIG_BACKGROUND_BENCHMARK, which runs it once at boot on
+ * one worker and on all workers and logs both results.
+ */
+
+#ifndef BACKGROUND_BENCH_H
+#define BACKGROUND_BENCH_H
+
+#include <stdint.h>
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define BACKGROUND_BENCH_JOBS       200
+
+typedef struct {
+    uint32_t workers;
+    uint32_t jobs;                  // Completed
+    uint32_t elapsed_us;            // First submission to last completion
+    uint32_t jobs_per_s;
+    uint32_t p50_us;                // Submission to completion
+    uint32_t p95_us;
+    uint32_t p99_us;
+    uint32_t max_us;
+    uint32_t order_errors;          // nvs jobs run out of submission order
+    uint32_t failed;                // Rejected or completed with an error
+} background_bench_result_t;
+
+/**
+ * @brief Runs the job mix with `workers` active workers. Blocks until all
+ *        jobs completed; the previous worker count is restored.
+ * @return ESP_OK, ESP_ERR_INVALID_ARG, ESP_ERR_NO_MEM or ESP_ERR_TIMEOUT
+ */
+esp_err_t background_bench_run(uint32_t workers, uint32_t jobs, background_bench_result_t *result);
+
+/**
+ * @brief Runs the mix on one worker and on all workers and logs both.
+ */
+void background_bench_compare(uint32_t jobs);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // BACKGROUND_BENCH_H
@@ -0,0 +1,90 @@
+/*
+ * Boot Trace for ECU Dashboard
+ * Start and end times of the boot stages, and a runner for stages that
+ * do not depend on each other
+ *
+ * boot_trace_begin()/boot_trace_end() record one stage each; milestones
+ * such as the first frame on the panel are single points. Times are
+ * esp_timer microseconds since boot.
+ *
+ * boot_trace_run_stages() starts one task per stage of a table. Each
+ * stage waits only for the stages named in its `after` mask, so SD mount,
+ * Wi-Fi and panel init overlap instead of running one after another.
+ * The call returns when every stage has finished.
+ */
+
+#ifndef BOOT_TRACE_H
+#define BOOT_TRACE_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define BOOT_TRACE_MAX_ENTRIES      32
+#define BOOT_TRACE_NAME_LEN         16
+#define BOOT_STAGE_MAX              16
+
+typedef struct {
+    char name[BOOT_TRACE_NAME_LEN];
+    int64_t start_us;
+    int64_t end_us;                 // 0 while running; start_us for milestones
+    esp_err_t result;
+    int8_t core;
+} boot_trace_entry_t;
+
+typedef esp_err_t (*boot_stage_fn_t)(void);
+
+typedef struct {
+    const char *name;
+    boot_stage_fn_t fn;
+    uint32_t after;                 // BOOT_STAGE() bits of stages that must finish first
+    int core;                       // tskNO_AFFINITY or a core number
+    uint32_t stack_size;            // 0 = BOOT_STAGE_STACK_DEFAULT
+} boot_stage_t;
+
+#define BOOT_STAGE(index)           (1u << (index))
+#define BOOT_STAGE_STACK_DEFAULT    4096
+
+/**
+ * @brief Starts a stage.
+ * @return Entry index for boot_trace_end(), or -1 when the table is full
+ */
+int boot_trace_begin(const char *name);
+
+void boot_trace_end(int id, esp_err_t result);
+
+/**
+ * @brief Records a point in time, e.g. "first_frame".
+ */
+void boot_trace_mark(const char *name);
+
+/**
+ * @brief Copies the entries recorded so far.
+ * @return Number of entries copied
+ */
+size_t boot_trace_get(boot_trace_entry_t *entries, size_t max);
+
+/**
+ * @brief Logs all entries as a table.
+ */
+void boot_trace_log(void);
+
+/**
+ * @brief Runs a table of stages, each in its own task with the caller's
+ *        priority, as soon as the stages in its `after` mask have finished.
+ *        A failed stage still releases the stages after it; each stage
+ *        checks what it needs.
+ * @return ESP_OK, ESP_ERR_INVALID_ARG for a bad table, ESP_ERR_NO_MEM,
+ *         or the first error returned by a stage
+ */
+esp_err_t boot_trace_run_stages(const boot_stage_t *stages, size_t count);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // BOOT_TRACE_H
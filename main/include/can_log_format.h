@@ -0,0 +1,147 @@
+/*
+ * CAN Trace File Format for ECU Dashboard
+ * Shared by the logger, readers and host tools (tools/canlog_convert.py)
+ *
+ * A trace file is a sequence of CAN_LOG_BLOCK_SIZE blocks, little endian:
+ *
+ *   block 0    can_log_file_header_t (rest of the block unused)
+ *   block 1..  can_log_block_header_t followed by up to
+ *              CAN_LOG_RECORDS_PER_BLOCK can_log_record_t, or by
+ *              LZ4 chunks when CAN_LOG_BLOCK_FLAG_LZ4 is set:
+ *
+ *                can_log_chunk_header_t, stored_size bytes, repeated
+ *
+ *              Each chunk is one LZ4 block (see components/lz4_block)
+ *              of record_count byte-shuffled records: byte 0 of every
+ *              record, then byte 1 of every record, and so on. Identifiers,
+ *              DLCs and slowly changing data bytes then form long runs.
+ *              If stored_size equals record_count * 16 the chunk holds the
+ *              records as they are. Chunks continue the delta chain of the
+ *              previous chunk in the same block.
+ *
+ * Every data block can be decoded on its own: its header carries the
+ * absolute time the first record's delta refers to, the number of valid
+ * records and a CRC32 over them. Bytes past record_count are undefined
+ * (the block may have been cut short by a power loss).
+ *
+ * Files are preallocated, so their tail holds whatever the clusters held
+ * before. The data ends at the first block whose magic, file_id or
+ * sequence does not match.
+ *
+ * Each segment has a sidecar index (CANnnnnn.IDX): a can_log_index_header_t
+ * followed by one can_log_index_entry_t for every interval_blocks-th data
+ * block, in time order. Readers binary search it to find the block to
+ * start from; without it they fall back to searching the block headers.
+ *
+ * Only the C standard library is used so the header builds on a host.
+ */
+
+#ifndef CAN_LOG_FORMAT_H
+#define CAN_LOG_FORMAT_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// One write block: matches allocation_unit_size in sd_card_init()
+#define CAN_LOG_BLOCK_SIZE          (16 * 1024)
+
+#define CAN_LOG_FILE_MAGIC          0x474F4C43u     // "CLOG"
+#define CAN_LOG_BLOCK_MAGIC         0x4B4C4243u     // "CBLK"
+#define CAN_LOG_INDEX_MAGIC         0x58444943u     // "CIDX"
+#define CAN_LOG_FORMAT_VERSION      3     // 2: file_id and segment number, 3: LZ4 blocks
+#define CAN_LOG_FORMAT_MIN_VERSION  2     // Oldest version current readers accept
+
+// id_flags bits of a record
+#define CAN_LOG_ID_MASK             0x1FFFFFFFu
+#define CAN_LOG_FLAG_TIME           (1u << 29)  // Time marker: data holds the absolute µs (uint64)
+#define CAN_LOG_FLAG_RTR            (1u << 30)
+#define CAN_LOG_FLAG_EXTENDED       (1u << 31)
+
+// can_log_block_header_t.flags
+#define CAN_LOG_BLOCK_FLAG_LZ4      0x0001u     // Payload is a sequence of chunks
+
+// Writers put at most this many records in a chunk, so readers can
+// decompress a chunk into a fixed buffer
+#define CAN_LOG_CHUNK_MAX_RECORDS   256
+
+// delta_dlc layout of a record
+#define CAN_LOG_DELTA_MAX           0x00FFFFFFu
+#define CAN_LOG_DLC_SHIFT           24
+
+/**
+ * @brief Fixed-size frame record.
+ *
+ * Timestamps are the µs delta to the previous record (or to the block's
+ * base_time_us for the first one). A time marker record re-anchors the
+ * chain after a gap longer than CAN_LOG_DELTA_MAX or after dropped frames.
+ */
+typedef struct __attribute__((packed)) {
+    uint32_t delta_dlc;         // Bits 0-23: µs since the previous record, bits 24-27: DLC
+    uint32_t id_flags;          // Bits 0-28: identifier, CAN_LOG_FLAG_* above
+    uint8_t data[8];
+} can_log_record_t;
+
+typedef struct __attribute__((packed)) {
+    uint32_t magic;             // CAN_LOG_FILE_MAGIC
+    uint16_t version;           // CAN_LOG_FORMAT_VERSION
+    uint16_t header_size;       // sizeof(can_log_file_header_t)
+    uint32_t block_size;        // CAN_LOG_BLOCK_SIZE
+    uint16_t record_size;       // sizeof(can_log_record_t)
+    uint16_t reserved;
+    uint32_t bitrate;           // Bus bitrate in bit/s
+    uint64_t start_time_us;     // esp_timer time the file was opened
+    char firmware_version[32];  // esp_app_desc_t.version
+    char idf_version[32];
+    uint32_t file_id;           // Random, repeated in every block header
+    uint32_t segment;           // Segment number within the logging session, from 0
+    uint32_t crc32;             // Over the preceding bytes of this header
+} can_log_file_header_t;
+
+typedef struct __attribute__((packed)) {
+    uint32_t magic;             // CAN_LOG_BLOCK_MAGIC
+    uint32_t sequence;          // Block number within the file, data blocks start at 1
+    uint64_t base_time_us;      // Absolute time the first record's delta refers to
+    uint16_t record_count;      // Records in the block (all chunks)
+    uint16_t flags;             // CAN_LOG_BLOCK_FLAG_*
+    uint32_t crc32;             // Over the payload: the records, or the chunks
+    uint32_t file_id;           // can_log_file_header_t.file_id
+    uint16_t payload_size;      // LZ4 blocks: bytes of chunks after the header
+    uint8_t reserved[2];
+} can_log_block_header_t;
+
+typedef struct __attribute__((packed)) {
+    uint16_t record_count;      // 1..CAN_LOG_CHUNK_MAX_RECORDS
+    uint16_t stored_size;       // Bytes that follow
+} can_log_chunk_header_t;
+
+typedef struct __attribute__((packed)) {
+    uint32_t magic;             // CAN_LOG_INDEX_MAGIC
+    uint32_t file_id;           // Segment the index belongs to
+    uint32_t interval_blocks;   // Blocks between entries
+    uint32_t reserved;
+} can_log_index_header_t;
+
+typedef struct __attribute__((packed)) {
+    uint64_t time_us;           // base_time_us of the block
+    uint32_t block;             // Block sequence number (file offset / block size)
+    uint32_t reserved;
+} can_log_index_entry_t;
+
+#define CAN_LOG_RECORDS_PER_BLOCK \
+    ((CAN_LOG_BLOCK_SIZE - sizeof(can_log_block_header_t)) / sizeof(can_log_record_t))
+
+_Static_assert(sizeof(can_log_record_t) == 16, "can_log_record_t must stay 16 bytes");
+_Static_assert(sizeof(can_log_block_header_t) % sizeof(can_log_record_t) == 0,
+               "records must tile a block after its header");
+_Static_assert(sizeof(can_log_file_header_t) <= CAN_LOG_BLOCK_SIZE, "file header must fit block 0");
+_Static_assert(CAN_LOG_BLOCK_SIZE - sizeof(can_log_block_header_t) <= UINT16_MAX,
+               "payload_size must cover a full block");
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // CAN_LOG_FORMAT_H
@@ -0,0 +1,110 @@
+/*
+ * CAN Trace Reader for ECU Dashboard
+ * Sequential and time-seek access to CANnnnnn.BIN segments
+ *
+ * Seeking loads the sidecar index (CANnnnnn.IDX) once and binary searches
+ * it, so only the index and the blocks from the target time onwards are
+ * read. Segments without a usable index are searched through their block
+ * headers instead, which is still O(log n) block reads.
+ *
+ * Format versions 2 and 3 are read; LZ4 blocks are decompressed one chunk
+ * at a time into a small buffer.
+ *
+ * Only the C standard library is used so the reader also builds on a host
+ * (replay tests, tools); on the device the block buffer goes to PSRAM.
+ */
+
+#ifndef CAN_LOG_READER_H
+#define CAN_LOG_READER_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
+#include "can_log_format.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Reader results
+typedef enum {
+    CAN_LOG_OK = 0,
+    CAN_LOG_END = 1,                    // No more frames
+    CAN_LOG_ERR_IO = -1,                // File could not be opened or read
+    CAN_LOG_ERR_FORMAT = -2,            // Not a trace file, or an unsupported version
+    CAN_LOG_ERR_NO_MEM = -3,
+    CAN_LOG_ERR_INVALID = -4            // Bad arguments
+} can_log_result_t;
+
+// One decoded frame
+typedef struct {
+    uint64_t time_us;                   // Absolute esp_timer time (µs since boot)
+    uint32_t identifier;
+    bool extended;
+    bool rtr;
+    uint8_t dlc;
+    uint8_t data[8];
+} can_log_frame_t;
+
+typedef struct {
+    FILE *file;
+    can_log_file_header_t header;
+
+    char index_path[32];
+    bool index_loaded;                  // Load was attempted
+    can_log_index_entry_t *index;       // NULL if the segment has no usable index
+    uint32_t index_count;
+    uint32_t block_limit;               // Blocks that start in the file
+
+    uint8_t *block;                     // One block, verified before use
+    uint32_t block_seq;                 // Sequence of the block in `block` (0 = none)
+    uint8_t *chunk;                     // Decompressed records of one LZ4 chunk
+    uint8_t *shuffled;                  // Decompressor output before unshuffling
+    uint32_t chunk_offset;              // Next chunk in `block`, LZ4 blocks only
+    uint32_t chunk_end;
+    const can_log_record_t *records;    // Records being decoded, in `block` or `chunk`
+    uint16_t record_pos;
+    uint16_t record_count;
+    uint64_t time_us;                   // Time of the last decoded record
+    uint64_t skip_before_us;            // Frames before this time are skipped after a seek
+
+    uint32_t crc_errors;                // Blocks skipped: bad CRC or chunks that do not decode
+} can_log_reader_t;
+
+/**
+ * @brief Opens a segment and validates its header. The index is loaded
+ *        lazily by the first seek.
+ * @return CAN_LOG_OK or a negative can_log_result_t
+ */
+int can_log_reader_open(can_log_reader_t *r, const char *path);
+
+void can_log_reader_close(can_log_reader_t *r);
+
+/**
+ * @brief Positions the reader so the next frame is the first one at or
+ *        after `time_us`.
+ *        If the segment ends earlier, the next read returns CAN_LOG_END.
+ * @return CAN_LOG_OK or a negative can_log_result_t
+ */
+int can_log_reader_seek_time(can_log_reader_t *r, uint64_t time_us);
+
+/**
+ * @brief Data block that holds `time_us` (the last one starting at or before
+ *        it), for reading a time range as raw bytes, e.g. HTTP downloads.
+ *        The block starts at file offset block_seq * header.block_size.
+ */
+int can_log_reader_find_block(can_log_reader_t *r, uint64_t time_us, uint32_t *block_seq);
+
+/**
+ * @brief Reads the next frame. Blocks that fail their CRC are skipped and
+ *        counted in crc_errors.
+ * @return CAN_LOG_OK, CAN_LOG_END or a negative can_log_result_t
+ */
+int can_log_reader_next(can_log_reader_t *r, can_log_frame_t *frame);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // CAN_LOG_READER_H
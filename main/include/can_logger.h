@@ -0,0 +1,127 @@
+/*
+ * CAN Trace Logger for ECU Dashboard
+ * Double-buffered SD logging of raw CAN frames in a dedicated task
+ *
+ * The CAN task copies each frame as a fixed 16-byte record into the active
+ * of two PSRAM buffers. A full buffer is handed to the logger task, which
+ * owns the open trace file and writes it as one block, aligned to the
+ * 16 KB FAT allocation unit, while the other buffer keeps filling.
+ * The file layout is described in can_log_format.h.
+ *
+ * The trace is split into preallocated, contiguous segment files. Writing
+ * into allocated clusters avoids FAT updates (and their latency spikes)
+ * while logging; the next segment is prepared while the current one is
+ * still being filled, so rotation does not lose frames.
+ *
+ * With compression the logger task (pinned to core 1, away from WiFi)
+ * packs the records into LZ4 chunks, so each 16 KB block holds several
+ * buffers' worth of frames while staying independently decodable.
+ */
+
+#ifndef CAN_LOGGER_H
+#define CAN_LOGGER_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "esp_err.h"
+#include "driver/twai.h"
+#include "can_log_format.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define CAN_LOGGER_BLOCK_SIZE   CAN_LOG_BLOCK_SIZE
+
+// Segments are numbered across sessions: /sdcard/CAN00001.BIN, CAN00002.BIN, ...
+#ifndef CAN_LOGGER_DIR         // The host tests log into their build directory
+#define CAN_LOGGER_DIR          "/sdcard"
+#endif
+#define CAN_LOGGER_PREFIX       "CAN"
+#define CAN_LOGGER_EXT          ".BIN"
+#define CAN_LOGGER_INDEX_EXT    ".IDX"      // Sidecar time index, see can_log_format.h
+
+typedef struct {
+    uint32_t flush_interval_ms;     // Partial blocks are written at least this often
+    uint32_t fsync_interval_ms;     // Segment and index are committed this often (0 = on stop only)
+    uint32_t segment_size_mb;       // Preallocated size of each segment file
+    uint32_t retention_segments;    // Oldest segments are deleted beyond this count (min 2)
+    uint32_t index_interval_blocks; // One index entry per this many blocks
+    bool compress;                  // LZ4 blocks (format version 3)
+} can_logger_config_t;
+
+#define CAN_LOGGER_CONFIG_DEFAULT() { \
+    .flush_interval_ms = 1000,        \
+    .fsync_interval_ms = 5000,        \
+    .segment_size_mb = 64,            \
+    .retention_segments = 32,         \
+    .index_interval_blocks = 4,       \
+    .compress = true,                 \
+}
+
+typedef struct {
+    uint32_t frames_logged;
+    uint32_t frames_dropped;        // Both buffers full (SD card too slow)
+    uint32_t blocks_written;
+    uint64_t bytes_written;
+    uint32_t write_errors;
+    uint32_t last_write_us;         // Duration of the last block write
+    uint32_t max_write_us;
+    uint32_t segments_created;
+    uint32_t segments_deleted;      // Removed by the retention limit
+    uint32_t prealloc_failures;     // Segments that had to grow cluster by cluster
+    uint64_t compress_in_bytes;     // Records handed to the compressor
+    uint64_t compress_out_bytes;    // Chunks produced, headers included
+    uint64_t compress_us;           // Time spent compressing
+    uint32_t compress_max_us;       // Longest compression of one buffer (up to 16 KB)
+} can_logger_stats_t;
+
+/**
+ * @brief Allocates the buffers, opens the trace file and starts the logger task.
+ *        Requires a mounted SD card.
+ * @param config NULL for CAN_LOGGER_CONFIG_DEFAULT()
+ */
+esp_err_t can_logger_start(const can_logger_config_t *config);
+
+/**
+ * @brief Writes out buffered frames, closes the file and stops the task.
+ */
+esp_err_t can_logger_stop(void);
+
+bool can_logger_is_running(void);
+
+/**
+ * @brief Queues one received frame. Single producer: called only from
+ *        canbus_ingest_frame(), which serializes the CAN task and trace
+ *        replay. Never blocks; frames are dropped and counted when both
+ *        buffers are waiting for the card.
+ */
+void can_logger_log_frame(const twai_message_t *message);
+
+void can_logger_get_stats(can_logger_stats_t *stats);
+
+/**
+ * @brief Fills a trace file header for this firmware, CRC included.
+ *        Also used by other writers of the format (event_capture.c).
+ */
+void can_logger_init_file_header(can_log_file_header_t *hdr, uint32_t file_id,
+                                 uint32_t segment, uint64_t start_time_us);
+
+/**
+ * @brief Copies the path of the segment being written ("" when stopped).
+ */
+void can_logger_get_path(char *path, size_t len);
+
+/**
+ * @brief Bytes of the segment being written that hold data, up to the last
+ *        block written (0 when stopped). The file itself is preallocated
+ *        and larger.
+ */
+long can_logger_get_data_size(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // CAN_LOGGER_H
@@ -0,0 +1,113 @@
+/*
+ * CAN Trace Replay for ECU Dashboard
+ * Feeds recorded traces through the live ingest path (canbus_ingest_frame)
+ *
+ * Supported inputs, detected from the file:
+ *   - binary logger segments (CANnnnnn.BIN, see can_log_format.h)
+ *   - the legacy text trace can_trace.csv: "ms,ID,d0,...,d7" (hex)
+ *   - CSV written by tools/canlog_convert.py ("timestamp_s,id,..." header)
+ *   - candump -L logs: "(sec.usec) can0 ID#DATA"
+ *
+ * The source and timing code only uses the C standard library, so replay
+ * also runs in a Linux host build with a caller-supplied sink
+ * (test/host/test_can_replay.c); the task and the hookup to
+ * canbus_ingest_frame() are ESP-IDF only.
+ */
+
+#ifndef CAN_REPLAY_H
+#define CAN_REPLAY_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include "can_log_reader.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum {
+    CAN_REPLAY_FORMAT_AUTO = 0,
+    CAN_REPLAY_FORMAT_BINARY,           // CANnnnnn.BIN
+    CAN_REPLAY_FORMAT_LEGACY_CSV,       // can_trace.csv
+    CAN_REPLAY_FORMAT_TOOL_CSV,         // canlog_convert.py -f csv
+    CAN_REPLAY_FORMAT_CANDUMP           // candump -L
+} can_replay_format_t;
+
+// An open trace of any supported format
+typedef struct {
+    can_replay_format_t format;
+    can_log_reader_t reader;            // Binary traces
+    FILE *text;                         // Text traces
+    uint32_t line;
+    uint32_t parse_errors;              // Text lines that were not a frame
+} can_replay_source_t;
+
+typedef struct {
+    float speed;                        // 1 = real time, N = N times faster, 0 = as fast as possible
+    bool loop;                          // Start over at the end of the trace
+} can_replay_config_t;
+
+#define CAN_REPLAY_DEFAULT_CONFIG() { .speed = 1.0f, .loop = false }
+
+typedef struct {
+    uint32_t frames;                    // Frames handed to the sink
+    uint32_t parse_errors;
+    uint32_t crc_errors;                // Binary blocks skipped
+    uint32_t loops;                     // Completed passes over the trace
+    uint64_t trace_us;                  // Trace time covered
+    uint64_t elapsed_us;                // Wall time spent
+    uint32_t max_lag_us;                // Worst lateness against the paced schedule
+} can_replay_stats_t;
+
+typedef void (*can_replay_sink_t)(const can_log_frame_t *frame, void *ctx);
+
+/**
+ * @brief Opens a trace; CAN_REPLAY_FORMAT_AUTO detects the format from
+ *        the extension and the first line.
+ * @return CAN_LOG_OK or a negative can_log_result_t
+ */
+int can_replay_open(can_replay_source_t *src, const char *path, can_replay_format_t format);
+
+/**
+ * @brief Reads the next frame. Text lines that do not parse are skipped
+ *        and counted in parse_errors.
+ * @return CAN_LOG_OK, CAN_LOG_END or a negative can_log_result_t
+ */
+int can_replay_next(can_replay_source_t *src, can_log_frame_t *frame);
+
+void can_replay_close(can_replay_source_t *src);
+
+/**
+ * @brief Replays a trace into `sink` with the configured timing. Returns
+ *        at the end of the trace (unless looping) or when *stop is set.
+ * @param stop  Polled between frames, may be NULL
+ * @param stats Filled in while running, may be NULL
+ * @return CAN_LOG_OK or a negative can_log_result_t
+ */
+int can_replay_run(const char *path, const can_replay_config_t *config,
+                   can_replay_sink_t sink, void *ctx,
+                   volatile bool *stop, can_replay_stats_t *stats);
+
+#ifdef ESP_PLATFORM
+#include "esp_err.h"
+
+/**
+ * @brief Starts replaying a trace from the SD card into canbus_ingest_frame()
+ *        in a background task. Only one replay runs at a time.
+ */
+esp_err_t can_replay_start(const char *path, const can_replay_config_t *config);
+
+// Asks the replay task to stop; returns without waiting for it
+void can_replay_stop(void);
+
+bool can_replay_is_running(void);
+
+void can_replay_get_stats(can_replay_stats_t *stats);
+#endif // ESP_PLATFORM
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // CAN_REPLAY_H
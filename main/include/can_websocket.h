@@ -5,8 +5,12 @@
 #ifndef CAN_WEBSOCKET_H
 #define CAN_WEBSOCKET_H
 
+#include <stdint.h>
+#include <stdbool.h>
 #include "esp_err.h"
 
+#define CAN_WS_MAX_CLIENTS  7       // Each also takes one of the router's stream slots
+
 // Initialize and start data server
 esp_err_t start_websocket_server(void);
 
@@ -28,6 +32,26 @@ void stop_websocket_server(void);
 void update_websocket_can_data(uint16_t rpm, uint16_t map, uint8_t tps,
                               uint8_t wastegate, uint16_t target_boost, uint8_t tcu_status);
 
+// Fan-out counters of the broadcast task
+typedef struct {
+    uint32_t clients;               // Connected WebSocket clients
+    uint32_t connects;
+    uint32_t clients_closed;        // Closed for a send error or a stalled socket
+    uint32_t ticks;                 // Ticks with at least one client due
+    uint32_t frames_sent;
+    uint32_t frames_coalesced;      // Skipped, the client got the next snapshot instead
+    uint32_t last_serialize_us;     // One JSON snapshot
+    uint32_t last_fanout_us;        // Serialization plus sending to all clients
+    uint32_t max_fanout_us;
+    uint64_t total_fanout_us;
+} can_websocket_stats_t;
+
+// Serialize one snapshot and send it to the clients that are due
+void broadcast_can_data(void);
+
+// Copy of the fan-out counters
+void can_websocket_get_stats(can_websocket_stats_t *stats);
+
 // Data broadcast task
 void websocket_broadcast_task(void *pvParameters);
 
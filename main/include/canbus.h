@@ -12,6 +12,7 @@ extern "C" {
 // CAN bus configuration for ESP32-S3
 #define CAN_TX_PIN GPIO_NUM_20  // TXD0 pin
 #define CAN_RX_PIN GPIO_NUM_19  // RXD0 pin
+#define CANBUS_BITRATE 500000   // Must match t_config in canbus.c
 
 // Standard ECU CAN IDs (example values)
 #define CAN_ID_ENGINE_RPM     0x201
@@ -27,6 +28,9 @@ esp_err_t canbus_start(void);
 esp_err_t canbus_stop(void);
 void canbus_task(void *pvParameters);
 
+// Parser, sniffer and SD trace for one received (or replayed) frame
+void canbus_ingest_frame(const twai_message_t *message);
+
 #ifdef __cplusplus
 }
 #endif
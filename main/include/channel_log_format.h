@@ -0,0 +1,136 @@
+/*
+ * Channel Log File Format for ECU Dashboard
+ * Decoded channels in a columnar layout, shared by the channel logger,
+ * the reader and host tools (tools/chlog_convert.py)
+ *
+ * A channel log is a sequence of CHANNEL_LOG_PAGE_SIZE pages, little endian:
+ *
+ *   page 0     channel_log_file_header_t, then channel_count
+ *              channel_log_channel_t (rest of the page unused)
+ *   page 1..   channel_log_page_header_t, CHANNEL_LOG_PAGE_BLOCKS
+ *              channel_log_dir_entry_t (block_count of them valid), then
+ *              the column blocks the directory points to
+ *
+ * A column block holds samples of one channel only. Time is counted in
+ * ticks of tick_us from the file's start_time_us; values are stored scaled
+ * by 10^precision as integers. The directory entry carries the first
+ * sample; each following sample is
+ *
+ *   varint      ticks since the previous sample (unsigned LEB128)
+ *   varint      value minus the previous value (zigzag, then LEB128)
+ *
+ * so a steady signal costs two bytes per sample. The entry also has the
+ * block's time span and value range, enough for a zoomed-out chart.
+ *
+ * Reading one channel means reading the 32-byte page headers, the
+ * directories of pages whose channel_mask has the channel, and that
+ * channel's blocks; blocks of other channels are never read. A channel's
+ * blocks are stored in time order.
+ *
+ * The page being filled is rewritten on every flush. The data ends at the
+ * first page whose magic, file_id or sequence does not match; a page whose
+ * header CRC fails is skipped.
+ *
+ * Only the C standard library is used so the header builds on a host.
+ */
+
+#ifndef CHANNEL_LOG_FORMAT_H
+#define CHANNEL_LOG_FORMAT_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// One page: matches allocation_unit_size in sd_card_init()
+#define CHANNEL_LOG_PAGE_SIZE       (16 * 1024)
+
+#define CHANNEL_LOG_FILE_MAGIC      0x474C4843u     // "CHLG"
+#define CHANNEL_LOG_PAGE_MAGIC      0x47415043u     // "CPAG"
+#define CHANNEL_LOG_FORMAT_VERSION  1
+
+#define CHANNEL_LOG_MAX_CHANNELS    32      // channel_mask has one bit per channel
+#define CHANNEL_LOG_PAGE_BLOCKS     48      // Directory entries per page
+#define CHANNEL_LOG_BLOCK_MAX       1024    // Largest column block
+#define CHANNEL_LOG_SAMPLE_MAX      10      // Longest encoded sample (5 + 5 bytes)
+#define CHANNEL_LOG_MAX_PRECISION   6       // Readers reject larger channel precisions
+
+typedef struct __attribute__((packed)) {
+    uint32_t magic;             // CHANNEL_LOG_FILE_MAGIC
+    uint16_t version;           // CHANNEL_LOG_FORMAT_VERSION
+    uint16_t header_size;       // sizeof(channel_log_file_header_t)
+    uint32_t page_size;         // CHANNEL_LOG_PAGE_SIZE
+    uint32_t tick_us;           // Time unit of the samples
+    uint64_t start_time_us;     // esp_timer time of tick 0
+    char firmware_version[32];  // esp_app_desc_t.version
+    uint32_t file_id;           // Random, repeated in every page header
+    uint16_t channel_count;     // channel_log_channel_t that follow the header
+    uint16_t channel_size;      // sizeof(channel_log_channel_t)
+    uint32_t crc32;             // Over the preceding bytes and the channel table
+} channel_log_file_header_t;
+
+// Channel table entry, indexed by channel number
+typedef struct __attribute__((packed)) {
+    char name[24];              // channel_def_t.name
+    char unit[8];
+    uint8_t precision;          // Values are stored multiplied by 10^precision
+    uint8_t reserved[3];
+    uint32_t period_ticks;      // Sampling period when the file was opened (0 = not logged)
+} channel_log_channel_t;
+
+typedef struct __attribute__((packed)) {
+    uint32_t magic;             // CHANNEL_LOG_PAGE_MAGIC
+    uint32_t sequence;          // Page number within the file, data pages start at 1
+    uint32_t file_id;           // channel_log_file_header_t.file_id
+    uint32_t first_tick;        // Earliest sample in the page
+    uint32_t last_tick;         // Latest sample in the page
+    uint32_t channel_mask;      // Bit n: the page has blocks of channel n
+    uint16_t block_count;       // Valid directory entries
+    uint16_t data_end;          // Page offset past the last block
+    uint32_t crc32;             // Over the valid directory entries
+} channel_log_page_header_t;
+
+typedef struct __attribute__((packed)) {
+    uint8_t channel;
+    uint8_t reserved;
+    uint16_t sample_count;      // Samples in the block, the first one included
+    uint16_t offset;            // Page offset of the encoded samples
+    uint16_t size;              // Bytes of encoded samples (0 for a single sample)
+    uint32_t first_tick;        // First sample
+    int32_t first_value;
+    uint32_t last_tick;
+    int32_t min_value;
+    int32_t max_value;
+    uint32_t crc32;             // Over the encoded samples
+} channel_log_dir_entry_t;
+
+#define CHANNEL_LOG_DATA_OFFSET \
+    (sizeof(channel_log_page_header_t) + CHANNEL_LOG_PAGE_BLOCKS * sizeof(channel_log_dir_entry_t))
+
+_Static_assert(sizeof(channel_log_page_header_t) == 32, "channel_log_page_header_t must stay 32 bytes");
+_Static_assert(sizeof(channel_log_dir_entry_t) == 32, "channel_log_dir_entry_t must stay 32 bytes");
+_Static_assert(sizeof(channel_log_file_header_t) +
+               CHANNEL_LOG_MAX_CHANNELS * sizeof(channel_log_channel_t) <= CHANNEL_LOG_PAGE_SIZE,
+               "file header and channel table must fit page 0");
+_Static_assert(CHANNEL_LOG_DATA_OFFSET + CHANNEL_LOG_BLOCK_MAX <= CHANNEL_LOG_PAGE_SIZE,
+               "a full column block must fit an empty page");
+
+/**
+ * @brief Zigzag mapping of signed deltas, so small negative values stay short.
+ */
+static inline uint32_t channel_log_zigzag(int32_t v)
+{
+    return ((uint32_t)v << 1) ^ (uint32_t)(v >> 31);
+}
+
+static inline int32_t channel_log_unzigzag(uint32_t v)
+{
+    return (int32_t)(v >> 1) ^ -(int32_t)(v & 1);
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // CHANNEL_LOG_FORMAT_H
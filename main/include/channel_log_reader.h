@@ -0,0 +1,94 @@
+/*
+ * Channel Log Reader for ECU Dashboard
+ * Reads the samples of one channel from a CHNnnnnn.COL file
+ *
+ * Pages are skipped on their 32-byte header when their channel mask or
+ * time span does not match; of the remaining pages only the directory and
+ * the selected channel's blocks are read.
+ *
+ * Only the C standard library is used so the reader also builds on a host.
+ */
+
+#ifndef CHANNEL_LOG_READER_H
+#define CHANNEL_LOG_READER_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
+#include "channel_log_format.h"
+#include "can_log_reader.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Results are the can_log_result_t values of the trace reader
+
+// One decoded sample
+typedef struct {
+    uint64_t time_us;                   // Absolute esp_timer time (µs since boot)
+    double value;                       // Scaled back by 10^precision
+} channel_log_sample_t;
+
+typedef struct {
+    FILE *file;
+    channel_log_file_header_t header;
+    channel_log_channel_t channels[CHANNEL_LOG_MAX_CHANNELS];
+
+    // Selection
+    uint8_t channel;
+    uint32_t from_tick;
+    uint32_t to_tick;                   // Inclusive
+    double scale;                       // 1 / 10^precision
+
+    // Position
+    uint32_t page_seq;                  // Next page to look at
+    channel_log_dir_entry_t *dir;       // Directory of the current page
+    uint16_t dir_count;
+    uint16_t dir_pos;                   // Next entry to look at
+    uint8_t *block;                     // Encoded samples of the current block
+    uint16_t block_size;
+    uint16_t block_pos;
+    uint16_t samples_left;              // Samples of the current block not yet returned
+    bool first_pending;                 // The first one, taken from the directory entry
+    uint32_t tick;                      // Last decoded sample
+    int32_t value;
+
+    uint32_t pages_read;                // Directories read
+    uint32_t blocks_read;
+    uint32_t crc_errors;                // Pages or blocks skipped
+} channel_log_reader_t;
+
+/**
+ * @brief Opens a channel log and reads its header and channel table.
+ * @return CAN_LOG_OK or a negative can_log_result_t
+ */
+int channel_log_reader_open(channel_log_reader_t *r, const char *path);
+
+void channel_log_reader_close(channel_log_reader_t *r);
+
+/**
+ * @brief Index of a channel in the file's table by name, or -1.
+ */
+int channel_log_reader_find(const channel_log_reader_t *r, const char *name);
+
+/**
+ * @brief Starts reading one channel between two times relative to the
+ *        file's start_time_us.
+ * @param to_us 0 = to the end
+ * @return CAN_LOG_OK or CAN_LOG_ERR_INVALID
+ */
+int channel_log_reader_select(channel_log_reader_t *r, uint8_t channel, uint64_t from_us, uint64_t to_us);
+
+/**
+ * @brief Reads the next sample of the selected channel.
+ * @return CAN_LOG_OK, CAN_LOG_END or a negative can_log_result_t
+ */
+int channel_log_reader_next(channel_log_reader_t *r, channel_log_sample_t *sample);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // CHANNEL_LOG_READER_H
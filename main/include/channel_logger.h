@@ -0,0 +1,105 @@
+/*
+ * Channel Logger for ECU Dashboard
+ * Decoded channels sampled at per-channel rates into columnar SD files
+ *
+ * Alongside the raw CAN trace, a timer samples the registry channels, each
+ * at its own period, and delta-encodes every channel into its own column
+ * block. Closed blocks are packed into 16 KB pages that the logger task
+ * writes to /sdcard/CHNnnnnn.COL; the layout is in channel_log_format.h.
+ *
+ * A chart or export of one channel reads only that channel's blocks and
+ * needs no DBC. A channel that was not updated since its last sample is
+ * not sampled again, so stale values are not repeated in the log.
+ */
+
+#ifndef CHANNEL_LOGGER_H
+#define CHANNEL_LOGGER_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "esp_err.h"
+#include "channel_registry.h"
+#include "channel_log_format.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Files are numbered across sessions: /sdcard/CHN00001.COL, CHN00002.COL, ...
+#ifndef CHANNEL_LOGGER_DIR         // The host tests log into their build directory
+#define CHANNEL_LOGGER_DIR      "/sdcard"
+#endif
+#define CHANNEL_LOGGER_PREFIX   "CHN"
+#define CHANNEL_LOGGER_EXT      ".COL"
+
+typedef struct {
+    uint32_t tick_ms;               // Sampling timer period; channel periods are multiples of it
+    uint32_t default_period_ms;     // Channels without an entry in the built-in rate table
+    uint32_t flush_interval_ms;     // Open blocks are closed and written at least this often
+    uint32_t file_size_mb;          // A new file is started beyond this size
+    uint32_t retention_files;       // Oldest files are deleted beyond this count (min 2)
+} channel_logger_config_t;
+
+#define CHANNEL_LOGGER_CONFIG_DEFAULT() { \
+    .tick_ms = 10,                        \
+    .default_period_ms = 100,             \
+    .flush_interval_ms = 10000,           \
+    .file_size_mb = 16,                   \
+    .retention_files = 32,                \
+}
+
+typedef struct {
+    uint32_t samples_logged;
+    uint32_t samples_stale;         // Skipped: no update since the last sample
+    uint32_t blocks_closed;
+    uint32_t blocks_dropped;        // Both pages waiting for the card
+    uint32_t pages_written;         // Full pages
+    uint64_t bytes_written;         // Partial page rewrites included
+    uint32_t write_errors;
+    uint32_t max_write_us;
+    uint32_t max_sample_us;         // Longest sampling timer callback
+    uint32_t files_created;
+    uint32_t files_deleted;         // Removed by the retention limit
+} channel_logger_stats_t;
+
+/**
+ * @brief Sets the sampling period of a channel, rounded to the timer tick.
+ *        May be called before the logger starts or while it runs; the file
+ *        header records the periods in force when the file was opened.
+ * @param period_ms 0 stops logging the channel
+ * @return ESP_OK or ESP_ERR_INVALID_ARG for an unknown channel
+ */
+esp_err_t channel_logger_set_period(channel_id_t id, uint32_t period_ms);
+
+/**
+ * @brief Current sampling period of a channel in ms (0 = not logged).
+ */
+uint32_t channel_logger_get_period(channel_id_t id);
+
+/**
+ * @brief Allocates the column and page buffers, opens the next CHNnnnnn.COL
+ *        and starts sampling. Requires a mounted SD card.
+ * @param config NULL for CHANNEL_LOGGER_CONFIG_DEFAULT()
+ */
+esp_err_t channel_logger_start(const channel_logger_config_t *config);
+
+/**
+ * @brief Closes the open blocks, writes them out and stops the task.
+ */
+esp_err_t channel_logger_stop(void);
+
+bool channel_logger_is_running(void);
+
+void channel_logger_get_stats(channel_logger_stats_t *stats);
+
+/**
+ * @brief Copies the path of the file being written ("" when stopped).
+ */
+void channel_logger_get_path(char *path, size_t len);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // CHANNEL_LOGGER_H
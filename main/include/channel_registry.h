@@ -0,0 +1,161 @@
+/*
+ * Channel Registry for ECU Dashboard
+ * Numbered data channels with metadata, stored in one dense array
+ */
+
+#ifndef CHANNEL_REGISTRY_H
+#define CHANNEL_REGISTRY_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Maximum number of channels (built-in + runtime definitions)
+#define CHANNEL_MAX             32
+#define CHANNEL_NAME_MAX_LEN    24
+#define CHANNEL_UNIT_MAX_LEN    8
+
+// Built-in channels. The numbering is stable: decoders, the UI, the logger
+// and the web API all address channels by these indices.
+typedef enum {
+    // Engine Parameters
+    CH_ENGINE_RPM = 0,
+    CH_TPS_POSITION,
+    CH_ABS_PEDAL_POS,
+    CH_MAP_KPA,
+
+    // Boost Control
+    CH_WG_SET_PERCENT,
+    CH_WG_POS_PERCENT,
+    CH_BOV_PERCENT,
+    CH_TARGET_BOOST_KPA,
+
+    // Torque Values (Nm)
+    CH_TCU_TQ_REQ_NM,
+    CH_TCU_TQ_ACT_NM,
+    CH_ENG_TRG_NM,
+    CH_ENG_ACT_NM,
+    CH_LIMIT_TQ_NM,
+
+    // Engine health (Screen2)
+    CH_OIL_PRESSURE_BAR,
+    CH_OIL_TEMP_C,
+    CH_WATER_TEMP_C,
+    CH_FUEL_PRESSURE_BAR,
+    CH_BATTERY_V,
+
+    // Status (alarm levels: 0=OK, 1=WARNING, 2=ERROR)
+    CH_TCU_STATUS,
+
+    CH_BUILTIN_COUNT
+} channel_builtin_t;
+
+typedef uint8_t channel_id_t;
+
+#define CHANNEL_INVALID 0xFF
+
+// Encoded width used when a channel is written to logs or telemetry frames.
+// Values are scaled by 10^precision before being stored in this type.
+typedef enum {
+    CH_STORAGE_U8 = 0,
+    CH_STORAGE_U16,
+    CH_STORAGE_I16,
+    CH_STORAGE_I32,
+    CH_STORAGE_FLOAT
+} channel_storage_t;
+
+// Channel metadata
+typedef struct {
+    char name[CHANNEL_NAME_MAX_LEN];    // Key used in JSON/CSV ("engine_rpm")
+    char unit[CHANNEL_UNIT_MAX_LEN];    // Display unit ("kPa")
+    float min;                          // Display range minimum
+    float max;                          // Display range maximum
+    uint8_t precision;                  // Decimal places shown/encoded
+    channel_storage_t storage;          // Encoded width for logs/telemetry
+} channel_def_t;
+
+// Consistent copy of the first `count` channels
+typedef struct {
+    uint8_t count;
+    int64_t timestamp_us;               // Time of the copy
+    float values[CHANNEL_MAX];
+    uint32_t seq[CHANNEL_MAX];          // Per-channel update counters
+} channel_snapshot_t;
+
+// Called from the writer's context after a channel takes a new value
+typedef void (*channel_listener_t)(channel_id_t id, float value);
+
+#define CHANNEL_MAX_LISTENERS   4
+
+/**
+ * @brief Fills the registry from the compile-time table. Safe to call twice.
+ */
+void channel_registry_init(void);
+
+/**
+ * @brief Appends a runtime channel definition after the built-in ones.
+ * @param def Channel metadata (copied)
+ * @param out_id Receives the new channel index (may be NULL)
+ * @return ESP_OK, ESP_ERR_INVALID_ARG, ESP_ERR_INVALID_STATE if the name is
+ *         already taken, or ESP_ERR_NO_MEM if the registry is full
+ */
+esp_err_t channel_registry_define(const channel_def_t *def, channel_id_t *out_id);
+
+/**
+ * @brief Number of channels in use (built-in + runtime).
+ */
+uint8_t channel_count(void);
+
+/**
+ * @brief Channel metadata by index, or NULL if the index is not in use.
+ */
+const channel_def_t *channel_get_def(channel_id_t id);
+
+/**
+ * @brief Looks a channel up by name. Linear, meant for setup code only.
+ * @return Channel index or CHANNEL_INVALID
+ */
+channel_id_t channel_find(const char *name);
+
+/**
+ * @brief Stores a new value. O(1), callable from any task.
+ */
+void channel_set(channel_id_t id, float value);
+
+/**
+ * @brief Returns the latest value (0 for unknown channels).
+ */
+float channel_get(channel_id_t id);
+
+/**
+ * @brief Update counter of a channel; 0 means it was never written.
+ */
+uint32_t channel_get_seq(channel_id_t id);
+
+/**
+ * @brief Time of the last update of a channel (esp_timer microseconds).
+ */
+int64_t channel_get_timestamp(channel_id_t id);
+
+/**
+ * @brief Registers a listener notified when a channel value changes.
+ *        Writes of an unchanged value do not notify. Listeners must be quick:
+ *        they run in the CAN task (or whichever task called channel_set).
+ * @return ESP_OK, ESP_ERR_INVALID_ARG or ESP_ERR_NO_MEM if all slots are used
+ */
+esp_err_t channel_registry_add_listener(channel_listener_t listener);
+
+/**
+ * @brief Copies all channels in use in one critical section.
+ */
+void channel_snapshot(channel_snapshot_t *snap);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // CHANNEL_REGISTRY_H
@@ -5,35 +5,13 @@
 #include <stdbool.h>
 #include "freertos/FreeRTOS.h"
 #include "freertos/semphr.h"
+#include "channel_registry.h"
+#include "json_writer.h"
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
-// ECU Data structure based on VW CAN bus spec
-typedef struct {
-    // Engine Parameters
-    float engine_rpm;
-    float tps_position;
-    float abs_pedal_pos;
-    float map_kpa;
-
-    // Boost Control
-    float wg_set_percent;
-    float wg_pos_percent;
-    float bov_percent;
-
-    // Torque Values (Nm)
-    float tcu_tq_req_nm;
-    float tcu_tq_act_nm;
-    float eng_trg_nm;
-    float eng_act_nm;
-    float limit_tq_nm;
-
-    // System
-    uint64_t timestamp;
-} ecu_data_t;
-
 // System settings
 typedef struct {
     float max_boost_limit;       // Maximum boost limit
@@ -63,13 +41,16 @@ typedef struct {
 } data_stream_entry_t;
 
 // Function prototypes
+// ECU values themselves live in the channel registry (channel_registry.h)
 void ecu_data_init(void);
-void ecu_data_update(ecu_data_t *data);
-ecu_data_t* ecu_data_get(void); // Unsafe, for internal use
-void ecu_data_get_copy(ecu_data_t *data_copy); // Thread-safe getter
-char* ecu_data_to_json(const ecu_data_t *data);
-bool ecu_data_from_json(const char *json_str, ecu_data_t *data);
-void ecu_data_simulate(ecu_data_t *data);
+void ecu_data_write_json(json_writer_t *w);
+void ecu_data_simulate(void);
+
+// Live values for every web transport (/data, /data.bin, /events, /ws).
+// In demo mode the gauge channels carry generated values instead.
+void ecu_data_live_snapshot(channel_snapshot_t *snap);
+// Gauge object of a live snapshot: {"map_pressure":..,...,"tcu_status":..}
+void ecu_data_write_gauges_json(json_writer_t *w, const channel_snapshot_t *snap);
 
 // System settings functions
 void system_settings_init(void);
@@ -79,10 +60,10 @@ void system_settings_save(const system_settings_t *settings);
 // Logging functions
 void data_stream_add_entry(const char *message, log_type_t type);
 void data_stream_clear(void);
-char* data_stream_to_json(void);
+void data_stream_write_json(json_writer_t *w);
 
 // Simple data functions for WiFi server
-char* ecu_data_to_string(const ecu_data_t *data);
+char* ecu_data_to_string(void);
 char* data_stream_to_string(void);
 
 #ifdef __cplusplus
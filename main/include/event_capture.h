@@ -0,0 +1,114 @@
+/*
+ * Event Capture for ECU Dashboard
+ * Pre-trigger ring of raw CAN frames and channel samples, saved around events
+ *
+ * Every received frame is copied into a PSRAM ring holding the last
+ * pre_trigger_s seconds of traffic; a timer samples all channels into a
+ * second ring. When a trigger fires (an alarm rule reaching a level, a
+ * CAN identifier on the bus, or the EVENT button on Screen3) the capture
+ * task writes the pre-trigger window and the following post_trigger_s
+ * seconds to the SD card:
+ *
+ *   /sdcard/EVTnnnnn.BIN   raw frames, trace format of can_log_format.h
+ *                          (readable by can_log_reader and canlog_convert.py)
+ *   /sdcard/EVTnnnnn.CSV   channel samples, time relative to the trigger
+ *
+ * The receive path only reserves a slot and copies the frame; it never
+ * takes a lock and never waits for the card. Triggers that fire while an
+ * event is being saved are counted and ignored.
+ */
+
+#ifndef EVENT_CAPTURE_H
+#define EVENT_CAPTURE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "esp_err.h"
+#include "driver/twai.h"
+#include "alarm_engine.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define EVENT_CAPTURE_DIR           "/sdcard"
+#define EVENT_CAPTURE_PREFIX        "EVT"
+#define EVENT_CAPTURE_MAX_ALARMS    8
+#define EVENT_CAPTURE_MAX_CAN_IDS   8
+#define EVENT_CAPTURE_REASON_LEN    24
+
+typedef struct {
+    uint32_t pre_trigger_s;         // History kept before the trigger
+    uint32_t post_trigger_s;        // Recorded after the trigger
+    uint32_t max_frame_rate;        // Frames per second the frame ring is sized for
+    uint32_t sample_period_ms;      // Channel sampling period
+} event_capture_config_t;
+
+#define EVENT_CAPTURE_CONFIG_DEFAULT() { \
+    .pre_trigger_s = 10,                 \
+    .post_trigger_s = 5,                 \
+    .max_frame_rate = 4000,              \
+    .sample_period_ms = 50,              \
+}
+
+typedef struct {
+    uint32_t events_saved;
+    uint32_t triggers_ignored;      // Fired while an event was being saved
+    uint32_t frames_saved;
+    uint32_t frames_lost;           // Overwritten before the capture task copied them
+    uint32_t samples_saved;
+    uint32_t write_errors;
+    uint32_t last_event;            // Number of the last EVTnnnnn file (0 = none)
+    char last_reason[EVENT_CAPTURE_REASON_LEN];
+} event_capture_stats_t;
+
+/**
+ * @brief Allocates the rings in PSRAM, starts channel sampling and the
+ *        capture task, and watches the CRITICAL level of the temperature
+ *        and battery alarms. The alarm engine must be initialized first;
+ *        events can only be saved while the SD card is mounted.
+ * @param config NULL for EVENT_CAPTURE_CONFIG_DEFAULT()
+ */
+esp_err_t event_capture_init(const event_capture_config_t *config);
+
+/**
+ * @brief Copies one received frame into the ring and checks the CAN
+ *        identifier triggers. Called from canbus_ingest_frame(); lock-free
+ *        and safe with several producers (CAN task and trace replay).
+ */
+void event_capture_frame(const twai_message_t *message);
+
+/**
+ * @brief Saves an event when a rule rises to `level` or above.
+ *        A channel threshold is an alarm rule added with alarm_engine_add_rule().
+ * @return ESP_OK, ESP_ERR_INVALID_STATE or ESP_ERR_NO_MEM if all slots are used
+ */
+esp_err_t event_capture_watch_alarm(alarm_id_t id, alarm_level_t level);
+
+/**
+ * @brief Saves an event when a frame with (identifier & mask) == (id & mask)
+ *        is received.
+ * @return ESP_OK, ESP_ERR_INVALID_STATE or ESP_ERR_NO_MEM if all slots are used
+ */
+esp_err_t event_capture_watch_can_id(uint32_t id, uint32_t mask);
+
+/**
+ * @brief Triggers an event now (EVENT button, web). Does not block.
+ * @param reason Short label stored with the event ("manual"), copied
+ * @return ESP_OK, ESP_ERR_INVALID_STATE if not initialized or ESP_ERR_TIMEOUT
+ *         while an event is still being saved
+ */
+esp_err_t event_capture_trigger(const char *reason);
+
+/**
+ * @brief true from a trigger until its files are written.
+ */
+bool event_capture_is_busy(void);
+
+void event_capture_get_stats(event_capture_stats_t *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // EVENT_CAPTURE_H
@@ -0,0 +1,43 @@
+/*
+ * HTTP Range header parsing for ECU Dashboard
+ * Used by the log download (log_download.c) to serve "Range: bytes=" requests
+ *
+ * Only a single byte range is honoured:
+ *   bytes=100-199      first and last byte (the last is clipped to the file)
+ *   bytes=100-         from byte 100 to the end
+ *   bytes=-500         the last 500 bytes
+ * Several ranges, other units and malformed values are ignored and the whole
+ * file is sent, as RFC 9110 allows. A range that starts past the end of the
+ * file cannot be satisfied (416).
+ *
+ * Only uses the C standard library, so it builds on a host for tests
+ * (test/host/test_log_download.c).
+ */
+
+#ifndef HTTP_RANGE_H
+#define HTTP_RANGE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum {
+    HTTP_RANGE_UNSATISFIABLE = -1,  // Answer 416 with "Content-Range: bytes */size"
+    HTTP_RANGE_NONE = 0,            // Send the whole file
+    HTTP_RANGE_OK = 1               // Send *start..*end with 206
+} http_range_result_t;
+
+/**
+ * @brief Parses the value of a Range header against the file size.
+ * @param value Header value, e.g. "bytes=0-1023"
+ * @param size Bytes of the file that can be sent
+ * @param start Receives the first byte (HTTP_RANGE_OK only)
+ * @param end Receives the last byte, inclusive (HTTP_RANGE_OK only)
+ */
+http_range_result_t http_range_parse(const char *value, long size, long *start, long *end);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // HTTP_RANGE_H
@@ -0,0 +1,58 @@
+/*
+ * Log Download for ECU Dashboard
+ * Lists the files on the SD card and streams them over HTTP
+ *
+ *   GET /logs                  JSON list of files and transfer counters
+ *   GET /logs/CAN00001.BIN     the file, honouring a single "Range: bytes=" range
+ *   GET /logs/CAN00001.BIN?format=csv&from=10&to=20
+ *                              trace transcoded to CSV on the fly (same
+ *                              columns as tools/canlog_convert.py), optionally
+ *                              limited to seconds from the start of the file
+ *   GET /logs/CHN00001.COL?format=csv&channel=engine_rpm&from=10&to=20
+ *                              one channel of a channel log as CSV, reading
+ *                              only that channel's blocks
+ *
+ * Requests are handed to download workers with the httpd async API, so a
+ * slow client only occupies its worker and the server keeps answering
+ * others. A transfer holds one of the shared server's stream slots. Files are read and sent through one fixed buffer per worker;
+ * the segment being logged is served up to its last written block.
+ */
+
+#ifndef LOG_DOWNLOAD_H
+#define LOG_DOWNLOAD_H
+
+#include <stdint.h>
+#include "esp_err.h"
+#include "esp_http_server.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define LOG_DOWNLOAD_WORKERS        2
+#define LOG_DOWNLOAD_CHUNK_SIZE     4096    // Read and send buffer of each worker
+
+typedef struct {
+    uint32_t downloads;             // Completed transfers
+    uint32_t aborted;               // Client gone or read error mid-transfer
+    uint32_t rejected;              // All workers or stream slots busy (503)
+    uint32_t range_requests;        // Served as 206 Partial Content
+    uint32_t active;                // Transfers in progress
+    uint64_t bytes_sent;
+    uint32_t last_kbps;             // Throughput of the last transfer, KB/s
+    uint32_t best_kbps;             // Best transfer of at least LOG_DOWNLOAD_CHUNK_SIZE * 16 bytes
+} log_download_stats_t;
+
+/**
+ * @brief Starts the workers and adds /logs and the /logs/<file> wildcard
+ *        to the shared server's routes.
+ */
+esp_err_t log_download_register(void);
+
+void log_download_get_stats(log_download_stats_t *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // LOG_DOWNLOAD_H
@@ -0,0 +1,94 @@
+/*
+ * NVS Write-Behind Cache for ECU Dashboard
+ * Keeps NVS blobs in RAM and batches their flash writes
+ *
+ * Writes only update the RAM copy and mark the key dirty. Dirty keys are
+ * written after a quiet period without further writes, or at the latest a
+ * deadline after the first unwritten change, with one nvs_open/commit per
+ * namespace. A key changed several times in between costs one flash write.
+ *
+ * The flush runs as a background job. It is also run directly on
+ * esp_restart() and queued at high priority when the battery alarm goes
+ * critical, so a dying supply does not lose pending changes.
+ *
+ * Reads are served from RAM; a miss reads NVS once and keeps the result,
+ * including "not found".
+ */
+
+#ifndef NVS_CACHE_H
+#define NVS_CACHE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define NVS_CACHE_MAX_ENTRIES   16
+#define NVS_CACHE_NAME_SIZE     16      // NVS namespace and key limit, with the terminator
+
+typedef struct {
+    uint32_t quiet_ms;              // Flush after this long without a write
+    uint32_t deadline_ms;           // ...but no later than this after the first unwritten change
+} nvs_cache_config_t;
+
+#define NVS_CACHE_CONFIG_DEFAULT() { \
+    .quiet_ms = 2000,                \
+    .deadline_ms = 15000,            \
+}
+
+typedef struct {
+    uint32_t sets;                  // nvs_cache_set_blob() calls
+    uint32_t erases;
+    uint32_t writes_avoided;        // Changes to a key that was still dirty
+    uint32_t write_through;         // Table full of dirty keys: written directly
+    uint32_t flushes;
+    uint32_t commits;               // One per namespace and flush
+    uint32_t keys_written;
+    uint32_t flush_errors;
+    uint32_t read_hits;
+    uint32_t read_misses;
+    uint32_t dirty;                 // Keys waiting for the next flush
+    uint32_t max_flush_us;
+} nvs_cache_stats_t;
+
+/**
+ * @brief Creates the flush timer, registers the shutdown handler and
+ *        subscribes to the battery alarm. NVS flash must be initialised.
+ * @param config NULL for NVS_CACHE_CONFIG_DEFAULT()
+ */
+esp_err_t nvs_cache_init(const nvs_cache_config_t *config);
+
+/**
+ * @brief Stores a blob in the cache and schedules the flush. Does not touch
+ *        flash unless the table is full of dirty keys.
+ */
+esp_err_t nvs_cache_set_blob(const char *namespace, const char *key, const void *value, size_t size);
+
+/**
+ * @brief Reads a blob like nvs_get_blob(): `value` NULL returns the size.
+ * @return ESP_OK, ESP_ERR_NVS_NOT_FOUND or ESP_ERR_NVS_INVALID_LENGTH
+ */
+esp_err_t nvs_cache_get_blob(const char *namespace, const char *key, void *value, size_t *size);
+
+/**
+ * @brief Removes a key; the erase is written with the next flush.
+ */
+esp_err_t nvs_cache_erase_key(const char *namespace, const char *key);
+
+/**
+ * @brief Writes all dirty keys now (blocking, one commit per namespace).
+ *        Normally run by the background task.
+ */
+esp_err_t nvs_cache_flush(void);
+
+void nvs_cache_get_stats(nvs_cache_stats_t *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // NVS_CACHE_H
@@ -0,0 +1,117 @@
+/*
+ * Binary Telemetry Frame for ECU Dashboard
+ * Compact, versioned encoding of channel values for web and socket clients
+ *
+ * Frame layout (little endian):
+ *   [0]      version (TELEMETRY_FRAME_VERSION)
+ *   [1]      flags (TELEMETRY_FLAG_*)
+ *   [2..3]   sequence number, +1 per frame of a stream
+ *   [4..7]   timestamp in milliseconds
+ *   [8]      channel count N
+ *   [9..]    presence bitmap, (N + 7) / 8 bytes, bit i = channel i follows
+ *   [...]    one zigzag varint per present channel, in channel order:
+ *            keyframes carry the fixed-point value (value * 10^precision),
+ *            delta frames carry the difference to the previous frame
+ *
+ * /data.bin answers every poll with a keyframe; WebSocket clients on
+ * /ws?format=bin get a delta stream with one encoder per client.
+ *
+ * The codec itself only uses the C standard library so the same file builds
+ * on a host for decoder tests; the registry glue is ESP-IDF only.
+ */
+
+#ifndef TELEMETRY_FRAME_H
+#define TELEMETRY_FRAME_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define TELEMETRY_FRAME_VERSION     1
+#define TELEMETRY_MAX_CHANNELS      32
+#define TELEMETRY_HEADER_SIZE       9
+
+// Worst case: header + full bitmap + 5-byte varint per channel
+#define TELEMETRY_FRAME_MAX_SIZE    (TELEMETRY_HEADER_SIZE + TELEMETRY_MAX_CHANNELS / 8 + TELEMETRY_MAX_CHANNELS * 5)
+
+// A stream sends a keyframe at least this often so late decoders resync
+#define TELEMETRY_KEYFRAME_INTERVAL 50
+
+#define TELEMETRY_FLAG_KEYFRAME     0x01
+
+// Decoder results
+typedef enum {
+    TELEMETRY_OK = 0,
+    TELEMETRY_ERR_TRUNCATED = -1,       // Frame shorter than its header/bitmap/values
+    TELEMETRY_ERR_VERSION = -2,         // Unknown frame version
+    TELEMETRY_ERR_NEED_KEYFRAME = -3,   // Delta frame without a matching previous frame
+    TELEMETRY_ERR_NO_SPACE = -4,        // Output buffer too small (encoder)
+    TELEMETRY_ERR_INVALID = -5          // Bad arguments or channel count
+} telemetry_result_t;
+
+// Per-stream encoder state (one per connected client)
+typedef struct {
+    uint16_t seq;
+    uint16_t frames_since_key;
+    bool have_key;
+    uint8_t count;                      // Channel count of the last frame
+    uint32_t known_mask;                // Channels the decoder already holds
+    int32_t last[TELEMETRY_MAX_CHANNELS];
+} telemetry_encoder_t;
+
+// Decoder state mirroring one encoder
+typedef struct {
+    uint16_t seq;
+    bool synced;
+    uint8_t count;
+    uint32_t known_mask;
+    uint32_t timestamp_ms;
+    int32_t values[TELEMETRY_MAX_CHANNELS];   // Fixed-point values
+} telemetry_decoder_t;
+
+void telemetry_encoder_init(telemetry_encoder_t *enc);
+
+/**
+ * @brief Encodes one frame.
+ * @param fixed Fixed-point value per channel (value * 10^precision)
+ * @param present_mask Bit i set if channel i has a value
+ * @param keyframe Force a keyframe; one is also sent for the first frame,
+ *        every TELEMETRY_KEYFRAME_INTERVAL frames and whenever the channel
+ *        count changes (decoders refuse deltas across a count change)
+ * @return Frame length in bytes, or a negative telemetry_result_t
+ */
+int telemetry_frame_encode(telemetry_encoder_t *enc, uint8_t count, const int32_t *fixed,
+                           uint32_t present_mask, uint32_t timestamp_ms, bool keyframe,
+                           uint8_t *out, size_t cap);
+
+void telemetry_decoder_init(telemetry_decoder_t *dec);
+
+/**
+ * @brief Applies one frame to the decoder state.
+ * @param updated_mask Receives the channels carried by this frame (may be NULL)
+ * @return TELEMETRY_OK or a negative telemetry_result_t; after an error the
+ *         decoder waits for the next keyframe
+ */
+int telemetry_frame_decode(telemetry_decoder_t *dec, const uint8_t *data, size_t len,
+                           uint32_t *updated_mask);
+
+#ifdef ESP_PLATFORM
+#include "channel_registry.h"
+
+/**
+ * @brief Encodes the channels of a snapshot. Channels never written
+ *        (seq == 0) are left out.
+ */
+int telemetry_frame_encode_snapshot(telemetry_encoder_t *enc, const channel_snapshot_t *snap,
+                                    bool keyframe, uint8_t *out, size_t cap);
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // TELEMETRY_FRAME_H
@@ -0,0 +1,54 @@
+/*
+ * Web Assets for ECU Dashboard
+ * Pages, styles and scripts compressed at build time
+ *
+ * The files in main/web are gzipped by tools/web_assets.py during the
+ * build and linked in as constant tables with their length and an ETag.
+ * web_asset_send() answers with the stored bytes and
+ * "Content-Encoding: gzip", or with 304 and no body when the browser
+ * already holds the same version (If-None-Match).
+ */
+
+#ifndef WEB_ASSETS_H
+#define WEB_ASSETS_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "esp_err.h"
+#include "esp_http_server.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct {
+    const char *name;               // File name in main/web, e.g. "dashboard.css"
+    const char *content_type;
+    const char *cache_control;
+    const char *etag;               // Quoted, from the uncompressed content
+    const uint8_t *data;            // gzip stream
+    size_t len;
+    size_t raw_len;                 // Uncompressed size
+} web_asset_t;
+
+// Generated table (web_assets_data.c in the build directory)
+extern const web_asset_t web_assets[];
+extern const size_t web_asset_count;
+
+/**
+ * @brief Looks up an asset by file name.
+ * @return The asset or NULL
+ */
+const web_asset_t *web_asset_find(const char *name);
+
+/**
+ * @brief Sends an asset, or 304 when If-None-Match carries its ETag.
+ *        A NULL asset is answered with 404.
+ */
+esp_err_t web_asset_send(httpd_req_t *req, const web_asset_t *asset);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // WEB_ASSETS_H
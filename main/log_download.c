@@ -0,0 +1,534 @@
+/*
+ * Log Download for ECU Dashboard
+ * The httpd task only validates a request and queues it; download workers
+ * stream the file (or its CSV transcoding) in fixed-size chunks
+ */
+
+#include "include/log_download.h"
+#include "include/http_range.h"
+#include "include/can_logger.h"
+#include "include/can_log_reader.h"
+#include "include/channel_logger.h"
+#include "include/channel_log_reader.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/queue.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "json_writer.h"
+#include "http_router.h"
+#include <dirent.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <sys/stat.h>
+
+static const char *TAG = "LOG_DOWNLOAD";
+
+#define DOWNLOAD_TASK_STACK_SIZE    4096
+#define DOWNLOAD_TASK_PRIORITY      2       // Below the CAN logger (4) and the httpd task (5)
+#define DOWNLOAD_NAME_MAX           16      // 8.3 names
+#define DOWNLOAD_CSV_LINE_MAX       64      // Longest CSV line, newline included
+#define DOWNLOAD_RETRY_AFTER_S      "2"
+
+typedef struct {
+    httpd_req_t *req;           // Async copy, completed by the worker
+    char path[48];
+    char name[DOWNLOAD_NAME_MAX];
+    bool csv;
+    char channel[CHANNEL_NAME_MAX_LEN]; // CSV of a channel log: the channel to export
+    bool partial;               // Answer with 206 and Content-Range
+    long start;                 // Raw: first and last byte to send
+    long end;
+    long size;                  // Raw: bytes of the file that hold data
+    uint64_t from_us;           // CSV: window relative to the start of the file
+    uint64_t to_us;             // 0 = to the end
+} download_job_t;
+
+static QueueHandle_t download_queue = NULL;
+static log_download_stats_t download_stats;
+static portMUX_TYPE download_lock = portMUX_INITIALIZER_UNLOCKED;
+
+// ============================================================================
+// REQUEST PARSING (httpd task)
+// ============================================================================
+
+/**
+ * @brief Copies the file name after /logs/ without the query string.
+ *        Only plain names in the card root are accepted.
+ */
+static bool download_name_from_uri(const char *uri, char *name, size_t len)
+{
+    const char *start = uri + strlen("/logs/");
+    size_t n = strcspn(start, "?");
+    if (n == 0 || n >= len) {
+        return false;
+    }
+    memcpy(name, start, n);
+    name[n] = '\0';
+    return strchr(name, '/') == NULL && strstr(name, "..") == NULL;
+}
+
+static uint64_t download_query_seconds(const char *query, const char *key)
+{
+    char value[16];
+    if (httpd_query_key_value(query, key, value, sizeof(value)) != ESP_OK) {
+        return 0;
+    }
+    double seconds = strtod(value, NULL);
+    return seconds > 0 ? (uint64_t)(seconds * 1e6) : 0;
+}
+
+static esp_err_t download_send_status(httpd_req_t *req, const char *status, const char *text)
+{
+    httpd_resp_set_status(req, status);
+    httpd_resp_set_type(req, "text/plain");
+    return httpd_resp_sendstr(req, text);
+}
+
+static esp_err_t log_file_handler(httpd_req_t *req)
+{
+    download_job_t job = { 0 };
+
+    if (!download_name_from_uri(req->uri, job.name, sizeof(job.name))) {
+        httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Invalid file name");
+        return ESP_FAIL;
+    }
+    snprintf(job.path, sizeof(job.path), "%s/%s", CAN_LOGGER_DIR, job.name);
+
+    struct stat st;
+    if (stat(job.path, &st) != 0 || !S_ISREG(st.st_mode)) {
+        httpd_resp_send_404(req);
+        return ESP_FAIL;
+    }
+    job.size = (long)st.st_size;
+
+    // The segment being logged is preallocated; only its written part is data
+    char active[32];
+    can_logger_get_path(active, sizeof(active));
+    if (strcmp(active, job.path) == 0) {
+        job.size = can_logger_get_data_size();
+    }
+
+    char query[96];
+    if (httpd_req_get_url_query_str(req, query, sizeof(query)) == ESP_OK) {
+        char format[8];
+        if (httpd_query_key_value(query, "format", format, sizeof(format)) == ESP_OK &&
+            strcmp(format, "csv") == 0) {
+            job.csv = true;
+            job.from_us = download_query_seconds(query, "from");
+            job.to_us = download_query_seconds(query, "to");
+            httpd_query_key_value(query, "channel", job.channel, sizeof(job.channel));
+        }
+    }
+
+    // Channel logs are exported one column at a time
+    size_t name_len = strlen(job.name);
+    size_t ext_len = strlen(CHANNEL_LOGGER_EXT);
+    bool channel_log = name_len > ext_len && strcasecmp(job.name + name_len - ext_len, CHANNEL_LOGGER_EXT) == 0;
+    if (job.csv && channel_log != (job.channel[0] != '\0')) {
+        httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST,
+                            channel_log ? "channel= is required for channel logs" : "channel= needs a channel log");
+        return ESP_FAIL;
+    }
+
+    job.start = 0;
+    job.end = job.size - 1;
+    char range[48];
+    if (!job.csv && httpd_req_get_hdr_value_str(req, "Range", range, sizeof(range)) == ESP_OK) {
+        http_range_result_t ret = http_range_parse(range, job.size, &job.start, &job.end);
+        if (ret == HTTP_RANGE_UNSATISFIABLE) {
+            char content_range[32];
+            snprintf(content_range, sizeof(content_range), "bytes */%ld", job.size);
+            httpd_resp_set_hdr(req, "Content-Range", content_range);
+            return download_send_status(req, "416 Range Not Satisfiable", "Range not satisfiable");
+        }
+        job.partial = ret == HTTP_RANGE_OK;
+    }
+
+    // The transfer keeps the session busy: it must not be purged as idle
+    int fd = httpd_req_to_sockfd(req);
+    if (http_router_stream_begin(fd) != ESP_OK) {
+        portENTER_CRITICAL(&download_lock);
+        download_stats.rejected++;
+        portEXIT_CRITICAL(&download_lock);
+        httpd_resp_set_hdr(req, "Retry-After", DOWNLOAD_RETRY_AFTER_S);
+        return download_send_status(req, "503 Service Unavailable", "Too many open streams");
+    }
+    if (httpd_req_async_handler_begin(req, &job.req) != ESP_OK) {
+        http_router_stream_end(fd);
+        httpd_resp_send_500(req);
+        return ESP_FAIL;
+    }
+    if (xQueueSend(download_queue, &job, 0) != pdTRUE) {
+        http_router_stream_end(fd);
+        httpd_req_async_handler_complete(job.req);
+        portENTER_CRITICAL(&download_lock);
+        download_stats.rejected++;
+        portEXIT_CRITICAL(&download_lock);
+        httpd_resp_set_hdr(req, "Retry-After", DOWNLOAD_RETRY_AFTER_S);
+        return download_send_status(req, "503 Service Unavailable", "All download slots busy");
+    }
+    return ESP_OK;
+}
+
+// File list and transfer counters
+static esp_err_t log_list_handler(httpd_req_t *req)
+{
+    char active[32];
+    can_logger_get_path(active, sizeof(active));
+
+    log_download_stats_t stats;
+    log_download_get_stats(&stats);
+
+    char chunk[JSON_WRITER_CHUNK_SIZE];
+    json_writer_t w;
+    json_writer_init_httpd(&w, req, chunk, sizeof(chunk));
+    json_obj_begin(&w);
+    json_key(&w, "files");
+    json_arr_begin(&w);
+
+    DIR *dir = opendir(CAN_LOGGER_DIR);
+    if (dir != NULL) {
+        struct dirent *entry;
+        char path[48];
+        struct stat st;
+        while ((entry = readdir(dir)) != NULL) {
+            snprintf(path, sizeof(path), "%s/%s", CAN_LOGGER_DIR, entry->d_name);
+            if (stat(path, &st) != 0 || !S_ISREG(st.st_mode)) {
+                continue;
+            }
+            bool is_active = strcmp(path, active) == 0;
+            json_obj_begin(&w);
+            json_kv_str(&w, "name", entry->d_name);
+            json_kv_uint(&w, "size", is_active ? (uint64_t)can_logger_get_data_size() : (uint64_t)st.st_size);
+            json_kv_bool(&w, "active", is_active);
+            json_obj_end(&w);
+        }
+        closedir(dir);
+    }
+    json_arr_end(&w);
+
+    json_key(&w, "stats");
+    json_obj_begin(&w);
+    json_kv_uint(&w, "downloads", stats.downloads);
+    json_kv_uint(&w, "aborted", stats.aborted);
+    json_kv_uint(&w, "rejected", stats.rejected);
+    json_kv_uint(&w, "range_requests", stats.range_requests);
+    json_kv_uint(&w, "active", stats.active);
+    json_kv_uint(&w, "bytes_sent", stats.bytes_sent);
+    json_kv_uint(&w, "last_kbps", stats.last_kbps);
+    json_kv_uint(&w, "best_kbps", stats.best_kbps);
+    json_obj_end(&w);
+    json_obj_end(&w);
+    return json_writer_finish(&w);
+}
+
+// ============================================================================
+// DOWNLOAD WORKERS
+// ============================================================================
+
+static void download_set_disposition(httpd_req_t *req, const download_job_t *job, char *buf, size_t len)
+{
+    if (job->csv && job->channel[0] != '\0') {
+        // CHN00001.COL -> CHN00001_engine_rpm.csv
+        int stem = (int)strcspn(job->name, ".");
+        snprintf(buf, len, "attachment; filename=\"%.*s_%s.csv\"", stem, job->name, job->channel);
+    } else if (job->csv) {
+        // CAN00001.BIN -> CAN00001.csv
+        int stem = (int)strcspn(job->name, ".");
+        snprintf(buf, len, "attachment; filename=\"%.*s.csv\"", stem, job->name);
+    } else {
+        snprintf(buf, len, "attachment; filename=\"%s\"", job->name);
+    }
+    httpd_resp_set_hdr(req, "Content-Disposition", buf);
+}
+
+/**
+ * @brief Sends [start, end] of the file.
+ * @return Bytes sent; *ok is false if the transfer did not complete
+ */
+static uint64_t download_send_raw(const download_job_t *job, char *buf, bool *ok)
+{
+    httpd_req_t *req = job->req;
+    char disposition[64];
+    char content_range[48];
+    uint64_t sent = 0;
+    *ok = false;
+
+    FILE *f = fopen(job->path, "rb");
+    if (f == NULL || fseek(f, job->start, SEEK_SET) != 0) {
+        if (f != NULL) {
+            fclose(f);
+        }
+        httpd_resp_send_404(req);
+        return 0;
+    }
+
+    httpd_resp_set_type(req, "application/octet-stream");
+    httpd_resp_set_hdr(req, "Accept-Ranges", "bytes");
+    download_set_disposition(req, job, disposition, sizeof(disposition));
+    if (job->partial) {
+        snprintf(content_range, sizeof(content_range), "bytes %ld-%ld/%ld", job->start, job->end, job->size);
+        httpd_resp_set_status(req, "206 Partial Content");
+        httpd_resp_set_hdr(req, "Content-Range", content_range);
+    }
+
+    long remaining = job->end - job->start + 1;
+    while (remaining > 0) {
+        size_t want = remaining < LOG_DOWNLOAD_CHUNK_SIZE ? (size_t)remaining : LOG_DOWNLOAD_CHUNK_SIZE;
+        size_t n = fread(buf, 1, want, f);
+        if (n == 0 || httpd_resp_send_chunk(req, buf, n) != ESP_OK) {
+            break;
+        }
+        remaining -= (long)n;
+        sent += n;
+    }
+    fclose(f);
+
+    if (remaining <= 0 && httpd_resp_send_chunk(req, NULL, 0) == ESP_OK) {
+        *ok = true;
+    }
+    return sent;
+}
+
+/**
+ * @brief Decodes the trace and sends it as CSV lines, batched into the buffer.
+ */
+static uint64_t download_send_csv(const download_job_t *job, char *buf, bool *ok)
+{
+    static const char hex[] = "0123456789ABCDEF";
+    httpd_req_t *req = job->req;
+    char disposition[64];
+    uint64_t sent = 0;
+    *ok = false;
+
+    can_log_reader_t reader;
+    if (can_log_reader_open(&reader, job->path) != CAN_LOG_OK) {
+        httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Not a CAN trace");
+        return 0;
+    }
+    uint64_t origin = reader.header.start_time_us;
+    uint64_t end_us = job->to_us > 0 ? origin + job->to_us : UINT64_MAX;
+    if (job->from_us > 0) {
+        can_log_reader_seek_time(&reader, origin + job->from_us);
+    }
+
+    httpd_resp_set_type(req, "text/csv");
+    download_set_disposition(req, job, disposition, sizeof(disposition));
+
+    size_t fill = (size_t)snprintf(buf, LOG_DOWNLOAD_CHUNK_SIZE, "timestamp_s,id,extended,rtr,dlc,data\n");
+    can_log_frame_t frame;
+    int ret;
+    bool failed = false;
+
+    while ((ret = can_log_reader_next(&reader, &frame)) == CAN_LOG_OK && frame.time_us < end_us) {
+        char *p = buf + fill;
+        p += sprintf(p, "%llu.%06llu,%lX,%d,%d,%u,",
+                     (unsigned long long)(frame.time_us / 1000000),
+                     (unsigned long long)(frame.time_us % 1000000),
+                     (unsigned long)frame.identifier, frame.extended, frame.rtr, frame.dlc);
+        uint8_t len = frame.dlc < 8 ? frame.dlc : 8;
+        for (uint8_t i = 0; i < len; i++) {
+            if (i > 0) {
+                *p++ = ' ';
+            }
+            *p++ = hex[frame.data[i] >> 4];
+            *p++ = hex[frame.data[i] & 0x0F];
+        }
+        *p++ = '\n';
+        fill = (size_t)(p - buf);
+
+        if (fill > LOG_DOWNLOAD_CHUNK_SIZE - DOWNLOAD_CSV_LINE_MAX) {
+            if (httpd_resp_send_chunk(req, buf, fill) != ESP_OK) {
+                failed = true;
+                break;
+            }
+            sent += fill;
+            fill = 0;
+        }
+    }
+    can_log_reader_close(&reader);
+
+    if (!failed && ret >= CAN_LOG_OK && (fill == 0 || httpd_resp_send_chunk(req, buf, fill) == ESP_OK)) {
+        sent += fill;
+        *ok = httpd_resp_send_chunk(req, NULL, 0) == ESP_OK;
+    }
+    return sent;
+}
+
+/**
+ * @brief Sends one channel of a channel log as "time_s,<channel>" lines.
+ *        Only that channel's blocks are read from the card.
+ */
+static uint64_t download_send_channel_csv(const download_job_t *job, char *buf, bool *ok)
+{
+    httpd_req_t *req = job->req;
+    char disposition[80];
+    uint64_t sent = 0;
+    *ok = false;
+
+    channel_log_reader_t reader;
+    if (channel_log_reader_open(&reader, job->path) != CAN_LOG_OK) {
+        httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Not a channel log");
+        return 0;
+    }
+    int channel = channel_log_reader_find(&reader, job->channel);
+    if (channel < 0 || channel_log_reader_select(&reader, (uint8_t)channel, job->from_us, job->to_us) != CAN_LOG_OK) {
+        channel_log_reader_close(&reader);
+        httpd_resp_send_err(req, HTTPD_404_NOT_FOUND, "Channel not in this log");
+        return 0;
+    }
+    uint64_t origin = reader.header.start_time_us;
+    int precision = reader.channels[channel].precision;
+
+    httpd_resp_set_type(req, "text/csv");
+    download_set_disposition(req, job, disposition, sizeof(disposition));
+
+    size_t fill = (size_t)snprintf(buf, LOG_DOWNLOAD_CHUNK_SIZE, "time_s,%s\n", job->channel);
+    channel_log_sample_t sample;
+    int ret;
+    bool failed = false;
+
+    while ((ret = channel_log_reader_next(&reader, &sample)) == CAN_LOG_OK) {
+        uint64_t t = sample.time_us - origin;
+        size_t room = LOG_DOWNLOAD_CHUNK_SIZE - fill;
+        int len = snprintf(buf + fill, room, "%llu.%03llu,%.*f\n",
+                           (unsigned long long)(t / 1000000), (unsigned long long)(t % 1000000 / 1000),
+                           precision, sample.value);
+        if (len < 0 || (size_t)len >= room) {
+            // Longer than DOWNLOAD_CSV_LINE_MAX: never add a truncated line
+            ESP_LOGE(TAG, "CSV line of %s does not fit the chunk", job->path);
+            failed = true;
+            break;
+        }
+        fill += (size_t)len;
+        if (fill > LOG_DOWNLOAD_CHUNK_SIZE - DOWNLOAD_CSV_LINE_MAX) {
+            if (httpd_resp_send_chunk(req, buf, fill) != ESP_OK) {
+                failed = true;
+                break;
+            }
+            sent += fill;
+            fill = 0;
+        }
+    }
+    channel_log_reader_close(&reader);
+
+    if (!failed && ret >= CAN_LOG_OK && (fill == 0 || httpd_resp_send_chunk(req, buf, fill) == ESP_OK)) {
+        sent += fill;
+        *ok = httpd_resp_send_chunk(req, NULL, 0) == ESP_OK;
+    }
+    return sent;
+}
+
+static void download_worker_task(void *pvParameters)
+{
+    char *buf = (char *)pvParameters;
+    download_job_t job;
+
+    while (1) {
+        if (xQueueReceive(download_queue, &job, portMAX_DELAY) != pdTRUE) {
+            continue;
+        }
+
+        portENTER_CRITICAL(&download_lock);
+        download_stats.active++;
+        portEXIT_CRITICAL(&download_lock);
+
+        int64_t start_us = esp_timer_get_time();
+        bool ok;
+        uint64_t sent;
+        if (job.csv && job.channel[0] != '\0') {
+            sent = download_send_channel_csv(&job, buf, &ok);
+        } else if (job.csv) {
+            sent = download_send_csv(&job, buf, &ok);
+        } else {
+            sent = download_send_raw(&job, buf, &ok);
+        }
+        int64_t elapsed_us = esp_timer_get_time() - start_us;
+        // Before completing: afterwards the fd may already belong to a new session
+        http_router_stream_end(httpd_req_to_sockfd(job.req));
+        httpd_req_async_handler_complete(job.req);
+
+        uint32_t kbps = elapsed_us > 0 ? (uint32_t)(sent * 1000000 / 1024 / (uint64_t)elapsed_us) : 0;
+
+        portENTER_CRITICAL(&download_lock);
+        download_stats.active--;
+        download_stats.bytes_sent += sent;
+        if (ok) {
+            download_stats.downloads++;
+            if (job.partial) {
+                download_stats.range_requests++;
+            }
+            download_stats.last_kbps = kbps;
+            // Short transfers are dominated by latency, not throughput
+            if (sent >= LOG_DOWNLOAD_CHUNK_SIZE * 16 && kbps > download_stats.best_kbps) {
+                download_stats.best_kbps = kbps;
+            }
+        } else {
+            download_stats.aborted++;
+        }
+        portEXIT_CRITICAL(&download_lock);
+
+        ESP_LOGI(TAG, "%s %s%s: %llu bytes in %lld ms (%lu KB/s)", ok ? "Sent" : "Aborted",
+                 job.name, job.csv ? " as CSV" : "", (unsigned long long)sent,
+                 (long long)(elapsed_us / 1000), (unsigned long)kbps);
+    }
+}
+
+// ============================================================================
+// SETUP
+// ============================================================================
+
+esp_err_t log_download_register(void)
+{
+    if (download_queue == NULL) {
+        download_queue = xQueueCreate(LOG_DOWNLOAD_WORKERS, sizeof(download_job_t));
+        if (download_queue == NULL) {
+            return ESP_ERR_NO_MEM;
+        }
+        for (int i = 0; i < LOG_DOWNLOAD_WORKERS; i++) {
+            char *buf = malloc(LOG_DOWNLOAD_CHUNK_SIZE);
+            if (buf == NULL ||
+                xTaskCreate(download_worker_task, "log_download", DOWNLOAD_TASK_STACK_SIZE,
+                            buf, DOWNLOAD_TASK_PRIORITY, NULL) != pdPASS) {
+                ESP_LOGE(TAG, "Failed to start download worker %d", i);
+                free(buf);
+                return ESP_ERR_NO_MEM;
+            }
+        }
+    }
+
+    httpd_uri_t list_uri = {
+        .uri = "/logs",
+        .method = HTTP_GET,
+        .handler = log_list_handler,
+        .user_ctx = NULL
+    };
+    esp_err_t ret = http_router_register(&list_uri);
+
+    httpd_uri_t file_uri = {
+        .uri = "/logs/*",
+        .method = HTTP_GET,
+        .handler = log_file_handler,
+        .user_ctx = NULL
+    };
+    if (ret == ESP_OK) {
+        ret = http_router_register(&file_uri);
+    }
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to register handlers: %s", esp_err_to_name(ret));
+    }
+    return ret;
+}
+
+void log_download_get_stats(log_download_stats_t *stats)
+{
+    if (stats == NULL) {
+        return;
+    }
+    portENTER_CRITICAL(&download_lock);
+    *stats = download_stats;
+    portEXIT_CRITICAL(&download_lock);
+}
@@ -36,6 +36,13 @@
 #include "include/canbus.h"
 #include "include/can_websocket.h"
 #include "include/ecu_data.h"
+#include "include/alarm_engine.h"
+#include "include/can_logger.h"
+#include "include/channel_logger.h"
+#include "include/event_capture.h"
+#include "include/nvs_cache.h"
+#include "include/background_bench.h"
+#include "include/boot_trace.h"
 
 // Display driver
 #include "../components/espressif__esp_lcd_touch/display.h"
@@ -46,38 +53,70 @@
 
 static const char *TAG = "ECU_DASHBOARD";
 
+void ui_update_task_handler(void *pvParameters);
 
+// Result of settings_load(): on ESP_ERR_NOT_FOUND the SD stage imports
+// the old settings.json and the display waits for it
+static esp_err_t boot_settings_ret = ESP_OK;
+static bool boot_can_started = false;
 
-void app_main(void)
-{
-    ESP_LOGI(TAG, "ECU Dashboard Starting...");
-    ESP_LOGI(TAG, "Free heap: %ld bytes", esp_get_free_heap_size());
+// ============================================================================
+// BOOT STAGES
+// ============================================================================
 
-    // Initialize ECU data system
-    ecu_data_init();
-    system_settings_init();
-
-    // Initialize NVS
-    esp_err_t ret = nvs_flash_init();
-    if (ret == ESP_ERR_NVS_NO_FREE_PAGES || ret == ESP_ERR_NVS_NEW_VERSION_FOUND) {
-        ESP_ERROR_CHECK(nvs_flash_erase());
-        ret = nvs_flash_init();
-    }
-    ESP_ERROR_CHECK(ret);
+enum {
+    STAGE_BACKGROUND,
+    STAGE_SD,
+    STAGE_CAPTURE,
+    STAGE_WIFI,
+    STAGE_WEB,
+    STAGE_CAN,
+    STAGE_CAN_WS,
+    STAGE_DISPLAY,
+    STAGE_TOUCH,
+    STAGE_UI,
+    STAGE_COUNT
+};
 
+static esp_err_t stage_background(void)
+{
     // --- ДОБАВЛЕНО: Инициализация фоновой задачи для медленных операций ---
     // Эта задача будет обрабатывать сохранение в NVS, не блокируя UI.
-    background_task_init();
+    esp_err_t ret = background_task_init();
+#if CONFIG_BACKGROUND_BENCHMARK
+    // Job mix on one worker, then on the pool; results go to the log
+    background_bench_compare(BACKGROUND_BENCH_JOBS);
+#endif
+    return ret;
+}
 
+static esp_err_t stage_sd(void)
+{
     // Initialize SD Card
-    if (sd_card_init() == ESP_OK) {
-        // Now that SD card is available, load settings
-        settings_load();
+    esp_err_t ret = sd_card_init();
+    if (ret == ESP_OK) {
+        // First boot after the move to NVS: pick up the old settings.json
+        if (boot_settings_ret == ESP_ERR_NOT_FOUND) {
+            settings_import_from_sd();
+        }
         // Enable CAN trace logging from SD card settings if needed in the future
         // For now, let's enable it by default for testing.
         sd_card_set_can_trace_enabled(true);
+        can_logger_start(NULL);
+        // Decoded channels in columnar files, next to the raw trace
+        channel_logger_start(NULL);
     }
+    return ret;
+}
+
+static esp_err_t stage_capture(void)
+{
+    // Pre-trigger ring for alarm events; files are only written with a card
+    return event_capture_init(NULL);
+}
 
+static esp_err_t stage_wifi(void)
+{
     // Initialize WiFi
     ESP_ERROR_CHECK(esp_netif_init());
     ESP_ERROR_CHECK(esp_event_loop_create_default());
@@ -105,8 +144,12 @@ void app_main(void)
     ESP_ERROR_CHECK(esp_wifi_start());
     
     ESP_LOGI(TAG, "WiFi AP started. SSID: %s", wifi_config.ap.ssid);
+    return ESP_OK;
+}
 
-    // Start web server with dashboard first (port 80)
+static esp_err_t stage_web(void)
+{
+    // Start the shared web server with the dashboard routes (port 80)
     ESP_LOGI(TAG, "Starting web server...");
     esp_err_t web_ret = start_dashboard_web_server();
     if (web_ret == ESP_OK) {
@@ -114,7 +157,11 @@ void app_main(void)
     } else {
         ESP_LOGE(TAG, "Failed to start web server: %s", esp_err_to_name(web_ret));
     }
+    return web_ret;
+}
 
+static esp_err_t stage_can(void)
+{
     // Initialize CAN bus
     ESP_LOGI(TAG, "Initializing CAN bus...");
     esp_err_t can_ret = canbus_init();
@@ -129,25 +176,50 @@ void app_main(void)
             // Create CAN task
             xTaskCreate(canbus_task, "can_task", 4096, NULL, 10, NULL);
             ESP_LOGI(TAG, "CAN task created");
-
-            // Start WebSocket server for CAN data (port 8080)
-            esp_err_t ws_ret = start_websocket_server();
-            if (ws_ret == ESP_OK) {
-                ESP_LOGI(TAG, "WebSocket server for CAN started successfully!");
-                // Create WebSocket broadcast task
-                xTaskCreate(websocket_broadcast_task, "ws_broadcast", 4096, NULL, 5, NULL);
-            } else {
-                ESP_LOGE(TAG, "Failed to start WebSocket server: %s", esp_err_to_name(ws_ret));
-            }
+            boot_can_started = true;
         } else {
             ESP_LOGE(TAG, "Failed to start CAN bus: %s", esp_err_to_name(can_ret));
         }
     } else {
         ESP_LOGE(TAG, "Failed to initialize CAN bus: %s", esp_err_to_name(can_ret));
     }
-    
+    return can_ret;
+}
+
+static esp_err_t stage_can_ws(void)
+{
+    if (!boot_can_started) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    // WebSocket routes for CAN data on the shared server (/ws)
+    esp_err_t ws_ret = start_websocket_server();
+    if (ws_ret == ESP_OK) {
+        ESP_LOGI(TAG, "WebSocket server for CAN started successfully!");
+        // Create WebSocket broadcast task
+        xTaskCreate(websocket_broadcast_task, "ws_broadcast", 4096, NULL, 5, NULL);
+    } else {
+        ESP_LOGE(TAG, "Failed to start WebSocket server: %s", esp_err_to_name(ws_ret));
+    }
+    return ws_ret;
+}
+
+static esp_err_t stage_display(void)
+{
     /* Initialize display and UI */
-    display();
+    display_panel_init();
+    return ESP_OK;
+}
+
+static esp_err_t stage_touch(void)
+{
+    display_touch_init();
+    return ESP_OK;
+}
+
+static esp_err_t stage_ui(void)
+{
+    ui_updates_init();
 
     // Create the UI update task
     xTaskCreate(ui_update_task_handler, "ui_update_task", 4096, NULL, 5, NULL);
@@ -158,7 +230,62 @@ void app_main(void)
 
     // Initialize demo mode after UI is fully initialized
     demo_mode_set_enabled(DEFAULT_DEMO_MODE_ENABLED);
+    return ESP_OK;
+}
+
+// Panel, SD and Wi-Fi start together; the touch reset drives GPIO 4, the
+// SD card CS, so it waits for the mount as it did when boot was serial
+static boot_stage_t boot_stages[STAGE_COUNT] = {
+    [STAGE_BACKGROUND] = { "background", stage_background, 0, tskNO_AFFINITY, 0 },
+    [STAGE_SD]         = { "sd", stage_sd, BOOT_STAGE(STAGE_BACKGROUND), tskNO_AFFINITY, 0 },
+    [STAGE_CAPTURE]    = { "capture", stage_capture, BOOT_STAGE(STAGE_SD), tskNO_AFFINITY, 0 },
+    [STAGE_WIFI]       = { "wifi", stage_wifi, 0, tskNO_AFFINITY, 0 },
+    [STAGE_WEB]        = { "web", stage_web, BOOT_STAGE(STAGE_WIFI), tskNO_AFFINITY, 0 },
+    [STAGE_CAN]        = { "can", stage_can, 0, tskNO_AFFINITY, 0 },
+    [STAGE_CAN_WS]     = { "can_ws", stage_can_ws, BOOT_STAGE(STAGE_CAN) | BOOT_STAGE(STAGE_WIFI), tskNO_AFFINITY, 0 },
+    [STAGE_DISPLAY]    = { "display", stage_display, 0, tskNO_AFFINITY, 6144 },
+    [STAGE_TOUCH]      = { "touch", stage_touch, BOOT_STAGE(STAGE_DISPLAY) | BOOT_STAGE(STAGE_SD), tskNO_AFFINITY, 0 },
+    [STAGE_UI]         = { "ui", stage_ui, BOOT_STAGE(STAGE_DISPLAY), tskNO_AFFINITY, 6144 },
+};
+
+void app_main(void)
+{
+    ESP_LOGI(TAG, "ECU Dashboard Starting...");
+    ESP_LOGI(TAG, "Free heap: %ld bytes", esp_get_free_heap_size());
+
+    // Initialize ECU data system
+    int stage = boot_trace_begin("core");
+    ecu_data_init();
+    alarm_engine_init();
+    system_settings_init();
+    boot_trace_end(stage, ESP_OK);
+
+    // Initialize NVS
+    stage = boot_trace_begin("nvs");
+    esp_err_t ret = nvs_flash_init();
+    if (ret == ESP_ERR_NVS_NO_FREE_PAGES || ret == ESP_ERR_NVS_NEW_VERSION_FOUND) {
+        ESP_ERROR_CHECK(nvs_flash_erase());
+        ret = nvs_flash_init();
+    }
+    ESP_ERROR_CHECK(ret);
+
+    // Write-behind cache in front of NVS: batched commits, flushed on restart
+    nvs_cache_init(NULL);
+
+    // Settings come from NVS in one read, before the display and the SD card
+    boot_settings_ret = settings_load();
+    boot_trace_end(stage, boot_settings_ret);
+
+    // The screens are built from the settings: wait for the one-time import
+    if (boot_settings_ret == ESP_ERR_NOT_FOUND) {
+        boot_stages[STAGE_DISPLAY].after |= BOOT_STAGE(STAGE_SD);
+    }
+
+    // Everything else in parallel where the dependencies allow
+    boot_trace_run_stages(boot_stages, STAGE_COUNT);
 
+    boot_trace_mark("boot_complete");
+    boot_trace_log();
     ESP_LOGI(TAG, "ECU Dashboard initialized. Connect to WiFi: ECU_Dashboard");
 }
 // Task to update the UI gauges periodically
@@ -167,6 +294,7 @@ void ui_update_task_handler(void *pvParameters) {
         // Lock the LVGL mutex before touching UI elements
         if (example_lvgl_lock(-1)) {
             update_all_gauges();
+            ui_Screen6_apply_save_status();
             example_lvgl_unlock();
         }
         // Run this task at a reasonable rate, e.g., every 50ms (20 FPS)
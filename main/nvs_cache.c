@@ -0,0 +1,500 @@
+/*
+ * NVS Write-Behind Cache for ECU Dashboard
+ * RAM copies of NVS blobs, flushed per namespace by the background task
+ */
+
+#include "include/nvs_cache.h"
+#include "include/alarm_engine.h"
+#include "background_task.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "esp_log.h"
+#include "esp_system.h"
+#include "esp_timer.h"
+#include "nvs.h"
+#include <stdlib.h>
+#include <string.h>
+
+static const char *TAG = "NVS_CACHE";
+
+#define NVS_CACHE_LOCK_TIMEOUT_MS       1000
+#define NVS_CACHE_REQUEUE_MS            500     // Background queue was full: try again
+
+typedef enum {
+    ENTRY_FREE = 0,
+    ENTRY_PRESENT,              // `data` holds the value
+    ENTRY_ABSENT                // Known not to exist (read miss or erased)
+} entry_state_t;
+
+typedef struct {
+    char namespace[NVS_CACHE_NAME_SIZE];
+    char key[NVS_CACHE_NAME_SIZE];
+    entry_state_t state;
+    bool dirty;                 // RAM differs from flash
+    void *data;
+    size_t size;
+    uint32_t last_use;          // For evicting clean entries
+} cache_entry_t;
+
+static cache_entry_t entries[NVS_CACHE_MAX_ENTRIES];
+static SemaphoreHandle_t cache_mutex = NULL;
+static esp_timer_handle_t flush_timer = NULL;
+static nvs_cache_config_t cache_config;
+static int64_t first_dirty_us = 0;      // 0 = nothing waiting
+static uint32_t use_counter = 0;
+static nvs_cache_stats_t cache_stats;
+
+// ============================================================================
+// TABLE
+// ============================================================================
+
+static bool cache_lock(void)
+{
+    return cache_mutex != NULL &&
+           xSemaphoreTake(cache_mutex, pdMS_TO_TICKS(NVS_CACHE_LOCK_TIMEOUT_MS)) == pdTRUE;
+}
+
+static void cache_unlock(void)
+{
+    xSemaphoreGive(cache_mutex);
+}
+
+static bool names_valid(const char *namespace, const char *key)
+{
+    return namespace != NULL && key != NULL &&
+           strlen(namespace) < NVS_CACHE_NAME_SIZE && strlen(key) < NVS_CACHE_NAME_SIZE;
+}
+
+static cache_entry_t *entry_find(const char *namespace, const char *key)
+{
+    for (int i = 0; i < NVS_CACHE_MAX_ENTRIES; i++) {
+        cache_entry_t *e = &entries[i];
+        if (e->state != ENTRY_FREE && strcmp(e->key, key) == 0 && strcmp(e->namespace, namespace) == 0) {
+            e->last_use = ++use_counter;
+            return e;
+        }
+    }
+    return NULL;
+}
+
+/**
+ * @brief A free slot, or the least recently used clean one.
+ * @return NULL when every entry is dirty
+ */
+static cache_entry_t *entry_claim(const char *namespace, const char *key)
+{
+    cache_entry_t *victim = NULL;
+    for (int i = 0; i < NVS_CACHE_MAX_ENTRIES; i++) {
+        cache_entry_t *e = &entries[i];
+        if (e->state == ENTRY_FREE) {
+            victim = e;
+            break;
+        }
+        if (!e->dirty && (victim == NULL || e->last_use < victim->last_use)) {
+            victim = e;
+        }
+    }
+    if (victim == NULL) {
+        return NULL;
+    }
+    free(victim->data);
+    memset(victim, 0, sizeof(*victim));
+    strcpy(victim->namespace, namespace);
+    strcpy(victim->key, key);
+    victim->state = ENTRY_ABSENT;
+    victim->last_use = ++use_counter;
+    return victim;
+}
+
+static esp_err_t entry_store(cache_entry_t *e, const void *value, size_t size)
+{
+    if (e->data == NULL || e->size != size) {
+        void *data = malloc(size);
+        if (data == NULL) {
+            return ESP_ERR_NO_MEM;
+        }
+        free(e->data);
+        e->data = data;
+        e->size = size;
+    }
+    memcpy(e->data, value, size);
+    e->state = ENTRY_PRESENT;
+    return ESP_OK;
+}
+
+// ============================================================================
+// FLUSH SCHEDULING
+// ============================================================================
+
+static void flush_timer_cb(void *arg)
+{
+    background_task_t task = {
+        .type = BG_TASK_NVS_FLUSH,
+        .priority = BG_PRIORITY_NORMAL,
+        .dedup_key = BG_DEDUP_KEY(BG_TASK_NVS_FLUSH, 0)
+    };
+    if (background_task_add(&task) != ESP_OK) {
+        esp_timer_start_once(flush_timer, (uint64_t)NVS_CACHE_REQUEUE_MS * 1000);
+    }
+}
+
+/**
+ * @brief Restarts the quiet period, never past the deadline of the oldest
+ *        unwritten change. Called with the cache locked after a change.
+ */
+static void schedule_flush_locked(void)
+{
+    int64_t now = esp_timer_get_time();
+    if (first_dirty_us == 0) {
+        first_dirty_us = now;
+    }
+    int64_t delay = (int64_t)cache_config.quiet_ms * 1000;
+    int64_t to_deadline = first_dirty_us + (int64_t)cache_config.deadline_ms * 1000 - now;
+    if (to_deadline < delay) {
+        delay = to_deadline > 0 ? to_deadline : 0;
+    }
+    if (flush_timer != NULL) {
+        esp_timer_stop(flush_timer);
+        esp_timer_start_once(flush_timer, (uint64_t)delay);
+    }
+}
+
+// The supply is failing: write now rather than after the quiet period
+static void battery_alarm_cb(const alarm_event_t *event, void *arg)
+{
+    if (event->alarm != ALARM_BATTERY_LOW || event->new_level != ALARM_LEVEL_CRITICAL ||
+        first_dirty_us == 0) {
+        return;
+    }
+    background_task_t task = {
+        .type = BG_TASK_NVS_FLUSH,
+        .priority = BG_PRIORITY_HIGH,
+        .dedup_key = BG_DEDUP_KEY(BG_TASK_NVS_FLUSH, 0)
+    };
+    background_task_add(&task);
+}
+
+static void shutdown_handler(void)
+{
+    nvs_cache_flush();
+}
+
+// ============================================================================
+// PUBLIC API
+// ============================================================================
+
+esp_err_t nvs_cache_init(const nvs_cache_config_t *config)
+{
+    if (cache_mutex != NULL) {
+        return ESP_OK;
+    }
+    nvs_cache_config_t defaults = NVS_CACHE_CONFIG_DEFAULT();
+    cache_config = config ? *config : defaults;
+
+    cache_mutex = xSemaphoreCreateMutex();
+    if (cache_mutex == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+
+    const esp_timer_create_args_t args = {
+        .callback = flush_timer_cb,
+        .name = "nvs_cache"
+    };
+    esp_err_t ret = esp_timer_create(&args, &flush_timer);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+
+    esp_register_shutdown_handler(shutdown_handler);
+    alarm_engine_subscribe(battery_alarm_cb, NULL);
+
+    ESP_LOGI(TAG, "NVS cache ready: %d keys, flush after %lu ms quiet, %lu ms at most",
+             NVS_CACHE_MAX_ENTRIES, (unsigned long)cache_config.quiet_ms,
+             (unsigned long)cache_config.deadline_ms);
+    return ESP_OK;
+}
+
+/**
+ * @brief Writes one blob straight to flash, for a table full of dirty keys.
+ */
+static esp_err_t write_through(const char *namespace, const char *key, const void *value, size_t size)
+{
+    nvs_handle_t handle;
+    esp_err_t ret = nvs_open(namespace, NVS_READWRITE, &handle);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+    ret = value ? nvs_set_blob(handle, key, value, size) : nvs_erase_key(handle, key);
+    if (ret == ESP_ERR_NVS_NOT_FOUND && value == NULL) {
+        ret = ESP_OK;
+    }
+    if (ret == ESP_OK) {
+        ret = nvs_commit(handle);
+    }
+    nvs_close(handle);
+    return ret;
+}
+
+esp_err_t nvs_cache_set_blob(const char *namespace, const char *key, const void *value, size_t size)
+{
+    if (!names_valid(namespace, key) || value == NULL || size == 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (!cache_lock()) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    cache_stats.sets++;
+    cache_entry_t *e = entry_find(namespace, key);
+    if (e != NULL && e->state == ENTRY_PRESENT && !e->dirty &&
+        e->size == size && memcmp(e->data, value, size) == 0) {
+        // Same as in flash
+        cache_stats.writes_avoided++;
+        cache_unlock();
+        return ESP_OK;
+    }
+    if (e == NULL) {
+        e = entry_claim(namespace, key);
+    }
+
+    esp_err_t ret;
+    if (e == NULL) {
+        cache_stats.write_through++;
+        ret = write_through(namespace, key, value, size);
+    } else {
+        bool was_dirty = e->dirty;
+        ret = entry_store(e, value, size);
+        if (ret == ESP_OK) {
+            if (was_dirty) {
+                cache_stats.writes_avoided++;
+            }
+            e->dirty = true;
+            schedule_flush_locked();
+        }
+    }
+    cache_unlock();
+    return ret;
+}
+
+esp_err_t nvs_cache_get_blob(const char *namespace, const char *key, void *value, size_t *size)
+{
+    if (!names_valid(namespace, key) || size == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (!cache_lock()) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    cache_entry_t *e = entry_find(namespace, key);
+    if (e != NULL) {
+        cache_stats.read_hits++;
+    } else {
+        // Read through once; the result, "not found" included, stays cached
+        cache_stats.read_misses++;
+        size_t len = 0;
+        void *data = NULL;
+        nvs_handle_t handle;
+        esp_err_t ret = nvs_open(namespace, NVS_READONLY, &handle);
+        if (ret == ESP_OK) {
+            ret = nvs_get_blob(handle, key, NULL, &len);
+            if (ret == ESP_OK && len > 0) {
+                data = malloc(len);
+                ret = data ? nvs_get_blob(handle, key, data, &len) : ESP_ERR_NO_MEM;
+            }
+            nvs_close(handle);
+        }
+        if (ret != ESP_OK && ret != ESP_ERR_NVS_NOT_FOUND) {
+            free(data);
+            cache_unlock();
+            return ret;
+        }
+        if (ret == ESP_ERR_NVS_NOT_FOUND) {
+            free(data);
+            data = NULL;
+            len = 0;
+        }
+
+        e = entry_claim(namespace, key);
+        if (e == NULL) {
+            // No room: answer from what was read, without caching it
+            esp_err_t result = data ? ESP_OK : ESP_ERR_NVS_NOT_FOUND;
+            if (data && value) {
+                result = (*size < len) ? ESP_ERR_NVS_INVALID_LENGTH : ESP_OK;
+                if (result == ESP_OK) {
+                    memcpy(value, data, len);
+                }
+            }
+            if (data) {
+                *size = len;
+            }
+            free(data);
+            cache_unlock();
+            return result;
+        }
+        if (data != NULL) {
+            e->data = data;
+            e->size = len;
+            e->state = ENTRY_PRESENT;
+        }
+    }
+
+    esp_err_t ret = ESP_OK;
+    if (e->state != ENTRY_PRESENT) {
+        ret = ESP_ERR_NVS_NOT_FOUND;
+    } else if (value == NULL) {
+        *size = e->size;
+    } else if (*size < e->size) {
+        *size = e->size;
+        ret = ESP_ERR_NVS_INVALID_LENGTH;
+    } else {
+        memcpy(value, e->data, e->size);
+        *size = e->size;
+    }
+    cache_unlock();
+    return ret;
+}
+
+esp_err_t nvs_cache_erase_key(const char *namespace, const char *key)
+{
+    if (!names_valid(namespace, key)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (!cache_lock()) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    cache_stats.erases++;
+    esp_err_t ret = ESP_OK;
+    cache_entry_t *e = entry_find(namespace, key);
+    if (e == NULL) {
+        e = entry_claim(namespace, key);
+    }
+    if (e == NULL) {
+        cache_stats.write_through++;
+        ret = write_through(namespace, key, NULL, 0);
+    } else {
+        if (e->dirty) {
+            cache_stats.writes_avoided++;
+        }
+        free(e->data);
+        e->data = NULL;
+        e->size = 0;
+        e->state = ENTRY_ABSENT;
+        e->dirty = true;
+        schedule_flush_locked();
+    }
+    cache_unlock();
+    return ret;
+}
+
+esp_err_t nvs_cache_flush(void)
+{
+    if (!cache_lock()) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    if (first_dirty_us == 0) {
+        cache_unlock();
+        return ESP_OK;
+    }
+
+    int64_t start_us = esp_timer_get_time();
+    esp_err_t result = ESP_OK;
+    bool done[NVS_CACHE_MAX_ENTRIES] = { false };
+    bool staged[NVS_CACHE_MAX_ENTRIES] = { false };
+
+    // One open and commit per namespace, all its dirty keys in between.
+    // A key is clean only once its namespace is committed.
+    for (int i = 0; i < NVS_CACHE_MAX_ENTRIES; i++) {
+        if (done[i] || !entries[i].dirty) {
+            continue;
+        }
+        const char *namespace = entries[i].namespace;
+        nvs_handle_t handle;
+        esp_err_t ret = nvs_open(namespace, NVS_READWRITE, &handle);
+        uint32_t count = 0;
+
+        for (int j = i; j < NVS_CACHE_MAX_ENTRIES; j++) {
+            cache_entry_t *e = &entries[j];
+            if (done[j] || !e->dirty || strcmp(e->namespace, namespace) != 0) {
+                continue;
+            }
+            done[j] = true;
+            if (ret != ESP_OK) {
+                continue;
+            }
+            esp_err_t set_ret = (e->state == ENTRY_PRESENT) ?
+                nvs_set_blob(handle, e->key, e->data, e->size) : nvs_erase_key(handle, e->key);
+            if (set_ret == ESP_ERR_NVS_NOT_FOUND && e->state == ENTRY_ABSENT) {
+                set_ret = ESP_OK;
+            }
+            if (set_ret != ESP_OK) {
+                ESP_LOGE(TAG, "Failed to write %s/%s: %s", namespace, e->key, esp_err_to_name(set_ret));
+                result = set_ret;
+                continue;
+            }
+            staged[j] = true;
+            count++;
+        }
+
+        if (ret == ESP_OK) {
+            ret = nvs_commit(handle);
+            nvs_close(handle);
+        }
+        if (ret != ESP_OK) {
+            // Keys stay dirty for the next flush
+            ESP_LOGE(TAG, "Failed to flush namespace %s: %s", namespace, esp_err_to_name(ret));
+            result = ret;
+            continue;
+        }
+        for (int j = i; j < NVS_CACHE_MAX_ENTRIES; j++) {
+            if (staged[j]) {
+                entries[j].dirty = false;
+                staged[j] = false;
+            }
+        }
+        cache_stats.commits++;
+        cache_stats.keys_written += count;
+    }
+
+    cache_stats.flushes++;
+    if (result != ESP_OK) {
+        cache_stats.flush_errors++;
+    }
+    uint32_t flush_us = (uint32_t)(esp_timer_get_time() - start_us);
+    if (flush_us > cache_stats.max_flush_us) {
+        cache_stats.max_flush_us = flush_us;
+    }
+
+    bool dirty_left = false;
+    for (int i = 0; i < NVS_CACHE_MAX_ENTRIES; i++) {
+        dirty_left = dirty_left || entries[i].dirty;
+    }
+    first_dirty_us = 0;
+    if (dirty_left) {
+        // Failed keys: retry after the next quiet period
+        schedule_flush_locked();
+    }
+    cache_unlock();
+
+    ESP_LOGD(TAG, "Flushed in %lu us", (unsigned long)flush_us);
+    return result;
+}
+
+void nvs_cache_get_stats(nvs_cache_stats_t *stats)
+{
+    if (stats == NULL) {
+        return;
+    }
+    if (!cache_lock()) {
+        memset(stats, 0, sizeof(*stats));
+        return;
+    }
+    *stats = cache_stats;
+    stats->dirty = 0;
+    for (int i = 0; i < NVS_CACHE_MAX_ENTRIES; i++) {
+        if (entries[i].dirty) {
+            stats->dirty++;
+        }
+    }
+    cache_unlock();
+}
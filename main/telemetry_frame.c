@@ -0,0 +1,255 @@
+/*
+ * Binary Telemetry Frame for ECU Dashboard
+ * Encoder/decoder for the frame format described in telemetry_frame.h
+ */
+
+#include "include/telemetry_frame.h"
+#include <string.h>
+
+// ============================================================================
+// VARINT HELPERS
+// ============================================================================
+
+static inline uint32_t zigzag_encode(int32_t v)
+{
+    return ((uint32_t)v << 1) ^ (uint32_t)(v >> 31);
+}
+
+static inline int32_t zigzag_decode(uint32_t v)
+{
+    return (int32_t)(v >> 1) ^ -(int32_t)(v & 1);
+}
+
+static size_t varint_put(uint8_t *out, uint32_t v)
+{
+    size_t n = 0;
+    while (v >= 0x80) {
+        out[n++] = (uint8_t)(v | 0x80);
+        v >>= 7;
+    }
+    out[n++] = (uint8_t)v;
+    return n;
+}
+
+// Returns bytes consumed, or 0 if the varint runs past `len` or is too long
+static size_t varint_get(const uint8_t *in, size_t len, uint32_t *v)
+{
+    uint32_t result = 0;
+    for (size_t n = 0; n < len && n < 5; n++) {
+        result |= (uint32_t)(in[n] & 0x7F) << (7 * n);
+        if ((in[n] & 0x80) == 0) {
+            *v = result;
+            return n + 1;
+        }
+    }
+    return 0;
+}
+
+// ============================================================================
+// ENCODER
+// ============================================================================
+
+void telemetry_encoder_init(telemetry_encoder_t *enc)
+{
+    memset(enc, 0, sizeof(*enc));
+}
+
+int telemetry_frame_encode(telemetry_encoder_t *enc, uint8_t count, const int32_t *fixed,
+                           uint32_t present_mask, uint32_t timestamp_ms, bool keyframe,
+                           uint8_t *out, size_t cap)
+{
+    if (!enc || !fixed || !out || count > TELEMETRY_MAX_CHANNELS) {
+        return TELEMETRY_ERR_INVALID;
+    }
+
+    size_t bitmap_len = (count + 7) / 8;
+    if (cap < TELEMETRY_HEADER_SIZE + bitmap_len) {
+        return TELEMETRY_ERR_NO_SPACE;
+    }
+
+    if (!enc->have_key || enc->frames_since_key >= TELEMETRY_KEYFRAME_INTERVAL ||
+        count != enc->count) {
+        keyframe = true;
+    }
+    if (count < TELEMETRY_MAX_CHANNELS) {
+        present_mask &= (1u << count) - 1;
+    }
+
+    uint16_t seq = enc->seq + 1;
+    out[0] = TELEMETRY_FRAME_VERSION;
+    out[1] = keyframe ? TELEMETRY_FLAG_KEYFRAME : 0;
+    out[2] = (uint8_t)seq;
+    out[3] = (uint8_t)(seq >> 8);
+    out[4] = (uint8_t)timestamp_ms;
+    out[5] = (uint8_t)(timestamp_ms >> 8);
+    out[6] = (uint8_t)(timestamp_ms >> 16);
+    out[7] = (uint8_t)(timestamp_ms >> 24);
+    out[8] = count;
+
+    uint8_t *bitmap = out + TELEMETRY_HEADER_SIZE;
+    memset(bitmap, 0, bitmap_len);
+    size_t pos = TELEMETRY_HEADER_SIZE + bitmap_len;
+
+    for (uint8_t i = 0; i < count; i++) {
+        uint32_t bit = 1u << i;
+        if (!(present_mask & bit)) {
+            continue;
+        }
+
+        int32_t value;
+        if (keyframe) {
+            value = fixed[i];
+        } else {
+            // Delta frames skip unchanged channels entirely
+            int32_t prev = (enc->known_mask & bit) ? enc->last[i] : 0;
+            if ((enc->known_mask & bit) && fixed[i] == prev) {
+                continue;
+            }
+            value = (int32_t)((uint32_t)fixed[i] - (uint32_t)prev);
+        }
+
+        if (pos + 5 > cap) {
+            return TELEMETRY_ERR_NO_SPACE;
+        }
+        pos += varint_put(out + pos, zigzag_encode(value));
+        bitmap[i / 8] |= (uint8_t)(1u << (i % 8));
+    }
+
+    // Commit the stream state only once the frame is complete
+    for (uint8_t i = 0; i < count; i++) {
+        if (present_mask & (1u << i)) {
+            enc->last[i] = fixed[i];
+        }
+    }
+    enc->known_mask = keyframe ? present_mask : (enc->known_mask | present_mask);
+    enc->seq = seq;
+    enc->have_key = true;
+    enc->count = count;
+    enc->frames_since_key = keyframe ? 0 : enc->frames_since_key + 1;
+
+    return (int)pos;
+}
+
+// ============================================================================
+// DECODER
+// ============================================================================
+
+void telemetry_decoder_init(telemetry_decoder_t *dec)
+{
+    memset(dec, 0, sizeof(*dec));
+}
+
+int telemetry_frame_decode(telemetry_decoder_t *dec, const uint8_t *data, size_t len,
+                           uint32_t *updated_mask)
+{
+    if (!dec || !data) {
+        return TELEMETRY_ERR_INVALID;
+    }
+    if (len < TELEMETRY_HEADER_SIZE) {
+        return TELEMETRY_ERR_TRUNCATED;
+    }
+    if (data[0] != TELEMETRY_FRAME_VERSION) {
+        return TELEMETRY_ERR_VERSION;
+    }
+
+    bool keyframe = (data[1] & TELEMETRY_FLAG_KEYFRAME) != 0;
+    uint16_t seq = (uint16_t)(data[2] | (data[3] << 8));
+    uint32_t timestamp = (uint32_t)data[4] | ((uint32_t)data[5] << 8) |
+                         ((uint32_t)data[6] << 16) | ((uint32_t)data[7] << 24);
+    uint8_t count = data[8];
+
+    if (count > TELEMETRY_MAX_CHANNELS) {
+        dec->synced = false;
+        return TELEMETRY_ERR_INVALID;
+    }
+    if (!keyframe && (!dec->synced || seq != (uint16_t)(dec->seq + 1) || count != dec->count)) {
+        dec->synced = false;
+        return TELEMETRY_ERR_NEED_KEYFRAME;
+    }
+
+    size_t bitmap_len = (count + 7) / 8;
+    if (len < TELEMETRY_HEADER_SIZE + bitmap_len) {
+        dec->synced = false;
+        return TELEMETRY_ERR_TRUNCATED;
+    }
+    const uint8_t *bitmap = data + TELEMETRY_HEADER_SIZE;
+    size_t pos = TELEMETRY_HEADER_SIZE + bitmap_len;
+
+    // Decode into a scratch copy so a truncated frame leaves the state intact
+    int32_t values[TELEMETRY_MAX_CHANNELS];
+    memcpy(values, dec->values, sizeof(values));
+    uint32_t mask = 0;
+
+    for (uint8_t i = 0; i < count; i++) {
+        if (!(bitmap[i / 8] & (1u << (i % 8)))) {
+            continue;
+        }
+        uint32_t raw;
+        size_t used = varint_get(data + pos, len - pos, &raw);
+        if (used == 0) {
+            dec->synced = false;
+            return TELEMETRY_ERR_TRUNCATED;
+        }
+        pos += used;
+
+        int32_t v = zigzag_decode(raw);
+        if (keyframe) {
+            values[i] = v;
+        } else {
+            int32_t prev = (dec->known_mask & (1u << i)) ? dec->values[i] : 0;
+            values[i] = (int32_t)((uint32_t)prev + (uint32_t)v);
+        }
+        mask |= 1u << i;
+    }
+
+    memcpy(dec->values, values, sizeof(values));
+    dec->known_mask = keyframe ? mask : (dec->known_mask | mask);
+    dec->count = count;
+    dec->seq = seq;
+    dec->timestamp_ms = timestamp;
+    dec->synced = true;
+
+    if (updated_mask) {
+        *updated_mask = mask;
+    }
+    return TELEMETRY_OK;
+}
+
+// ============================================================================
+// CHANNEL REGISTRY GLUE
+// ============================================================================
+
+#ifdef ESP_PLATFORM
+
+static const float pow10_table[] = { 1.0f, 10.0f, 100.0f, 1000.0f, 10000.0f };
+
+int telemetry_frame_encode_snapshot(telemetry_encoder_t *enc, const channel_snapshot_t *snap,
+                                    bool keyframe, uint8_t *out, size_t cap)
+{
+    int32_t fixed[TELEMETRY_MAX_CHANNELS];
+    uint32_t present = 0;
+    uint8_t count = snap->count < TELEMETRY_MAX_CHANNELS ? snap->count : TELEMETRY_MAX_CHANNELS;
+
+    for (uint8_t i = 0; i < count; i++) {
+        const channel_def_t *def = channel_get_def(i);
+        uint8_t precision = (def && def->precision < 5) ? def->precision : 0;
+        float scaled = snap->values[i] * pow10_table[precision];
+
+        // Clamp to the int32 range; rounding half away from zero
+        if (scaled >= 2147483647.0f) {
+            fixed[i] = INT32_MAX;
+        } else if (scaled <= -2147483648.0f) {
+            fixed[i] = INT32_MIN;
+        } else {
+            fixed[i] = (int32_t)(scaled < 0 ? scaled - 0.5f : scaled + 0.5f);
+        }
+        if (snap->seq[i] != 0) {
+            present |= 1u << i;
+        }
+    }
+
+    return telemetry_frame_encode(enc, count, fixed, present,
+                                  (uint32_t)(snap->timestamp_us / 1000), keyframe, out, cap);
+}
+
+#endif // ESP_PLATFORM
@@ -6,6 +6,7 @@
 #include "ui_Screen1.h"
 #include "ui_Screen3.h"
 #include "../ui_screen_manager.h"
+#include "alarm_engine.h"
 #include "esp_log.h"
 #include <stdio.h>
 
@@ -55,37 +56,10 @@ static void anim_value_cb(void * var, int32_t v)
     }
     else if(var == ui_Arc_RPM) {
         lv_label_set_text_fmt(ui_Label_RPM_Value, "%d", v);
-        
-        // Update Arc RPM color based on RPM range
-        if(v >= 0 && v < 5000) {
-            // 0-5000: голубой/cyan
-            lv_obj_set_style_arc_color(ui_Arc_RPM, lv_color_hex(0x00D4FF), LV_PART_INDICATOR);
-        }
-        else if(v >= 5000 && v < 6500) {
-            // 5000-6500: желтый
-            lv_obj_set_style_arc_color(ui_Arc_RPM, lv_color_hex(0xFFD700), LV_PART_INDICATOR);
-        }
-        else if(v >= 6500 && v <= 8000) {
-            // 6500-8000: красный
-            lv_obj_set_style_arc_color(ui_Arc_RPM, lv_color_hex(0xFF0000), LV_PART_INDICATOR);
-        }
-        
-        // Update TCU status based on RPM
-        if(v > 5500) {
-            lv_led_set_color(ui_LED_TCU, lv_color_hex(0xFF0000));
-            lv_label_set_text(ui_Label_TCU_Status, "ERROR");
-            lv_obj_set_style_text_color(ui_Label_TCU_Status, lv_color_hex(0xFF0000), 0);
-        }
-        else if(v > 4500) {
-            lv_led_set_color(ui_LED_TCU, lv_color_hex(0xFFAA00));
-            lv_label_set_text(ui_Label_TCU_Status, "WARNING");
-            lv_obj_set_style_text_color(ui_Label_TCU_Status, lv_color_hex(0xFFAA00), 0);
-        }
-        else {
-            lv_led_set_color(ui_LED_TCU, lv_color_hex(0x00FF00));
-            lv_label_set_text(ui_Label_TCU_Status, "OK");
-            lv_obj_set_style_text_color(ui_Label_TCU_Status, lv_color_hex(0x00FF00), 0);
-        }
+
+        // Демо-анимация не пишет в каналы, поэтому передаём значение в движок
+        // тревог напрямую. Цвет дуги и статус TCU меняются только по переходам.
+        alarm_engine_evaluate(CH_ENGINE_RPM, (float)v);
     }
     else if(var == ui_Arc_Boost) {
         lv_label_set_text_fmt(ui_Label_Boost_Value, "%d", v);
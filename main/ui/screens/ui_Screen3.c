@@ -8,6 +8,7 @@
 #include "ui_screen_manager.h"
 #include "ui_helpers.h"
 #include "ui_events.h"
+#include "event_capture.h"
 #include <stdio.h>
 #include <string.h>
 #include <stdbool.h>
@@ -23,6 +24,7 @@ void * ui_Label_CAN_Count;
 // Advanced CAN Terminal Objects
 void * ui_Button_Clear;
 void * ui_Button_Sniffer;
+void * ui_Button_Event;
 void * ui_TextArea_Search;
 void * ui_Slider_UpdateSpeed;
 void * ui_Label_UpdateSpeed;
@@ -43,6 +45,7 @@ static void screen3_touch_handler(lv_event_t * e);
 static void swipe_handler_screen3(lv_event_t * e);
 static void clear_button_event_cb(lv_event_t * e);
 static void sniffer_button_event_cb(lv_event_t * e);
+static void event_button_event_cb(lv_event_t * e);
 static void search_text_event_cb(lv_event_t * e);
 static void update_speed_slider_event_cb(lv_event_t * e);
 static int is_message_matches_search(const char* message);
@@ -123,6 +126,20 @@ static void sniffer_button_event_cb(lv_event_t * e) {
     }
 }
 
+// Event button: saves the buffered traffic around this moment to SD
+static void event_button_event_cb(lv_event_t * e) {
+    lv_event_code_t code = lv_event_get_code(e);
+    if (code == LV_EVENT_CLICKED) {
+        esp_err_t ret = event_capture_trigger("manual");
+        if (ret == ESP_OK) {
+            ui_add_can_message("EVENT: saving capture to SD");
+        } else if (ret == ESP_ERR_TIMEOUT) {
+            ui_add_can_message("EVENT: previous capture still saving");
+        } else {
+            ui_add_can_message("EVENT: capture not available");
+        }
+    }
+}
 
 
 // Search text event callback
@@ -292,6 +309,19 @@ void ui_Screen3_screen_init(void)
     lv_obj_set_style_text_font(sniffer_label, &lv_font_montserrat_10, 0);
     lv_obj_center(sniffer_label);
 
+    // Event capture button
+    ui_Button_Event = lv_btn_create(control_cont);
+    lv_obj_set_size((lv_obj_t*)ui_Button_Event, 120, 30);
+    lv_obj_set_style_bg_color((lv_obj_t*)ui_Button_Event, lv_color_hex(0xFFAA00), 0);
+    lv_obj_set_style_radius((lv_obj_t*)ui_Button_Event, 15, 0);
+    lv_obj_add_event_cb((lv_obj_t*)ui_Button_Event, event_button_event_cb, LV_EVENT_CLICKED, NULL);
+
+    lv_obj_t * event_label = lv_label_create((lv_obj_t*)ui_Button_Event);
+    lv_label_set_text(event_label, "SAVE EVENT");
+    lv_obj_set_style_text_color(event_label, lv_color_black(), 0);
+    lv_obj_set_style_text_font(event_label, &lv_font_montserrat_10, 0);
+    lv_obj_center(event_label);
+
     // --- Search row ---
     lv_obj_t * search_cont = lv_obj_create(right_panel);
     lv_obj_remove_style_all(search_cont);
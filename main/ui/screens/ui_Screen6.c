@@ -13,6 +13,7 @@
 #include <stdio.h>
 #include <string.h>
 #include <stdbool.h>
+#include <stdint.h>
 #include <esp_log.h>
 
 // Screen object
@@ -30,6 +31,17 @@ lv_obj_t * ui_Touch_Cursor_Screen6;
 
 // Settings state
 static int settings_modified = 0;
+
+// Save progress shown on the save button. The continuation of the save job
+// runs on the background worker, so it only records the result here and
+// ui_Screen6_apply_save_status() updates the label in the LVGL task.
+#define SAVE_LABEL_IDLE       "SAVE SETTINGS"
+#define SAVE_RESULT_SHOW_MS   1500
+static lv_obj_t * save_label = NULL;
+static background_handle_t save_handle = BG_HANDLE_INVALID;     // Latest save
+static bool save_result_ready = false;
+static esp_err_t save_result = ESP_OK;
+static portMUX_TYPE save_status_lock = portMUX_INITIALIZER_UNLOCKED;
 static bool demo_mode_enabled = false;
 static bool screen3_enabled = false;
 
@@ -188,8 +200,8 @@ void ui_Screen6_screen_init(void)
     lv_obj_set_style_radius((lv_obj_t*)ui_Button_Save_Settings, 25, 0);
     lv_obj_add_event_cb((lv_obj_t*)ui_Button_Save_Settings, save_settings_event_cb, LV_EVENT_CLICKED, NULL);
 
-    lv_obj_t * save_label = lv_label_create((lv_obj_t*)ui_Button_Save_Settings);
-    lv_label_set_text(save_label, "SAVE SETTINGS");
+    save_label = lv_label_create((lv_obj_t*)ui_Button_Save_Settings);
+    lv_label_set_text(save_label, SAVE_LABEL_IDLE);
     lv_obj_set_style_text_color(save_label, lv_color_black(), 0);
     lv_obj_set_style_text_font(save_label, &lv_font_montserrat_14, 0);
     lv_obj_center(save_label);
@@ -235,6 +247,7 @@ void ui_Screen6_screen_destroy(void)
     if(ui_Screen6) {
         lv_obj_del(ui_Screen6);
         ui_Screen6 = NULL;
+        save_label = NULL;
     }
 }
 
@@ -248,12 +261,73 @@ void ui_Screen6_load_settings(void)
              screen3_enabled ? "ON" : "OFF");
 }
 
+static void screen6_set_save_label(const char * text)
+{
+    if (save_label && lv_obj_is_valid(save_label)) {
+        lv_label_set_text(save_label, text);
+        lv_obj_center(save_label);
+    }
+}
+
+static void save_label_restore_cb(lv_timer_t * timer)
+{
+    // A newer save may be in progress by now
+    if (!background_task_is_pending(save_handle)) {
+        screen6_set_save_label(SAVE_LABEL_IDLE);
+    }
+}
+
+// Continuation of the save job (background worker): record only
+static void screen6_save_done(esp_err_t result, void * arg)
+{
+    portENTER_CRITICAL(&save_status_lock);
+    if ((background_handle_t)(uintptr_t)arg == save_handle) {
+        save_result = result;
+        save_result_ready = true;
+    }
+    portEXIT_CRITICAL(&save_status_lock);
+}
+
+// Called from the UI update task with the LVGL lock held
+void ui_Screen6_apply_save_status(void)
+{
+    portENTER_CRITICAL(&save_status_lock);
+    bool ready = save_result_ready;
+    esp_err_t result = save_result;
+    save_result_ready = false;
+    portEXIT_CRITICAL(&save_status_lock);
+
+    if (!ready) {
+        return;
+    }
+    screen6_set_save_label(result == ESP_OK ? "SAVED" : "SAVE FAILED");
+    lv_timer_t * timer = lv_timer_create(save_label_restore_cb, SAVE_RESULT_SHOW_MS, NULL);
+    lv_timer_set_repeat_count(timer, 1);
+}
+
 // Save Screen6 settings to NVS
 void ui_Screen6_save_settings(void)
 {
     demo_mode_set_enabled(demo_mode_enabled);
     screen3_set_enabled(screen3_enabled);
-    trigger_settings_save(); // Use the non-blocking trigger
+
+    // Non-blocking: the button reads "SAVING..." until the job completes
+    background_handle_t handle;
+    if (trigger_settings_save(&handle) != ESP_OK) {
+        ESP_LOGW("SCREEN6", "Settings save rejected, background queue is full");
+        screen6_set_save_label("QUEUE FULL");
+        lv_timer_t * timer = lv_timer_create(save_label_restore_cb, SAVE_RESULT_SHOW_MS, NULL);
+        lv_timer_set_repeat_count(timer, 1);
+        return;
+    }
+    portENTER_CRITICAL(&save_status_lock);
+    save_handle = handle;
+    save_result_ready = false;
+    portEXIT_CRITICAL(&save_status_lock);
+    screen6_set_save_label("SAVING...");
+    background_task_then(handle, screen6_save_done, (void *)(uintptr_t)handle);
+    background_task_release(handle);
+
     ESP_LOGI("SCREEN6", "Triggered save settings - Demo: %s, Screen3: %s",
              demo_mode_enabled ? "ON" : "OFF",
              screen3_enabled ? "ON" : "OFF");
@@ -32,6 +32,7 @@ extern void ui_reset_device_settings(void);
 extern void ui_Screen6_load_settings(void);
 extern void ui_Screen6_save_settings(void);
 extern void ui_Screen6_update_button_states(void);
+extern void ui_Screen6_apply_save_status(void);   // LVGL task: show the result of the last save
 
 // Touch cursor update function for Screen6
 extern void ui_update_touch_cursor_screen6(void * point);
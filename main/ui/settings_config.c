@@ -8,19 +8,119 @@
 #include <string.h>
 #include <stdlib.h>
 #include "../background_task.h"
+#include "esp_timer.h"
+#include "esp_rom_crc.h"
+#include "json_writer.h"
+#include "nvs_cache.h"
 
 static const char *TAG = "SETTINGS_CONFIG";
 #define NVS_NAMESPACE "settings"
+#define NVS_BLOB_KEY "blob"
+#define SETTINGS_SD_PATH "/sdcard/settings.json"
 static touch_settings_t current_settings;
 
+// ============================================================================
+// NVS BLOB LAYOUT
+// ============================================================================
+// The blob is a fixed header followed by a versioned payload. Layouts only
+// ever grow by appending fields, so a newer payload still starts with every
+// field this firmware knows. Settings from before the blob (settings.json on
+// the SD card only) come in through settings_import_from_sd().
+
+#define SETTINGS_BLOB_MAGIC     0x5453  // "ST"
+#define SETTINGS_BLOB_VERSION   1
+
+typedef struct __attribute__((packed)) {
+    uint16_t magic;
+    uint16_t version;
+    uint16_t payload_size;
+    uint16_t reserved;
+    uint32_t crc32;             // esp_rom_crc32_le over the payload
+} settings_blob_header_t;
+
+// Version 1: the fields of settings.json
+typedef struct __attribute__((packed)) {
+    uint8_t touch_sensitivity_level;
+    uint8_t demo_mode_enabled;
+    uint8_t screen3_enabled;
+    uint8_t screen1_arcs_enabled[SCREEN1_ARCS_COUNT];
+    uint8_t screen2_arcs_enabled[SCREEN2_ARCS_COUNT];
+} settings_payload_v1_t;
+
+typedef struct __attribute__((packed)) {
+    settings_blob_header_t header;
+    settings_payload_v1_t payload;
+} settings_blob_t;
+
+// Delay before the SD mirror is rewritten, so bursts of changes cost one write
+#define SETTINGS_EXPORT_DELAY_US (10 * 1000 * 1000)
+static esp_timer_handle_t export_timer = NULL;
+
+static void settings_to_payload(const touch_settings_t *settings, settings_payload_v1_t *p)
+{
+    p->touch_sensitivity_level = settings->touch_sensitivity_level;
+    p->demo_mode_enabled = settings->demo_mode_enabled;
+    p->screen3_enabled = settings->screen3_enabled;
+    for (int i = 0; i < SCREEN1_ARCS_COUNT; i++) p->screen1_arcs_enabled[i] = settings->screen1_arcs_enabled[i];
+    for (int i = 0; i < SCREEN2_ARCS_COUNT; i++) p->screen2_arcs_enabled[i] = settings->screen2_arcs_enabled[i];
+}
+
+/**
+ * @brief Converts a stored payload into settings. Newer layouts append
+ *        fields, so their version 1 prefix is still valid.
+ */
+static bool settings_from_payload(uint16_t version, const uint8_t *payload, size_t size, touch_settings_t *out)
+{
+    if (version < 1 || size < sizeof(settings_payload_v1_t)) return false;
+
+    const settings_payload_v1_t *v1 = (const settings_payload_v1_t *)payload;
+    settings_init_defaults(out);
+    out->touch_sensitivity_level = v1->touch_sensitivity_level;
+    out->demo_mode_enabled = v1->demo_mode_enabled != 0;
+    out->screen3_enabled = v1->screen3_enabled != 0;
+    for (int i = 0; i < SCREEN1_ARCS_COUNT; i++) out->screen1_arcs_enabled[i] = v1->screen1_arcs_enabled[i] != 0;
+    for (int i = 0; i < SCREEN2_ARCS_COUNT; i++) out->screen2_arcs_enabled[i] = v1->screen2_arcs_enabled[i] != 0;
+    return true;
+}
+
+// ============================================================================
+// SD MIRROR (export/import)
+// ============================================================================
+
 // Helper to serialize settings to a JSON string
-static void settings_to_json(const touch_settings_t* settings, char* buffer, size_t buffer_size) {
-    // A more robust implementation would use a proper JSON library
-    snprintf(buffer, buffer_size,
-             "{\"sensitivity\":%d,\"demo_mode\":%s,\"screen3_enabled\":%s}",
-             settings->touch_sensitivity_level,
-             settings->demo_mode_enabled ? "true" : "false",
-             settings->screen3_enabled ? "true" : "false");
+static esp_err_t settings_to_json(const touch_settings_t* settings, char* buffer, size_t buffer_size) {
+    json_writer_t w;
+    json_writer_init(&w, buffer, buffer_size, NULL, NULL);
+    json_obj_begin(&w);
+    json_kv_int(&w, "version", SETTINGS_BLOB_VERSION);
+    json_kv_int(&w, "sensitivity", settings->touch_sensitivity_level);
+    json_kv_bool(&w, "demo_mode", settings->demo_mode_enabled);
+    json_kv_bool(&w, "screen3_enabled", settings->screen3_enabled);
+    json_key(&w, "screen1_arcs");
+    json_arr_begin(&w);
+    for (int i = 0; i < SCREEN1_ARCS_COUNT; i++) json_bool(&w, settings->screen1_arcs_enabled[i]);
+    json_arr_end(&w);
+    json_key(&w, "screen2_arcs");
+    json_arr_begin(&w);
+    for (int i = 0; i < SCREEN2_ARCS_COUNT; i++) json_bool(&w, settings->screen2_arcs_enabled[i]);
+    json_arr_end(&w);
+    json_obj_end(&w);
+    return json_writer_finish(&w);
+}
+
+// Reads "key":[true,false,...] into flags; missing entries are left untouched
+static void settings_bool_array_from_json(const char* json_str, const char* key, bool* flags, int count) {
+    const char* p = strstr(json_str, key);
+    if (!p) return;
+    p = strchr(p + strlen(key), '[');
+    if (!p) return;
+    p++;
+    for (int i = 0; i < count; i++) {
+        while (*p == ' ' || *p == ',') p++;
+        if (strncmp(p, "true", 4) == 0) { flags[i] = true; p += 4; }
+        else if (strncmp(p, "false", 5) == 0) { flags[i] = false; p += 5; }
+        else break;
+    }
 }
 
 // Helper to deserialize settings from a JSON string
@@ -36,8 +136,10 @@ static bool settings_from_json(const char* json_str, touch_settings_t* settings)
 
     if (sens_ptr && demo_ptr && s3_ptr) {
         settings->touch_sensitivity_level = atoi(sens_ptr + strlen(sens_key));
-        settings->demo_mode_enabled = strstr(demo_ptr, "true") != NULL;
-        settings->screen3_enabled = strstr(s3_ptr, "true") != NULL;
+        settings->demo_mode_enabled = strncmp(demo_ptr + strlen(demo_key), "true", 4) == 0;
+        settings->screen3_enabled = strncmp(s3_ptr + strlen(s3_key), "true", 4) == 0;
+        settings_bool_array_from_json(json_str, "\"screen1_arcs\":", settings->screen1_arcs_enabled, SCREEN1_ARCS_COUNT);
+        settings_bool_array_from_json(json_str, "\"screen2_arcs\":", settings->screen2_arcs_enabled, SCREEN2_ARCS_COUNT);
         return true;
     }
     return false;
@@ -52,86 +154,201 @@ void settings_init_defaults(touch_settings_t *settings) {
     for (int i = 0; i < SCREEN2_ARCS_COUNT; i++) settings->screen2_arcs_enabled[i] = true;
 }
 
+static void settings_export_timer_cb(void *arg) {
+    background_task_t task = {
+        .type = BG_TASK_SETTINGS_EXPORT,
+        .data = NULL,
+        .callback = NULL,
+        .priority = BG_PRIORITY_LOW,
+        .dedup_key = BG_DEDUP_KEY(BG_TASK_SETTINGS_EXPORT, 0)
+    };
+    if (background_task_add(&task) != ESP_OK) {
+        ESP_LOGW(TAG, "Failed to queue settings export, will retry on next save.");
+    }
+}
+
+// Restarts the export delay; the SD copy is written once changes settle
+static void settings_schedule_export(void) {
+    if (export_timer == NULL) {
+        const esp_timer_create_args_t args = {
+            .callback = settings_export_timer_cb,
+            .name = "settings_export"
+        };
+        if (esp_timer_create(&args, &export_timer) != ESP_OK) {
+            return;
+        }
+    }
+    esp_timer_stop(export_timer);
+    esp_timer_start_once(export_timer, SETTINGS_EXPORT_DELAY_US);
+}
+
+static void settings_export_done(sd_request_t *req, void *arg) {
+    if (req->result == ESP_OK) {
+        ESP_LOGI(TAG, "Settings mirrored to SD card.");
+    } else {
+        ESP_LOGW(TAG, "Failed to mirror settings to SD card.");
+    }
+}
+
 /**
- * @brief Saves the provided settings struct to the SD card.
- * This is a slow, blocking function and should only be called from a background task
- * or during initial setup.
+ * @brief Writes the current settings to /sdcard/settings.json.
+ * Runs in the background task, scheduled by settings_save(); the write itself
+ * is queued for the SD I/O task and its result is logged on completion.
+ */
+esp_err_t settings_export_to_sd(void) {
+    char json_buffer[256];
+    esp_err_t ret = settings_to_json(&current_settings, json_buffer, sizeof(json_buffer));
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Settings JSON does not fit the export buffer.");
+        return ret;
+    }
+    ret = sd_card_write_async(SETTINGS_SD_PATH, json_buffer, strlen(json_buffer),
+                              settings_export_done, NULL);
+    if (ret != ESP_OK) {
+        ESP_LOGW(TAG, "Failed to queue settings export: %s", esp_err_to_name(ret));
+    }
+    return ret;
+}
+
+/**
+ * @brief Imports /sdcard/settings.json into the current settings and NVS.
+ * Used once after upgrading from SD-only storage, or to restore a copy.
+ */
+esp_err_t settings_import_from_sd(void) {
+    FILE* f = fopen(SETTINGS_SD_PATH, "r");
+    if (f == NULL) {
+        return ESP_ERR_NOT_FOUND;
+    }
+    char buffer[256] = {0};
+    fread(buffer, 1, sizeof(buffer) - 1, f);
+    fclose(f);
+
+    touch_settings_t imported = current_settings;
+    if (!settings_from_json(buffer, &imported) || !settings_validate(&imported)) {
+        ESP_LOGW(TAG, "Failed to parse settings.json, keeping current settings.");
+        return ESP_ERR_INVALID_RESPONSE;
+    }
+    current_settings = imported;
+    ESP_LOGI(TAG, "Settings imported from SD card.");
+    return settings_save(&current_settings);
+}
+
+// ============================================================================
+// PERSISTENCE
+// ============================================================================
+
+/**
+ * @brief Stores the settings as a CRC-protected blob in NVS and schedules
+ * the SD mirror. The blob goes to the NVS write-behind cache, which writes
+ * flash once the changes settle; UI code should still use
+ * trigger_settings_save().
  * @param settings_to_save A pointer to the settings struct to save.
  */
-void settings_save(const touch_settings_t *settings_to_save) {
+esp_err_t settings_save(const touch_settings_t *settings_to_save) {
     if (settings_to_save == NULL) {
         ESP_LOGE(TAG, "settings_save called with NULL data!");
-        return;
+        return ESP_ERR_INVALID_ARG;
     }
-    // Save to SD Card as JSON
-    char json_buffer[256];
-    settings_to_json(settings_to_save, json_buffer, sizeof(json_buffer));
-    if (sd_card_write_file("/sdcard/settings.json", json_buffer) == ESP_OK) {
-        ESP_LOGI(TAG, "Settings saved to SD card successfully.");
-    } else {
-        ESP_LOGE(TAG, "Failed to save settings to SD card.");
+
+    settings_blob_t blob = {0};
+    settings_to_payload(settings_to_save, &blob.payload);
+    blob.header.magic = SETTINGS_BLOB_MAGIC;
+    blob.header.version = SETTINGS_BLOB_VERSION;
+    blob.header.payload_size = sizeof(blob.payload);
+    blob.header.crc32 = esp_rom_crc32_le(0, (const uint8_t *)&blob.payload, sizeof(blob.payload));
+
+    esp_err_t ret = background_nvs_save(NVS_NAMESPACE, NVS_BLOB_KEY, &blob, sizeof(blob));
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to save settings to NVS: %s", esp_err_to_name(ret));
+        return ret;
     }
+    ESP_LOGI(TAG, "Settings saved to NVS.");
+
+    settings_schedule_export();
+    return ESP_OK;
 }
 
 /**
- * @brief Queues a request to save the current settings in a background task.
- * This function makes a copy of the current settings to pass to the background task.
+ * @brief Saves a snapshot of the current settings. Runs in the background
+ * task for saves queued by trigger_settings_save().
  */
-void trigger_settings_save(void) {
-    // Allocate memory for a copy of the settings to ensure thread safety.
-    touch_settings_t *settings_copy = malloc(sizeof(touch_settings_t));
-    if (settings_copy == NULL) {
-        ESP_LOGE(TAG, "Failed to allocate memory for settings copy!");
-        return;
-    }
-
-    // Copy the current settings to the new memory block
-    memcpy(settings_copy, &current_settings, sizeof(touch_settings_t));
+esp_err_t settings_save_current(void) {
+    touch_settings_t snapshot = current_settings;
+    return settings_save(&snapshot);
+}
 
+/**
+ * @brief Queues a request to save the current settings in a background task.
+ * The settings are read when the job runs, so no copy is made here and a
+ * save that is still pending absorbs the new one.
+ * @param handle NULL, or receives a handle to wait on or chain to (the
+ *        caller releases it); the handle of an absorbed save completes
+ *        with ESP_ERR_INVALID_STATE
+ * @return ESP_OK, or ESP_ERR_TIMEOUT when the background queue is full
+ */
+esp_err_t trigger_settings_save(background_handle_t *handle) {
     background_task_t task = {
         .type = BG_TASK_SETTINGS_SAVE,
-        .data = settings_copy, // Pass the pointer to the copy
-        .data_size = sizeof(touch_settings_t),
-        .callback = NULL
+        .data = NULL,
+        .callback = NULL,
+        .priority = BG_PRIORITY_NORMAL,
+        .dedup_key = BG_DEDUP_KEY(BG_TASK_SETTINGS_SAVE, 0)
     };
 
-    if (background_task_add(&task) != ESP_OK) {
-        ESP_LOGE(TAG, "Failed to queue settings save task. Queue might be full.");
-        free(settings_copy); // Free memory if task queuing fails
+    esp_err_t ret = handle ? background_task_submit_handle(&task, 0, handle)
+                           : background_task_add(&task);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to queue settings save task: %s", esp_err_to_name(ret));
     } else {
         ESP_LOGI(TAG, "Settings save queued for background processing.");
     }
+    return ret;
 }
 
 /**
- * @brief Loads settings from the SD card. If it fails, loads defaults.
+ * @brief Loads settings from NVS with a single blob read. Needs NVS only,
+ * not the SD card. Falls back to defaults if the blob is missing or corrupt.
+ * @return ESP_OK, or ESP_ERR_NOT_FOUND / ESP_ERR_INVALID_CRC when defaults were loaded
  */
 esp_err_t settings_load(void) {
-    // Try to load from SD card
-    FILE* f = fopen("/sdcard/settings.json", "r");
-    if (f != NULL) {
-        char buffer[256] = {0};
-        fread(buffer, 1, sizeof(buffer) - 1, f);
-        fclose(f);
-        if (settings_from_json(buffer, &current_settings)) {
-            ESP_LOGI(TAG, "Settings loaded from SD card successfully.");
-            return ESP_OK;
-        } else {
-            ESP_LOGW(TAG, "Failed to parse settings.json, using defaults.");
-            settings_init_defaults(&current_settings);
-            return ESP_FAIL;
-        }
+    int64_t start_us = esp_timer_get_time();
+
+    // Room for a newer (larger) layout than this firmware knows
+    uint8_t raw[sizeof(settings_blob_header_t) + 64];
+    size_t size = sizeof(raw);
+    esp_err_t ret;
+
+    // Read through the NVS cache, which keeps the blob for later reads
+    ret = nvs_cache_get_blob(NVS_NAMESPACE, NVS_BLOB_KEY, raw, &size);
+
+    if (ret != ESP_OK) {
+        ESP_LOGI(TAG, "No settings in NVS (%s), using defaults.", esp_err_to_name(ret));
+        settings_init_defaults(&current_settings);
+        return ESP_ERR_NOT_FOUND;
     }
 
-    // If file doesn't exist or can't be opened, use defaults and create the file.
-    ESP_LOGI(TAG, "settings.json not found on SD card, initializing with defaults and saving.");
-    settings_init_defaults(&current_settings);
+    const settings_blob_header_t *header = (const settings_blob_header_t *)raw;
+    const uint8_t *payload = raw + sizeof(settings_blob_header_t);
+    if (size < sizeof(settings_blob_header_t) || header->magic != SETTINGS_BLOB_MAGIC ||
+        header->payload_size > size - sizeof(settings_blob_header_t) ||
+        esp_rom_crc32_le(0, payload, header->payload_size) != header->crc32) {
+        ESP_LOGW(TAG, "Settings blob corrupt, using defaults.");
+        settings_init_defaults(&current_settings);
+        return ESP_ERR_INVALID_CRC;
+    }
 
-    // Attempt to save the new default settings to the SD card.
-    // This is a blocking call, but it only happens once on the very first boot.
-    settings_save(&current_settings);
+    touch_settings_t loaded;
+    if (!settings_from_payload(header->version, payload, header->payload_size, &loaded) ||
+        !settings_validate(&loaded)) {
+        ESP_LOGW(TAG, "Settings blob v%d not usable, using defaults.", header->version);
+        settings_init_defaults(&current_settings);
+        return ESP_ERR_INVALID_VERSION;
+    }
 
-    return ESP_ERR_NOT_FOUND; // Return NOT_FOUND to indicate that defaults were loaded.
+    current_settings = loaded;
+    ESP_LOGI(TAG, "Settings v%d loaded from NVS in %lld us.", header->version,
+             esp_timer_get_time() - start_us);
+    return ESP_OK;
 }
 
 // ... other functions like settings_validate, getters/setters, etc. remain the same ...
@@ -11,6 +11,7 @@ extern "C" {
 #include <stdint.h>
 #include <stdbool.h>
 #include "esp_err.h"
+#include "../background_task.h"
 
 // Default settings values
 #define DEFAULT_TOUCH_SENSITIVITY        5
@@ -60,11 +61,16 @@ void ui_Screen1_update_arcs_visibility(void);
 void ui_Screen2_update_arcs_visibility(void);
 
 // Settings persistence functions
-void settings_save(void);
-void trigger_settings_save(void);  // Асинхронное сохранение с фоновой задачей
+// NVS holds the settings as a versioned, CRC-protected blob; the SD card
+// keeps a lazily written settings.json copy for export/import.
+esp_err_t settings_load(void);                                  // Один read из NVS, SD не нужна
+esp_err_t settings_save(const touch_settings_t *settings);      // Запись в NVS через кэш (flash позже)
+esp_err_t settings_save_current(void);                          // Снимок текущих настроек -> settings_save
+esp_err_t trigger_settings_save(background_handle_t *handle);  // Асинхронное сохранение (handle может быть NULL), ESP_ERR_TIMEOUT при полной очереди
+esp_err_t settings_export_to_sd(void);
+esp_err_t settings_import_from_sd(void);
 void settings_apply_changes(void);
 void settings_reset_to_defaults(void);
-esp_err_t settings_load(void);
 
 #ifdef __cplusplus
 } /*extern "C"*/
@@ -44,8 +44,7 @@ void ui_init(void)
     // Initialize screen manager
     ui_screen_manager_init();
 
-    // Load settings
-    settings_load();
+    // Settings are already loaded from NVS in app_main
 
     // Initialize all screens
     ui_Screen1_screen_init();
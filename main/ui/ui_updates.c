@@ -1,73 +1,138 @@
 #include "ui_updates.h"
 #include "ui.h"
-#include "ecu_data.h"
+#include "channel_registry.h"
+#include "alarm_engine.h"
+#include "freertos/FreeRTOS.h"
 #include <stdio.h>
+#include <string.h>
 
-// This function is called periodically by the LVGL task.
-// It reads the latest data from the global ECU data struct
-// and updates all the gauge widgets on all screens.
-void update_all_gauges(void) {
-    ecu_data_t data_copy;
+// Binds one channel to an arc and its value label.
+// arc_scale converts the channel value into the arc's integer range.
+typedef struct {
+    channel_id_t channel;
+    lv_obj_t **arc;
+    lv_obj_t **label;
+    float arc_scale;
+    const char *suffix;     // Appended to the label text (e.g. "°C"), may be NULL
+} gauge_binding_t;
 
-    // Get a thread-safe copy of the latest ECU data
-    ecu_data_get_copy(&data_copy);
+static const gauge_binding_t gauge_bindings[] = {
+    // --- Screen 1 ---
+    { CH_ENGINE_RPM,        &ui_Arc_RPM,             &ui_Label_RPM_Value,             1.0f, NULL  },
+    { CH_TPS_POSITION,      &ui_Arc_TPS,             &ui_Label_TPS_Value,             1.0f, NULL  },
+    { CH_MAP_KPA,           &ui_Arc_MAP,             &ui_Label_MAP_Value,             1.0f, NULL  },
+    { CH_WG_POS_PERCENT,    &ui_Arc_Wastegate,       &ui_Label_Wastegate_Value,       1.0f, NULL  },
+    { CH_TARGET_BOOST_KPA,  &ui_Arc_Boost,           &ui_Label_Boost_Value,           1.0f, NULL  },
 
-    char buffer[50];
+    // --- Screen 2 ---
+    { CH_OIL_PRESSURE_BAR,  &ui_Arc_Oil_Pressure,    &ui_Label_Oil_Pressure_Value,    1.0f, NULL  },
+    { CH_OIL_TEMP_C,        &ui_Arc_Oil_Temp,        &ui_Label_Oil_Temp_Value,        1.0f, "°C"  },
+    { CH_WATER_TEMP_C,      &ui_Arc_Water_Temp,      &ui_Label_Water_Temp_Value,      1.0f, "°C"  },
+    { CH_FUEL_PRESSURE_BAR, &ui_Arc_Fuel_Pressure,   &ui_Label_Fuel_Pressure_Value,   1.0f, NULL  },
+    { CH_BATTERY_V,         &ui_Arc_Battery_Voltage, &ui_Label_Battery_Voltage_Value, 1.0f, NULL  },
 
-    // --- Update Screen 1 Widgets ---
-    if (lv_obj_is_valid(ui_Arc_RPM)) {
-        lv_arc_set_value(ui_Arc_RPM, (int16_t)data_copy.engine_rpm);
-        lv_label_set_text_fmt(ui_Label_RPM_Value, "%d", (int)data_copy.engine_rpm);
-    }
-    if (lv_obj_is_valid(ui_Arc_TPS)) {
-        lv_arc_set_value(ui_Arc_TPS, (int16_t)data_copy.tps_position);
-        lv_label_set_text_fmt(ui_Label_TPS_Value, "%.1f", data_copy.tps_position);
-    }
-    if (lv_obj_is_valid(ui_Arc_MAP)) {
-        lv_arc_set_value(ui_Arc_MAP, (int16_t)data_copy.map_kpa);
-        lv_label_set_text_fmt(ui_Label_MAP_Value, "%.0f", data_copy.map_kpa);
-    }
-    if (lv_obj_is_valid(ui_Arc_Wastegate)) {
-        lv_arc_set_value(ui_Arc_Wastegate, (int16_t)data_copy.wg_pos_percent);
-        lv_label_set_text_fmt(ui_Label_Wastegate_Value, "%.1f", data_copy.wg_pos_percent);
-    }
-    // NOTE: The "Target Boost" gauge on Screen 1 and all gauges on Screen 2 are for display only.
-    // The current CAN bus specification provided by the user does not include data for these values.
-    // They will animate in demo mode but will not show live data.
-
-    // --- Update Screen 4 Widgets ---
-    if (lv_obj_is_valid(ui_Arc_Abs_Pedal)) {
-        lv_arc_set_value(ui_Arc_Abs_Pedal, (int16_t)data_copy.abs_pedal_pos);
-        lv_label_set_text_fmt(ui_Label_Abs_Pedal_Value, "%.1f", data_copy.abs_pedal_pos);
-    }
-    if (lv_obj_is_valid(ui_Arc_WG_Pos)) {
-        lv_arc_set_value(ui_Arc_WG_Pos, (int16_t)data_copy.wg_pos_percent);
-        lv_label_set_text_fmt(ui_Label_WG_Pos_Value, "%.1f", data_copy.wg_pos_percent);
-    }
-    if (lv_obj_is_valid(ui_Arc_BOV)) {
-        lv_arc_set_value(ui_Arc_BOV, (int16_t)data_copy.bov_percent);
-        lv_label_set_text_fmt(ui_Label_BOV_Value, "%.1f", data_copy.bov_percent);
-    }
-    if (lv_obj_is_valid(ui_Arc_TCU_TQ_Req)) {
-        lv_arc_set_value(ui_Arc_TCU_TQ_Req, (int16_t)data_copy.tcu_tq_req_nm);
-        lv_label_set_text_fmt(ui_Label_TCU_TQ_Req_Value, "%.0f", data_copy.tcu_tq_req_nm);
-    }
-    if (lv_obj_is_valid(ui_Arc_TCU_TQ_Act)) {
-        lv_arc_set_value(ui_Arc_TCU_TQ_Act, (int16_t)data_copy.tcu_tq_act_nm);
-        lv_label_set_text_fmt(ui_Label_TCU_TQ_Act_Value, "%.0f", data_copy.tcu_tq_act_nm);
+    // --- Screen 4 ---
+    { CH_ABS_PEDAL_POS,     &ui_Arc_Abs_Pedal,       &ui_Label_Abs_Pedal_Value,       1.0f, NULL  },
+    { CH_WG_POS_PERCENT,    &ui_Arc_WG_Pos,          &ui_Label_WG_Pos_Value,          1.0f, NULL  },
+    { CH_BOV_PERCENT,       &ui_Arc_BOV,             &ui_Label_BOV_Value,             1.0f, NULL  },
+    { CH_TCU_TQ_REQ_NM,     &ui_Arc_TCU_TQ_Req,      &ui_Label_TCU_TQ_Req_Value,      1.0f, NULL  },
+    { CH_TCU_TQ_ACT_NM,     &ui_Arc_TCU_TQ_Act,      &ui_Label_TCU_TQ_Act_Value,      1.0f, NULL  },
+    { CH_ENG_TRG_NM,        &ui_Arc_Eng_TQ_Req,      &ui_Label_Eng_TQ_Req_Value,      1.0f, NULL  },
+
+    // --- Screen 5 ---
+    { CH_ENG_ACT_NM,        &ui_Arc_Eng_TQ_Act,      &ui_Label_Eng_TQ_Act_Value,      1.0f, NULL  },
+    { CH_LIMIT_TQ_NM,       &ui_Arc_Limit_TQ,        &ui_Label_Limit_TQ_Value,        1.0f, NULL  },
+};
+
+#define GAUGE_BINDING_COUNT (sizeof(gauge_bindings) / sizeof(gauge_bindings[0]))
+
+// Channel update counter last drawn for each binding
+static uint32_t applied_seq[GAUGE_BINDING_COUNT];
+
+// Indicator colours per alarm level (OK, WARNING, CRITICAL)
+static const uint32_t rpm_arc_colors[] = { 0x00D4FF, 0xFFD700, 0xFF0000 };
+static const uint32_t tcu_status_colors[] = { 0x00FF00, 0xFFAA00, 0xFF0000 };
+static const char *tcu_status_texts[] = { "OK", "WARNING", "ERROR" };
+
+// Alarm transitions received since the last redraw. The subscriber runs
+// outside the LVGL lock, so it only records levels; update_all_gauges()
+// applies them.
+static uint8_t alarm_ui_level[ALARM_MAX_RULES];
+static uint32_t alarm_ui_dirty = 0;
+static portMUX_TYPE alarm_ui_lock = portMUX_INITIALIZER_UNLOCKED;
+
+static void ui_alarm_subscriber(const alarm_event_t *event, void *arg)
+{
+    portENTER_CRITICAL(&alarm_ui_lock);
+    alarm_ui_level[event->alarm] = event->new_level;
+    alarm_ui_dirty |= (1u << event->alarm);
+    portEXIT_CRITICAL(&alarm_ui_lock);
+}
+
+static void apply_alarm_transitions(void)
+{
+    uint8_t levels[ALARM_MAX_RULES];
+
+    portENTER_CRITICAL(&alarm_ui_lock);
+    uint32_t dirty = alarm_ui_dirty;
+    alarm_ui_dirty = 0;
+    memcpy(levels, alarm_ui_level, sizeof(levels));
+    portEXIT_CRITICAL(&alarm_ui_lock);
+
+    if (dirty == 0) {
+        return;
     }
-    if (lv_obj_is_valid(ui_Arc_Eng_TQ_Req)) {
-        lv_arc_set_value(ui_Arc_Eng_TQ_Req, (int16_t)data_copy.eng_trg_nm);
-        lv_label_set_text_fmt(ui_Label_Eng_TQ_Req_Value, "%.0f", data_copy.eng_trg_nm);
+
+    if ((dirty & (1u << ALARM_RPM_SHIFT)) && lv_obj_is_valid(ui_Arc_RPM)) {
+        lv_obj_set_style_arc_color(ui_Arc_RPM, lv_color_hex(rpm_arc_colors[levels[ALARM_RPM_SHIFT]]),
+                                   LV_PART_INDICATOR);
     }
 
-    // --- Update Screen 5 Widgets ---
-    if (lv_obj_is_valid(ui_Arc_Eng_TQ_Act)) {
-        lv_arc_set_value(ui_Arc_Eng_TQ_Act, (int16_t)data_copy.eng_act_nm);
-        lv_label_set_text_fmt(ui_Label_Eng_TQ_Act_Value, "%.0f", data_copy.eng_act_nm);
+    if ((dirty & (1u << ALARM_TCU_RPM)) && lv_obj_is_valid(ui_LED_TCU) && lv_obj_is_valid(ui_Label_TCU_Status)) {
+        lv_color_t color = lv_color_hex(tcu_status_colors[levels[ALARM_TCU_RPM]]);
+        lv_led_set_color(ui_LED_TCU, color);
+        lv_label_set_text(ui_Label_TCU_Status, tcu_status_texts[levels[ALARM_TCU_RPM]]);
+        lv_obj_set_style_text_color(ui_Label_TCU_Status, color, 0);
     }
-    if (lv_obj_is_valid(ui_Arc_Limit_TQ)) {
-        lv_arc_set_value(ui_Arc_Limit_TQ, (int16_t)data_copy.limit_tq_nm);
-        lv_label_set_text_fmt(ui_Label_Limit_TQ_Value, "%.0f", data_copy.limit_tq_nm);
+}
+
+void ui_updates_init(void)
+{
+    alarm_engine_subscribe(ui_alarm_subscriber, NULL);
+}
+
+// This function is called periodically by the LVGL task.
+// It reads a snapshot of the channel registry and redraws only the gauges
+// whose channel changed since the last call. Gauges without live data keep
+// their demo animation untouched.
+void update_all_gauges(void) {
+    channel_snapshot_t snap;
+
+    // Get a consistent copy of the channels in use
+    channel_snapshot(&snap);
+
+    char buffer[24];
+
+    for (size_t i = 0; i < GAUGE_BINDING_COUNT; i++) {
+        const gauge_binding_t *b = &gauge_bindings[i];
+        if (b->channel >= snap.count || snap.seq[b->channel] == applied_seq[i]) {
+            continue;
+        }
+        lv_obj_t *arc = *b->arc;
+        lv_obj_t *label = *b->label;
+        if (!lv_obj_is_valid(arc) || !lv_obj_is_valid(label)) {
+            continue;
+        }
+
+        const channel_def_t *def = channel_get_def(b->channel);
+        float value = snap.values[b->channel];
+
+        lv_arc_set_value(arc, (int16_t)(value * b->arc_scale));
+        snprintf(buffer, sizeof(buffer), "%.*f%s", def->precision, value, b->suffix ? b->suffix : "");
+        lv_label_set_text(label, buffer);
+
+        applied_seq[i] = snap.seq[b->channel];
     }
+
+    apply_alarm_transitions();
 }
@@ -5,9 +5,13 @@
 extern "C" {
 #endif
 
+// Subscribes the gauges to alarm transitions (RPM arc colour, TCU LED).
+// Call once after the alarm engine is initialized.
+void ui_updates_init(void);
+
 // This function is called periodically by the LVGL task.
-// It reads the latest data from the global ECU data struct
-// and updates all the gauge widgets on all screens.
+// It reads a snapshot of the channel registry and updates the gauge
+// widgets whose channel changed since the previous call.
 void update_all_gauges(void);
 
 #ifdef __cplusplus
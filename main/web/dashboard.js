@@ -0,0 +1,164 @@
+class ECUDashboard {
+  constructor() {
+    this.data = {
+      engine_rpm: 0,
+      map_pressure: 0,
+      tps_position: 0,
+      wastegate_position: 0,
+      target_boost: 0,
+      tcu_protection_active: false,
+      tcu_limp_mode: false
+    };
+    this.gauges = [];
+    this.init();
+  }
+  init() {
+    this.initGauges();
+    this.startDataPolling();
+  }
+  initGauges() {
+    const gaugeConfigs = [
+      { id: 'rpm', max: 7000, unit: 'RPM', color: '#FF6B35', warningThreshold: 6000, dangerThreshold: 6500 },
+      { id: 'map', max: 250, unit: 'kPa', color: '#00D4FF', warningThreshold: 230, dangerThreshold: 245 },
+      { id: 'tps', max: 100, unit: '%', color: '#FFD700' },
+      { id: 'wastegate', max: 100, unit: '%', color: '#00FF88' },
+      { id: 'boost', max: 25, unit: 'PSI', color: '#96CEB4' }
+    ];
+    gaugeConfigs.forEach(config => {
+      this.createGauge(config);
+    });
+  }
+  createGauge(config) {
+    const canvas = document.querySelector(`#gauge-${config.id} canvas`);
+    if (!canvas) return;
+    const ctx = canvas.getContext('2d');
+    const centerX = canvas.width / 2;
+    const centerY = canvas.height / 2;
+    const radius = Math.min(centerX, centerY) - 20;
+    const gauge = {
+      id: config.id,
+      max: config.max,
+      unit: config.unit,
+      color: config.color,
+      value: 0,
+      ctx: ctx,
+      centerX: centerX,
+      centerY: centerY,
+      radius: radius,
+      warningThreshold: config.warningThreshold,
+      dangerThreshold: config.dangerThreshold
+    };
+    this.gauges.push(gauge);
+    this.drawGauge(gauge);
+  }
+  drawGauge(gauge) {
+    const ctx = gauge.ctx;
+    const centerX = gauge.centerX;
+    const centerY = gauge.centerY;
+    const radius = gauge.radius;
+    ctx.clearRect(0, 0, ctx.canvas.width, ctx.canvas.height);
+    const percentage = Math.max(0, Math.min(1, gauge.value / gauge.max));
+    const startAngle = -Math.PI / 2;
+    const endAngle = startAngle + (percentage * Math.PI * 2);
+    let strokeColor = gauge.color;
+    if (gauge.dangerThreshold && gauge.value >= gauge.dangerThreshold) {
+      strokeColor = '#FF3366';
+    } else if (gauge.warningThreshold && gauge.value >= gauge.warningThreshold) {
+      strokeColor = '#FF6B35';
+    }
+    ctx.beginPath();
+    ctx.arc(centerX, centerY, radius, 0, 2 * Math.PI);
+    ctx.strokeStyle = '#333';
+    ctx.lineWidth = 8;
+    ctx.stroke();
+    ctx.beginPath();
+    ctx.arc(centerX, centerY, radius, startAngle, endAngle);
+    ctx.strokeStyle = strokeColor;
+    ctx.lineWidth = 8;
+    ctx.lineCap = 'round';
+    ctx.stroke();
+    const valueElement = document.querySelector(`#gauge-${gauge.id} .gauge-value`);
+    if (valueElement) {
+      valueElement.textContent = Math.round(gauge.value);
+    }
+  }
+  updateGauge(id, value) {
+    const gauge = this.gauges.find(g => g.id === id);
+    if (gauge) {
+      gauge.value = value;
+      this.drawGauge(gauge);
+    }
+  }
+  updateTCUStatus(protection, limp) {
+    const indicator = document.getElementById('tcu-indicator');
+    if (!indicator) return;
+    const led = indicator.querySelector('.tcu-led');
+    if (led) {
+      if (protection || limp) {
+        led.style.backgroundColor = '#FF3366';
+        led.style.boxShadow = '0 0 10px #FF3366';
+      } else {
+        led.style.backgroundColor = '#00FF88';
+        led.style.boxShadow = '0 0 10px #00FF88';
+      }
+    }
+  }
+  updateStatusIndicator(connected) {
+    const indicator = document.getElementById('status-indicator');
+    if (!indicator) return;
+    const dot = indicator.querySelector('.status-dot');
+    const text = indicator.querySelector('.status-text');
+    if (dot && text) {
+      if (connected) {
+        dot.style.backgroundColor = '#00FF88';
+        text.textContent = 'Connected';
+      } else {
+        dot.style.backgroundColor = '#FF3366';
+        text.textContent = 'Disconnected';
+      }
+    }
+  }
+  addDataStreamEntry(message, type = 'info') {
+    const streamContent = document.getElementById('stream-content');
+    if (!streamContent) return;
+    const entry = document.createElement('div');
+    entry.className = `stream-entry stream-${type}`;
+    entry.innerHTML = `<span class="timestamp">${new Date().toLocaleTimeString()}</span><span class="message">${message}</span>`;
+    streamContent.appendChild(entry);
+    while (streamContent.children.length > 10) {
+      streamContent.removeChild(streamContent.firstChild);
+    }
+    streamContent.scrollTop = streamContent.scrollHeight;
+  }
+  async fetchECUData() {
+    try {
+      const response = await fetch('/api/ecu_data');
+      if (response.ok) {
+        const data = await response.json();
+        this.updateGauge('rpm', data.engine_rpm || 0);
+        this.updateGauge('map', data.map_pressure || 0);
+        this.updateGauge('tps', data.tps_position || 0);
+        this.updateGauge('wastegate', data.wastegate_position || 0);
+        this.updateGauge('boost', data.target_boost || 0);
+        this.updateTCUStatus(data.tcu_protection_active || false, data.tcu_limp_mode || false);
+        this.updateStatusIndicator(true);
+        this.addDataStreamEntry(`RPM: ${Math.round(data.engine_rpm || 0)}, MAP: ${(data.map_pressure || 0).toFixed(1)} kPa`, 'success');
+        return data;
+      }
+    } catch (error) {
+      console.error('Error fetching ECU data:', error);
+      this.updateStatusIndicator(false);
+      this.addDataStreamEntry('Connection error', 'error');
+    }
+    return null;
+  }
+  startDataPolling() {
+    this.fetchECUData();
+    setInterval(() => {
+      this.fetchECUData();
+    }, 100);
+  }
+}
+document.addEventListener('DOMContentLoaded', () => {
+  new ECUDashboard();
+});
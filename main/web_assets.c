@@ -0,0 +1,62 @@
+/*
+ * Web Assets for ECU Dashboard
+ * Pages, styles and scripts compressed at build time
+ */
+
+#include "web_assets.h"
+#include <string.h>
+#include <stdbool.h>
+#include "esp_log.h"
+
+static const char *TAG = "WEB_ASSETS";
+
+// Longest If-None-Match value checked; a longer list is treated as a miss
+#define IF_NONE_MATCH_MAX   96
+
+const web_asset_t *web_asset_find(const char *name)
+{
+    if (name == NULL) {
+        return NULL;
+    }
+    for (size_t i = 0; i < web_asset_count; i++) {
+        if (strcmp(web_assets[i].name, name) == 0) {
+            return &web_assets[i];
+        }
+    }
+    return NULL;
+}
+
+// If-None-Match may list several tags, weak ones with a W/ prefix
+static bool web_asset_not_modified(httpd_req_t *req, const web_asset_t *asset)
+{
+    char value[IF_NONE_MATCH_MAX];
+    size_t len = httpd_req_get_hdr_value_len(req, "If-None-Match");
+    if (len == 0 || len >= sizeof(value) ||
+        httpd_req_get_hdr_value_str(req, "If-None-Match", value, sizeof(value)) != ESP_OK) {
+        return false;
+    }
+    return strcmp(value, "*") == 0 || strstr(value, asset->etag) != NULL;
+}
+
+esp_err_t web_asset_send(httpd_req_t *req, const web_asset_t *asset)
+{
+    if (asset == NULL) {
+        return httpd_resp_send_404(req);
+    }
+
+    httpd_resp_set_hdr(req, "Access-Control-Allow-Origin", "*");
+    httpd_resp_set_hdr(req, "Cache-Control", asset->cache_control);
+    httpd_resp_set_hdr(req, "ETag", asset->etag);
+
+    if (web_asset_not_modified(req, asset)) {
+        ESP_LOGD(TAG, "%s not modified", asset->name);
+        httpd_resp_set_status(req, "304 Not Modified");
+        return httpd_resp_send(req, NULL, 0);
+    }
+
+    // Every browser sends Accept-Encoding: gzip; there is no plain copy to fall back to
+    httpd_resp_set_type(req, asset->content_type);
+    httpd_resp_set_hdr(req, "Content-Encoding", "gzip");
+    httpd_resp_set_hdr(req, "Vary", "Accept-Encoding");
+    return httpd_resp_send(req, (const char *)asset->data, asset->len);
+}
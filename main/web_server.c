@@ -8,629 +8,663 @@
 #include <math.h>
 #include "include/can_websocket.h"
 #include "ui/settings_config.h"
+#include "json_writer.h"
+#include "include/channel_registry.h"
+#include "include/ecu_data.h"
+#include "include/telemetry_frame.h"
+#include "include/can_logger.h"
+#include "include/channel_logger.h"
+#include "include/can_replay.h"
+#include "include/log_download.h"
+#include "sd_card_manager.h"
+#include "background_task.h"
+#include "block_pool.h"
+#include "include/nvs_cache.h"
+#include "include/boot_trace.h"
+#include "include/web_assets.h"
+#include "http_router.h"
+#include <stdlib.h>
+#include <sys/select.h>
+#include "lwip/sockets.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_timer.h"
 
 static const char *TAG = "WEB_SERVER";
 
-// Simple HTML dashboard
-const char dashboard_html[] = R"HTML(
-<!DOCTYPE html>
-<html>
-<head>
-    <meta charset="UTF-8">
-    <meta name="viewport" content="width=device-width, initial-scale=1.0">
-    <title>Turbo Control Dashboard</title>
-    <style>
-        body { 
-            margin: 0; 
-            padding: 20px; 
-            background: #0a0a0a;
-            color: #fff; 
-            font-family: 'Segoe UI', Tahoma, Geneva, Verdana, sans-serif;
-            overflow-x: hidden;
-        }
-        
-        .header {
-            display: flex;
-            justify-content: space-between;
-            align-items: center;
-            margin-bottom: 20px;
-            padding: 20px;
-            background: #1a1a1a;
-            border-radius: 10px;
-            border: 1px solid #333;
-        }
-        
-        .header-left {
-            display: flex;
-            align-items: center;
-            gap: 20px;
-        }
-        
-        .title {
-            font-size: 28px;
-            font-weight: bold;
-            color: #fff;
-        }
-        
-        .connection-status {
-            display: flex;
-            align-items: center;
-            gap: 8px;
-            color: #00FF88;
-            font-size: 14px;
-        }
-        
-        .status-dot {
-            width: 8px;
-            height: 8px;
-            background: #00FF88;
-            border-radius: 50%;
-            animation: pulse 2s infinite;
-        }
-        
-        .header-controls {
-            display: flex;
-            gap: 10px;
-        }
-        
-        .control-btn {
-            padding: 8px 16px;
-            background: #2a2a2a;
-            border: 1px solid #444;
-            border-radius: 6px;
-            color: #ccc;
-            cursor: pointer;
-            font-size: 12px;
-            transition: all 0.3s ease;
-        }
-        
-        .control-btn:hover {
-            background: #3a3a3a;
-            border-color: #555;
-        }
-        
-        .status-bar {
-            display: flex;
-            justify-content: space-between;
-            margin-bottom: 30px;
-            padding: 15px 20px;
-            background: #1a1a1a;
-            border-radius: 10px;
-            border: 1px solid #333;
-            font-size: 14px;
-        }
-        
-        .status-item {
-            display: flex;
-            align-items: center;
-            gap: 8px;
-        }
-        
-        .status-value {
-            color: #00D4FF;
-            font-weight: bold;
-        }
-        
-        .dashboard {
-            display: grid;
-            grid-template-columns: repeat(3, 1fr);
-            gap: 20px;
-            max-width: 1200px;
-            margin: 0 auto;
-        }
-        
-        .gauge-panel {
-            background: #1a1a1a;
-            border: 1px solid #333;
-            border-radius: 10px;
-            padding: 20px;
-            text-align: center;
-            height: 300px;
-            display: flex;
-            flex-direction: column;
-            align-items: center;
-            justify-content: space-between;
-        }
-        
-        .gauge-title {
-            font-size: 16px;
-            font-weight: bold;
-            color: #fff;
-            text-transform: uppercase;
-            margin-bottom: 5px;
-        }
-        
-        .gauge-subtitle {
-            font-size: 12px;
-            color: #aaa;
-            margin-bottom: 15px;
-        }
-        
-        .gauge-value-container {
-            display: flex;
-            align-items: center;
-            justify-content: center;
-            gap: 10px;
-            margin-bottom: 20px;
-        }
-        
-        .gauge-value {
-            font-size: 32px;
-            font-weight: bold;
-            color: #00D4FF;
-        }
-        
-        .gauge-icon {
-            width: 16px;
-            height: 16px;
-            background: #00D4FF;
-            border-radius: 3px;
-        }
-        
-        .gauge-unit {
-            font-size: 14px;
-            color: #888;
-            margin-bottom: 15px;
-        }
-        
-        .semi-circle-gauge {
-            width: 120px;
-            height: 60px;
-            position: relative;
-            margin-bottom: 15px;
-        }
-        
-        .semi-circle-bg {
-            fill: none;
-            stroke: #444;
-            stroke-width: 8;
-        }
-        
-        .semi-circle-value {
-            fill: none;
-            stroke-width: 8;
-            stroke-linecap: round;
-            transition: stroke-dasharray 0.5s ease;
-        }
-        
-        .gauge-pointer {
-            position: absolute;
-            width: 12px;
-            height: 12px;
-            background: #00FF88;
-            border-radius: 50%;
-            border: 2px solid #fff;
-            box-shadow: 0 0 5px rgba(0, 255, 136, 0.5);
-            transition: all 0.3s ease;
-        }
-        
-        .gauge-info {
-            font-size: 11px;
-            color: #666;
-            line-height: 1.4;
-        }
-        
-        .tcu-panel {
-            background: #1a1a1a;
-            border: 1px solid #333;
-            border-radius: 10px;
-            padding: 20px;
-            text-align: center;
-            height: 300px;
-            display: flex;
-            flex-direction: column;
-            align-items: center;
-            justify-content: space-between;
-        }
-        
-        .tcu-icon {
-            width: 80px;
-            height: 80px;
-            background: #00D4FF;
-            border-radius: 50%;
-            display: flex;
-            align-items: center;
-            justify-content: center;
-            margin: 20px 0;
-            position: relative;
-        }
-        
-        .tcu-icon::before {
-            content: "🛡️";
-            font-size: 40px;
+// The dashboard page is main/web/dashboard.html, served from web_assets
+
+// HTTP handler for main page
+static esp_err_t dashboard_handler(httpd_req_t *req)
+{
+    ESP_LOGD(TAG, "Dashboard handler called for URI: %s", req->uri);
+    return web_asset_send(req, web_asset_find("dashboard.html"));
+}
+
+// /data payload: the same gauge values as /events and /ws
+static esp_err_t send_can_data_json(httpd_req_t *req)
+{
+    char chunk[JSON_WRITER_CHUNK_SIZE];
+    json_writer_t w;
+    channel_snapshot_t snap;
+
+    ecu_data_live_snapshot(&snap);
+    httpd_resp_set_hdr(req, "Access-Control-Allow-Origin", "*");
+    json_writer_init_httpd(&w, req, chunk, sizeof(chunk));
+    ecu_data_write_gauges_json(&w, &snap);
+    return json_writer_finish(&w);
+}
+
+// Handler for CAN data
+static esp_err_t can_data_handler(httpd_req_t *req)
+{
+    ESP_LOGD(TAG, "CAN data handler called for URI: %s, method: %d", req->uri, req->method);
+    if (req->method == HTTP_GET) {
+        return send_can_data_json(req);
+    }
+    ESP_LOGW(TAG, "Invalid method for CAN data handler");
+    return ESP_FAIL;
+}
+
+// Channel metadata for the telemetry decoder: [{"name":..,"unit":..,"min":..,"max":..,"precision":..},...]
+static esp_err_t channels_handler(httpd_req_t *req)
+{
+    char chunk[JSON_WRITER_CHUNK_SIZE];
+    json_writer_t w;
+
+    json_writer_init_httpd(&w, req, chunk, sizeof(chunk));
+    json_arr_begin(&w);
+    for (uint8_t i = 0; i < channel_count(); i++) {
+        const channel_def_t *def = channel_get_def(i);
+        json_obj_begin(&w);
+        json_kv_str(&w, "name", def->name);
+        json_kv_str(&w, "unit", def->unit);
+        json_kv_float(&w, "min", def->min, def->precision);
+        json_kv_float(&w, "max", def->max, def->precision);
+        json_kv_int(&w, "precision", def->precision);
+        json_obj_end(&w);
+    }
+    json_arr_end(&w);
+    return json_writer_finish(&w);
+}
+
+// Binary telemetry frame with all channels
+static esp_err_t data_bin_handler(httpd_req_t *req)
+{
+    channel_snapshot_t snap;
+    ecu_data_live_snapshot(&snap);
+
+    // Polling clients keep no stream state, so every response is a keyframe
+    telemetry_encoder_t enc;
+    uint8_t frame[TELEMETRY_FRAME_MAX_SIZE];
+    telemetry_encoder_init(&enc);
+    int len = telemetry_frame_encode_snapshot(&enc, &snap, true, frame, sizeof(frame));
+    if (len < 0) {
+        httpd_resp_send_500(req);
+        return ESP_FAIL;
+    }
+
+    httpd_resp_set_type(req, "application/octet-stream");
+    httpd_resp_set_hdr(req, "Cache-Control", "no-store");
+    return httpd_resp_send(req, (const char *)frame, len);
+}
+
+// ============================================================================
+// SERVER-SENT EVENTS
+// ============================================================================
+
+// /events?hz=N keeps one response open per client. The handler writes the
+// headers and returns; the session stays open and web_events_task writes
+// "data: {...}" events to the socket. One payload is serialized per tick
+// for all streams, and a stream whose send buffer is full skips the tick
+// (the next event carries the newer values), so a slow client never holds
+// up the others or the server task.
+
+#define WEB_EVENTS_MAX_STREAMS  4       // Each also takes one of the router's stream slots
+#define WEB_EVENTS_TICK_MS      50      // 20 Hz, the highest rate a client can ask for
+#define WEB_EVENTS_MAX_HZ       (1000 / WEB_EVENTS_TICK_MS)
+#define WEB_EVENTS_DEFAULT_HZ   10
+#define WEB_EVENTS_STALL_MS     5000    // Backed up this long: the stream is closed
+
+typedef struct {
+    int fd;                         // -1 = free
+    uint32_t interval_us;
+    int64_t last_sent_us;
+    int64_t stalled_since_us;
+    bool ready;                     // Headers sent, events may follow
+} web_event_stream_t;
+
+static web_event_stream_t event_streams[WEB_EVENTS_MAX_STREAMS] = {
+    [0 ... WEB_EVENTS_MAX_STREAMS - 1] = { .fd = -1 }
+};
+static portMUX_TYPE event_lock = portMUX_INITIALIZER_UNLOCKED;
+
+static void web_events_remove(int fd)
+{
+    portENTER_CRITICAL(&event_lock);
+    for (int i = 0; i < WEB_EVENTS_MAX_STREAMS; i++) {
+        if (event_streams[i].fd == fd) {
+            event_streams[i].fd = -1;
+            break;
         }
-        
-        .tcu-status {
-            font-size: 18px;
-            font-weight: bold;
-            color: #00D4FF;
-            margin-bottom: 15px;
+    }
+    portEXIT_CRITICAL(&event_lock);
+}
+
+// Router close hook: every closed session passes here, only streams are in the table
+static void web_events_closed(int sockfd)
+{
+    web_events_remove(sockfd);
+}
+
+static esp_err_t events_handler(httpd_req_t *req)
+{
+    uint32_t hz = WEB_EVENTS_DEFAULT_HZ;
+    char query[32];
+    char value[8];
+    if (httpd_req_get_url_query_str(req, query, sizeof(query)) == ESP_OK &&
+        httpd_query_key_value(query, "hz", value, sizeof(value)) == ESP_OK) {
+        hz = (uint32_t)atoi(value);
+    }
+    if (hz == 0 || hz > WEB_EVENTS_MAX_HZ) {
+        hz = WEB_EVENTS_MAX_HZ;
+    }
+
+    // A stream slot of the shared server first, then one of ours
+    int fd = httpd_req_to_sockfd(req);
+    bool claimed = http_router_stream_begin(fd) == ESP_OK;
+    int slot = -1;
+    portENTER_CRITICAL(&event_lock);
+    for (int i = 0; i < WEB_EVENTS_MAX_STREAMS && claimed; i++) {
+        if (event_streams[i].fd < 0) {
+            slot = i;
+            event_streams[i].fd = fd;
+            event_streams[i].interval_us = 1000000 / hz;
+            event_streams[i].last_sent_us = 0;
+            event_streams[i].stalled_since_us = 0;
+            event_streams[i].ready = false;
+            break;
         }
-        
-        @keyframes pulse {
-            0%, 100% { opacity: 1; }
-            50% { opacity: 0.5; }
+    }
+    portEXIT_CRITICAL(&event_lock);
+
+    if (slot < 0) {
+        if (claimed) {
+            http_router_stream_end(fd);
+        }
+        // EventSource gives up on 503; the page polls and retries later
+        httpd_resp_set_status(req, "503 Service Unavailable");
+        httpd_resp_set_hdr(req, "Retry-After", "5");
+        return httpd_resp_send(req, NULL, 0);
+    }
+
+    // No length and no chunking: the body ends when the connection does
+    static const char headers[] =
+        "HTTP/1.1 200 OK\r\n"
+        "Content-Type: text/event-stream\r\n"
+        "Cache-Control: no-store\r\n"
+        "Access-Control-Allow-Origin: *\r\n"
+        "\r\n"
+        "retry: 2000\n\n";
+    if (httpd_send(req, headers, sizeof(headers) - 1) < 0) {
+        web_events_remove(fd);
+        return ESP_FAIL;
+    }
+    portENTER_CRITICAL(&event_lock);
+    if (event_streams[slot].fd == fd) {
+        event_streams[slot].ready = true;
+    }
+    portEXIT_CRITICAL(&event_lock);
+    return ESP_OK;
+}
+
+// One event with the gauge values: "data: {...}\n\n"
+static int web_events_format(char *buf, size_t cap)
+{
+    channel_snapshot_t snap;
+    ecu_data_live_snapshot(&snap);
+
+    static const char prefix[] = "data: ";
+    const size_t prefix_len = sizeof(prefix) - 1;
+    memcpy(buf, prefix, prefix_len);
+
+    json_writer_t w;
+    json_writer_init(&w, buf + prefix_len, cap - prefix_len - 2, NULL, NULL);
+    ecu_data_write_gauges_json(&w, &snap);
+    if (json_writer_finish(&w) != ESP_OK) {
+        return -1;
+    }
+
+    size_t len = prefix_len + w.len;
+    buf[len++] = '\n';
+    buf[len++] = '\n';
+    return (int)len;
+}
+
+static void web_events_task(void *pvParameters)
+{
+    char event[JSON_WRITER_CHUNK_SIZE];
+
+    while (1) {
+        vTaskDelay(pdMS_TO_TICKS(WEB_EVENTS_TICK_MS));
+
+        // Streams whose rate allows an event this tick, with half a tick of slack
+        int64_t now = esp_timer_get_time();
+        int due[WEB_EVENTS_MAX_STREAMS];
+        int due_count = 0;
+        portENTER_CRITICAL(&event_lock);
+        for (int i = 0; i < WEB_EVENTS_MAX_STREAMS; i++) {
+            const web_event_stream_t *st = &event_streams[i];
+            if (st->fd >= 0 && st->ready &&
+                now - st->last_sent_us >= (int64_t)st->interval_us - WEB_EVENTS_TICK_MS * 500) {
+                due[due_count++] = st->fd;
+            }
         }
-        
-        .gauge-panel:hover {
-            border-color: #00D4FF;
-            box-shadow: 0 0 15px rgba(0, 212, 255, 0.2);
+        portEXIT_CRITICAL(&event_lock);
+        if (due_count == 0) {
+            continue;
         }
-    </style>
-</head>
-<body>
-    <div class="header">
-        <div class="header-left">
-            <div class="title">Turbo Control Dashboard</div>
-            <div class="connection-status">
-                <div class="status-dot"></div>
-                Connected to ECU
-            </div>
-        </div>
-        <div class="header-controls">
-            <button class="control-btn">⚙️ Display Settings</button>
-            <button class="control-btn">⚙️ Settings</button>
-            <button class="control-btn">🔴 Record</button>
-        </div>
-    </div>
-    
-    <div class="status-bar">
-        <div class="status-item">
-            <span>TCU Status:</span>
-            <span class="status-value">Unknown</span>
-        </div>
-        <div class="status-item">
-            <span>Protection:</span>
-            <span class="status-value">Unknown</span>
-        </div>
-        <div class="status-item">
-            <span>Data Rate:</span>
-            <span class="status-value">20Hz</span>
-        </div>
-        <div class="status-item">
-            <span>Last Update:</span>
-            <span class="status-value">Never</span>
-        </div>
-    </div>
-    
-    <div class="dashboard">
-        <!-- BOOST PRESSURE -->
-        <div class="gauge-panel">
-            <div class="gauge-title">BOOST PRESSURE</div>
-            <div class="gauge-subtitle">MAP Sensor (kPa)</div>
-            <div class="gauge-value-container">
-                <div class="gauge-value" id="mapValue">0.0</div>
-                <div class="gauge-icon"></div>
-            </div>
-            <div class="gauge-unit">kPa</div>
-            <div class="semi-circle-gauge">
-                <svg width="120" height="60" viewBox="0 0 120 60">
-                    <path class="semi-circle-bg" d="M 20 50 A 40 40 0 0 1 100 50"></path>
-                    <path class="semi-circle-value" d="M 20 50 A 40 40 0 0 1 20 50" 
-                          stroke="#00FF88" id="mapGauge"></path>
-                </svg>
-                <div class="gauge-pointer" id="mapPointer" style="left: 20px; top: 50px;"></div>
-            </div>
-            <div class="gauge-info">
-                Target: <span id="mapTarget">0.0</span> kPa<br>
-                Range: 100-250 kPa
-            </div>
-        </div>
-        
-        <!-- WASTEGATE -->
-        <div class="gauge-panel">
-            <div class="gauge-title">WASTEGATE</div>
-            <div class="gauge-subtitle">Position Control (%)</div>
-            <div class="gauge-value-container">
-                <div class="gauge-value" id="wastegateValue">0.0</div>
-                <div class="gauge-icon"></div>
-            </div>
-            <div class="gauge-unit">%</div>
-            <div class="semi-circle-gauge">
-                <svg width="120" height="60" viewBox="0 0 120 60">
-                    <path class="semi-circle-bg" d="M 20 50 A 40 40 0 0 1 100 50"></path>
-                    <path class="semi-circle-value" d="M 20 50 A 40 40 0 0 1 20 50" 
-                          stroke="#00FF88" id="wastegateGauge"></path>
-                </svg>
-                <div class="gauge-pointer" id="wastegatePointer" style="left: 20px; top: 50px;"></div>
-            </div>
-            <div class="gauge-info">
-                Range: 0-100 %
-            </div>
-        </div>
-        
-        <!-- THROTTLE -->
-        <div class="gauge-panel">
-            <div class="gauge-title">THROTTLE</div>
-            <div class="gauge-subtitle">TPS Position (%)</div>
-            <div class="gauge-value-container">
-                <div class="gauge-value" id="tpsValue">0.0</div>
-                <div class="gauge-icon"></div>
-            </div>
-            <div class="gauge-unit">%</div>
-            <div class="semi-circle-gauge">
-                <svg width="120" height="60" viewBox="0 0 120 60">
-                    <path class="semi-circle-bg" d="M 20 50 A 40 40 0 0 1 100 50"></path>
-                    <path class="semi-circle-value" d="M 20 50 A 40 40 0 0 1 20 50" 
-                          stroke="#FFD700" id="tpsGauge"></path>
-                </svg>
-                <div class="gauge-pointer" id="tpsPointer" style="left: 20px; top: 50px;"></div>
-            </div>
-            <div class="gauge-info">
-                Range: 0-100 %
-            </div>
-        </div>
-        
-        <!-- ENGINE RPM -->
-        <div class="gauge-panel">
-            <div class="gauge-title">ENGINE RPM</div>
-            <div class="gauge-subtitle">Engine Speed</div>
-            <div class="gauge-value-container">
-                <div class="gauge-value" id="rpmValue">0</div>
-                <div class="gauge-icon"></div>
-            </div>
-            <div class="gauge-unit">RPM</div>
-            <div class="semi-circle-gauge">
-                <svg width="120" height="60" viewBox="0 0 120 60">
-                    <path class="semi-circle-bg" d="M 20 50 A 40 40 0 0 1 100 50"></path>
-                    <path class="semi-circle-value" d="M 20 50 A 40 40 0 0 1 20 50" 
-                          stroke="#FF6B35" id="rpmGauge"></path>
-                </svg>
-                <div class="gauge-pointer" id="rpmPointer" style="left: 20px; top: 50px;"></div>
-            </div>
-            <div class="gauge-info">
-                Range: 0-7000 RPM
-            </div>
-        </div>
-        
-        <!-- TARGET BOOST -->
-        <div class="gauge-panel">
-            <div class="gauge-title">TARGET BOOST</div>
-            <div class="gauge-subtitle">Desired Pressure (kPa)</div>
-            <div class="gauge-value-container">
-                <div class="gauge-value" id="boostValue">0.0</div>
-                <div class="gauge-icon"></div>
-            </div>
-            <div class="gauge-unit">kPa</div>
-            <div class="semi-circle-gauge">
-                <svg width="120" height="60" viewBox="0 0 120 60">
-                    <path class="semi-circle-bg" d="M 20 50 A 40 40 0 0 1 100 50"></path>
-                    <path class="semi-circle-value" d="M 20 50 A 40 40 0 0 1 20 50" 
-                          stroke="#FFD700" id="boostGauge"></path>
-                </svg>
-                <div class="gauge-pointer" id="boostPointer" style="left: 20px; top: 50px;"></div>
-            </div>
-            <div class="gauge-info">
-                Range: 100-250 kPa
-            </div>
-        </div>
-        
-        <!-- TCU STATUS -->
-        <div class="tcu-panel">
-            <div class="gauge-title">TCU STATUS</div>
-            <div class="gauge-subtitle">Transmission Control</div>
-            <div class="tcu-icon"></div>
-            <div class="tcu-status" id="tcuStatus">UNKNOWN</div>
-            <div class="gauge-info">
-                Torque Req: <span id="torqueReq">0</span>%<br>
-                Transmission Status
-            </div>
-        </div>
-    </div>
-
-    <script>
-        // Gauge ranges and colors
-        const gaugeConfig = {
-            map: { min: 100, max: 250, color: '#00FF88', target: 180 },
-            wastegate: { min: 0, max: 100, color: '#00FF88' },
-            tps: { min: 0, max: 100, color: '#FFD700' },
-            rpm: { min: 0, max: 7000, color: '#FF6B35' },
-            boost: { min: 100, max: 250, color: '#FFD700' }
-        };
-        
-        function updateSemiCircleGauge(gaugeId, pointerId, value, config) {
-            const gauge = document.getElementById(gaugeId);
-            const pointer = document.getElementById(pointerId);
-            
-            if (!gauge || !pointer) return;
-            
-            const percentage = Math.min(Math.max((value - config.min) / (config.max - config.min), 0), 1);
-            const angle = percentage * Math.PI; // 0 to π (semi-circle)
-            const radius = 40;
-            
-            // Calculate pointer position
-            const x = 20 + radius * Math.cos(angle);
-            const y = 50 - radius * Math.sin(angle);
-            
-            // Update gauge arc
-            const arcLength = percentage * Math.PI * radius;
-            gauge.style.strokeDasharray = `${arcLength} ${Math.PI * radius}`;
-            
-            // Update pointer position
-            pointer.style.left = `${x}px`;
-            pointer.style.top = `${y}px`;
-            pointer.style.background = config.color;
+
+        int len = web_events_format(event, sizeof(event));
+        if (len < 0) {
+            continue;
         }
-        
-        function updateTCUStatus(rpm) {
-            const status = document.getElementById('tcuStatus');
-            const icon = document.querySelector('.tcu-icon');
-            
-            if (rpm > 5500) {
-                status.textContent = 'ERROR';
-                status.style.color = '#FF0000';
-                icon.style.background = '#FF0000';
-            } else if (rpm > 4500) {
-                status.textContent = 'WARNING';
-                status.style.color = '#FFAA00';
-                icon.style.background = '#FFAA00';
-            } else {
-                status.textContent = 'OK';
-                status.style.color = '#00FF88';
-                icon.style.background = '#00FF88';
+
+        fd_set writable;
+        FD_ZERO(&writable);
+        int max_fd = -1;
+        for (int i = 0; i < due_count; i++) {
+            FD_SET(due[i], &writable);
+            if (due[i] > max_fd) {
+                max_fd = due[i];
             }
         }
-        
-        function updateStatusBar() {
-            const now = new Date();
-            const timeStr = now.toLocaleTimeString();
-            document.querySelector('.status-bar .status-item:last-child .status-value').textContent = timeStr;
-        }
-        
-        function startDataPolling() {
-            document.querySelector('.connection-status').innerHTML = '<div class="status-dot"></div>Connected to ECU';
-            setInterval(fetchData, 1000);
-            setInterval(updateStatusBar, 1000);
-        }
-        
-        function fetchData() {
-            fetch('/data')
-                .then(response => response.json())
-                .then(data => {
-                    updateGauges(data);
-                })
-                .catch(error => {
-                    console.error('Error:', error);
-                });
+        struct timeval no_wait = { 0, 0 };
+        if (select(max_fd + 1, NULL, &writable, NULL, &no_wait) < 0) {
+            FD_ZERO(&writable);
         }
-        
-        function updateGauges(data) {
-            // Update values
-            document.getElementById('mapValue').textContent = (data.map_pressure || 0).toFixed(1);
-            document.getElementById('wastegateValue').textContent = (data.wastegate_pos || 0).toFixed(1);
-            document.getElementById('tpsValue').textContent = (data.tps_position || 0).toFixed(1);
-            document.getElementById('rpmValue').textContent = data.engine_rpm || 0;
-            document.getElementById('boostValue').textContent = (data.target_boost || 0).toFixed(1);
-            
-            // Update targets
-            document.getElementById('mapTarget').textContent = (data.target_boost || 0).toFixed(1);
-            document.getElementById('torqueReq').textContent = Math.round((data.wastegate_pos || 0) * 0.8);
-            
-            // Update gauges
-            updateSemiCircleGauge('mapGauge', 'mapPointer', data.map_pressure || 0, gaugeConfig.map);
-            updateSemiCircleGauge('wastegateGauge', 'wastegatePointer', data.wastegate_pos || 0, gaugeConfig.wastegate);
-            updateSemiCircleGauge('tpsGauge', 'tpsPointer', data.tps_position || 0, gaugeConfig.tps);
-            updateSemiCircleGauge('rpmGauge', 'rpmPointer', data.engine_rpm || 0, gaugeConfig.rpm);
-            updateSemiCircleGauge('boostGauge', 'boostPointer', data.target_boost || 0, gaugeConfig.boost);
-            
-            // Update TCU status
-            updateTCUStatus(data.engine_rpm || 0);
+
+        httpd_handle_t server = http_router_handle();
+        for (int i = 0; i < due_count && server != NULL; i++) {
+            int fd = due[i];
+            bool room = FD_ISSET(fd, &writable);
+            bool failed = room && httpd_socket_send(server, fd, event, len, 0) != len;
+
+            now = esp_timer_get_time();
+            bool stalled = false;
+            portENTER_CRITICAL(&event_lock);
+            for (int j = 0; j < WEB_EVENTS_MAX_STREAMS; j++) {
+                web_event_stream_t *st = &event_streams[j];
+                if (st->fd != fd) {
+                    continue;
+                }
+                if (room && !failed) {
+                    st->last_sent_us = now;
+                    st->stalled_since_us = 0;
+                } else if (!room) {
+                    if (st->stalled_since_us == 0) {
+                        st->stalled_since_us = now;
+                    } else if (now - st->stalled_since_us > (int64_t)WEB_EVENTS_STALL_MS * 1000) {
+                        st->stalled_since_us = now;
+                        stalled = true;
+                    }
+                }
+                break;
+            }
+            portEXIT_CRITICAL(&event_lock);
+
+            if (failed || stalled) {
+                ESP_LOGD(TAG, "Closing event stream fd %d (%s)", fd, failed ? "send error" : "stalled");
+                httpd_sess_trigger_close(server, fd);
+            }
         }
-        
-        window.onload = function() {
-            startDataPolling(); // Start data polling directly on page load
-        };
-    </script>
-</body>
-</html>
-)HTML";
+    }
+}
 
-// HTTP handler for main page
-static esp_err_t dashboard_handler(httpd_req_t *req)
+// SD trace logger counters
+static esp_err_t logger_handler(httpd_req_t *req)
 {
-    ESP_LOGI(TAG, "Dashboard handler called for URI: %s", req->uri);
-    httpd_resp_set_type(req, "text/html");
-    httpd_resp_set_hdr(req, "Access-Control-Allow-Origin", "*");
-    httpd_resp_send(req, dashboard_html, HTTPD_RESP_USE_STRLEN);
-    ESP_LOGI(TAG, "Dashboard HTML sent successfully");
-    return ESP_OK;
+    can_logger_stats_t stats;
+    sd_card_latency_stats_t latency;
+    char path[32];
+    can_logger_get_stats(&stats);
+    can_logger_get_path(path, sizeof(path));
+    sd_card_get_write_latency(&latency);
+    sd_card_async_stats_t requests;
+    sd_card_get_async_stats(&requests);
+    channel_logger_stats_t channels;
+    char channel_path[32];
+    channel_logger_get_stats(&channels);
+    channel_logger_get_path(channel_path, sizeof(channel_path));
+
+    char chunk[JSON_WRITER_CHUNK_SIZE];
+    json_writer_t w;
+    json_writer_init_httpd(&w, req, chunk, sizeof(chunk));
+    json_obj_begin(&w);
+    json_kv_bool(&w, "running", can_logger_is_running());
+    json_kv_str(&w, "file", path);
+    json_kv_uint(&w, "frames_logged", stats.frames_logged);
+    json_kv_uint(&w, "frames_dropped", stats.frames_dropped);
+    json_kv_uint(&w, "blocks_written", stats.blocks_written);
+    json_kv_uint(&w, "bytes_written", stats.bytes_written);
+    json_kv_uint(&w, "write_errors", stats.write_errors);
+    json_kv_uint(&w, "last_write_us", stats.last_write_us);
+    json_kv_uint(&w, "max_write_us", stats.max_write_us);
+    json_kv_uint(&w, "segments_created", stats.segments_created);
+    json_kv_uint(&w, "segments_deleted", stats.segments_deleted);
+    json_kv_uint(&w, "prealloc_failures", stats.prealloc_failures);
+
+    // Compression: ratio of record bytes to stored bytes, and CPU time
+    // normalised to one uncompressed 16 KB block
+    json_key(&w, "compression");
+    json_obj_begin(&w);
+    json_kv_uint(&w, "in_bytes", stats.compress_in_bytes);
+    json_kv_uint(&w, "out_bytes", stats.compress_out_bytes);
+    json_kv_float(&w, "ratio", stats.compress_out_bytes > 0 ?
+                  (float)stats.compress_in_bytes / (float)stats.compress_out_bytes : 0.0f, 2);
+    json_kv_uint(&w, "us_per_block", stats.compress_in_bytes > 0 ?
+                 stats.compress_us * CAN_LOGGER_BLOCK_SIZE / stats.compress_in_bytes : 0);
+    json_kv_uint(&w, "max_us", stats.compress_max_us);
+    json_obj_end(&w);
+
+    // Write latency over all SD writes, not only the logger's
+    json_key(&w, "sd_write_latency_us");
+    json_obj_begin(&w);
+    json_kv_uint(&w, "count", latency.count);
+    json_kv_uint(&w, "p50", latency.p50_us);
+    json_kv_uint(&w, "p90", latency.p90_us);
+    json_kv_uint(&w, "p99", latency.p99_us);
+    json_kv_uint(&w, "p999", latency.p999_us);
+    json_kv_uint(&w, "max", latency.max_us);
+    json_obj_end(&w);
+
+    // Requests served by the SD I/O task, latency from submission to completion
+    json_key(&w, "sd_requests");
+    json_obj_begin(&w);
+    json_kv_uint(&w, "submitted", requests.submitted);
+    json_kv_uint(&w, "completed", requests.completed);
+    json_kv_uint(&w, "failed", requests.failed);
+    json_kv_uint(&w, "rejected", requests.rejected);
+    json_kv_uint(&w, "merged", requests.merged);
+    json_kv_uint(&w, "queue_depth", requests.queue_depth);
+    json_kv_uint(&w, "max_queue_depth", requests.max_queue_depth);
+    json_kv_uint(&w, "p50_us", requests.latency.p50_us);
+    json_kv_uint(&w, "p99_us", requests.latency.p99_us);
+    json_kv_uint(&w, "max_us", requests.latency.max_us);
+    json_obj_end(&w);
+
+    // Columnar channel log (CHNnnnnn.COL)
+    json_key(&w, "channel_log");
+    json_obj_begin(&w);
+    json_kv_bool(&w, "running", channel_logger_is_running());
+    json_kv_str(&w, "file", channel_path);
+    json_kv_uint(&w, "samples_logged", channels.samples_logged);
+    json_kv_uint(&w, "samples_stale", channels.samples_stale);
+    json_kv_uint(&w, "blocks_closed", channels.blocks_closed);
+    json_kv_uint(&w, "blocks_dropped", channels.blocks_dropped);
+    json_kv_uint(&w, "pages_written", channels.pages_written);
+    json_kv_uint(&w, "bytes_written", channels.bytes_written);
+    json_kv_uint(&w, "write_errors", channels.write_errors);
+    json_kv_uint(&w, "max_write_us", channels.max_write_us);
+    json_kv_uint(&w, "max_sample_us", channels.max_sample_us);
+    json_obj_end(&w);
+    json_obj_end(&w);
+    return json_writer_finish(&w);
 }
 
-// Handler for CAN data
-static esp_err_t can_data_handler(httpd_req_t *req)
+// Trace replay control: /replay?file=CAN00001.BIN&speed=10&loop=1 starts,
+// /replay?stop=1 stops, plain /replay reports the progress
+static esp_err_t replay_handler(httpd_req_t *req)
 {
-    ESP_LOGI(TAG, "CAN data handler called for URI: %s, method: %d", req->uri, req->method);
-    if (req->method == HTTP_GET) {
-        // Check if demo mode is enabled
-        bool demo_enabled = demo_mode_get_enabled();
-        ESP_LOGI(TAG, "🌐 Web server - demo mode check: %s", demo_enabled ? "ENABLED" : "DISABLED");
-
-        if (demo_enabled) {
-            // Return simulated CAN data for demo (since WebSocket server has real data)
-            char json_data[256];
-            static int demo_counter = 0;
-            demo_counter++;
-
-            // Generate demo data using simple periodic functions
-            int cycle = demo_counter % 100;
-            float phase = cycle / 100.0f;
-            float map_pressure = 120.0f + 30.0f * (cycle > 50 ? (100 - cycle) : cycle) / 50.0f;
-            float wastegate_pos = 45.0f + 25.0f * phase;
-            float tps_position = 35.0f + 30.0f * phase;
-            float engine_rpm = 2500.0f + 500.0f * phase;
-            float target_boost = 180.0f + 20.0f * phase;
-            int tcu_status = (demo_counter % 100 > 95) ? 1 : 0; // Occasional warning
-
-            snprintf(json_data, sizeof(json_data),
-                "{\"map_pressure\":%.1f,\"wastegate_pos\":%.1f,\"tps_position\":%.1f,"
-                "\"engine_rpm\":%.0f,\"target_boost\":%.1f,\"tcu_status\":%d}",
-                map_pressure, wastegate_pos, tps_position, engine_rpm, target_boost, tcu_status);
-
-            httpd_resp_set_type(req, "application/json");
-            httpd_resp_set_hdr(req, "Access-Control-Allow-Origin", "*");
-            httpd_resp_send(req, json_data, HTTPD_RESP_USE_STRLEN);
-            ESP_LOGI(TAG, "CAN demo data JSON sent successfully");
-        } else {
-            // Demo mode disabled, return zero values
-            char json_data[256];
-            snprintf(json_data, sizeof(json_data),
-                "{\"map_pressure\":0.0,\"wastegate_pos\":0.0,\"tps_position\":0.0,"
-                "\"engine_rpm\":0,\"target_boost\":0.0,\"tcu_status\":0}");
-
-            httpd_resp_set_type(req, "application/json");
-            httpd_resp_set_hdr(req, "Access-Control-Allow-Origin", "*");
-            httpd_resp_send(req, json_data, HTTPD_RESP_USE_STRLEN);
-            ESP_LOGI(TAG, "❌ Demo mode disabled, zero values sent to client");
+    char query[96];
+    char value[32];
+    esp_err_t start_ret = ESP_OK;
+
+    if (httpd_req_get_url_query_str(req, query, sizeof(query)) == ESP_OK) {
+        if (httpd_query_key_value(query, "stop", value, sizeof(value)) == ESP_OK) {
+            can_replay_stop();
+        } else if (httpd_query_key_value(query, "file", value, sizeof(value)) == ESP_OK) {
+            // Only plain file names in the card root
+            if (strchr(value, '/') != NULL || strstr(value, "..") != NULL) {
+                httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Invalid file name");
+                return ESP_FAIL;
+            }
+            char path[48];
+            snprintf(path, sizeof(path), "%s/%s", CAN_LOGGER_DIR, value);
+
+            can_replay_config_t config = CAN_REPLAY_DEFAULT_CONFIG();
+            char number[12];
+            if (httpd_query_key_value(query, "speed", number, sizeof(number)) == ESP_OK) {
+                config.speed = strtof(number, NULL);    // 0 = as fast as possible
+                if (config.speed < 0.0f) {
+                    config.speed = 0.0f;
+                }
+            }
+            if (httpd_query_key_value(query, "loop", number, sizeof(number)) == ESP_OK) {
+                config.loop = atoi(number) != 0;
+            }
+            start_ret = can_replay_start(path, &config);
         }
-        return ESP_OK;
     }
-    ESP_LOGW(TAG, "Invalid method for CAN data handler");
-    return ESP_FAIL;
+
+    can_replay_stats_t stats;
+    can_replay_get_stats(&stats);
+
+    char chunk[JSON_WRITER_CHUNK_SIZE];
+    json_writer_t w;
+    json_writer_init_httpd(&w, req, chunk, sizeof(chunk));
+    json_obj_begin(&w);
+    json_kv_bool(&w, "running", can_replay_is_running());
+    if (start_ret != ESP_OK) {
+        json_kv_str(&w, "error", esp_err_to_name(start_ret));
+    }
+    json_kv_uint(&w, "frames", stats.frames);
+    json_kv_uint(&w, "parse_errors", stats.parse_errors);
+    json_kv_uint(&w, "crc_errors", stats.crc_errors);
+    json_kv_uint(&w, "loops", stats.loops);
+    json_kv_uint(&w, "trace_ms", stats.trace_us / 1000);
+    json_kv_uint(&w, "elapsed_ms", stats.elapsed_us / 1000);
+    json_kv_uint(&w, "max_lag_us", stats.max_lag_us);
+    json_obj_end(&w);
+    return json_writer_finish(&w);
+}
+
+// Background queue: per job type counts, wait in the queue and run time,
+// the payload pool's high-water marks and the NVS cache
+static esp_err_t tasks_handler(httpd_req_t *req)
+{
+    background_stats_t stats;
+    background_task_get_stats(&stats);
+    block_pool_stats_t pool;
+    block_pool_get_stats(&pool);
+    nvs_cache_stats_t nvs;
+    nvs_cache_get_stats(&nvs);
+
+    char chunk[JSON_WRITER_CHUNK_SIZE];
+    json_writer_t w;
+    json_writer_init_httpd(&w, req, chunk, sizeof(chunk));
+    json_obj_begin(&w);
+    json_kv_uint(&w, "pending", stats.pending);
+    json_kv_uint(&w, "max_pending", stats.max_pending);
+    json_kv_uint(&w, "handles_in_use", stats.handles_in_use);
+    json_kv_uint(&w, "active_workers", stats.active_workers);
+    json_key(&w, "workers");
+    json_arr_begin(&w);
+    for (int i = 0; i < stats.worker_count; i++) {
+        const background_worker_stats_t *ws = &stats.workers[i];
+        json_obj_begin(&w);
+        json_kv_uint(&w, "core", ws->core);
+        json_kv_uint(&w, "completed", ws->completed);
+        json_kv_uint(&w, "stolen", ws->stolen);
+        json_kv_uint(&w, "busy_ms", (uint32_t)(ws->busy_us / 1000));
+        json_obj_end(&w);
+    }
+    json_arr_end(&w);
+    json_key(&w, "types");
+    json_obj_begin(&w);
+    for (int i = 0; i < BG_TASK_TYPE_COUNT; i++) {
+        const background_type_stats_t *t = &stats.types[i];
+        if (t->submitted == 0 && t->rejected == 0) {
+            continue;
+        }
+        json_key(&w, background_task_type_name((background_task_type_t)i));
+        json_obj_begin(&w);
+        json_kv_uint(&w, "submitted", t->submitted);
+        json_kv_uint(&w, "completed", t->completed);
+        json_kv_uint(&w, "failed", t->failed);
+        json_kv_uint(&w, "coalesced", t->coalesced);
+        json_kv_uint(&w, "rejected", t->rejected);
+        json_kv_uint(&w, "cancelled", t->cancelled);
+        json_kv_uint(&w, "expired", t->expired);
+        json_kv_uint(&w, "overruns", t->overruns);
+        json_kv_uint(&w, "avg_wait_us", t->completed > 0 ? (uint32_t)(t->total_wait_us / t->completed) : 0);
+        json_kv_uint(&w, "max_wait_us", t->max_wait_us);
+        json_kv_uint(&w, "avg_run_us", t->completed > 0 ? (uint32_t)(t->total_run_us / t->completed) : 0);
+        json_kv_uint(&w, "max_run_us", t->max_run_us);
+        json_obj_end(&w);
+    }
+    json_obj_end(&w);
+
+    json_key(&w, "pool");
+    json_obj_begin(&w);
+    json_kv_uint(&w, "heap_allocs", pool.heap_allocs);
+    json_kv_uint(&w, "heap_in_use", pool.heap_in_use);
+    json_key(&w, "classes");
+    json_arr_begin(&w);
+    for (int i = 0; i < BLOCK_POOL_CLASSES; i++) {
+        const block_pool_class_stats_t *c = &pool.classes[i];
+        json_obj_begin(&w);
+        json_kv_uint(&w, "block_size", c->block_size);
+        json_kv_uint(&w, "blocks", c->blocks);
+        json_kv_uint(&w, "in_use", c->in_use);
+        json_kv_uint(&w, "high_water", c->high_water);
+        json_kv_uint(&w, "allocs", c->allocs);
+        json_kv_uint(&w, "exhausted", c->exhausted);
+        json_obj_end(&w);
+    }
+    json_arr_end(&w);
+    json_obj_end(&w);
+
+    // Flash writes avoided: changes folded into a pending write or equal to flash
+    json_key(&w, "nvs_cache");
+    json_obj_begin(&w);
+    json_kv_uint(&w, "sets", nvs.sets);
+    json_kv_uint(&w, "erases", nvs.erases);
+    json_kv_uint(&w, "writes_avoided", nvs.writes_avoided);
+    json_kv_uint(&w, "write_through", nvs.write_through);
+    json_kv_uint(&w, "flushes", nvs.flushes);
+    json_kv_uint(&w, "commits", nvs.commits);
+    json_kv_uint(&w, "keys_written", nvs.keys_written);
+    json_kv_uint(&w, "flush_errors", nvs.flush_errors);
+    json_kv_uint(&w, "read_hits", nvs.read_hits);
+    json_kv_uint(&w, "read_misses", nvs.read_misses);
+    json_kv_uint(&w, "dirty", nvs.dirty);
+    json_kv_uint(&w, "max_flush_us", nvs.max_flush_us);
+    json_obj_end(&w);
+    json_obj_end(&w);
+    return json_writer_finish(&w);
 }
 
-// Start dashboard web server
+// Boot timeline: stages and milestones in the order they started,
+// times in microseconds since boot
+static esp_err_t boot_handler(httpd_req_t *req)
+{
+    static boot_trace_entry_t entries[BOOT_TRACE_MAX_ENTRIES];
+    size_t count = boot_trace_get(entries, BOOT_TRACE_MAX_ENTRIES);
+
+    char chunk[JSON_WRITER_CHUNK_SIZE];
+    json_writer_t w;
+    json_writer_init_httpd(&w, req, chunk, sizeof(chunk));
+    json_obj_begin(&w);
+    json_key(&w, "stages");
+    json_arr_begin(&w);
+    for (size_t i = 0; i < count; i++) {
+        const boot_trace_entry_t *e = &entries[i];
+        json_obj_begin(&w);
+        json_kv_str(&w, "name", e->name);
+        json_kv_int(&w, "start_us", e->start_us);
+        if (e->end_us != 0) {
+            json_kv_int(&w, "end_us", e->end_us);
+        }
+        json_kv_int(&w, "core", e->core);
+        if (e->end_us != e->start_us) {
+            json_kv_str(&w, "result", e->end_us != 0 ? esp_err_to_name(e->result) : "running");
+        }
+        json_obj_end(&w);
+    }
+    json_arr_end(&w);
+    json_obj_end(&w);
+    return json_writer_finish(&w);
+}
+
+// Shared server counters: sessions, streams and purges
+static esp_err_t http_stats_handler(httpd_req_t *req)
+{
+    http_router_stats_t stats;
+    http_router_get_stats(&stats);
+
+    char chunk[JSON_WRITER_CHUNK_SIZE];
+    json_writer_t w;
+    json_writer_init_httpd(&w, req, chunk, sizeof(chunk));
+    json_obj_begin(&w);
+    json_kv_uint(&w, "routes", stats.routes);
+    json_kv_uint(&w, "sessions", stats.sessions);
+    json_kv_uint(&w, "max_sessions", stats.max_sessions);
+    json_kv_uint(&w, "session_limit", HTTP_ROUTER_MAX_SESSIONS);
+    json_kv_uint(&w, "streams", stats.streams);
+    json_kv_uint(&w, "stream_limit", CONFIG_HTTP_ROUTER_MAX_STREAMS);
+    json_kv_uint(&w, "stream_rejects", stats.stream_rejects);
+    json_kv_uint(&w, "purged", stats.purged);
+    json_kv_uint(&w, "requests", stats.requests);
+    json_obj_end(&w);
+    return json_writer_finish(&w);
+}
+
+// Dashboard routes on the shared server
+static const httpd_uri_t dashboard_routes[] = {
+    { .uri = "/",          .method = HTTP_GET, .handler = dashboard_handler },
+    { .uri = "/dashboard", .method = HTTP_GET, .handler = dashboard_handler },
+    { .uri = "/data",      .method = HTTP_GET, .handler = can_data_handler },
+    // Channel metadata and binary telemetry frames
+    { .uri = "/channels",  .method = HTTP_GET, .handler = channels_handler },
+    { .uri = "/data.bin",  .method = HTTP_GET, .handler = data_bin_handler },
+    // Live gauge values as Server-Sent Events
+    { .uri = "/events",    .method = HTTP_GET, .handler = events_handler },
+    { .uri = "/logger",    .method = HTTP_GET, .handler = logger_handler },
+    { .uri = "/replay",    .method = HTTP_GET, .handler = replay_handler },
+    { .uri = "/tasks",     .method = HTTP_GET, .handler = tasks_handler },
+    { .uri = "/boot",      .method = HTTP_GET, .handler = boot_handler },
+    { .uri = "/http",      .method = HTTP_GET, .handler = http_stats_handler },
+};
+
+// Start dashboard web server: starts the shared server and adds the dashboard routes
 esp_err_t start_dashboard_web_server(void)
 {
-    httpd_config_t config = HTTPD_DEFAULT_CONFIG();
-    config.server_port = 80;
-    config.max_open_sockets = 7;
-    
-    httpd_handle_t server = NULL;
-    
-    ESP_LOGI(TAG, "Starting dashboard web server on port: %d", config.server_port);
-    
-    if (httpd_start(&server, &config) == ESP_OK) {
-        // Register main page handler
-        httpd_uri_t dashboard_uri = {
-            .uri = "/",
-            .method = HTTP_GET,
-            .handler = dashboard_handler,
-            .user_ctx = NULL
-        };
-        httpd_register_uri_handler(server, &dashboard_uri);
-        
-        // Also handle /dashboard
-        httpd_uri_t dashboard_alt_uri = {
-            .uri = "/dashboard",
-            .method = HTTP_GET,
-            .handler = dashboard_handler,
-            .user_ctx = NULL
-        };
-        httpd_register_uri_handler(server, &dashboard_alt_uri);
-        
-        // Handler for CAN data
-        httpd_uri_t can_data_uri = {
-            .uri = "/data",
-            .method = HTTP_GET,
-            .handler = can_data_handler,
-            .user_ctx = NULL
-        };
-        httpd_register_uri_handler(server, &can_data_uri);
-        
-        ESP_LOGI(TAG, "Dashboard web server started successfully");
-        return ESP_OK;
+    esp_err_t ret = http_router_start();
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Error starting dashboard web server");
+        return ret;
     }
-    
-    ESP_LOGE(TAG, "Error starting dashboard web server");
-    return ESP_FAIL;
+
+    for (size_t i = 0; i < sizeof(dashboard_routes) / sizeof(dashboard_routes[0]); i++) {
+        esp_err_t r = http_router_register(&dashboard_routes[i]);
+        if (r != ESP_OK && ret == ESP_OK) {
+            ret = r;
+        }
+    }
+
+    // File list and downloads from the SD card
+    esp_err_t r = log_download_register();
+    if (r != ESP_OK && ret == ESP_OK) {
+        ret = r;
+    }
+
+    // Drops closed event streams from the table
+    http_router_add_close_hook(web_events_closed);
+    if (xTaskCreate(web_events_task, "web_events", 4096, NULL, 5, NULL) != pdPASS) {
+        ESP_LOGE(TAG, "Failed to create event stream task");
+    }
+
+    ESP_LOGI(TAG, "Dashboard web server started successfully");
+    return ret;
 }
@@ -0,0 +1,242 @@
+/*
+ * Host benchmark and check: CAN trace logger
+ *
+ *   bench_can_logger [seconds] [compress 0/1] [realtime 0/1] [segment_mb] [flush_ms]
+ *
+ * Feeds the real logger (logger task on a thread, files in ./sdcard) with a
+ * synthetic VW-style bus: 48 periodic IDs at 10-100 ms, 3960 frames/s,
+ * rolling counters, XOR checksums and slowly changing signals. In burst
+ * mode (realtime 0) the frames are produced as fast as the logger accepts
+ * them. Afterwards every segment is read back with can_log_reader, and the
+ * frames must come back complete, in order and with non-decreasing times.
+ * Prints the compression ratio and cost per 16 KB of records.
+ */
+
+#include "include/can_logger.h"
+#include "include/can_log_reader.h"
+#include "esp_timer.h"
+#include <dirent.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+typedef struct {
+    uint32_t id;
+    int period_ms;
+} bus_message_t;
+
+static const bus_message_t bus[] = {
+    { 0x280, 10 }, { 0x288, 10 }, { 0x380, 10 }, { 0x388, 10 }, { 0x480, 10 }, { 0x488, 10 },
+    { 0x580, 10 }, { 0x1A0, 10 }, { 0x4A0, 10 }, { 0x5A0, 10 }, { 0x320, 20 }, { 0x420, 20 },
+    { 0x520, 20 }, { 0x540, 20 }, { 0x390, 20 }, { 0x394, 20 }, { 0x3D0, 20 }, { 0x440, 20 },
+    { 0x50C, 20 }, { 0x570, 20 }, { 0x60E, 50 }, { 0x62E, 50 }, { 0x65D, 100 }, { 0x727, 100 },
+    { 0x35B, 10 }, { 0x3E5, 10 }, { 0x101, 10 }, { 0x0C2, 10 }, { 0x1AC, 10 }, { 0x0D0, 10 },
+    { 0x4A8, 10 }, { 0x5D2, 10 }, { 0x3C0, 10 }, { 0x3E0, 10 }, { 0x12B, 10 }, { 0x17B, 10 },
+    { 0x1F5, 10 }, { 0x086, 10 }, { 0x0FD, 10 }, { 0x106, 10 }, { 0x116, 10 }, { 0x12E, 10 },
+    { 0x13C, 10 }, { 0x14C, 10 }, { 0x30B, 10 }, { 0x31B, 10 }, { 0x0B2, 10 }, { 0x0C0, 10 },
+};
+
+#define BUS_COUNT (sizeof(bus) / sizeof(bus[0]))
+
+typedef struct {
+    uint32_t id;
+    uint8_t data[8];
+} expected_frame_t;
+
+static void make_frame(int cycle, unsigned k, twai_message_t *m)
+{
+    memset(m, 0, sizeof(*m));
+    m->identifier = bus[k].id;
+    m->data_length_code = 8;
+    uint16_t signal = (uint16_t)(3000 + 1000 * sin(cycle * 0.003 + k));
+    m->data[0] = cycle & 0x0F;
+    m->data[1] = signal & 0xFF;
+    m->data[2] = signal >> 8;
+    m->data[3] = (uint8_t)(k * 3);
+    m->data[4] = (uint8_t)(cycle / 50);
+    m->data[5] = (uint8_t)(0x10 + k);
+    m->data[6] = k % 3 ? 0 : (uint8_t)(cycle / 7);
+    uint8_t checksum = 0;
+    for (int b = 0; b < 7; b++) {
+        checksum ^= m->data[b];
+    }
+    m->data[7] = checksum;
+}
+
+static int compare_numbers(const void *a, const void *b)
+{
+    uint32_t x = *(const uint32_t *)a, y = *(const uint32_t *)b;
+    return x < y ? -1 : x > y;
+}
+
+static void clear_log_dir(void)
+{
+    mkdir(CAN_LOGGER_DIR, 0755);
+    DIR *dir = opendir(CAN_LOGGER_DIR);
+    struct dirent *entry;
+    while (dir != NULL && (entry = readdir(dir)) != NULL) {
+        if (strncmp(entry->d_name, CAN_LOGGER_PREFIX, strlen(CAN_LOGGER_PREFIX)) == 0) {
+            char path[300];
+            snprintf(path, sizeof(path), "%s/%s", CAN_LOGGER_DIR, entry->d_name);
+            unlink(path);
+        }
+    }
+    if (dir != NULL) {
+        closedir(dir);
+    }
+}
+
+// Segment numbers in the log directory, ascending
+static size_t list_segments(uint32_t *numbers, size_t max)
+{
+    size_t count = 0;
+    DIR *dir = opendir(CAN_LOGGER_DIR);
+    struct dirent *entry;
+    size_t prefix_len = strlen(CAN_LOGGER_PREFIX);
+    while (dir != NULL && (entry = readdir(dir)) != NULL && count < max) {
+        const char *ext = strrchr(entry->d_name, '.');
+        if (strncmp(entry->d_name, CAN_LOGGER_PREFIX, prefix_len) == 0 &&
+            ext != NULL && strcmp(ext, CAN_LOGGER_EXT) == 0) {
+            numbers[count++] = strtoul(entry->d_name + prefix_len, NULL, 10);
+        }
+    }
+    if (dir != NULL) {
+        closedir(dir);
+    }
+    qsort(numbers, count, sizeof(numbers[0]), compare_numbers);
+    return count;
+}
+
+/**
+ * @brief Reads every segment back and matches it against the frames the
+ *        logger accepted.
+ * @return Number of problems found
+ */
+static int verify(const expected_frame_t *expected, size_t count)
+{
+    uint32_t numbers[256];
+    size_t segments = list_segments(numbers, 256);
+    size_t pos = 0;
+    uint64_t last_time = 0;
+    int problems = 0;
+
+    for (size_t s = 0; s < segments; s++) {
+        char path[64];
+        snprintf(path, sizeof(path), "%s/%s%05lu%s", CAN_LOGGER_DIR, CAN_LOGGER_PREFIX,
+                 (unsigned long)numbers[s], CAN_LOGGER_EXT);
+        can_log_reader_t reader;
+        if (can_log_reader_open(&reader, path) != CAN_LOG_OK) {
+            fprintf(stderr, "%s: cannot open\n", path);
+            problems++;
+            continue;
+        }
+        can_log_frame_t frame;
+        while (can_log_reader_next(&reader, &frame) == CAN_LOG_OK) {
+            if (frame.time_us < last_time) {
+                if (problems++ < 5) {
+                    fprintf(stderr, "%s: frame %zu goes back in time by %llu us\n", path, pos,
+                            (unsigned long long)(last_time - frame.time_us));
+                }
+            }
+            last_time = frame.time_us;
+            if (pos >= count || frame.identifier != expected[pos].id ||
+                memcmp(frame.data, expected[pos].data, 8) != 0) {
+                if (problems++ < 5) {
+                    fprintf(stderr, "%s: frame %zu is 0x%03lX, expected 0x%03lX\n", path, pos,
+                            (unsigned long)frame.identifier,
+                            (unsigned long)(pos < count ? expected[pos].id : 0));
+                }
+            }
+            pos++;
+        }
+        if (reader.crc_errors) {
+            fprintf(stderr, "%s: %lu CRC errors\n", path, (unsigned long)reader.crc_errors);
+            problems++;
+        }
+        can_log_reader_close(&reader);
+    }
+    if (pos != count) {
+        fprintf(stderr, "read back %zu frames, logged %zu\n", pos, count);
+        problems++;
+    }
+    printf("verified %zu frames in %zu segments: %s\n", pos, segments, problems ? "FAILED" : "ok");
+    return problems;
+}
+
+int main(int argc, char **argv)
+{
+    int seconds = argc > 1 ? atoi(argv[1]) : 10;
+    bool compress = argc > 2 ? atoi(argv[2]) != 0 : true;
+    bool realtime = argc > 3 ? atoi(argv[3]) != 0 : false;
+    int segment_mb = argc > 4 ? atoi(argv[4]) : 1;
+    int flush_ms = argc > 5 ? atoi(argv[5]) : 200;
+
+    clear_log_dir();
+
+    can_logger_config_t config = CAN_LOGGER_CONFIG_DEFAULT();
+    config.segment_size_mb = segment_mb;
+    config.retention_segments = 1000;
+    config.compress = compress;
+    config.flush_interval_ms = flush_ms;
+    if (can_logger_start(&config) != ESP_OK) {
+        fprintf(stderr, "can_logger_start failed\n");
+        return 1;
+    }
+
+    size_t capacity = (size_t)seconds * 100 * BUS_COUNT;
+    expected_frame_t *expected = malloc(capacity * sizeof(*expected));
+    size_t count = 0;
+    size_t offered = 0;
+    int64_t start = esp_timer_get_time();
+
+    for (int cycle = 0; cycle < seconds * 100; cycle++) {
+        for (unsigned k = 0; k < BUS_COUNT; k++) {
+            if ((cycle * 10) % bus[k].period_ms) {
+                continue;
+            }
+            twai_message_t m;
+            make_frame(cycle, k, &m);
+            can_logger_stats_t before, after;
+            can_logger_get_stats(&before);
+            can_logger_log_frame(&m);
+            can_logger_get_stats(&after);
+            offered++;
+            if (after.frames_logged != before.frames_logged) {
+                expected[count].id = m.identifier;
+                memcpy(expected[count].data, m.data, 8);
+                count++;
+            }
+        }
+        if (realtime) {
+            int64_t due = start + (int64_t)(cycle + 1) * 10000;
+            int64_t now = esp_timer_get_time();
+            if (due > now) {
+                usleep((useconds_t)(due - now));
+            }
+        }
+    }
+    double elapsed = (esp_timer_get_time() - start) / 1e6;
+
+    can_logger_stop();
+    can_logger_stats_t s;
+    can_logger_get_stats(&s);
+
+    printf("offered %zu frames in %.2f s (%.0f/s), logged %lu, dropped %lu\n", offered, elapsed,
+           offered / elapsed, (unsigned long)s.frames_logged, (unsigned long)s.frames_dropped);
+    printf("blocks %lu, %llu bytes, %lu segments, max write %lu us\n",
+           (unsigned long)s.blocks_written, (unsigned long long)s.bytes_written,
+           (unsigned long)s.segments_created, (unsigned long)s.max_write_us);
+    if (s.compress_in_bytes > 0 && s.compress_out_bytes > 0 && s.compress_us > 0) {
+        printf("LZ4 ratio %.2f:1, %.1f us per 16 KB of records (max %lu us per buffer), %.0f MB/s\n",
+               (double)s.compress_in_bytes / s.compress_out_bytes,
+               (double)s.compress_us * 16384 / s.compress_in_bytes,
+               (unsigned long)s.compress_max_us, (double)s.compress_in_bytes / s.compress_us);
+    }
+
+    int problems = verify(expected, count);
+    free(expected);
+    return problems ? 1 : 0;
+}
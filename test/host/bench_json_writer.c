@@ -0,0 +1,321 @@
+/*
+ * Host benchmark: json_writer against the snprintf/strcat code it replaced
+ *
+ *   bench_json_writer [iterations]
+ *
+ * Each case builds the same document both ways and checks that the text is
+ * identical before timing it. The "old" functions are copies of the
+ * handlers from before the writer: the /data snprintf, data_stream_to_json
+ * (sprintf into a static 4 KB buffer) and the Wi-Fi scan list
+ * (malloc(2048) + strcat). The writer streams 256-byte chunks into a sink
+ * that only counts bytes, as httpd_resp_send_chunk would take them.
+ */
+
+#include "json_writer.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+esp_err_t httpd_resp_set_type(httpd_req_t *req, const char *type)
+{
+    return ESP_OK;
+}
+
+esp_err_t httpd_resp_send_chunk(httpd_req_t *req, const char *buf, ssize_t len)
+{
+    return ESP_OK;
+}
+
+// Sink that keeps the document so it can be compared with the old text
+typedef struct {
+    char text[4096];
+    size_t len;
+} capture_t;
+
+static esp_err_t capture_sink(void *ctx, const char *data, size_t len)
+{
+    capture_t *c = ctx;
+    if (c->len + len >= sizeof(c->text)) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+    memcpy(c->text + c->len, data, len);
+    c->len += len;
+    c->text[c->len] = '\0';
+    return ESP_OK;
+}
+
+static esp_err_t count_sink(void *ctx, const char *data, size_t len)
+{
+    *(size_t *)ctx += len;
+    return ESP_OK;
+}
+
+static double now_us(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e6 + ts.tv_nsec / 1e3;
+}
+
+// Keeps the compiler from dropping the old-path work
+static volatile size_t sink_bytes;
+
+// ============================================================================
+// /data GAUGES
+// ============================================================================
+
+typedef struct {
+    float map, wastegate, tps, rpm, boost;
+    int tcu;
+} gauges_t;
+
+static void gauges_at(int i, gauges_t *g)
+{
+    g->map = 100.0f + (float)(i % 997) * 0.37f;
+    g->wastegate = (float)(i % 100);
+    g->tps = (float)(i % 1000) / 10.0f;
+    g->rpm = 800.0f + (float)(i % 6000);
+    g->boost = 180.0f + (float)(i % 200) / 10.0f;
+    g->tcu = i % 3;
+}
+
+static size_t gauges_old(const gauges_t *g, char *out)
+{
+    char json_data[256];
+    snprintf(json_data, sizeof(json_data),
+        "{\"map_pressure\":%.1f,\"wastegate_pos\":%.1f,\"tps_position\":%.1f,"
+        "\"engine_rpm\":%.0f,\"target_boost\":%.1f,\"tcu_status\":%d}",
+        g->map, g->wastegate, g->tps, g->rpm, g->boost, g->tcu);
+    size_t len = strlen(json_data);
+    if (out) {
+        memcpy(out, json_data, len + 1);
+    }
+    return len;
+}
+
+static void gauges_new(const gauges_t *g, json_sink_t sink, void *ctx)
+{
+    char chunk[JSON_WRITER_CHUNK_SIZE];
+    json_writer_t w;
+    json_writer_init(&w, chunk, sizeof(chunk), sink, ctx);
+    json_obj_begin(&w);
+    json_kv_float(&w, "map_pressure", g->map, 1);
+    json_kv_float(&w, "wastegate_pos", g->wastegate, 1);
+    json_kv_float(&w, "tps_position", g->tps, 1);
+    json_kv_float(&w, "engine_rpm", g->rpm, 0);
+    json_kv_float(&w, "target_boost", g->boost, 1);
+    json_kv_int(&w, "tcu_status", g->tcu);
+    json_obj_end(&w);
+    json_writer_finish(&w);
+}
+
+// ============================================================================
+// DATA STREAM (20 log entries)
+// ============================================================================
+
+#define STREAM_SIZE 20
+
+typedef struct {
+    unsigned long long timestamp;
+    char message[64];
+    const char *type;
+} stream_entry_t;
+
+static stream_entry_t stream[STREAM_SIZE];
+
+static size_t stream_old(char *out)
+{
+    static char json_buffer[4096];
+    char *ptr = json_buffer;
+    ptr += sprintf(ptr, "[");
+    for (int i = 0; i < STREAM_SIZE; i++) {
+        if (ptr > json_buffer + 1) {
+            ptr += sprintf(ptr, ",");
+        }
+        ptr += sprintf(ptr, "{\"timestamp\":%llu,\"message\":\"%s\",\"type\":\"%s\"}",
+                       stream[i].timestamp, stream[i].message, stream[i].type);
+    }
+    ptr += sprintf(ptr, "]");
+    if (out) {
+        strcpy(out, json_buffer);
+    }
+    return (size_t)(ptr - json_buffer);
+}
+
+static void stream_new(json_sink_t sink, void *ctx)
+{
+    char chunk[JSON_WRITER_CHUNK_SIZE];
+    json_writer_t w;
+    json_writer_init(&w, chunk, sizeof(chunk), sink, ctx);
+    json_arr_begin(&w);
+    for (int i = 0; i < STREAM_SIZE; i++) {
+        json_obj_begin(&w);
+        json_kv_uint(&w, "timestamp", stream[i].timestamp);
+        json_kv_str(&w, "message", stream[i].message);
+        json_kv_str(&w, "type", stream[i].type);
+        json_obj_end(&w);
+    }
+    json_arr_end(&w);
+    json_writer_finish(&w);
+}
+
+// ============================================================================
+// WI-FI SCAN (20 networks)
+// ============================================================================
+
+#define SCAN_SIZE 20
+
+typedef struct {
+    char ssid[33];
+    int rssi;
+    int is_open;
+} scan_entry_t;
+
+static scan_entry_t scan[SCAN_SIZE];
+
+static size_t scan_old(char *out)
+{
+    char *json_response = malloc(2048);
+    strcpy(json_response, "{\"networks\":[");
+    for (size_t i = 0; i < SCAN_SIZE; i++) {
+        char network_json[128];
+        snprintf(network_json, sizeof(network_json),
+                 "%s{\"ssid\":\"%.32s\",\"rssi\":%d,\"open\":%s}",
+                 (i > 0) ? "," : "", scan[i].ssid, scan[i].rssi,
+                 scan[i].is_open ? "true" : "false");
+        strcat(json_response, network_json);
+    }
+    strcat(json_response, "]}");
+    size_t len = strlen(json_response);
+    if (out) {
+        strcpy(out, json_response);
+    }
+    free(json_response);
+    return len;
+}
+
+static void scan_new(json_sink_t sink, void *ctx)
+{
+    char chunk[JSON_WRITER_CHUNK_SIZE];
+    json_writer_t w;
+    json_writer_init(&w, chunk, sizeof(chunk), sink, ctx);
+    json_obj_begin(&w);
+    json_key(&w, "networks");
+    json_arr_begin(&w);
+    for (size_t i = 0; i < SCAN_SIZE; i++) {
+        json_obj_begin(&w);
+        json_key(&w, "ssid");
+        json_strn(&w, scan[i].ssid, 32);
+        json_kv_int(&w, "rssi", scan[i].rssi);
+        json_kv_bool(&w, "open", scan[i].is_open);
+        json_obj_end(&w);
+    }
+    json_arr_end(&w);
+    json_obj_end(&w);
+    json_writer_finish(&w);
+}
+
+// ============================================================================
+// MAIN
+// ============================================================================
+
+static int failures = 0;
+
+static void compare(const char *name, const char *old_text, const capture_t *cap)
+{
+    if (strcmp(old_text, cap->text) != 0) {
+        fprintf(stderr, "%s: outputs differ\n  old: %s\n  new: %s\n", name, old_text, cap->text);
+        failures++;
+    }
+}
+
+static void report(const char *name, size_t bytes, double old_us, double new_us, int iterations)
+{
+    printf("%-10s %5zu bytes  snprintf %7.3f us  writer %7.3f us  %.2fx\n",
+           name, bytes, old_us / iterations, new_us / iterations, old_us / new_us);
+}
+
+int main(int argc, char **argv)
+{
+    int iterations = argc > 1 ? atoi(argv[1]) : 200000;
+    if (iterations <= 0) {
+        iterations = 1;
+    }
+
+    for (int i = 0; i < STREAM_SIZE; i++) {
+        stream[i].timestamp = 1700000000000ULL + (unsigned long long)i * 1234;
+        snprintf(stream[i].message, sizeof(stream[i].message), "CAN frame 0x%03X: MAP %d kPa", 0x280 + i, 100 + i);
+        stream[i].type = (i % 4 == 0) ? "warning" : "info";
+    }
+    for (int i = 0; i < SCAN_SIZE; i++) {
+        snprintf(scan[i].ssid, sizeof(scan[i].ssid), "Network-%02d-%s", i, i % 3 ? "Home" : "Guest");
+        scan[i].rssi = -40 - i * 2;
+        scan[i].is_open = i % 5 == 0;
+    }
+
+    // Same text both ways
+    char old_text[4096];
+    capture_t cap;
+    gauges_t g;
+    for (int i = 0; i < 1000; i++) {
+        gauges_at(i, &g);
+        gauges_old(&g, old_text);
+        cap.len = 0;
+        gauges_new(&g, capture_sink, &cap);
+        compare("gauges", old_text, &cap);
+    }
+    stream_old(old_text);
+    cap.len = 0;
+    stream_new(capture_sink, &cap);
+    compare("stream", old_text, &cap);
+    scan_old(old_text);
+    cap.len = 0;
+    scan_new(capture_sink, &cap);
+    compare("scan", old_text, &cap);
+    if (failures) {
+        return 1;
+    }
+
+    size_t bytes = 0;
+    size_t count = 0;
+    double t0 = now_us();
+    for (int i = 0; i < iterations; i++) {
+        gauges_at(i, &g);
+        bytes = gauges_old(&g, NULL);
+        sink_bytes += bytes;
+    }
+    double t1 = now_us();
+    for (int i = 0; i < iterations; i++) {
+        gauges_at(i, &g);
+        gauges_new(&g, count_sink, &count);
+    }
+    double t2 = now_us();
+    report("gauges", bytes, t1 - t0, t2 - t1, iterations);
+
+    int big = iterations / 10 > 0 ? iterations / 10 : 1;
+    t0 = now_us();
+    for (int i = 0; i < big; i++) {
+        bytes = stream_old(NULL);
+        sink_bytes += bytes;
+    }
+    t1 = now_us();
+    for (int i = 0; i < big; i++) {
+        stream_new(count_sink, &count);
+    }
+    t2 = now_us();
+    report("stream", bytes, t1 - t0, t2 - t1, big);
+
+    t0 = now_us();
+    for (int i = 0; i < big; i++) {
+        bytes = scan_old(NULL);
+        sink_bytes += bytes;
+    }
+    t1 = now_us();
+    for (int i = 0; i < big; i++) {
+        scan_new(count_sink, &count);
+    }
+    t2 = now_us();
+    report("scan", bytes, t1 - t0, t2 - t1, big);
+    return 0;
+}
@@ -0,0 +1,33 @@
+/*
+ * Host tests for ECU Dashboard
+ * Minimal check macros shared by the test programs in test/host
+ */
+
+#ifndef HOST_TEST_H
+#define HOST_TEST_H
+
+#include <stdio.h>
+#include <string.h>
+
+static int host_test_failures = 0;
+
+#define CHECK(cond) do {                                                    \
+    if (!(cond)) {                                                          \
+        fprintf(stderr, "%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #cond); \
+        host_test_failures++;                                               \
+    }                                                                       \
+} while (0)
+
+#define CHECK_STR(actual, expected) do {                                    \
+    const char *a_ = (actual), *e_ = (expected);                            \
+    if (strcmp(a_, e_) != 0) {                                              \
+        fprintf(stderr, "%s:%d: got \"%s\", expected \"%s\"\n",             \
+                __FILE__, __LINE__, a_, e_);                                \
+        host_test_failures++;                                               \
+    }                                                                       \
+} while (0)
+
+// Exit status for main()
+#define HOST_TEST_RESULT() (host_test_failures == 0 ? 0 : 1)
+
+#endif // HOST_TEST_H
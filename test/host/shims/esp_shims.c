@@ -0,0 +1,232 @@
+/*
+ * Host shims: esp_timer, heap, random, CRC, app description, error names
+ */
+
+#include "esp_err.h"
+#include "esp_timer.h"
+#include "esp_heap_caps.h"
+#include "esp_random.h"
+#include "esp_rom_crc.h"
+#include "esp_app_desc.h"
+#include <errno.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+int64_t esp_timer_get_time(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+// ============================================================================
+// TIMERS
+// ============================================================================
+
+struct esp_timer {
+    esp_timer_create_args_t args;
+    pthread_t thread;
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    int64_t due_us;                 // 0 = not armed
+    uint64_t period_us;             // 0 = one-shot
+    bool deleted;
+};
+
+static void timespec_from_us(int64_t mono_us, struct timespec *ts)
+{
+    // Condition variables use CLOCK_MONOTONIC, see esp_timer_create()
+    ts->tv_sec = mono_us / 1000000;
+    ts->tv_nsec = (mono_us % 1000000) * 1000;
+}
+
+static void *timer_thread(void *arg)
+{
+    struct esp_timer *t = arg;
+
+    pthread_mutex_lock(&t->lock);
+    while (!t->deleted) {
+        if (t->due_us == 0) {
+            pthread_cond_wait(&t->cond, &t->lock);
+            continue;
+        }
+        int64_t now = esp_timer_get_time();
+        if (now < t->due_us) {
+            struct timespec ts;
+            timespec_from_us(t->due_us, &ts);
+            pthread_cond_timedwait(&t->cond, &t->lock, &ts);
+            continue;
+        }
+        t->due_us = t->period_us ? t->due_us + (int64_t)t->period_us : 0;
+        if (t->due_us != 0 && t->due_us < now) {
+            t->due_us = now + (int64_t)t->period_us;    // Skip missed periods
+        }
+        pthread_mutex_unlock(&t->lock);
+        t->args.callback(t->args.arg);
+        pthread_mutex_lock(&t->lock);
+    }
+    pthread_mutex_unlock(&t->lock);
+    return NULL;
+}
+
+esp_err_t esp_timer_create(const esp_timer_create_args_t *args, esp_timer_handle_t *out)
+{
+    if (args == NULL || args->callback == NULL || out == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    struct esp_timer *t = calloc(1, sizeof(*t));
+    if (t == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+    t->args = *args;
+    pthread_mutex_init(&t->lock, NULL);
+    pthread_condattr_t attr;
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    pthread_cond_init(&t->cond, &attr);
+    pthread_condattr_destroy(&attr);
+    if (pthread_create(&t->thread, NULL, timer_thread, t) != 0) {
+        free(t);
+        return ESP_FAIL;
+    }
+    *out = t;
+    return ESP_OK;
+}
+
+static esp_err_t timer_arm(esp_timer_handle_t t, uint64_t timeout_us, uint64_t period_us)
+{
+    if (t == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    pthread_mutex_lock(&t->lock);
+    esp_err_t ret = ESP_ERR_INVALID_STATE;
+    if (t->due_us == 0) {
+        t->due_us = esp_timer_get_time() + (int64_t)timeout_us;
+        if (t->due_us == 0) {
+            t->due_us = 1;
+        }
+        t->period_us = period_us;
+        pthread_cond_signal(&t->cond);
+        ret = ESP_OK;
+    }
+    pthread_mutex_unlock(&t->lock);
+    return ret;
+}
+
+esp_err_t esp_timer_start_once(esp_timer_handle_t timer, uint64_t timeout_us)
+{
+    return timer_arm(timer, timeout_us, 0);
+}
+
+esp_err_t esp_timer_start_periodic(esp_timer_handle_t timer, uint64_t period_us)
+{
+    return timer_arm(timer, period_us, period_us);
+}
+
+esp_err_t esp_timer_stop(esp_timer_handle_t t)
+{
+    if (t == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    pthread_mutex_lock(&t->lock);
+    esp_err_t ret = t->due_us != 0 ? ESP_OK : ESP_ERR_INVALID_STATE;
+    t->due_us = 0;
+    pthread_cond_signal(&t->cond);
+    pthread_mutex_unlock(&t->lock);
+    return ret;
+}
+
+esp_err_t esp_timer_delete(esp_timer_handle_t t)
+{
+    if (t == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    pthread_mutex_lock(&t->lock);
+    t->deleted = true;
+    pthread_cond_signal(&t->cond);
+    pthread_mutex_unlock(&t->lock);
+    // A callback may delete its own timer
+    if (!pthread_equal(pthread_self(), t->thread)) {
+        pthread_join(t->thread, NULL);
+        free(t);
+    } else {
+        pthread_detach(t->thread);
+    }
+    return ESP_OK;
+}
+
+bool esp_timer_is_active(esp_timer_handle_t t)
+{
+    pthread_mutex_lock(&t->lock);
+    bool active = t->due_us != 0;
+    pthread_mutex_unlock(&t->lock);
+    return active;
+}
+
+// ============================================================================
+// MISC
+// ============================================================================
+
+void *heap_caps_malloc(size_t size, uint32_t caps)
+{
+    return malloc(size);
+}
+
+void *heap_caps_calloc(size_t n, size_t size, uint32_t caps)
+{
+    return calloc(n, size);
+}
+
+void heap_caps_free(void *ptr)
+{
+    free(ptr);
+}
+
+uint32_t esp_random(void)
+{
+    static uint32_t state = 0x2545F491u;
+    // xorshift32, deterministic so test runs repeat
+    state ^= state << 13;
+    state ^= state >> 17;
+    state ^= state << 5;
+    return state;
+}
+
+uint32_t esp_rom_crc32_le(uint32_t crc, const uint8_t *buf, uint32_t len)
+{
+    crc = ~crc;
+    for (uint32_t i = 0; i < len; i++) {
+        crc ^= buf[i];
+        for (int k = 0; k < 8; k++) {
+            crc = (crc >> 1) ^ (0xEDB88320u & (0u - (crc & 1u)));
+        }
+    }
+    return ~crc;
+}
+
+const esp_app_desc_t *esp_app_get_description(void)
+{
+    static const esp_app_desc_t desc = {
+        .version = "host",
+        .project_name = "Westgate_Dashboard",
+        .idf_ver = "v5.3.3",
+    };
+    return &desc;
+}
+
+const char *esp_err_to_name(esp_err_t code)
+{
+    switch (code) {
+        case ESP_OK:                return "ESP_OK";
+        case ESP_FAIL:              return "ESP_FAIL";
+        case ESP_ERR_NO_MEM:        return "ESP_ERR_NO_MEM";
+        case ESP_ERR_INVALID_ARG:   return "ESP_ERR_INVALID_ARG";
+        case ESP_ERR_INVALID_STATE: return "ESP_ERR_INVALID_STATE";
+        case ESP_ERR_INVALID_SIZE:  return "ESP_ERR_INVALID_SIZE";
+        case ESP_ERR_NOT_FOUND:     return "ESP_ERR_NOT_FOUND";
+        case ESP_ERR_TIMEOUT:       return "ESP_ERR_TIMEOUT";
+        default:                    return "UNKNOWN ERROR";
+    }
+}
@@ -0,0 +1,224 @@
+/*
+ * Host shims: FreeRTOS tasks, notifications, mutexes and critical sections
+ * on POSIX threads
+ */
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include <errno.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+typedef struct {
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    uint32_t notify;                // Notification value (counting semantics)
+    TaskFunction_t fn;
+    void *arg;
+} host_task_t;
+
+// Threads not started by xTaskCreate (main) get a task on first use
+static __thread host_task_t *current_task = NULL;
+
+static pthread_mutex_t critical_lock;
+static pthread_once_t critical_once = PTHREAD_ONCE_INIT;
+
+static void critical_init(void)
+{
+    pthread_mutexattr_t attr;
+    pthread_mutexattr_init(&attr);
+    pthread_mutexattr_settype(&attr, PTHREAD_MUTEX_RECURSIVE);
+    pthread_mutex_init(&critical_lock, &attr);
+    pthread_mutexattr_destroy(&attr);
+}
+
+void host_critical_enter(void)
+{
+    pthread_once(&critical_once, critical_init);
+    pthread_mutex_lock(&critical_lock);
+}
+
+void host_critical_exit(void)
+{
+    pthread_mutex_unlock(&critical_lock);
+}
+
+int xPortGetCoreID(void)
+{
+    return 1;
+}
+
+// ============================================================================
+// TASKS
+// ============================================================================
+
+static host_task_t *task_new(TaskFunction_t fn, void *arg)
+{
+    host_task_t *t = calloc(1, sizeof(*t));
+    if (t != NULL) {
+        pthread_mutex_init(&t->lock, NULL);
+        pthread_cond_init(&t->cond, NULL);
+        t->fn = fn;
+        t->arg = arg;
+    }
+    return t;
+}
+
+static void *task_entry(void *arg)
+{
+    current_task = arg;
+    current_task->fn(current_task->arg);
+    return NULL;
+}
+
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t fn, const char *name, uint32_t stack,
+                                   void *arg, UBaseType_t priority, TaskHandle_t *out,
+                                   BaseType_t core)
+{
+    host_task_t *t = task_new(fn, arg);
+    if (t == NULL) {
+        return pdFAIL;
+    }
+    // Published before the thread runs, as FreeRTOS does
+    if (out != NULL) {
+        *out = t;
+    }
+    pthread_t thread;
+    if (pthread_create(&thread, NULL, task_entry, t) != 0) {
+        free(t);
+        return pdFAIL;
+    }
+    pthread_detach(thread);
+    return pdPASS;
+}
+
+BaseType_t xTaskCreate(TaskFunction_t fn, const char *name, uint32_t stack,
+                       void *arg, UBaseType_t priority, TaskHandle_t *out)
+{
+    return xTaskCreatePinnedToCore(fn, name, stack, arg, priority, out, tskNO_AFFINITY);
+}
+
+void vTaskDelete(TaskHandle_t task)
+{
+    // Only self-deletion is used; the task struct stays valid for late notifiers
+    if (task == NULL || task == current_task) {
+        pthread_exit(NULL);
+    }
+}
+
+void vTaskDelay(TickType_t ticks)
+{
+    usleep((useconds_t)ticks * 1000);
+}
+
+TickType_t xTaskGetTickCount(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (TickType_t)(ts.tv_sec * 1000 + ts.tv_nsec / 1000000);
+}
+
+TaskHandle_t xTaskGetCurrentTaskHandle(void)
+{
+    if (current_task == NULL) {
+        current_task = task_new(NULL, NULL);
+    }
+    return current_task;
+}
+
+uint32_t ulTaskNotifyTake(BaseType_t clear_on_exit, TickType_t wait)
+{
+    host_task_t *t = xTaskGetCurrentTaskHandle();
+
+    struct timespec deadline;
+    clock_gettime(CLOCK_REALTIME, &deadline);
+    deadline.tv_sec += wait / 1000;
+    deadline.tv_nsec += (long)(wait % 1000) * 1000000L;
+    if (deadline.tv_nsec >= 1000000000L) {
+        deadline.tv_sec++;
+        deadline.tv_nsec -= 1000000000L;
+    }
+
+    pthread_mutex_lock(&t->lock);
+    while (t->notify == 0) {
+        int rc = wait == portMAX_DELAY ? pthread_cond_wait(&t->cond, &t->lock)
+                                       : pthread_cond_timedwait(&t->cond, &t->lock, &deadline);
+        if (rc == ETIMEDOUT) {
+            break;
+        }
+    }
+    uint32_t value = t->notify;
+    if (clear_on_exit) {
+        t->notify = 0;
+    } else if (t->notify > 0) {
+        t->notify--;
+    }
+    pthread_mutex_unlock(&t->lock);
+    return value;
+}
+
+BaseType_t xTaskNotifyGive(TaskHandle_t task)
+{
+    host_task_t *t = task;
+    if (t == NULL) {
+        return pdFAIL;
+    }
+    pthread_mutex_lock(&t->lock);
+    t->notify++;
+    pthread_cond_signal(&t->cond);
+    pthread_mutex_unlock(&t->lock);
+    return pdPASS;
+}
+
+// ============================================================================
+// MUTEXES
+// ============================================================================
+
+_Static_assert(sizeof(StaticSemaphore_t) >= sizeof(pthread_mutex_t),
+               "StaticSemaphore_t too small for a pthread mutex");
+
+SemaphoreHandle_t xSemaphoreCreateMutexStatic(StaticSemaphore_t *buffer)
+{
+    pthread_mutex_t *m = (pthread_mutex_t *)buffer;
+    pthread_mutex_init(m, NULL);
+    return m;
+}
+
+SemaphoreHandle_t xSemaphoreCreateMutex(void)
+{
+    pthread_mutex_t *m = malloc(sizeof(*m));
+    if (m != NULL) {
+        pthread_mutex_init(m, NULL);
+    }
+    return m;
+}
+
+BaseType_t xSemaphoreTake(SemaphoreHandle_t sem, TickType_t wait)
+{
+    if (wait == portMAX_DELAY) {
+        return pthread_mutex_lock(sem) == 0 ? pdTRUE : pdFALSE;
+    }
+    TickType_t start = xTaskGetTickCount();
+    while (pthread_mutex_trylock(sem) != 0) {
+        if (xTaskGetTickCount() - start >= wait) {
+            return pdFALSE;
+        }
+        usleep(100);
+    }
+    return pdTRUE;
+}
+
+BaseType_t xSemaphoreGive(SemaphoreHandle_t sem)
+{
+    return pthread_mutex_unlock(sem) == 0 ? pdTRUE : pdFALSE;
+}
+
+void vSemaphoreDelete(SemaphoreHandle_t sem)
+{
+    pthread_mutex_destroy(sem);
+    free(sem);
+}
@@ -0,0 +1,26 @@
+/*
+ * Host shim: esp_log.h
+ * Warnings and errors go to stderr; info and debug only with HOST_LOG_VERBOSE
+ */
+
+#ifndef HOST_ESP_LOG_H
+#define HOST_ESP_LOG_H
+
+#include <stdio.h>
+
+#define HOST_LOG(level, tag, fmt, ...) \
+    fprintf(stderr, level " (%s) " fmt "\n", tag, ##__VA_ARGS__)
+
+#define ESP_LOGE(tag, fmt, ...) HOST_LOG("E", tag, fmt, ##__VA_ARGS__)
+#define ESP_LOGW(tag, fmt, ...) HOST_LOG("W", tag, fmt, ##__VA_ARGS__)
+
+#ifdef HOST_LOG_VERBOSE
+#define ESP_LOGI(tag, fmt, ...) HOST_LOG("I", tag, fmt, ##__VA_ARGS__)
+#define ESP_LOGD(tag, fmt, ...) HOST_LOG("D", tag, fmt, ##__VA_ARGS__)
+#else
+#define ESP_LOGI(tag, fmt, ...) do { if (0) HOST_LOG("I", tag, fmt, ##__VA_ARGS__); } while (0)
+#define ESP_LOGD(tag, fmt, ...) do { if (0) HOST_LOG("D", tag, fmt, ##__VA_ARGS__); } while (0)
+#endif
+#define ESP_LOGV ESP_LOGD
+
+#endif // HOST_ESP_LOG_H
@@ -0,0 +1,12 @@
+/*
+ * Host shim: esp_random.h
+ */
+
+#ifndef HOST_ESP_RANDOM_H
+#define HOST_ESP_RANDOM_H
+
+#include <stdint.h>
+
+uint32_t esp_random(void);
+
+#endif // HOST_ESP_RANDOM_H
@@ -0,0 +1,13 @@
+/*
+ * Host shim: esp_rom_crc.h
+ * Same polynomial and conditioning as the ROM function (and zlib crc32)
+ */
+
+#ifndef HOST_ESP_ROM_CRC_H
+#define HOST_ESP_ROM_CRC_H
+
+#include <stdint.h>
+
+uint32_t esp_rom_crc32_le(uint32_t crc, const uint8_t *buf, uint32_t len);
+
+#endif // HOST_ESP_ROM_CRC_H
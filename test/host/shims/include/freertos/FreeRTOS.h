@@ -0,0 +1,55 @@
+/*
+ * Host shim: freertos/FreeRTOS.h
+ * Types and critical sections. Every portMUX maps to one process-wide
+ * recursive mutex, which is stricter than the per-mux spinlocks on the
+ * device but keeps the same ordering guarantees.
+ */
+
+#ifndef HOST_FREERTOS_H
+#define HOST_FREERTOS_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+typedef uint32_t TickType_t;
+typedef int BaseType_t;
+typedef unsigned int UBaseType_t;
+
+typedef void *TaskHandle_t;
+typedef void *QueueHandle_t;
+typedef void *SemaphoreHandle_t;
+typedef void (*TaskFunction_t)(void *arg);
+
+typedef struct {
+    int unused;
+} portMUX_TYPE;
+
+#define portMUX_INITIALIZER_UNLOCKED    { 0 }
+
+void host_critical_enter(void);
+void host_critical_exit(void);
+
+#define portENTER_CRITICAL(mux)         host_critical_enter()
+#define portEXIT_CRITICAL(mux)          host_critical_exit()
+#define portENTER_CRITICAL_ISR(mux)     host_critical_enter()
+#define portEXIT_CRITICAL_ISR(mux)      host_critical_exit()
+
+// One tick is one millisecond
+#define configTICK_RATE_HZ              1000
+#define portTICK_PERIOD_MS              1
+#define pdMS_TO_TICKS(ms)               ((TickType_t)(ms))
+#define pdTICKS_TO_MS(ticks)            ((uint32_t)(ticks))
+#define portMAX_DELAY                   ((TickType_t)0xFFFFFFFFu)
+
+#define pdFALSE                         0
+#define pdTRUE                          1
+#define pdFAIL                          0
+#define pdPASS                          1
+
+#define tskNO_AFFINITY                  0x7FFFFFFF
+#define portNUM_PROCESSORS              2
+
+int xPortGetCoreID(void);
+
+#endif // HOST_FREERTOS_H
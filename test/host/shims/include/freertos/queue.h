@@ -0,0 +1,11 @@
+/*
+ * Host shim: freertos/queue.h
+ * Declarations only; no host-built module sends through a queue
+ */
+
+#ifndef HOST_FREERTOS_QUEUE_H
+#define HOST_FREERTOS_QUEUE_H
+
+#include "FreeRTOS.h"
+
+#endif // HOST_FREERTOS_QUEUE_H
@@ -0,0 +1,13 @@
+/*
+ * Host shim: sdkconfig.h
+ * The project defaults for the options the host-built modules read
+ */
+
+#ifndef HOST_SDKCONFIG_H
+#define HOST_SDKCONFIG_H
+
+#define CONFIG_LWIP_MAX_SOCKETS         16
+#define CONFIG_HTTP_ROUTER_MAX_STREAMS  8
+#define CONFIG_BACKGROUND_WORKERS       2
+
+#endif // HOST_SDKCONFIG_H
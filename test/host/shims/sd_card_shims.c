@@ -0,0 +1,23 @@
+/*
+ * Host shims: the sd_card_manager functions the loggers call.
+ * Files live under the test's working directory.
+ */
+
+#include "sd_card_manager.h"
+#include <stdio.h>
+#include <unistd.h>
+
+esp_err_t sd_card_create_contiguous_file(const char *path, uint64_t size)
+{
+    FILE *f = fopen(path, "wb");
+    if (f == NULL) {
+        return ESP_FAIL;
+    }
+    int rc = ftruncate(fileno(f), (off_t)size);
+    fclose(f);
+    return rc == 0 ? ESP_OK : ESP_FAIL;
+}
+
+void sd_card_record_write_latency(uint32_t elapsed_us)
+{
+}
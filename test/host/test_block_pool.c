@@ -0,0 +1,319 @@
+/*
+ * Host test: lock-free block pool
+ *
+ * Checks the size-class choice, the fallback to the next larger class and
+ * to the heap when the classes are empty, the in-use and high-water
+ * counters, and a multi-threaded stress run: every thread fills the blocks
+ * it holds with its own pattern and checks it before freeing, so a block
+ * handed to two owners at once (a broken pop or an ABA on the free stack)
+ * shows up as a corrupted pattern.
+ *
+ * The pool is a process-wide singleton without a reset, so the tests run
+ * in order and compare counters against the state they start from.
+ *
+ *   test_block_pool [threads] [iterations per thread]
+ */
+
+#include "block_pool.h"
+#include "host_test.h"
+#include <pthread.h>
+#include <sched.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#define CLASS_SIZE(size, count)     (size),
+#define CLASS_COUNT(size, count)    (count),
+#define CLASS_BLOCKS(size, count)   + (count)
+
+static const uint32_t sizes[BLOCK_POOL_CLASSES] = { BLOCK_POOL_CLASS_TABLE(CLASS_SIZE) };
+static const uint32_t counts[BLOCK_POOL_CLASSES] = { BLOCK_POOL_CLASS_TABLE(CLASS_COUNT) };
+
+#define TOTAL_BLOCKS    (0 BLOCK_POOL_CLASS_TABLE(CLASS_BLOCKS))
+
+static block_pool_stats_t stats(void)
+{
+    block_pool_stats_t s;
+    block_pool_get_stats(&s);
+    return s;
+}
+
+static void test_high_water(void)
+{
+    void *p[5];
+
+    for (int i = 0; i < 5; i++) {
+        p[i] = block_pool_alloc(16);
+        CHECK(block_pool_owns(p[i]));
+    }
+    CHECK(stats().classes[0].in_use == 5);
+    for (int i = 0; i < 5; i++) {
+        block_pool_free(p[i]);
+    }
+    for (int i = 0; i < 3; i++) {
+        p[i] = block_pool_alloc(16);
+    }
+
+    // The peak stays after the blocks went back
+    block_pool_stats_t s = stats();
+    CHECK(s.classes[0].in_use == 3);
+    CHECK(s.classes[0].high_water == 5);
+    CHECK(s.classes[0].allocs == 8);
+    CHECK(s.classes[1].high_water == 0);
+    for (int i = 0; i < 3; i++) {
+        block_pool_free(p[i]);
+    }
+    CHECK(stats().classes[0].in_use == 0);
+    CHECK(stats().classes[0].high_water == 5);
+}
+
+static void test_size_classes(void)
+{
+    block_pool_stats_t before = stats();
+
+    // Smallest class that holds the request, 8-byte aligned: one request
+    // just over the previous class and one of exactly the block size
+    size_t requests[2 * BLOCK_POOL_CLASSES];
+    int expected[2 * BLOCK_POOL_CLASSES];
+    void *p[2 * BLOCK_POOL_CLASSES];
+    for (int c = 0; c < BLOCK_POOL_CLASSES; c++) {
+        requests[2 * c] = c == 0 ? 1 : sizes[c - 1] + 1;
+        requests[2 * c + 1] = sizes[c];
+        expected[2 * c] = expected[2 * c + 1] = c;
+    }
+    for (int i = 0; i < 2 * BLOCK_POOL_CLASSES; i++) {
+        p[i] = block_pool_alloc(requests[i]);
+        CHECK(p[i] != NULL && block_pool_owns(p[i]));
+        CHECK(((uintptr_t)p[i] & 7) == 0);
+    }
+    block_pool_stats_t s = stats();
+    for (int c = 0; c < BLOCK_POOL_CLASSES; c++) {
+        int n = 0;
+        for (int i = 0; i < 2 * BLOCK_POOL_CLASSES; i++) {
+            n += expected[i] == c;
+        }
+        CHECK(s.classes[c].in_use == (uint32_t)n);
+        CHECK(s.classes[c].block_size == sizes[c]);
+        CHECK(s.classes[c].blocks == counts[c]);
+    }
+
+    // Larger than every class: heap, recognised by free
+    void *big = block_pool_alloc(sizes[BLOCK_POOL_CLASSES - 1] + 1);
+    CHECK(big != NULL && !block_pool_owns(big));
+    CHECK(stats().heap_allocs == before.heap_allocs + 1);
+    CHECK(stats().heap_in_use == before.heap_in_use + 1);
+    block_pool_free(big);
+    CHECK(stats().heap_in_use == before.heap_in_use);
+
+    CHECK(block_pool_alloc(0) == NULL);
+    block_pool_free(NULL);
+
+    // A pointer inside a block is not a block: ignored
+    block_pool_free((uint8_t *)p[0] + 8);
+    CHECK(stats().classes[0].in_use == s.classes[0].in_use);
+
+    for (int i = 0; i < 2 * BLOCK_POOL_CLASSES; i++) {
+        block_pool_free(p[i]);
+    }
+    for (int c = 0; c < BLOCK_POOL_CLASSES; c++) {
+        CHECK(stats().classes[c].in_use == 0);
+    }
+}
+
+static void test_class_fallback(void)
+{
+    block_pool_stats_t before = stats();
+    void *small[TOTAL_BLOCKS];
+
+    for (uint32_t i = 0; i < counts[0]; i++) {
+        small[i] = block_pool_alloc(32);
+    }
+    CHECK(stats().classes[0].in_use == counts[0]);
+
+    // Class 0 is empty: the next small request takes a block of class 1
+    void *spill = block_pool_alloc(32);
+    block_pool_stats_t s = stats();
+    CHECK(spill != NULL && block_pool_owns(spill));
+    CHECK(s.classes[1].in_use == 1);
+    CHECK(s.classes[0].exhausted == before.classes[0].exhausted + 1);
+    // Counted as a request of the class it fits, not of the one serving it
+    CHECK(s.classes[0].allocs == before.classes[0].allocs + counts[0] + 1);
+    CHECK(s.classes[1].allocs == before.classes[1].allocs);
+
+    // Blocks freed to class 0 are served from it again
+    block_pool_free(small[3]);
+    void *again = block_pool_alloc(32);
+    CHECK(again == small[3]);
+    small[3] = again;
+
+    block_pool_free(spill);
+    for (uint32_t i = 0; i < counts[0]; i++) {
+        block_pool_free(small[i]);
+    }
+    CHECK(stats().classes[0].in_use == 0 && stats().classes[1].in_use == 0);
+}
+
+static void test_heap_fallback(void)
+{
+    block_pool_stats_t before = stats();
+    void *all[TOTAL_BLOCKS];
+
+    // Small requests drain every class, smallest first
+    for (int i = 0; i < TOTAL_BLOCKS; i++) {
+        all[i] = block_pool_alloc(8);
+        CHECK(all[i] != NULL && block_pool_owns(all[i]));
+    }
+    block_pool_stats_t s = stats();
+    for (int c = 0; c < BLOCK_POOL_CLASSES; c++) {
+        CHECK(s.classes[c].in_use == counts[c]);
+        CHECK(s.classes[c].high_water == counts[c]);
+    }
+
+    // Nothing left in the arena: malloc
+    void *heap = block_pool_alloc(8);
+    s = stats();
+    CHECK(heap != NULL && !block_pool_owns(heap));
+    CHECK(s.heap_allocs == before.heap_allocs + 1);
+    CHECK(s.heap_in_use == before.heap_in_use + 1);
+    CHECK(s.classes[2].exhausted > before.classes[2].exhausted);
+
+    block_pool_free(heap);
+    for (int i = 0; i < TOTAL_BLOCKS; i++) {
+        block_pool_free(all[i]);
+    }
+    s = stats();
+    CHECK(s.heap_in_use == before.heap_in_use);
+    for (int c = 0; c < BLOCK_POOL_CLASSES; c++) {
+        CHECK(s.classes[c].in_use == 0);
+    }
+}
+
+// ============================================================================
+// STRESS
+// ============================================================================
+
+#define STRESS_HOLD     6       // Blocks each thread holds at most
+
+typedef struct {
+    int id;
+    int iterations;
+    int corrupted;
+    unsigned seed;
+} stress_arg_t;
+
+static void fill(uint8_t *p, size_t len, uint8_t tag)
+{
+    for (size_t i = 0; i < len; i++) {
+        p[i] = (uint8_t)(tag + i);
+    }
+}
+
+static bool intact(const uint8_t *p, size_t len, uint8_t tag)
+{
+    for (size_t i = 0; i < len; i++) {
+        if (p[i] != (uint8_t)(tag + i)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static void *stress_thread(void *arg)
+{
+    stress_arg_t *a = (stress_arg_t *)arg;
+    uint8_t *held[STRESS_HOLD] = { 0 };
+    size_t len[STRESS_HOLD] = { 0 };
+    uint8_t tag[STRESS_HOLD] = { 0 };
+
+    for (int n = 0; n < a->iterations; n++) {
+        int slot = rand_r(&a->seed) % STRESS_HOLD;
+        if (held[slot] != NULL) {
+            if (!intact(held[slot], len[slot], tag[slot])) {
+                a->corrupted++;
+            }
+            block_pool_free(held[slot]);
+            held[slot] = NULL;
+            continue;
+        }
+        // Mostly pool sizes, now and then one for the heap
+        len[slot] = 1 + rand_r(&a->seed) % (sizes[BLOCK_POOL_CLASSES - 1] + 64);
+        tag[slot] = (uint8_t)(a->id * 37 + n);
+        held[slot] = block_pool_alloc(len[slot]);
+        if (held[slot] == NULL) {
+            a->corrupted++;
+            continue;
+        }
+        fill(held[slot], len[slot], tag[slot]);
+        if ((n & 63) == 0) {
+            sched_yield();
+        }
+    }
+    for (int i = 0; i < STRESS_HOLD; i++) {
+        if (held[i] != NULL) {
+            if (!intact(held[i], len[i], tag[i])) {
+                a->corrupted++;
+            }
+            block_pool_free(held[i]);
+        }
+    }
+    return NULL;
+}
+
+static void test_stress(int threads, int iterations)
+{
+    pthread_t tid[16];
+    stress_arg_t args[16];
+    block_pool_stats_t before = stats();
+
+    if (threads > 16) {
+        threads = 16;
+    }
+    for (int t = 0; t < threads; t++) {
+        args[t] = (stress_arg_t){ .id = t, .iterations = iterations, .seed = 1234u + t };
+        pthread_create(&tid[t], NULL, stress_thread, &args[t]);
+    }
+    int corrupted = 0;
+    for (int t = 0; t < threads; t++) {
+        pthread_join(tid[t], NULL);
+        corrupted += args[t].corrupted;
+    }
+    CHECK(corrupted == 0);
+
+    // Everything came back, and with more holders than blocks the classes
+    // must have run dry and spilled to the heap
+    block_pool_stats_t s = stats();
+    for (int c = 0; c < BLOCK_POOL_CLASSES; c++) {
+        CHECK(s.classes[c].in_use == 0);
+        CHECK(s.classes[c].high_water <= counts[c]);
+    }
+    CHECK(s.heap_in_use == before.heap_in_use);
+    CHECK(s.heap_allocs > before.heap_allocs);
+
+    // All blocks can still be handed out exactly once
+    void *all[TOTAL_BLOCKS];
+    for (int i = 0; i < TOTAL_BLOCKS; i++) {
+        all[i] = block_pool_alloc(8);
+        CHECK(block_pool_owns(all[i]));
+        for (int j = 0; j < i; j++) {
+            CHECK(all[j] != all[i]);
+        }
+    }
+    for (int i = 0; i < TOTAL_BLOCKS; i++) {
+        block_pool_free(all[i]);
+    }
+
+    printf("stress: %d threads x %d iterations, %u heap fallbacks\n",
+           threads, iterations, s.heap_allocs - before.heap_allocs);
+}
+
+int main(int argc, char **argv)
+{
+    int threads = argc > 1 ? atoi(argv[1]) : 8;
+    int iterations = argc > 2 ? atoi(argv[2]) : 200000;
+
+    test_high_water();
+    test_size_classes();
+    test_class_fallback();
+    test_heap_fallback();
+    test_stress(threads, iterations);
+    return HOST_TEST_RESULT();
+}
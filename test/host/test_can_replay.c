@@ -0,0 +1,287 @@
+/*
+ * Host test and load tool: CAN trace replay
+ *
+ *   test_can_replay                          self test
+ *   test_can_replay <trace> [speed] [loop]   replays a trace through the parser
+ *
+ * The sink converts each frame to a twai_message_t and hands it to the real
+ * parse_can_message() and channel registry, like replay_sink() on the
+ * device. With a trace argument the result is a throughput figure for
+ * parser plus registry (speed 0 = as fast as possible).
+ *
+ * The self test writes the same frames as candump -L, legacy CSV, tool CSV
+ * and (through the real logger) a binary segment, replays each one and
+ * checks frame count, parse errors, the resulting channel values, pacing,
+ * looping and stopping.
+ */
+
+#include "include/can_replay.h"
+#include "include/can_logger.h"
+#include "include/can_parser.h"
+#include "include/channel_registry.h"
+#include "host_test.h"
+#include <dirent.h>
+#include <math.h>
+#include <stdlib.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define TRACE_FRAMES    200
+#define TRACE_STEP_MS   2           // 200 frames over 398 ms
+
+typedef struct {
+    uint32_t frames;
+    uint32_t ids[TRACE_FRAMES * 3];
+    volatile bool *stop;
+    uint32_t stop_after;
+} sink_ctx_t;
+
+static void parser_sink(const can_log_frame_t *frame, void *arg)
+{
+    sink_ctx_t *ctx = (sink_ctx_t *)arg;
+    twai_message_t message = { 0 };
+    message.identifier = frame->identifier;
+    message.extd = frame->extended;
+    message.rtr = frame->rtr;
+    message.data_length_code = frame->dlc;
+    memcpy(message.data, frame->data, sizeof(message.data));
+    parse_can_message(&message);
+
+    if (ctx->frames < sizeof(ctx->ids) / sizeof(ctx->ids[0])) {
+        ctx->ids[ctx->frames] = frame->identifier;
+    }
+    ctx->frames++;
+    if (ctx->stop != NULL && ctx->frames == ctx->stop_after) {
+        *ctx->stop = true;
+    }
+}
+
+// Frame i: 0x280 with RPM = 1000 + 10 * i, every 10th one a 0x580 MAP frame
+static void trace_frame(int i, uint32_t *id, uint8_t *data)
+{
+    memset(data, 0, 8);
+    if (i % 10 == 9) {
+        uint16_t map = (uint16_t)(10000 + 100 * i);     // 0.01 kPa
+        *id = 0x580;
+        data[2] = (uint8_t)(map >> 8);
+        data[3] = (uint8_t)map;
+    } else {
+        uint16_t rpm = (uint16_t)((1000 + 10 * i) * 4);  // 0.25 rpm
+        *id = 0x280;
+        data[2] = (uint8_t)(rpm >> 8);
+        data[3] = (uint8_t)rpm;
+    }
+}
+
+static void write_trace(const char *path, can_replay_format_t format)
+{
+    FILE *f = fopen(path, "w");
+    if (format == CAN_REPLAY_FORMAT_TOOL_CSV) {
+        fprintf(f, "timestamp_s,id,extended,rtr,dlc,data\n");
+    }
+    for (int i = 0; i < TRACE_FRAMES; i++) {
+        uint32_t id;
+        uint8_t d[8];
+        unsigned ms = (unsigned)i * TRACE_STEP_MS;
+        trace_frame(i, &id, d);
+        switch (format) {
+            case CAN_REPLAY_FORMAT_CANDUMP:
+                fprintf(f, "(1700000000.%06u) can0 %03X#%02X%02X%02X%02X%02X%02X%02X%02X\n", ms * 1000,
+                        (unsigned)id, d[0], d[1], d[2], d[3], d[4], d[5], d[6], d[7]);
+                break;
+            case CAN_REPLAY_FORMAT_TOOL_CSV:
+                fprintf(f, "%u.%03u,%03X,0,0,8,%02X %02X %02X %02X %02X %02X %02X %02X\n", ms / 1000,
+                        ms % 1000, (unsigned)id, d[0], d[1], d[2], d[3], d[4], d[5], d[6], d[7]);
+                break;
+            default:
+                fprintf(f, "%u,%03X,%02X,%02X,%02X,%02X,%02X,%02X,%02X,%02X\r\n", ms, (unsigned)id,
+                        d[0], d[1], d[2], d[3], d[4], d[5], d[6], d[7]);
+                break;
+        }
+        if (i == TRACE_FRAMES / 2) {
+            fprintf(f, "not a frame\n");
+        }
+    }
+    fclose(f);
+}
+
+static void reset_channels(void)
+{
+    channel_set(CH_ENGINE_RPM, 0.0f);
+    channel_set(CH_MAP_KPA, 0.0f);
+}
+
+// Whole trace as fast as possible: every frame, one parse error, final values
+static void check_replay(const char *path, uint32_t parse_errors)
+{
+    can_replay_config_t config = { .speed = 0.0f, .loop = false };
+    can_replay_stats_t stats;
+    sink_ctx_t ctx = { 0 };
+
+    reset_channels();
+    CHECK(can_replay_run(path, &config, parser_sink, &ctx, NULL, &stats) == CAN_LOG_OK);
+    CHECK(stats.frames == TRACE_FRAMES && ctx.frames == TRACE_FRAMES);
+    CHECK(stats.parse_errors == parse_errors);
+    CHECK(stats.loops == 1);
+    CHECK(stats.trace_us == (uint64_t)(TRACE_FRAMES - 1) * TRACE_STEP_MS * 1000);
+    for (int i = 0; i < TRACE_FRAMES; i++) {
+        uint32_t id;
+        uint8_t d[8];
+        trace_frame(i, &id, d);
+        if (ctx.ids[i] != id) {
+            CHECK(ctx.ids[i] == id);
+            break;
+        }
+    }
+    CHECK(channel_get(CH_ENGINE_RPM) == 1000.0f + 10.0f * (TRACE_FRAMES - 2));
+    CHECK(fabsf(channel_get(CH_MAP_KPA) - (100.0f + (TRACE_FRAMES - 1))) < 0.01f);
+}
+
+static void test_text_formats(void)
+{
+    can_replay_source_t src;
+
+    write_trace("trace_candump.log", CAN_REPLAY_FORMAT_CANDUMP);
+    write_trace("trace_legacy.csv", CAN_REPLAY_FORMAT_LEGACY_CSV);
+    write_trace("trace_tool.csv", CAN_REPLAY_FORMAT_TOOL_CSV);
+
+    CHECK(can_replay_open(&src, "trace_candump.log", CAN_REPLAY_FORMAT_AUTO) == CAN_LOG_OK);
+    CHECK(src.format == CAN_REPLAY_FORMAT_CANDUMP);
+    can_replay_close(&src);
+    CHECK(can_replay_open(&src, "trace_tool.csv", CAN_REPLAY_FORMAT_AUTO) == CAN_LOG_OK);
+    CHECK(src.format == CAN_REPLAY_FORMAT_TOOL_CSV);
+    can_replay_close(&src);
+    CHECK(can_replay_open(&src, "trace_legacy.csv", CAN_REPLAY_FORMAT_AUTO) == CAN_LOG_OK);
+    CHECK(src.format == CAN_REPLAY_FORMAT_LEGACY_CSV);
+    can_replay_close(&src);
+    CHECK(can_replay_open(&src, "missing.log", CAN_REPLAY_FORMAT_AUTO) == CAN_LOG_ERR_IO);
+
+    check_replay("trace_candump.log", 1);
+    check_replay("trace_legacy.csv", 1);
+    check_replay("trace_tool.csv", 1);
+}
+
+static void test_candump_frames(void)
+{
+    FILE *f = fopen("trace_kinds.log", "w");
+    fprintf(f, "(0.000000) can0 1F334455#DEADBEEF\n");
+    fprintf(f, "(0.000100) vcan0 123#R\n");
+    fprintf(f, "(0.000200) can0 7FF#R4\n");
+    fprintf(f, "(0.000300) can0 123##1AABB\n");           // CAN FD: skipped
+    fclose(f);
+
+    can_replay_source_t src;
+    can_log_frame_t frame;
+    CHECK(can_replay_open(&src, "trace_kinds.log", CAN_REPLAY_FORMAT_AUTO) == CAN_LOG_OK);
+    CHECK(can_replay_next(&src, &frame) == CAN_LOG_OK);
+    CHECK(frame.identifier == 0x1F334455 && frame.extended && frame.dlc == 4 && frame.data[0] == 0xDE);
+    CHECK(can_replay_next(&src, &frame) == CAN_LOG_OK);
+    CHECK(frame.identifier == 0x123 && !frame.extended && frame.rtr && frame.dlc == 0);
+    CHECK(frame.time_us == 100);
+    CHECK(can_replay_next(&src, &frame) == CAN_LOG_OK);
+    CHECK(frame.rtr && frame.dlc == 4);
+    CHECK(can_replay_next(&src, &frame) == CAN_LOG_END);
+    CHECK(src.parse_errors == 1);
+    can_replay_close(&src);
+}
+
+// Frames logged by the real logger come back from the segment in order
+static void test_binary_segment(void)
+{
+    mkdir(CAN_LOGGER_DIR, 0755);
+    DIR *dir = opendir(CAN_LOGGER_DIR);
+    struct dirent *entry;
+    while (dir != NULL && (entry = readdir(dir)) != NULL) {
+        if (strncmp(entry->d_name, CAN_LOGGER_PREFIX, strlen(CAN_LOGGER_PREFIX)) == 0) {
+            char path[300];
+            snprintf(path, sizeof(path), "%s/%s", CAN_LOGGER_DIR, entry->d_name);
+            unlink(path);
+        }
+    }
+    if (dir != NULL) {
+        closedir(dir);
+    }
+
+    can_logger_config_t config = CAN_LOGGER_CONFIG_DEFAULT();
+    config.segment_size_mb = 1;
+    CHECK(can_logger_start(&config) == ESP_OK);
+    for (int i = 0; i < TRACE_FRAMES; i++) {
+        twai_message_t m = { .data_length_code = 8 };
+        trace_frame(i, &m.identifier, m.data);
+        can_logger_log_frame(&m);
+        usleep(TRACE_STEP_MS * 1000);
+    }
+    char path[64];
+    can_logger_get_path(path, sizeof(path));
+    CHECK(can_logger_stop() == ESP_OK);
+
+    // Logged times are wall times, so only count and order are exact
+    can_replay_config_t replay = { .speed = 0.0f, .loop = false };
+    can_replay_stats_t stats;
+    sink_ctx_t ctx = { 0 };
+    reset_channels();
+    CHECK(can_replay_run(path, &replay, parser_sink, &ctx, NULL, &stats) == CAN_LOG_OK);
+    CHECK(stats.frames == TRACE_FRAMES && stats.crc_errors == 0);
+    CHECK(channel_get(CH_ENGINE_RPM) == 1000.0f + 10.0f * (TRACE_FRAMES - 2));
+    CHECK(stats.trace_us >= (uint64_t)(TRACE_FRAMES - 1) * TRACE_STEP_MS * 1000);
+}
+
+// 1x and 4x take the trace time, loop repeats it, *stop ends it
+static void test_pacing(void)
+{
+    can_replay_stats_t stats;
+    sink_ctx_t ctx = { 0 };
+    uint64_t trace_us = (uint64_t)(TRACE_FRAMES - 1) * TRACE_STEP_MS * 1000;
+
+    can_replay_config_t real_time = { .speed = 1.0f, .loop = false };
+    CHECK(can_replay_run("trace_candump.log", &real_time, parser_sink, &ctx, NULL, &stats) == CAN_LOG_OK);
+    CHECK(stats.elapsed_us >= trace_us && stats.elapsed_us < trace_us + 100000);
+
+    can_replay_config_t fast = { .speed = 4.0f, .loop = false };
+    CHECK(can_replay_run("trace_candump.log", &fast, parser_sink, &ctx, NULL, &stats) == CAN_LOG_OK);
+    CHECK(stats.elapsed_us >= trace_us / 4 && stats.elapsed_us < trace_us / 4 + 100000);
+
+    volatile bool stop = false;
+    sink_ctx_t stopping = { .stop = &stop, .stop_after = TRACE_FRAMES * 5 / 2 };
+    can_replay_config_t loop = { .speed = 0.0f, .loop = true };
+    CHECK(can_replay_run("trace_legacy.csv", &loop, parser_sink, &stopping, &stop, &stats) == CAN_LOG_OK);
+    CHECK(stats.loops == 2 && stats.frames == TRACE_FRAMES * 5 / 2);
+    CHECK(stats.parse_errors == 2);         // The third pass stops before its bad line
+}
+
+static int replay_file(const char *path, float speed, bool loop)
+{
+    can_replay_config_t config = { .speed = speed, .loop = loop };
+    can_replay_stats_t stats;
+    sink_ctx_t ctx = { 0 };
+
+    int ret = can_replay_run(path, &config, parser_sink, &ctx, NULL, &stats);
+    double seconds = stats.elapsed_us / 1e6;
+    printf("%s: %lu frames, %.3f s of trace in %.3f s (%.0f frames/s), max lag %lu us, "
+           "%lu parse errors, %lu CRC errors, %lu loops\n",
+           path, (unsigned long)stats.frames, stats.trace_us / 1e6, seconds,
+           seconds > 0 ? stats.frames / seconds : 0.0, (unsigned long)stats.max_lag_us,
+           (unsigned long)stats.parse_errors, (unsigned long)stats.crc_errors,
+           (unsigned long)stats.loops);
+    for (channel_id_t c = 0; c < CH_BUILTIN_COUNT; c++) {
+        if (channel_get_seq(c) > 0) {
+            printf("  %-20s %10.2f %s\n", channel_get_def(c)->name, channel_get(c), channel_get_def(c)->unit);
+        }
+    }
+    return ret == CAN_LOG_OK ? 0 : 1;
+}
+
+int main(int argc, char **argv)
+{
+    channel_registry_init();
+    if (argc > 1) {
+        return replay_file(argv[1], argc > 2 ? (float)atof(argv[2]) : 0.0f,
+                           argc > 3 && atoi(argv[3]) != 0);
+    }
+
+    test_text_formats();
+    test_candump_frames();
+    test_binary_segment();
+    test_pacing();
+    return HOST_TEST_RESULT();
+}
@@ -0,0 +1,197 @@
+/*
+ * Host test: channel logger and channel log reader
+ *
+ *   test_channel_log [seconds]
+ *
+ * The real sampling timer runs on a host timer thread while a feeder
+ * thread updates the registry every 5 ms: engine_rpm counts up by one per
+ * update, most channels follow sine waves, water_temp is set once. The
+ * file is read while it is being written and again after the stop:
+ *   - engine_rpm samples must be strictly increasing in time and value
+ *   - water_temp must have exactly one sample (unchanged values are skipped)
+ *   - a time window returns only samples inside it
+ *   - a header with a precision the writer never stores is rejected
+ */
+
+#include "include/channel_logger.h"
+#include "include/channel_log_reader.h"
+#include "host_test.h"
+#include "esp_rom_crc.h"
+#include <dirent.h>
+#include <math.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define FEED_PERIOD_US  5000
+
+static volatile bool feeding = true;
+
+static void *feeder(void *arg)
+{
+    uint32_t step = 0;
+    while (feeding) {
+        for (channel_id_t c = 0; c < CH_BUILTIN_COUNT; c++) {
+            if (c == CH_ENGINE_RPM) {
+                channel_set(c, (float)step);
+            } else if (c == CH_WATER_TEMP_C) {
+                if (step == 0) {
+                    channel_set(c, 90.0f);
+                }
+            } else if (c != CH_TCU_STATUS) {
+                channel_set(c, 5.0f + 2.0f * sinf(step * 0.01f + c));
+            }
+        }
+        step++;
+        usleep(FEED_PERIOD_US);
+    }
+    return NULL;
+}
+
+static void clear_log_dir(void)
+{
+    mkdir(CHANNEL_LOGGER_DIR, 0755);
+    DIR *dir = opendir(CHANNEL_LOGGER_DIR);
+    struct dirent *entry;
+    while (dir != NULL && (entry = readdir(dir)) != NULL) {
+        if (strncmp(entry->d_name, CHANNEL_LOGGER_PREFIX, strlen(CHANNEL_LOGGER_PREFIX)) == 0) {
+            char path[300];
+            snprintf(path, sizeof(path), "%s/%s", CHANNEL_LOGGER_DIR, entry->d_name);
+            unlink(path);
+        }
+    }
+    if (dir != NULL) {
+        closedir(dir);
+    }
+}
+
+// Reads one channel completely; checks time order, returns the sample count
+static int read_channel(channel_log_reader_t *r, int channel, double *min, double *max, bool *increasing)
+{
+    channel_log_sample_t s;
+    int n = 0;
+    uint64_t last_time = 0;
+    double last_value = -INFINITY;
+
+    *min = INFINITY;
+    *max = -INFINITY;
+    *increasing = true;
+    CHECK(channel_log_reader_select(r, (uint8_t)channel, 0, 0) == CAN_LOG_OK);
+    while (channel_log_reader_next(r, &s) == CAN_LOG_OK) {
+        if (n > 0 && s.time_us <= last_time) {
+            *increasing = false;
+        }
+        if (s.value <= last_value) {
+            *increasing = false;
+        }
+        last_time = s.time_us;
+        last_value = s.value;
+        *min = fmin(*min, s.value);
+        *max = fmax(*max, s.value);
+        n++;
+    }
+    return n;
+}
+
+// Copy of a log whose first channel claims `precision` decimals, CRC fixed up
+static void write_with_precision(const char *from, const char *to, uint8_t precision)
+{
+    FILE *in = fopen(from, "rb");
+    channel_log_file_header_t hdr;
+    channel_log_channel_t table[CHANNEL_LOG_MAX_CHANNELS];
+    CHECK(fread(&hdr, sizeof(hdr), 1, in) == 1);
+    CHECK(fread(table, sizeof(table[0]), hdr.channel_count, in) == hdr.channel_count);
+    fclose(in);
+
+    table[0].precision = precision;
+    uint32_t crc = esp_rom_crc32_le(0, (const uint8_t *)&hdr, offsetof(channel_log_file_header_t, crc32));
+    hdr.crc32 = esp_rom_crc32_le(crc, (const uint8_t *)table, hdr.channel_count * sizeof(table[0]));
+
+    FILE *out = fopen(to, "wb");
+    fwrite(&hdr, sizeof(hdr), 1, out);
+    fwrite(table, sizeof(table[0]), hdr.channel_count, out);
+    fclose(out);
+}
+
+int main(int argc, char **argv)
+{
+    int seconds = argc > 1 ? atoi(argv[1]) : 3;
+    char path[64];
+
+    clear_log_dir();
+    channel_registry_init();
+    for (channel_id_t c = 0; c < CH_BUILTIN_COUNT; c++) {
+        channel_logger_set_period(c, 10);
+    }
+    channel_logger_set_period(CH_ENGINE_RPM, 20);
+
+    channel_logger_config_t config = CHANNEL_LOGGER_CONFIG_DEFAULT();
+    config.flush_interval_ms = 1000;
+    CHECK(channel_logger_start(&config) == ESP_OK);
+
+    pthread_t thread;
+    pthread_create(&thread, NULL, feeder, NULL);
+    sleep((unsigned)seconds);
+
+    // Live read of the file being written
+    channel_logger_get_path(path, sizeof(path));
+    channel_log_reader_t r;
+    double min, max;
+    bool increasing;
+    CHECK(channel_log_reader_open(&r, path) == CAN_LOG_OK);
+    int live = read_channel(&r, CH_ENGINE_RPM, &min, &max, &increasing);
+    CHECK(live > 0 && increasing);
+    channel_log_reader_close(&r);
+
+    feeding = false;
+    pthread_join(thread, NULL);
+    CHECK(channel_logger_stop() == ESP_OK);
+
+    channel_logger_stats_t st;
+    channel_logger_get_stats(&st);
+    CHECK(st.write_errors == 0 && st.blocks_dropped == 0);
+
+    CHECK(channel_log_reader_open(&r, path) == CAN_LOG_OK);
+    int total = 0;
+    for (int c = 0; c < r.header.channel_count && c < CH_BUILTIN_COUNT; c++) {
+        int n = read_channel(&r, c, &min, &max, &increasing);
+        total += n;
+        if (c == CH_ENGINE_RPM) {
+            // 20 ms period, feeder at 5 ms: one sample per period, all increasing
+            CHECK(increasing);
+            CHECK(n >= seconds * 50 * 8 / 10 && n <= seconds * 50 + 5);
+            CHECK(n >= live);
+        } else if (c == CH_WATER_TEMP_C) {
+            CHECK(n == 1 && min == 90.0);
+        } else if (c != CH_TCU_STATUS) {
+            CHECK(n > 0);
+        }
+    }
+    CHECK(r.crc_errors == 0);
+    CHECK((uint32_t)total == st.samples_logged);
+
+    // Window of one second in the middle
+    channel_log_sample_t s;
+    int in_window = 0;
+    CHECK(channel_log_reader_select(&r, CH_ENGINE_RPM, 1000000, 2000000) == CAN_LOG_OK);
+    while (channel_log_reader_next(&r, &s) == CAN_LOG_OK) {
+        uint64_t rel = s.time_us - r.header.start_time_us;
+        CHECK(rel >= 1000000 && rel <= 2000000);
+        in_window++;
+    }
+    CHECK(in_window >= 40 && in_window <= 52);
+    channel_log_reader_close(&r);
+
+    write_with_precision(path, CHANNEL_LOGGER_DIR "/precision.col", CHANNEL_LOG_MAX_PRECISION);
+    CHECK(channel_log_reader_open(&r, CHANNEL_LOGGER_DIR "/precision.col") == CAN_LOG_OK);
+    channel_log_reader_close(&r);
+    write_with_precision(path, CHANNEL_LOGGER_DIR "/precision.col", 200);
+    CHECK(channel_log_reader_open(&r, CHANNEL_LOGGER_DIR "/precision.col") == CAN_LOG_ERR_FORMAT);
+    unlink(CHANNEL_LOGGER_DIR "/precision.col");
+
+    printf("%lu samples (%d engine_rpm live), %lu blocks, %lu pages, %llu bytes written\n",
+           (unsigned long)st.samples_logged, live, (unsigned long)st.blocks_closed,
+           (unsigned long)st.pages_written, (unsigned long long)st.bytes_written);
+    return HOST_TEST_RESULT();
+}
@@ -0,0 +1,139 @@
+/*
+ * Host test: http_router with a fake esp_http_server
+ *
+ * The fake records the configuration and the registered handlers; the test
+ * drives open_fn/close_fn and the dispatcher the way the server task would.
+ * Checks late route registration, duplicate routes, the stream budget, the
+ * LRU purge (least recently used session without a stream) and close hooks.
+ */
+
+#include "http_router.h"
+#include "host_test.h"
+#include <stdint.h>
+
+static httpd_config_t server_config;
+static httpd_uri_t registered[HTTP_ROUTER_MAX_ROUTES];
+static int registered_count;
+static int triggered_close = -1;
+
+esp_err_t httpd_start(httpd_handle_t *handle, const httpd_config_t *config)
+{
+    server_config = *config;
+    *handle = (httpd_handle_t)&server_config;
+    return ESP_OK;
+}
+
+esp_err_t httpd_stop(httpd_handle_t handle)
+{
+    registered_count = 0;
+    return ESP_OK;
+}
+
+esp_err_t httpd_register_uri_handler(httpd_handle_t handle, const httpd_uri_t *uri)
+{
+    registered[registered_count++] = *uri;
+    return ESP_OK;
+}
+
+esp_err_t httpd_unregister_uri_handler(httpd_handle_t handle, const char *uri, httpd_method_t method)
+{
+    return ESP_OK;
+}
+
+bool httpd_uri_match_wildcard(const char *reference_uri, const char *uri_to_match, size_t match_upto)
+{
+    return true;
+}
+
+esp_err_t httpd_sess_trigger_close(httpd_handle_t handle, int sockfd)
+{
+    triggered_close = sockfd;
+    return ESP_OK;
+}
+
+int httpd_req_to_sockfd(httpd_req_t *req)
+{
+    return (int)(intptr_t)req->aux;
+}
+
+// Fake sockets: router_close() closes them, so use numbers no process holds
+#define FD_BASE 900
+
+static int handler_calls;
+static int hook_fd = -1;
+
+static esp_err_t page_handler(httpd_req_t *req)
+{
+    handler_calls++;
+    CHECK(req->user_ctx == (void *)0x55);
+    return ESP_OK;
+}
+
+static void close_hook(int sockfd)
+{
+    hook_fd = sockfd;
+}
+
+// A request on a session, through the handler the router registered
+static void request_on(int fd)
+{
+    httpd_req_t req = { 0 };
+    req.aux = (void *)(intptr_t)fd;
+    req.user_ctx = registered[0].user_ctx;
+    registered[0].handler(&req);
+}
+
+int main(void)
+{
+    const httpd_uri_t page = { .uri = "/a", .method = HTTP_GET, .handler = page_handler, .user_ctx = (void *)0x55 };
+    http_router_stats_t st;
+
+    // Routes added before the start are registered by it
+    CHECK(http_router_register(&page) == ESP_OK);
+    CHECK(http_router_register(&page) == ESP_ERR_INVALID_STATE);
+    CHECK(registered_count == 0);
+    CHECK(http_router_start() == ESP_OK);
+    CHECK(registered_count == 1);
+    CHECK(server_config.max_open_sockets == HTTP_ROUTER_MAX_SESSIONS);
+    CHECK(!server_config.lru_purge_enable);
+    CHECK(http_router_add_close_hook(close_hook) == ESP_OK);
+
+    // All but one session open; the first eight become streams
+    for (int i = 0; i < HTTP_ROUTER_MAX_SESSIONS - 1; i++) {
+        server_config.open_fn(&server_config, FD_BASE + i);
+    }
+    CHECK(triggered_close == -1);
+    for (int i = 0; i < CONFIG_HTTP_ROUTER_MAX_STREAMS; i++) {
+        CHECK(http_router_stream_begin(FD_BASE + i) == ESP_OK);
+    }
+    CHECK(http_router_stream_begin(FD_BASE + CONFIG_HTTP_ROUTER_MAX_STREAMS) == ESP_ERR_NO_MEM);
+
+    // Oldest idle session is the first non-stream one, unless it was just used
+    int oldest_idle = FD_BASE + CONFIG_HTTP_ROUTER_MAX_STREAMS;
+    request_on(oldest_idle);
+    CHECK(handler_calls == 1);
+
+    // The last free session: the least recently used idle session is closed
+    server_config.open_fn(&server_config, FD_BASE + HTTP_ROUTER_MAX_SESSIONS - 1);
+    CHECK(triggered_close == oldest_idle + 1);
+    server_config.close_fn(&server_config, triggered_close);
+    CHECK(hook_fd == oldest_idle + 1);
+
+    http_router_get_stats(&st);
+    CHECK(st.sessions == HTTP_ROUTER_MAX_SESSIONS - 1);
+    CHECK(st.streams == CONFIG_HTTP_ROUTER_MAX_STREAMS);
+    CHECK(st.stream_rejects == 1 && st.purged == 1);
+    CHECK(st.requests == 1 && st.routes == 1);
+
+    // Closing a stream returns its slot
+    server_config.close_fn(&server_config, FD_BASE);
+    http_router_get_stats(&st);
+    CHECK(st.streams == CONFIG_HTTP_ROUTER_MAX_STREAMS - 1);
+    CHECK(http_router_stream_begin(oldest_idle) == ESP_OK);
+    http_router_stream_end(oldest_idle);
+    http_router_get_stats(&st);
+    CHECK(st.streams == CONFIG_HTTP_ROUTER_MAX_STREAMS - 1);
+
+    http_router_stop();
+    return HOST_TEST_RESULT();
+}
@@ -0,0 +1,202 @@
+/*
+ * Host test: json_writer
+ * Token output, escaping, number formatting, chunked flushing and the
+ * httpd binding (chunks plus the terminating empty chunk)
+ */
+
+#include "json_writer.h"
+#include "host_test.h"
+#include <math.h>
+#include <stdint.h>
+
+// Chunks "sent" by the fake httpd binding
+static char sent[1024];
+static size_t sent_len;
+static int sent_chunks;
+static bool sent_end;
+static esp_err_t send_result = ESP_OK;
+
+esp_err_t httpd_resp_set_type(httpd_req_t *req, const char *type)
+{
+    return ESP_OK;
+}
+
+esp_err_t httpd_resp_send_chunk(httpd_req_t *req, const char *buf, ssize_t len)
+{
+    if (buf == NULL && len == 0) {
+        sent_end = true;
+        return ESP_OK;
+    }
+    if (send_result != ESP_OK) {
+        return send_result;
+    }
+    memcpy(sent + sent_len, buf, (size_t)len);
+    sent_len += (size_t)len;
+    sent_chunks++;
+    return ESP_OK;
+}
+
+static void reset_sent(void)
+{
+    sent_len = 0;
+    sent_chunks = 0;
+    sent_end = false;
+    send_result = ESP_OK;
+}
+
+// The document used by several cases
+static void write_sample(json_writer_t *w)
+{
+    json_obj_begin(w);
+    json_kv_int(w, "rpm", 3250);
+    json_kv_float(w, "map", -0.05f, 1);
+    json_kv_float(w, "afr", 14.7f, 2);
+    json_kv_bool(w, "ok", true);
+    json_key(w, "list");
+    json_arr_begin(w);
+    json_int(w, -1);
+    json_str(w, "q\"\\\n\x01");
+    json_obj_begin(w);
+    json_obj_end(w);
+    json_null(w);
+    json_arr_end(w);
+    json_kv_str(w, "name", "ECU");
+    json_obj_end(w);
+}
+
+#define SAMPLE_JSON \
+    "{\"rpm\":3250,\"map\":-0.1,\"afr\":14.70,\"ok\":true," \
+    "\"list\":[-1,\"q\\\"\\\\\\n\\u0001\",{},null],\"name\":\"ECU\"}"
+
+static void test_fixed_buffer(void)
+{
+    char buf[256];
+    json_writer_t w;
+    json_writer_init(&w, buf, sizeof(buf), NULL, NULL);
+    write_sample(&w);
+    CHECK(json_writer_finish(&w) == ESP_OK);
+    CHECK_STR(json_writer_str(&w), SAMPLE_JSON);
+}
+
+static void test_overflow(void)
+{
+    char buf[16];
+    json_writer_t w;
+    json_writer_init(&w, buf, sizeof(buf), NULL, NULL);
+    write_sample(&w);
+    CHECK(json_writer_finish(&w) == ESP_ERR_INVALID_SIZE);
+    // Still terminated, never past the buffer
+    CHECK(strlen(buf) == sizeof(buf) - 1);
+}
+
+static void test_numbers(void)
+{
+    char buf[256];
+    json_writer_t w;
+    json_writer_init(&w, buf, sizeof(buf), NULL, NULL);
+    json_arr_begin(&w);
+    json_int(&w, INT64_MIN);
+    json_uint(&w, UINT64_MAX);
+    json_fixed(&w, 1234, 1);
+    json_fixed(&w, -5, 3);
+    json_fixed(&w, 7, 0);
+    json_float(&w, 0.125f, 2);
+    json_float(&w, -2.5f, 0);
+    json_float(&w, NAN, 1);
+    json_float(&w, INFINITY, 1);
+    json_float(&w, 1e30f, 1);
+    json_float(&w, 109.25f, 1);
+    json_float(&w, 0.35f, 1);
+    json_arr_end(&w);
+    CHECK(json_writer_finish(&w) == ESP_OK);
+    CHECK_STR(buf, "[-9223372036854775808,18446744073709551615,123.4,-0.005,7,"
+                   "0.12,-2,null,null,null,109.2,0.3]");
+}
+
+static void test_strn_and_raw(void)
+{
+    char buf[64];
+    json_writer_t w;
+    json_writer_init(&w, buf, sizeof(buf), NULL, NULL);
+    json_obj_begin(&w);
+    json_key(&w, "m");
+    json_strn(&w, "abcdef", 3);
+    json_key(&w, "r");
+    json_raw(&w, "[1,2]");
+    json_key(&w, "n");
+    json_str(&w, NULL);
+    json_obj_end(&w);
+    CHECK(json_writer_finish(&w) == ESP_OK);
+    CHECK_STR(buf, "{\"m\":\"abc\",\"r\":[1,2],\"n\":null}");
+}
+
+static void test_nesting_errors(void)
+{
+    char buf[64];
+    json_writer_t w;
+    json_writer_init(&w, buf, sizeof(buf), NULL, NULL);
+    json_arr_end(&w);
+    CHECK(json_writer_finish(&w) == ESP_ERR_INVALID_STATE);
+
+    json_writer_init(&w, buf, sizeof(buf), NULL, NULL);
+    for (int i = 0; i < JSON_WRITER_MAX_DEPTH; i++) {
+        json_arr_begin(&w);
+    }
+    CHECK(json_writer_finish(&w) == ESP_ERR_INVALID_STATE);
+}
+
+static esp_err_t append_sink(void *ctx, const char *data, size_t len)
+{
+    return httpd_resp_send_chunk(ctx, data, (ssize_t)len);
+}
+
+// A tiny chunk buffer must give the same bytes as one big buffer
+static void test_sink_sizes(void)
+{
+    char chunk[16];
+    for (size_t cap = 2; cap <= sizeof(chunk); cap++) {
+        json_writer_t w;
+        reset_sent();
+        json_writer_init(&w, chunk, cap, append_sink, NULL);
+        write_sample(&w);
+        CHECK(json_writer_finish(&w) == ESP_OK);
+        sent[sent_len] = '\0';
+        CHECK_STR(sent, SAMPLE_JSON);
+        CHECK(sent_chunks >= (int)((sizeof(SAMPLE_JSON) - 1) / cap));
+    }
+}
+
+static void test_httpd_binding(void)
+{
+    char chunk[JSON_WRITER_CHUNK_SIZE];
+    httpd_req_t req = { 0 };
+    json_writer_t w;
+
+    reset_sent();
+    json_writer_init_httpd(&w, &req, chunk, sizeof(chunk));
+    write_sample(&w);
+    CHECK(json_writer_finish(&w) == ESP_OK);
+    sent[sent_len] = '\0';
+    CHECK_STR(sent, SAMPLE_JSON);
+    CHECK(sent_end);
+
+    // A failed send is sticky, and the response is still ended
+    reset_sent();
+    send_result = ESP_FAIL;
+    json_writer_init_httpd(&w, &req, chunk, 8);
+    write_sample(&w);
+    CHECK(json_writer_finish(&w) == ESP_FAIL);
+    CHECK(sent_end);
+}
+
+int main(void)
+{
+    test_fixed_buffer();
+    test_overflow();
+    test_numbers();
+    test_strn_and_raw();
+    test_nesting_errors();
+    test_sink_sizes();
+    test_httpd_binding();
+    return HOST_TEST_RESULT();
+}
@@ -0,0 +1,99 @@
+/*
+ * Host test: Range header parsing of the log download
+ *
+ * Covers first-last, open-ended and suffix ranges, clipping to the file
+ * size, unsatisfiable ranges (416) and the values that fall back to the
+ * whole file: several ranges, other units and malformed numbers.
+ */
+
+#include "include/http_range.h"
+#include "host_test.h"
+
+#define SIZE 1000
+
+static void check_range(const char *value, long size, long start, long end)
+{
+    long s = -1, e = -1;
+    http_range_result_t ret = http_range_parse(value, size, &s, &e);
+    if (ret != HTTP_RANGE_OK || s != start || e != end) {
+        fprintf(stderr, "\"%s\" of %ld: got %d %ld-%ld, expected %ld-%ld\n",
+                value, size, ret, s, e, start, end);
+        host_test_failures++;
+    }
+}
+
+static void check_result(const char *value, long size, http_range_result_t expected)
+{
+    long s = -1, e = -1;
+    http_range_result_t ret = http_range_parse(value, size, &s, &e);
+    if (ret != expected) {
+        fprintf(stderr, "\"%s\" of %ld: got %d, expected %d\n", value, size, ret, expected);
+        host_test_failures++;
+    }
+    // Only a satisfiable range writes the bounds
+    CHECK(s == -1 && e == -1);
+}
+
+static void test_ranges(void)
+{
+    check_range("bytes=0-0", SIZE, 0, 0);
+    check_range("bytes=0-499", SIZE, 0, 499);
+    check_range("bytes=500-999", SIZE, 500, 999);
+    check_range("bytes=999-999", SIZE, 999, 999);
+
+    // Last byte past the end is clipped
+    check_range("bytes=500-5000", SIZE, 500, 999);
+
+    // Open-ended: to the end of the file
+    check_range("bytes=0-", SIZE, 0, 999);
+    check_range("bytes=900-", SIZE, 900, 999);
+
+    // Suffix: the last N bytes, all of them if N is larger than the file
+    check_range("bytes=-1", SIZE, 999, 999);
+    check_range("bytes=-100", SIZE, 900, 999);
+    check_range("bytes=-1000", SIZE, 0, 999);
+    check_range("bytes=-5000", SIZE, 0, 999);
+}
+
+static void test_unsatisfiable(void)
+{
+    check_result("bytes=1000-", SIZE, HTTP_RANGE_UNSATISFIABLE);
+    check_result("bytes=1000-2000", SIZE, HTTP_RANGE_UNSATISFIABLE);
+    check_result("bytes=-0", SIZE, HTTP_RANGE_UNSATISFIABLE);
+
+    // Nothing of an empty file can be sent
+    check_result("bytes=0-", 0, HTTP_RANGE_UNSATISFIABLE);
+    check_result("bytes=-10", 0, HTTP_RANGE_UNSATISFIABLE);
+}
+
+static void test_whole_file(void)
+{
+    // Several ranges: the whole file instead of multipart/byteranges
+    check_result("bytes=0-99,200-299", SIZE, HTTP_RANGE_NONE);
+    check_result("bytes=-10,0-5", SIZE, HTTP_RANGE_NONE);
+
+    // Other units or no range at all
+    check_result("items=0-5", SIZE, HTTP_RANGE_NONE);
+    check_result("", SIZE, HTTP_RANGE_NONE);
+    check_result("bytes=", SIZE, HTTP_RANGE_NONE);
+
+    // Malformed: ignored rather than refused
+    check_result("bytes=500-100", SIZE, HTTP_RANGE_NONE);
+    check_result("bytes=abc-", SIZE, HTTP_RANGE_NONE);
+    check_result("bytes=5", SIZE, HTTP_RANGE_NONE);
+    check_result("bytes=5-x", SIZE, HTTP_RANGE_NONE);
+    check_result("bytes=5-6 ", SIZE, HTTP_RANGE_NONE);
+    check_result("bytes=-", SIZE, HTTP_RANGE_NONE);
+    check_result("bytes=--5", SIZE, HTTP_RANGE_NONE);
+    check_result("bytes=+5-", SIZE, HTTP_RANGE_NONE);
+    check_result("bytes= 5-6", SIZE, HTTP_RANGE_NONE);
+    check_result("bytes=5--3", SIZE, HTTP_RANGE_NONE);
+}
+
+int main(void)
+{
+    test_ranges();
+    test_unsatisfiable();
+    test_whole_file();
+    return HOST_TEST_RESULT();
+}
@@ -0,0 +1,213 @@
+/*
+ * Host test: telemetry frame encoder and decoder
+ *
+ * Random walks of 19 channels are encoded frame by frame and decoded on
+ * the other side; the decoder must hold exactly the encoder's values after
+ * every frame. Also covers extreme values, unchanged channels, the
+ * keyframe interval, a lost frame, a channel count that grows mid-stream
+ * and truncated or foreign frames.
+ */
+
+#include "include/telemetry_frame.h"
+#include "host_test.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define CHANNELS    19
+#define ALL         ((1u << CHANNELS) - 1)
+
+static uint8_t frame[TELEMETRY_FRAME_MAX_SIZE];
+
+static bool same_values(const telemetry_decoder_t *dec, const int32_t *v)
+{
+    return memcmp(dec->values, v, CHANNELS * sizeof(v[0])) == 0;
+}
+
+static void test_round_trip(void)
+{
+    telemetry_encoder_t enc;
+    telemetry_decoder_t dec;
+    int32_t v[CHANNELS] = { 0 };
+    int keyframes = 0;
+
+    telemetry_encoder_init(&enc);
+    telemetry_decoder_init(&dec);
+    srand(1);
+    for (int f = 0; f < 500; f++) {
+        for (int i = 0; i < CHANNELS; i++) {
+            if (rand() % 3 == 0) {
+                v[i] += rand() % 2001 - 1000;
+            }
+        }
+        if (f == 7) {
+            v[3] = INT32_MIN;
+        } else if (f == 8) {
+            v[3] = INT32_MAX;
+        }
+        int len = telemetry_frame_encode(&enc, CHANNELS, v, ALL, (uint32_t)f * 20, false,
+                                         frame, sizeof(frame));
+        CHECK(len > 0);
+        keyframes += frame[1] & TELEMETRY_FLAG_KEYFRAME;
+        CHECK(telemetry_frame_decode(&dec, frame, (size_t)len, NULL) == TELEMETRY_OK);
+        CHECK(same_values(&dec, v));
+        CHECK(dec.timestamp_ms == (uint32_t)f * 20);
+    }
+    // First frame, then one every TELEMETRY_KEYFRAME_INTERVAL + 1
+    CHECK(keyframes == (500 + TELEMETRY_KEYFRAME_INTERVAL) / (TELEMETRY_KEYFRAME_INTERVAL + 1));
+}
+
+static void test_unchanged_channels(void)
+{
+    telemetry_encoder_t enc;
+    telemetry_decoder_t dec;
+    int32_t v[CHANNELS];
+    uint32_t updated;
+
+    for (int i = 0; i < CHANNELS; i++) {
+        v[i] = 1000 * i;
+    }
+    telemetry_encoder_init(&enc);
+    telemetry_decoder_init(&dec);
+    int key_len = telemetry_frame_encode(&enc, CHANNELS, v, ALL, 0, false, frame, sizeof(frame));
+    CHECK(telemetry_frame_decode(&dec, frame, (size_t)key_len, &updated) == TELEMETRY_OK);
+    CHECK(updated == ALL);
+
+    // Nothing changed: header and bitmap only
+    int len = telemetry_frame_encode(&enc, CHANNELS, v, ALL, 20, false, frame, sizeof(frame));
+    CHECK(len == TELEMETRY_HEADER_SIZE + (CHANNELS + 7) / 8);
+    CHECK(telemetry_frame_decode(&dec, frame, (size_t)len, &updated) == TELEMETRY_OK);
+    CHECK(updated == 0);
+
+    // One small change: one byte of value
+    v[5] += 3;
+    len = telemetry_frame_encode(&enc, CHANNELS, v, ALL, 40, false, frame, sizeof(frame));
+    CHECK(len == TELEMETRY_HEADER_SIZE + (CHANNELS + 7) / 8 + 1);
+    CHECK(len < key_len);
+    CHECK(telemetry_frame_decode(&dec, frame, (size_t)len, &updated) == TELEMETRY_OK);
+    CHECK(updated == 1u << 5);
+    CHECK(same_values(&dec, v));
+
+    // A channel that appears later starts from its full value
+    int32_t w[CHANNELS];
+    memcpy(w, v, sizeof(w));
+    telemetry_encoder_init(&enc);
+    telemetry_decoder_init(&dec);
+    len = telemetry_frame_encode(&enc, CHANNELS, w, ALL & ~(1u << 9), 0, false, frame, sizeof(frame));
+    CHECK(telemetry_frame_decode(&dec, frame, (size_t)len, NULL) == TELEMETRY_OK);
+    len = telemetry_frame_encode(&enc, CHANNELS, w, ALL, 20, false, frame, sizeof(frame));
+    CHECK(!(frame[1] & TELEMETRY_FLAG_KEYFRAME));
+    CHECK(telemetry_frame_decode(&dec, frame, (size_t)len, NULL) == TELEMETRY_OK);
+    CHECK(same_values(&dec, w));
+}
+
+static void test_lost_frame(void)
+{
+    telemetry_encoder_t enc;
+    telemetry_decoder_t dec;
+    int32_t v[CHANNELS] = { 0 };
+
+    telemetry_encoder_init(&enc);
+    telemetry_decoder_init(&dec);
+    int len = telemetry_frame_encode(&enc, CHANNELS, v, ALL, 0, false, frame, sizeof(frame));
+    CHECK(telemetry_frame_decode(&dec, frame, (size_t)len, NULL) == TELEMETRY_OK);
+
+    // Frame 2 never arrives; frame 3 must not be applied on top of frame 1
+    v[0] = 10;
+    telemetry_frame_encode(&enc, CHANNELS, v, ALL, 20, false, frame, sizeof(frame));
+    v[0] = 20;
+    len = telemetry_frame_encode(&enc, CHANNELS, v, ALL, 40, false, frame, sizeof(frame));
+    CHECK(telemetry_frame_decode(&dec, frame, (size_t)len, NULL) == TELEMETRY_ERR_NEED_KEYFRAME);
+    CHECK(!dec.synced);
+
+    // Until the next keyframe every delta is refused
+    v[0] = 30;
+    len = telemetry_frame_encode(&enc, CHANNELS, v, ALL, 60, false, frame, sizeof(frame));
+    CHECK(telemetry_frame_decode(&dec, frame, (size_t)len, NULL) == TELEMETRY_ERR_NEED_KEYFRAME);
+    len = telemetry_frame_encode(&enc, CHANNELS, v, ALL, 80, true, frame, sizeof(frame));
+    CHECK(telemetry_frame_decode(&dec, frame, (size_t)len, NULL) == TELEMETRY_OK);
+    CHECK(same_values(&dec, v));
+}
+
+static void test_count_change(void)
+{
+    telemetry_encoder_t enc;
+    telemetry_decoder_t dec;
+    int32_t v[CHANNELS + 2] = { 0 };
+
+    telemetry_encoder_init(&enc);
+    telemetry_decoder_init(&dec);
+    int len = telemetry_frame_encode(&enc, CHANNELS, v, ALL, 0, false, frame, sizeof(frame));
+    CHECK(telemetry_frame_decode(&dec, frame, (size_t)len, NULL) == TELEMETRY_OK);
+    v[0] = 5;
+    len = telemetry_frame_encode(&enc, CHANNELS, v, ALL, 20, false, frame, sizeof(frame));
+    CHECK(!(frame[1] & TELEMETRY_FLAG_KEYFRAME));
+    CHECK(telemetry_frame_decode(&dec, frame, (size_t)len, NULL) == TELEMETRY_OK);
+
+    // Two channels defined at runtime: the next frame is a keyframe the
+    // decoder accepts, and deltas continue from it
+    v[CHANNELS] = 700;
+    v[CHANNELS + 1] = -42;
+    uint32_t all = (1u << (CHANNELS + 2)) - 1;
+    len = telemetry_frame_encode(&enc, CHANNELS + 2, v, all, 40, false, frame, sizeof(frame));
+    CHECK(frame[1] & TELEMETRY_FLAG_KEYFRAME);
+    CHECK(telemetry_frame_decode(&dec, frame, (size_t)len, NULL) == TELEMETRY_OK);
+    CHECK(dec.count == CHANNELS + 2);
+
+    v[CHANNELS + 1] = 8;
+    len = telemetry_frame_encode(&enc, CHANNELS + 2, v, all, 60, false, frame, sizeof(frame));
+    CHECK(!(frame[1] & TELEMETRY_FLAG_KEYFRAME));
+    CHECK(telemetry_frame_decode(&dec, frame, (size_t)len, NULL) == TELEMETRY_OK);
+    CHECK(memcmp(dec.values, v, sizeof(v)) == 0);
+}
+
+static void test_bad_frames(void)
+{
+    telemetry_encoder_t enc;
+    telemetry_decoder_t dec;
+    int32_t v[CHANNELS];
+
+    for (int i = 0; i < CHANNELS; i++) {
+        v[i] = -100000 * i;
+    }
+    telemetry_encoder_init(&enc);
+    telemetry_decoder_init(&dec);
+    int len = telemetry_frame_encode(&enc, CHANNELS, v, ALL, 0, false, frame, sizeof(frame));
+    CHECK(telemetry_frame_decode(&dec, frame, (size_t)len, NULL) == TELEMETRY_OK);
+
+    int32_t before[TELEMETRY_MAX_CHANNELS];
+    memcpy(before, dec.values, sizeof(before));
+    for (int i = 0; i < CHANNELS; i++) {
+        v[i] += 7;
+    }
+    len = telemetry_frame_encode(&enc, CHANNELS, v, ALL, 20, false, frame, sizeof(frame));
+
+    // Every truncation fails and leaves the values as they were
+    for (int cut = 0; cut < len; cut++) {
+        telemetry_decoder_t copy = dec;
+        CHECK(telemetry_frame_decode(&copy, frame, (size_t)cut, NULL) == TELEMETRY_ERR_TRUNCATED);
+        CHECK(memcmp(copy.values, before, sizeof(before)) == 0);
+    }
+
+    uint8_t foreign[TELEMETRY_FRAME_MAX_SIZE];
+    memcpy(foreign, frame, (size_t)len);
+    foreign[0] = TELEMETRY_FRAME_VERSION + 1;
+    CHECK(telemetry_frame_decode(&dec, foreign, (size_t)len, NULL) == TELEMETRY_ERR_VERSION);
+    foreign[0] = TELEMETRY_FRAME_VERSION;
+    foreign[8] = TELEMETRY_MAX_CHANNELS + 1;
+    CHECK(telemetry_frame_decode(&dec, foreign, (size_t)len, NULL) == TELEMETRY_ERR_INVALID);
+
+    // Encoder limits
+    CHECK(telemetry_frame_encode(&enc, TELEMETRY_MAX_CHANNELS + 1, v, ALL, 0, false, frame,
+                                 sizeof(frame)) == TELEMETRY_ERR_INVALID);
+    CHECK(telemetry_frame_encode(&enc, CHANNELS, v, ALL, 0, true, frame, 16) == TELEMETRY_ERR_NO_SPACE);
+}
+
+int main(void)
+{
+    test_round_trip();
+    test_unchanged_channels();
+    test_lost_frame();
+    test_count_change();
+    test_bad_frames();
+    return HOST_TEST_RESULT();
+}
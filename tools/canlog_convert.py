@@ -0,0 +1,361 @@
+#!/usr/bin/env python3
+"""
+Конвертер бинарных CAN логов дашборда (CANnnnnn.BIN) в текстовые форматы.
+
+Формат файла описан в main/include/can_log_format.h.
+
+Примеры:
+    python canlog_convert.py CAN00001.BIN                  # CSV в stdout
+    python canlog_convert.py CAN00001.BIN -f candump -o trace.log
+    python canlog_convert.py CAN00001.BIN -f asc -o trace.asc
+    python canlog_convert.py CAN00001.BIN --from 120 --to 150   # только 120-150 с после старта
+
+Сжатые блоки (версия 3, LZ4) распаковываются встроенным декодером,
+пакет lz4 не нужен.
+
+Для --from/--to используется индекс CANnnnnn.IDX рядом с файлом (если есть),
+иначе бинарный поиск по заголовкам блоков; читаются только нужные блоки.
+"""
+
+import argparse
+import bisect
+import os
+import struct
+import sys
+import zlib
+from datetime import datetime
+
+FILE_MAGIC = 0x474F4C43   # "CLOG"
+BLOCK_MAGIC = 0x4B4C4243  # "CBLK"
+INDEX_MAGIC = 0x58444943  # "CIDX"
+SUPPORTED_VERSION = 3
+
+# Common part of all header versions; v2 adds file_id and segment before the CRC
+FILE_HEADER_COMMON = struct.Struct("<IHHIHHIQ32s32s")
+FILE_HEADER_V2_EXTRA = struct.Struct("<II")
+BLOCK_HEADER = struct.Struct("<IIQHHIIH2s")
+CHUNK_HEADER = struct.Struct("<HH")
+RECORD = struct.Struct("<II8s")
+INDEX_HEADER = struct.Struct("<IIII")
+INDEX_ENTRY = struct.Struct("<QII")
+
+ID_MASK = 0x1FFFFFFF
+FLAG_TIME = 1 << 29
+FLAG_RTR = 1 << 30
+FLAG_EXTENDED = 1 << 31
+DELTA_MASK = 0x00FFFFFF
+DLC_SHIFT = 24
+BLOCK_FLAG_LZ4 = 0x0001
+CHUNK_MAX_RECORDS = 256
+
+
+class LogFormatError(Exception):
+    pass
+
+
+def lz4_block_decompress(src, max_size):
+    """Decodes one LZ4 block (components/lz4_block); raises LogFormatError."""
+    out = bytearray()
+    i, n = 0, len(src)
+    while i < n:
+        token = src[i]
+        i += 1
+        lit_len = token >> 4
+        if lit_len == 15:
+            while True:
+                if i >= n:
+                    raise LogFormatError("truncated LZ4 literal length")
+                b = src[i]
+                i += 1
+                lit_len += b
+                if b != 255:
+                    break
+        if i + lit_len > n:
+            raise LogFormatError("truncated LZ4 literals")
+        out += src[i:i + lit_len]
+        i += lit_len
+        if i == n:
+            break
+        if i + 2 > n:
+            raise LogFormatError("truncated LZ4 offset")
+        offset = src[i] | (src[i + 1] << 8)
+        i += 2
+        match_len = token & 0x0F
+        if match_len == 15:
+            while True:
+                if i >= n:
+                    raise LogFormatError("truncated LZ4 match length")
+                b = src[i]
+                i += 1
+                match_len += b
+                if b != 255:
+                    break
+        match_len += 4
+        if offset == 0 or offset > len(out):
+            raise LogFormatError("bad LZ4 match offset")
+        start = len(out) - offset
+        if offset >= match_len:
+            out += out[start:start + match_len]
+        else:
+            for k in range(match_len):  # Overlapping copy
+                out.append(out[start + k])
+        if len(out) > max_size:
+            raise LogFormatError("LZ4 chunk larger than expected")
+    return bytes(out)
+
+
+def decode_chunks(payload):
+    """Records of an LZ4 block: the chunks concatenated."""
+    records = bytearray()
+    pos = 0
+    while pos + CHUNK_HEADER.size <= len(payload):
+        count, stored_size = CHUNK_HEADER.unpack_from(payload, pos)
+        pos += CHUNK_HEADER.size
+        data = payload[pos:pos + stored_size]
+        pos += stored_size
+        raw_len = count * RECORD.size
+        if count == 0 or count > CHUNK_MAX_RECORDS or len(data) != stored_size:
+            raise LogFormatError("bad chunk header")
+        if stored_size != raw_len:
+            planes = lz4_block_decompress(data, raw_len)
+            if len(planes) != raw_len:
+                raise LogFormatError("chunk size mismatch")
+            # Byte planes back to records: byte i of record j is at i * count + j
+            data = bytearray(raw_len)
+            for i in range(RECORD.size):
+                data[i::RECORD.size] = planes[i * count:(i + 1) * count]
+        records += data
+    return bytes(records)
+
+
+def read_file_header(f):
+    raw = f.read(FILE_HEADER_COMMON.size)
+    if len(raw) < FILE_HEADER_COMMON.size:
+        raise LogFormatError("file too short for a header")
+    (magic, version, header_size, block_size, record_size, _reserved, bitrate,
+     start_time_us, firmware, idf) = FILE_HEADER_COMMON.unpack(raw)
+    if magic != FILE_MAGIC:
+        raise LogFormatError("not a CAN log file (bad magic)")
+    if version > SUPPORTED_VERSION:
+        raise LogFormatError(f"unsupported format version {version}")
+    raw += f.read(header_size - len(raw))
+    if len(raw) != header_size:
+        raise LogFormatError("file too short for a header")
+    if zlib.crc32(raw[:-4]) != struct.unpack_from("<I", raw, header_size - 4)[0]:
+        raise LogFormatError("file header CRC mismatch")
+    file_id, segment = None, 0
+    if version >= 2:
+        file_id, segment = FILE_HEADER_V2_EXTRA.unpack_from(raw, FILE_HEADER_COMMON.size)
+    if record_size != RECORD.size:
+        raise LogFormatError(f"unexpected record size {record_size}")
+    return {
+        "version": version,
+        "header_size": header_size,
+        "block_size": block_size,
+        "bitrate": bitrate,
+        "start_time_us": start_time_us,
+        "firmware": firmware.split(b"\0", 1)[0].decode(errors="replace"),
+        "idf": idf.split(b"\0", 1)[0].decode(errors="replace"),
+        "file_id": file_id,
+        "segment": segment,
+    }
+
+
+def read_block_header(f, header, seq):
+    """Header fields of data block seq, or None past the end of the data."""
+    f.seek(seq * header["block_size"])
+    raw = f.read(BLOCK_HEADER.size)
+    if len(raw) < BLOCK_HEADER.size:
+        return None
+    fields = BLOCK_HEADER.unpack(raw)
+    magic, block_seq, _base, _count, _flags, _crc, file_id, _size, _ = fields
+    if magic != BLOCK_MAGIC or block_seq != seq or (
+            header["file_id"] is not None and file_id != header["file_id"]):
+        return None
+    return fields
+
+
+def read_index(path, header):
+    """(times, blocks) from the sidecar .IDX, or None if it is missing or stale."""
+    idx_path = os.path.splitext(path)[0] + ".IDX"
+    try:
+        with open(idx_path, "rb") as f:
+            raw = f.read()
+    except OSError:
+        return None
+    if len(raw) < INDEX_HEADER.size:
+        return None
+    magic, file_id, _interval, _ = INDEX_HEADER.unpack_from(raw)
+    if magic != INDEX_MAGIC or file_id != header["file_id"]:
+        return None
+    usable = (len(raw) - INDEX_HEADER.size) // INDEX_ENTRY.size * INDEX_ENTRY.size
+    entries = list(INDEX_ENTRY.iter_unpack(raw[INDEX_HEADER.size:INDEX_HEADER.size + usable]))
+    return [e[0] for e in entries], [e[1] for e in entries]
+
+
+def find_start_block(f, path, header, time_us):
+    """Last data block that starts at or before time_us (as can_log_reader_find_block)."""
+    f.seek(0, os.SEEK_END)
+    lo, hi = 1, f.tell() // header["block_size"]
+    index = read_index(path, header) if header["file_id"] is not None else None
+    if index and index[0]:
+        times, blocks = index
+        pos = bisect.bisect_right(times, time_us)
+        if pos > 0:
+            lo = blocks[pos - 1]
+        if pos < len(blocks):
+            hi = blocks[pos]
+    while hi - lo > 1:
+        mid = (lo + hi) // 2
+        fields = read_block_header(f, header, mid)
+        if fields is not None and fields[2] <= time_us:
+            lo = mid
+        else:
+            hi = mid
+    return lo
+
+
+def iter_frames(path, stats, start_us=None, end_us=None):
+    """Yields (time_us, can_id, extended, rtr, dlc, data) for every frame
+    in [start_us, end_us) (absolute µs, None = unbounded)."""
+    with open(path, "rb") as f:
+        header = read_file_header(f)
+        block_size = header["block_size"]
+        block_index = 1
+        if start_us is not None:
+            block_index = find_start_block(f, path, header, start_us)
+        while True:
+            f.seek(block_index * block_size)
+            block = f.read(block_size)
+            if len(block) < BLOCK_HEADER.size:
+                break
+            magic, seq, base_time, count, flags, crc, file_id, payload_size, _ = \
+                BLOCK_HEADER.unpack_from(block)
+            if magic != BLOCK_MAGIC or seq != block_index or (
+                    header["file_id"] is not None and file_id != header["file_id"]):
+                # End of data: unused preallocated tail, stale clusters or a torn write
+                break
+            if end_us is not None and base_time >= end_us:
+                break
+            block_index += 1
+            size = payload_size if flags & BLOCK_FLAG_LZ4 else count * RECORD.size
+            payload = block[BLOCK_HEADER.size:BLOCK_HEADER.size + size]
+            if len(payload) != size or zlib.crc32(payload) != crc:
+                stats["bad_blocks"] += 1
+                continue
+            records = payload
+            if flags & BLOCK_FLAG_LZ4:
+                try:
+                    records = decode_chunks(payload)
+                except LogFormatError:
+                    stats["bad_blocks"] += 1
+                    continue
+                stats["stored_bytes"] += len(payload)
+                stats["record_bytes"] += len(records)
+            stats["blocks"] += 1
+
+            t = base_time
+            for delta_dlc, id_flags, data in RECORD.iter_unpack(records):
+                if id_flags & FLAG_TIME:
+                    t = struct.unpack("<Q", data)[0]
+                    continue
+                t += delta_dlc & DELTA_MASK
+                if start_us is not None and t < start_us:
+                    continue
+                if end_us is not None and t >= end_us:
+                    return
+                dlc = (delta_dlc >> DLC_SHIFT) & 0x0F
+                stats["frames"] += 1
+                yield (t, id_flags & ID_MASK, bool(id_flags & FLAG_EXTENDED),
+                       bool(id_flags & FLAG_RTR), dlc, data[:min(dlc, 8)])
+
+
+def write_csv(frames, out, header):
+    out.write("timestamp_s,id,extended,rtr,dlc,data\n")
+    for t, can_id, ext, rtr, dlc, data in frames:
+        out.write(f"{t / 1e6:.6f},{can_id:X},{int(ext)},{int(rtr)},{dlc},{data.hex(' ').upper()}\n")
+
+
+def write_candump(frames, out, header, interface="can0"):
+    for t, can_id, ext, rtr, dlc, data in frames:
+        ident = f"{can_id:08X}" if ext else f"{can_id:03X}"
+        payload = "R" if rtr else data.hex().upper()
+        out.write(f"({t / 1e6:.6f}) {interface} {ident}#{payload}\n")
+
+
+def write_asc(frames, out, header):
+    # Vector ASC: timestamps relative to the start of the file
+    now = datetime.now().strftime("%a %b %d %I:%M:%S.000 %p %Y")
+    out.write(f"date {now}\n")
+    out.write("base hex  timestamps absolute\n")
+    out.write("internal events logged\n")
+    out.write(f"// firmware {header['firmware']}, {header['bitrate']} bit/s\n")
+    out.write("Begin Triggerblock\n")
+    start = header["start_time_us"]
+    for t, can_id, ext, rtr, dlc, data in frames:
+        ident = f"{can_id:X}x" if ext else f"{can_id:X}"
+        rel = max(t - start, 0) / 1e6
+        if rtr:
+            out.write(f"{rel:11.6f} 1  {ident:<15} Rx   r\n")
+        else:
+            out.write(f"{rel:11.6f} 1  {ident:<15} Rx   d {dlc} {data.hex(' ').upper()}\n")
+    out.write("End TriggerBlock\n")
+
+
+WRITERS = {
+    "csv": write_csv,
+    "candump": write_candump,
+    "asc": write_asc,
+}
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Convert dashboard CAN logs (CANnnnnn.BIN)")
+    parser.add_argument("input", help="binary log file")
+    parser.add_argument("-f", "--format", choices=sorted(WRITERS), default="csv")
+    parser.add_argument("-o", "--output", help="output file (default: stdout)")
+    parser.add_argument("--from", dest="time_from", type=float, metavar="SEC",
+                        help="first frame, seconds after the file start")
+    parser.add_argument("--to", dest="time_to", type=float, metavar="SEC",
+                        help="end of the range, seconds after the file start")
+    parser.add_argument("--info", action="store_true", help="print the file header and exit")
+    args = parser.parse_args()
+
+    try:
+        with open(args.input, "rb") as f:
+            header = read_file_header(f)
+    except (OSError, LogFormatError) as e:
+        print(f"Ошибка: {e}", file=sys.stderr)
+        return 1
+
+    if args.info:
+        for key, value in header.items():
+            print(f"{key}: {value}")
+        return 0
+
+    # The logger has no wall clock: times are µs since boot, so ranges are
+    # given relative to the file start
+    start_us = end_us = None
+    if args.time_from is not None:
+        start_us = header["start_time_us"] + int(args.time_from * 1e6)
+    if args.time_to is not None:
+        end_us = header["start_time_us"] + int(args.time_to * 1e6)
+
+    stats = {"blocks": 0, "bad_blocks": 0, "frames": 0, "record_bytes": 0, "stored_bytes": 0}
+    out = open(args.output, "w", newline="\n") if args.output else sys.stdout
+    try:
+        WRITERS[args.format](iter_frames(args.input, stats, start_us, end_us), out, header)
+    finally:
+        if args.output:
+            out.close()
+
+    print(f"{stats['frames']} frames in {stats['blocks']} blocks, "
+          f"{stats['bad_blocks']} blocks with CRC errors", file=sys.stderr)
+    if stats["stored_bytes"]:
+        print(f"LZ4 blocks: {stats['record_bytes'] / stats['stored_bytes']:.2f}:1 "
+              f"({stats['record_bytes']} -> {stats['stored_bytes']} bytes)", file=sys.stderr)
+    return 0 if stats["bad_blocks"] == 0 else 2
+
+
+if __name__ == "__main__":
+    sys.exit(main())
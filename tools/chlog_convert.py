@@ -0,0 +1,217 @@
+#!/usr/bin/env python3
+"""
+Экспорт каналов из колоночных логов дашборда (CHNnnnnn.COL) в CSV.
+
+Формат файла описан в main/include/channel_log_format.h.
+
+Примеры:
+    python chlog_convert.py CHN00001.COL --list                 # список каналов
+    python chlog_convert.py CHN00001.COL -c engine_rpm          # один канал в stdout
+    python chlog_convert.py CHN00001.COL -c engine_rpm -c map_kpa -o boost.csv
+    python chlog_convert.py CHN00001.COL -c oil_temp --from 600 --to 1200
+
+Для каждого канала читаются только заголовки страниц, каталоги страниц
+с этим каналом и его собственные блоки.
+"""
+
+import argparse
+import struct
+import sys
+import zlib
+
+FILE_MAGIC = 0x474C4843   # "CHLG"
+PAGE_MAGIC = 0x47415043   # "CPAG"
+SUPPORTED_VERSION = 1
+PAGE_SIZE = 16 * 1024
+
+FILE_HEADER = struct.Struct("<IHHIIQ32sIHHI")
+CHANNEL = struct.Struct("<24s8sB3sI")
+PAGE_HEADER = struct.Struct("<IIIIIIHHI")
+DIR_ENTRY = struct.Struct("<BBHHHIiIiiI")
+
+
+class LogFormatError(Exception):
+    pass
+
+
+def read_file_header(f):
+    raw = f.read(FILE_HEADER.size)
+    if len(raw) < FILE_HEADER.size:
+        raise LogFormatError("file too short for a header")
+    (magic, version, header_size, page_size, tick_us, start_time_us, firmware,
+     file_id, channel_count, channel_size, crc) = FILE_HEADER.unpack(raw)
+    if magic != FILE_MAGIC:
+        raise LogFormatError("not a channel log file (bad magic)")
+    if version > SUPPORTED_VERSION:
+        raise LogFormatError(f"unsupported format version {version}")
+    if header_size != FILE_HEADER.size or channel_size != CHANNEL.size or page_size != PAGE_SIZE:
+        raise LogFormatError("unexpected header layout")
+    table = f.read(channel_count * CHANNEL.size)
+    if len(table) != channel_count * CHANNEL.size:
+        raise LogFormatError("file too short for the channel table")
+    if zlib.crc32(table, zlib.crc32(raw[:-4])) != crc:
+        raise LogFormatError("file header CRC mismatch")
+    channels = []
+    for i in range(channel_count):
+        name, unit, precision, _reserved, period_ticks = CHANNEL.unpack_from(table, i * CHANNEL.size)
+        channels.append({
+            "name": name.split(b"\0", 1)[0].decode(errors="replace"),
+            "unit": unit.split(b"\0", 1)[0].decode(errors="replace"),
+            "precision": precision,
+            "period_ms": period_ticks * tick_us / 1000,
+        })
+    return {
+        "version": version,
+        "tick_us": tick_us,
+        "start_time_us": start_time_us,
+        "firmware": firmware.split(b"\0", 1)[0].decode(errors="replace"),
+        "file_id": file_id,
+        "channels": channels,
+    }
+
+
+def iter_pages(f, header, stats):
+    """(page offset, page header fields) of every data page, in order."""
+    seq = 1
+    while True:
+        f.seek(seq * PAGE_SIZE)
+        raw = f.read(PAGE_HEADER.size)
+        if len(raw) < PAGE_HEADER.size:
+            return
+        magic, sequence, file_id, first_tick, last_tick, mask, count, data_end, crc = PAGE_HEADER.unpack(raw)
+        if magic != PAGE_MAGIC or sequence != seq or file_id != header["file_id"]:
+            return
+        yield seq * PAGE_SIZE, {"first_tick": first_tick, "last_tick": last_tick,
+                                "mask": mask, "count": count, "crc": crc}
+        seq += 1
+
+
+def read_varint(data, pos):
+    value, shift = 0, 0
+    while True:
+        if pos >= len(data) or shift > 28:
+            raise LogFormatError("truncated sample")
+        b = data[pos]
+        pos += 1
+        value |= (b & 0x7F) << shift
+        if not b & 0x80:
+            return value, pos
+        shift += 7
+
+
+def to_int32(v):
+    v &= 0xFFFFFFFF
+    return v - (1 << 32) if v & 0x80000000 else v
+
+
+def iter_samples(f, header, channel, stats, from_tick=0, to_tick=None):
+    """(tick, scaled value) of one channel, reading only its blocks."""
+    for offset, page in iter_pages(f, header, stats):
+        if not page["mask"] & (1 << channel) or page["last_tick"] < from_tick:
+            continue
+        f.seek(offset + PAGE_HEADER.size)
+        directory = f.read(page["count"] * DIR_ENTRY.size)
+        if zlib.crc32(directory) != page["crc"]:
+            stats["bad_blocks"] += 1
+            continue
+        for i in range(page["count"]):
+            (ch, _reserved, count, block_offset, size, first_tick, first_value,
+             last_tick, _min, _max, crc) = DIR_ENTRY.unpack_from(directory, i * DIR_ENTRY.size)
+            if ch != channel or last_tick < from_tick:
+                continue
+            if to_tick is not None and first_tick > to_tick:
+                return
+            f.seek(offset + block_offset)
+            data = f.read(size)
+            if zlib.crc32(data) != crc:
+                stats["bad_blocks"] += 1
+                continue
+            stats["blocks"] += 1
+            tick, value, pos = first_tick, first_value, 0
+            for n in range(count):
+                if n > 0:
+                    dt, pos = read_varint(data, pos)
+                    dv, pos = read_varint(data, pos)
+                    tick += dt
+                    value = to_int32(value + ((dv >> 1) ^ -(dv & 1)))
+                if tick < from_tick:
+                    continue
+                if to_tick is not None and tick > to_tick:
+                    return
+                stats["samples"] += 1
+                yield tick, value
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Export channels of dashboard channel logs (CHNnnnnn.COL)")
+    parser.add_argument("input", help="channel log file")
+    parser.add_argument("-c", "--channel", action="append", default=[],
+                        help="channel name, may be repeated (default: all)")
+    parser.add_argument("-o", "--output", help="output file (default: stdout)")
+    parser.add_argument("--from", dest="time_from", type=float, metavar="SEC",
+                        help="first sample, seconds after the file start")
+    parser.add_argument("--to", dest="time_to", type=float, metavar="SEC",
+                        help="end of the range, seconds after the file start")
+    parser.add_argument("--list", action="store_true", help="print the header and channel table and exit")
+    args = parser.parse_args()
+
+    try:
+        f = open(args.input, "rb")
+        header = read_file_header(f)
+    except (OSError, LogFormatError) as e:
+        print(f"Ошибка: {e}", file=sys.stderr)
+        return 1
+
+    channels = header["channels"]
+    if args.list:
+        for key in ("version", "tick_us", "start_time_us", "firmware", "file_id"):
+            print(f"{key}: {header[key]}")
+        for i, ch in enumerate(channels):
+            print(f"{i:3d} {ch['name']:<24} {ch['unit']:<6} precision {ch['precision']} "
+                  f"every {ch['period_ms']:g} ms")
+        return 0
+
+    names = [ch["name"] for ch in channels]
+    selected = args.channel or names
+    for name in selected:
+        if name not in names:
+            print(f"Ошибка: канала {name} нет в файле", file=sys.stderr)
+            return 1
+
+    tick_us = header["tick_us"]
+    from_tick = int(args.time_from * 1e6 // tick_us) if args.time_from is not None else 0
+    to_tick = int(args.time_to * 1e6 // tick_us) if args.time_to is not None else None
+
+    # One channel: time_s,<name>; several: one row per sample, sorted by time
+    stats = {"blocks": 0, "bad_blocks": 0, "samples": 0}
+    rows = []
+    for name in selected:
+        index = names.index(name)
+        precision = channels[index]["precision"]
+        scale = 10 ** precision
+        for tick, value in iter_samples(f, header, index, stats, from_tick, to_tick):
+            rows.append((tick, name, f"{value / scale:.{precision}f}"))
+    f.close()
+    rows.sort(key=lambda r: r[0])
+
+    out = open(args.output, "w", newline="\n") if args.output else sys.stdout
+    try:
+        if len(selected) == 1:
+            out.write(f"time_s,{selected[0]}\n")
+            for tick, _name, value in rows:
+                out.write(f"{tick * tick_us / 1e6:.3f},{value}\n")
+        else:
+            out.write("time_s,channel,value\n")
+            for tick, name, value in rows:
+                out.write(f"{tick * tick_us / 1e6:.3f},{name},{value}\n")
+    finally:
+        if args.output:
+            out.close()
+
+    print(f"{stats['samples']} samples from {stats['blocks']} blocks, "
+          f"{stats['bad_blocks']} blocks with CRC errors", file=sys.stderr)
+    return 0 if stats["bad_blocks"] == 0 else 2
+
+
+if __name__ == "__main__":
+    sys.exit(main())
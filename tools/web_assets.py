@@ -0,0 +1,118 @@
+#!/usr/bin/env python3
+"""
+Упаковка веб-ресурсов (main/web/*) в C файл для прошивки.
+
+Каждый файл сжимается gzip при сборке; в прошивку попадают сжатые байты,
+их длина и ETag (хеш исходного содержимого), так что обработчику остаётся
+отправить готовый буфер. Структура записи описана в main/include/web_assets.h.
+
+Вызывается из main/CMakeLists.txt:
+    python web_assets.py -o web_assets_data.c main/web/dashboard.html main/web/dashboard.css
+
+Без -o печатает размеры до и после сжатия.
+"""
+
+import argparse
+import gzip
+import hashlib
+import os
+import sys
+
+CONTENT_TYPES = {
+    ".html": "text/html",
+    ".css": "text/css",
+    ".js": "application/javascript",
+    ".json": "application/json",
+    ".svg": "image/svg+xml",
+    ".png": "image/png",
+    ".ico": "image/x-icon",
+}
+
+# Pages keep their URLs across firmware updates: the browser revalidates
+# them on every load and gets a 304 while the ETag matches. Styles and
+# scripts are reused for a while without asking.
+CACHE_PAGE = "no-cache"
+CACHE_STATIC = "max-age=600"
+
+
+def pack(path):
+    with open(path, "rb") as f:
+        raw = f.read()
+    name = os.path.basename(path)
+    ext = os.path.splitext(name)[1].lower()
+    if ext not in CONTENT_TYPES:
+        raise ValueError(f"{name}: unknown content type")
+    return {
+        "name": name,
+        "type": CONTENT_TYPES[ext],
+        "cache": CACHE_PAGE if ext == ".html" else CACHE_STATIC,
+        "etag": '"' + hashlib.sha256(raw).hexdigest()[:16] + '"',
+        # mtime=0: the same input gives the same bytes on every build
+        "gz": gzip.compress(raw, compresslevel=9, mtime=0),
+        "raw_len": len(raw),
+    }
+
+
+def c_string(s):
+    return '"' + s.replace("\\", "\\\\").replace('"', '\\"') + '"'
+
+
+def write_c(assets, out):
+    out.write("// Generated by tools/web_assets.py from main/web, do not edit\n\n")
+    out.write('#include "web_assets.h"\n\n')
+    for i, a in enumerate(assets):
+        out.write(f"// {a['name']}: {a['raw_len']} bytes, {len(a['gz'])} gzipped\n")
+        out.write(f"static const uint8_t asset_{i}[{len(a['gz'])}] = {{\n")
+        data = a["gz"]
+        for pos in range(0, len(data), 16):
+            out.write("    " + ", ".join(f"0x{b:02x}" for b in data[pos:pos + 16]) + ",\n")
+        out.write("};\n\n")
+
+    out.write("const web_asset_t web_assets[] = {\n")
+    for i, a in enumerate(assets):
+        out.write("    {\n")
+        out.write(f"        .name = {c_string(a['name'])},\n")
+        out.write(f"        .content_type = {c_string(a['type'])},\n")
+        out.write(f"        .cache_control = {c_string(a['cache'])},\n")
+        out.write(f"        .etag = {c_string(a['etag'])},\n")
+        out.write(f"        .data = asset_{i},\n")
+        out.write(f"        .len = sizeof(asset_{i}),\n")
+        out.write(f"        .raw_len = {a['raw_len']},\n")
+        out.write("    },\n")
+    out.write("};\n\n")
+    out.write("const size_t web_asset_count = sizeof(web_assets) / sizeof(web_assets[0]);\n")
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Упаковка веб-ресурсов в C файл")
+    parser.add_argument("files", nargs="+", help="файлы ресурсов")
+    parser.add_argument("-o", "--output", help="C файл для записи")
+    args = parser.parse_args()
+
+    try:
+        assets = [pack(path) for path in args.files]
+    except (OSError, ValueError) as e:
+        print(f"Ошибка: {e}", file=sys.stderr)
+        return 1
+
+    names = [a["name"] for a in assets]
+    if len(set(names)) != len(names):
+        print("Ошибка: повторяющиеся имена файлов", file=sys.stderr)
+        return 1
+
+    if args.output:
+        with open(args.output, "w", newline="\n") as f:
+            write_c(assets, f)
+        return 0
+
+    total_raw = total_gz = 0
+    for a in assets:
+        total_raw += a["raw_len"]
+        total_gz += len(a["gz"])
+        print(f"{a['name']:<20} {a['raw_len']:>7} -> {len(a['gz']):>6} bytes  {a['etag']}")
+    print(f"{'total':<20} {total_raw:>7} -> {total_gz:>6} bytes")
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,197 @@
+#!/usr/bin/env python3
+"""
+Нагрузочный тест WebSocket рассылки CAN данных (main/can_websocket.c).
+
+Открывает N клиентов к ws://<host>/ws. Часть клиентов "медленные":
+они не читают сокет, и их буфер на устройстве заполняется. После теста
+печатается частота кадров у каждого клиента и счётчики устройства из
+GET /ws/stats: стоимость сериализации и fan-out за тик, отправленные и
+пропущенные кадры, закрытые клиенты.
+
+Примеры:
+    python ws_load_test.py 192.168.4.1                      # 4 клиента, 10 с
+    python ws_load_test.py 192.168.4.1 -n 6 --slow 2 -t 30
+    python ws_load_test.py 192.168.4.1 -n 3 --hz 2          # клиенты с 2 Гц
+    python ws_load_test.py 192.168.4.1 --bin                # бинарные кадры телеметрии
+
+Только стандартная библиотека.
+"""
+
+import argparse
+import base64
+import json
+import os
+import socket
+import struct
+import sys
+import threading
+import time
+import urllib.request
+
+WS_PORT = 80
+
+
+class WsClient:
+    def __init__(self, host, port, hz, slow, binary=False):
+        self.slow = slow
+        self.binary = binary
+        self.frames = 0
+        self.bytes = 0
+        self.bad = 0
+        self.closed = False
+        self.error = None
+        self.first = None
+        self.last = None
+
+        self.sock = socket.create_connection((host, port), timeout=5)
+        if slow:
+            # Small receive buffer so the device side backs up quickly
+            self.sock.setsockopt(socket.SOL_SOCKET, socket.SO_RCVBUF, 1024)
+        key = base64.b64encode(os.urandom(16)).decode()
+        query = ([f"hz={hz}"] if hz else []) + (["format=bin"] if binary else [])
+        path = "/ws?" + "&".join(query) if query else "/ws"
+        request = (f"GET {path} HTTP/1.1\r\n"
+                   f"Host: {host}:{port}\r\n"
+                   "Upgrade: websocket\r\n"
+                   "Connection: Upgrade\r\n"
+                   f"Sec-WebSocket-Key: {key}\r\n"
+                   "Sec-WebSocket-Version: 13\r\n\r\n")
+        self.sock.sendall(request.encode())
+
+        response = b""
+        while b"\r\n\r\n" not in response:
+            chunk = self.sock.recv(1024)
+            if not chunk:
+                raise ConnectionError("connection closed during handshake")
+            response += chunk
+        head, self.pending = response.split(b"\r\n\r\n", 1)
+        if b" 101 " not in head.split(b"\r\n", 1)[0]:
+            raise ConnectionError(head.split(b"\r\n", 1)[0].decode(errors="replace"))
+        self.sock.settimeout(1)
+
+    def _read(self, n):
+        while len(self.pending) < n:
+            chunk = self.sock.recv(4096)
+            if not chunk:
+                raise ConnectionError("closed")
+            self.pending += chunk
+        data, self.pending = self.pending[:n], self.pending[n:]
+        return data
+
+    def _frame(self):
+        b0, b1 = self._read(2)
+        opcode = b0 & 0x0F
+        length = b1 & 0x7F
+        if length == 126:
+            length = struct.unpack(">H", self._read(2))[0]
+        elif length == 127:
+            length = struct.unpack(">Q", self._read(8))[0]
+        return opcode, self._read(length)
+
+    def run(self, stop):
+        if self.slow:
+            # Connected but never reading: the socket fills up
+            stop.wait()
+            return
+        while not stop.is_set():
+            try:
+                opcode, payload = self._frame()
+            except socket.timeout:
+                continue
+            except (ConnectionError, OSError) as e:
+                self.closed = True
+                self.error = str(e)
+                return
+            if opcode == 0x8:
+                self.closed = True
+                return
+            if opcode != (0x2 if self.binary else 0x1):
+                continue
+            now = time.monotonic()
+            self.first = self.first or now
+            self.last = now
+            self.frames += 1
+            self.bytes += len(payload)
+            if self.binary:
+                # Версия кадра и длина не короче заголовка (telemetry_frame.h)
+                if len(payload) < 9 or payload[0] != 1:
+                    self.bad += 1
+                continue
+            try:
+                json.loads(payload)
+            except ValueError:
+                self.bad += 1
+
+    def close(self):
+        try:
+            # Close frame, masked as a client must
+            self.sock.sendall(b"\x88\x80" + os.urandom(4))
+        except OSError:
+            pass
+        self.sock.close()
+
+
+def fetch_stats(host, port):
+    with urllib.request.urlopen(f"http://{host}:{port}/ws/stats", timeout=5) as r:
+        return json.loads(r.read())
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Нагрузочный тест WebSocket рассылки")
+    parser.add_argument("host", help="адрес дашборда, например 192.168.4.1")
+    parser.add_argument("--port", type=int, default=WS_PORT)
+    parser.add_argument("-n", "--clients", type=int, default=4, help="число клиентов (до 7)")
+    parser.add_argument("--slow", type=int, default=0, help="из них не читающих сокет")
+    parser.add_argument("--hz", type=int, default=0, help="частота кадров клиента, 0 = максимум")
+    parser.add_argument("--bin", action="store_true", help="бинарные кадры телеметрии вместо JSON")
+    parser.add_argument("-t", "--time", type=float, default=10.0, help="длительность, с")
+    args = parser.parse_args()
+
+    before = fetch_stats(args.host, args.port)
+
+    clients = []
+    for i in range(args.clients):
+        try:
+            clients.append(WsClient(args.host, args.port, args.hz, i < args.slow, args.bin))
+        except (ConnectionError, OSError) as e:
+            print(f"Клиент {i}: не подключился: {e}", file=sys.stderr)
+    if not clients:
+        return 1
+
+    stop = threading.Event()
+    threads = [threading.Thread(target=c.run, args=(stop,), daemon=True) for c in clients]
+    for t in threads:
+        t.start()
+    time.sleep(args.time)
+    after = fetch_stats(args.host, args.port)
+    stop.set()
+    for t in threads:
+        t.join()
+    for c in clients:
+        c.close()
+
+    print(f"{'client':>6} {'kind':>5} {'frames':>7} {'fps':>6} {'bytes':>8} {'bad':>4}  state")
+    for i, c in enumerate(clients):
+        span = (c.last - c.first) if c.first and c.last and c.last > c.first else 0
+        fps = (c.frames - 1) / span if span else 0.0
+        state = f"closed ({c.error})" if c.closed and c.error else ("closed" if c.closed else "open")
+        print(f"{i:>6} {'slow' if c.slow else 'fast':>5} {c.frames:>7} {fps:>6.1f} {c.bytes:>8} "
+              f"{c.bad:>4}  {state}")
+
+    ticks = after["ticks"] - before["ticks"]
+    sent = after["frames_sent"] - before["frames_sent"]
+    coalesced = after["frames_coalesced"] - before["frames_coalesced"]
+    print()
+    print(f"Устройство: {ticks} тиков, {sent} кадров отправлено, {coalesced} пропущено, "
+          f"{after['clients_closed'] - before['clients_closed']} клиентов закрыто")
+    avg = (after["total_fanout_us"] - before["total_fanout_us"]) / ticks if ticks else 0
+    print(f"Fan-out за тик: среднее {avg:.0f} us, максимум {after['max_fanout_us']} us, "
+          f"последний {after['last_fanout_us']} us (из них сериализация {after['last_serialize_us']} us)")
+    if ticks:
+        print(f"На отправленный кадр: {avg * ticks / max(1, sent):.0f} us, "
+              f"{sent / ticks:.2f} кадров за тик")
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())